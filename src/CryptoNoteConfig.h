@@ -69,6 +69,11 @@ const uint64_t CRYPTONOTE_LOCKED_TX_ALLOWED_DELTA_SECONDS    = DIFFICULTY_TARGET
 const uint64_t CRYPTONOTE_MEMPOOL_TX_LIVETIME                = (60 * 60 * 14); //seconds, 14 hours
 const uint64_t CRYPTONOTE_MEMPOOL_TX_FROM_ALT_BLOCK_LIVETIME = (60 * 60 * 24); //seconds, one day
 const uint64_t CRYPTONOTE_NUMBER_OF_PERIODS_TO_FORGET_TX_DELETED_FROM_POOL = 6;  // CRYPTONOTE_NUMBER_OF_PERIODS_TO_FORGET_TX_DELETED_FROM_POOL * CRYPTONOTE_MEMPOOL_TX_LIVETIME = time to forget tx
+const size_t   CRYPTONOTE_MEMPOOL_MAX_SIZE                   = 64 * 1024 * 1024; // bytes, total size of transaction blobs kept in pool
+const uint64_t CRYPTONOTE_MEMPOOL_MIN_FEE_RATE_HALF_LIFE     = 60 * 60 * 2;      // seconds, decay of the relay fee rate floor raised by evictions
+const uint64_t CRYPTONOTE_MEMPOOL_MIN_FEE_RATE_INCREMENT     = UINT64_C(10000);  // per kB, the floor is raised this far above the fee rate of an evicted transaction
+const size_t   CRYPTONOTE_MEMPOOL_JOURNAL_COMPACTION_SIZE    = 4 * 1024 * 1024;  // bytes, pool journal is compacted once it outgrows both this and the pool itself
+const size_t   CRYPTONOTE_BLOCK_BLOB_CACHE_MAX_SIZE          = 64 * 1024 * 1024; // bytes, serialized main chain blocks kept for sync requests
 
 const size_t   FUSION_TX_MAX_SIZE                            = CRYPTONOTE_BLOCK_GRANTED_FULL_REWARD_ZONE * 30 / 100;
 const size_t   FUSION_TX_MIN_INPUT_COUNT                     = 12;
@@ -85,6 +90,7 @@ const char     CRYPTONOTE_BLOCKS_FILENAME[]                  = "blocks.dat";
 const char     CRYPTONOTE_BLOCKINDEXES_FILENAME[]            = "blockindexes.dat";
 const char     CRYPTONOTE_BLOCKSCACHE_FILENAME[]             = "blockscache.dat";
 const char     CRYPTONOTE_POOLDATA_FILENAME[]                = "poolstate.bin";
+const char     CRYPTONOTE_POOLJOURNAL_FILENAME[]             = "pooljournal.bin";
 const char     P2P_NET_DATA_FILENAME[]                       = "p2pstate.bin";
 const char     CRYPTONOTE_BLOCKCHAIN_INDICES_FILENAME[]      = "blockchainindices.dat";
 const char     MINER_CONFIG_FILE_NAME[]                      = "miner_conf.json";
@@ -109,6 +115,11 @@ const uint8_t  BLOCK_MINOR_VERSION_1                         =  1;
 
 const size_t   BLOCKS_IDS_SYNCHRONIZING_DEFAULT_COUNT        =  10000;  //by default, blocks ids count in synchronizing
 const size_t   BLOCKS_SYNCHRONIZING_DEFAULT_COUNT            =  2000;    //by default, blocks count in blocks downloading
+const size_t   BLOCKS_SYNCHRONIZING_CHUNK_COUNT              =  200;     //blocks requested from a peer at once, when downloading from several peers
+const size_t   BLOCKS_SYNCHRONIZING_WINDOW_CHUNKS            =  20;      //chunks downloaded ahead of the oldest unprocessed one
+const size_t   BLOCKS_SYNCHRONIZING_CHUNKS_PER_PEER          =  4;       //chunks requested from one peer at a time
+const uint32_t BLOCKS_SYNCHRONIZING_CHUNK_TIMEOUT            =  30;      //seconds, chunk is requested from another peer after it
+const uint32_t BLOCKS_SYNCHRONIZING_STALL_TIMEOUT            =  5;       //seconds, the oldest chunk is also requested from another peer after it
 const size_t   COMMAND_RPC_GET_BLOCKS_FAST_MAX_COUNT         =  1000;
 
 const int      P2P_DEFAULT_PORT                              = 32001;
@@ -118,6 +129,13 @@ const size_t   P2P_LOCAL_WHITE_PEERLIST_LIMIT                =  1000;
 const size_t   P2P_LOCAL_GRAY_PEERLIST_LIMIT                 =  5000;
 
 const size_t   P2P_CONNECTION_MAX_WRITE_BUFFER_SIZE          = 16 * 1024 * 1024; // 16 MB
+const size_t   P2P_DEFAULT_SEND_BUFFER_SIZE                  = 256 * 1024 * 1024; // 256 MB, queued for sending on all connections together
+const size_t   P2P_CONNECTION_RECEIVE_BUFFER_SIZE            = 64 * 1024;     // 64 KB, kept by a connection between messages
+const size_t   P2P_RECEIVE_BUFFER_POOL_SIZE                  = 64 * 1024 * 1024; // 64 MB, buffers of larger messages kept for all connections
+const size_t   P2P_DEFAULT_CONTEXT_STACK_SIZE                = 64 * 1024;     // 64 KB, stack of each of the three contexts serving a connection
+const size_t   P2P_MIN_CONTEXT_STACK_SIZE                    = 64 * 1024;     // 64 KB, a smaller configured stack is raised to this
+const uint32_t P2P_DEFAULT_MAX_INCOMING_CONNECTIONS          = 1000;
+const uint32_t P2P_MAX_INCOMING_CONNECTIONS_PER_IP           = 8;
 const uint32_t P2P_DEFAULT_CONNECTIONS_COUNT                 = 8;
 const size_t   P2P_DEFAULT_WHITELIST_CONNECTIONS_PERCENT     = 70;
 const uint32_t P2P_DEFAULT_HANDSHAKE_INTERVAL                = 60;            // seconds
@@ -127,6 +145,18 @@ const uint32_t P2P_DEFAULT_CONNECTION_TIMEOUT                = 5000;          //
 const uint32_t P2P_DEFAULT_PING_CONNECTION_TIMEOUT           = 2000;          // 2 seconds
 const uint64_t P2P_DEFAULT_INVOKE_TIMEOUT                    = 60 * 2 * 1000; // 2 minutes
 const size_t   P2P_DEFAULT_HANDSHAKE_INVOKE_TIMEOUT          = 5000;          // 5 seconds
+const uint32_t P2P_IDLE_CONNECTION_TIMEOUT                   = 5 * 60;        // seconds, a handshaked peer sends timed sync every P2P_DEFAULT_HANDSHAKE_INTERVAL
+const uint32_t P2P_TX_ANNOUNCE_INTERVAL                      = 2000;          // milliseconds, mean delay of a transaction hashes announcement to a peer
+const size_t   P2P_TX_ANNOUNCE_MAX_COUNT                     = 1000;          // transaction hashes announced to a peer at once
+const size_t   P2P_TX_KNOWN_PER_PEER                         = 50000;         // transactions remembered as known to a peer
+const size_t   P2P_TX_QUEUED_PER_PEER                        = 10000;         // transaction hashes waiting for announcement to a peer, the oldest are dropped beyond it
+const size_t   P2P_TX_REQUESTS_PER_PEER                      = 5000;          // transactions requested from a peer at a time, its further announcements are only remembered
+const size_t   P2P_TX_REQUESTS_MAX_COUNT                     = 50000;         // transactions requested from all peers at a time
+const size_t   P2P_TX_ANNOUNCERS_PER_REQUEST                 = 8;             // peers asked in turn for a transaction whose request times out
+const uint32_t P2P_TX_REQUEST_TIMEOUT                        = 10;            // seconds, announced transaction is requested from another peer after it
+const uint32_t P2P_TX_RELAY_INTERVAL                         = 100;           // milliseconds, announcement timers are checked that often
+const uint32_t P2P_BLOCK_TXS_REQUEST_TIMEOUT                 = 5;             // seconds, a compact block is fetched by synchronization if its missing transactions don't arrive by then
+const size_t   P2P_PEER_SCORES_LIMIT                         = 2000;          // peers whose measurements are remembered
 const char     P2P_STAT_TRUSTED_PUB_KEY[]                    = "0000000000000000000000000000000000000000000000000000000000000000";
 
 const std::initializer_list<const char*> SEED_NODES = {
@@ -313,6 +313,7 @@ m_tx_pool(tx_pool),
 m_current_block_cumul_sz_limit(0),
 m_is_in_checkpoint_zone(false),
 m_checkpoints(logger),
+m_serializedBlocks(parameters::CRYPTONOTE_BLOCK_BLOB_CACHE_MAX_SIZE),
 m_upgradeDetector(currency, m_blocks, BLOCK_MAJOR_VERSION_2, logger) {
 
   m_outputs.set_deleted_key(0);
@@ -429,6 +430,7 @@ bool Blockchain::init(const std::string& config_folder, bool load_existing) {
     loadBlockchainIndices();
   } else {
     m_blocks.clear();
+    m_serializedBlocks.clear();
   }
 
   if (m_blocks.empty()) {
@@ -548,6 +550,7 @@ bool Blockchain::resetAndSetGenesisBlock(const Block& b) {
   std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   m_blocks.clear();
   m_blockIndex.clear();
+  m_serializedBlocks.clear();
   m_transactionMap.clear();
 
   m_spent_keys.clear();
@@ -625,6 +628,51 @@ Crypto::Hash Blockchain::getBlockIdByHeight(uint32_t height) {
   return m_blockIndex.getBlockId(height);
 }
 
+std::shared_ptr<const SerializedBlock> Blockchain::getSerializedBlock(const Crypto::Hash& blockHash) {
+  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  uint32_t height;
+  if (!m_blockIndex.getBlockHeight(blockHash, height)) {
+    return nullptr;
+  }
+
+  return serializeBlock(height, blockHash);
+}
+
+std::shared_ptr<const SerializedBlock> Blockchain::getSerializedBlock(uint32_t height) {
+  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  if (height >= m_blocks.size()) {
+    return nullptr;
+  }
+
+  return serializeBlock(height, m_blockIndex.getBlockId(height));
+}
+
+uint64_t Blockchain::getBlockTimestamp(uint32_t height) {
+  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  assert(height < m_blocks.size());
+  return m_blocks[height].bl.timestamp;
+}
+
+std::shared_ptr<const SerializedBlock> Blockchain::serializeBlock(uint32_t height, const Crypto::Hash& blockHash) {
+  auto block = m_serializedBlocks.find(blockHash);
+  if (block != nullptr) {
+    return block;
+  }
+
+  const BlockEntry& entry = m_blocks[height];
+  auto serialized = std::make_shared<SerializedBlock>();
+  serialized->timestamp = entry.bl.timestamp;
+  serialized->block = asString(toBinaryArray(entry.bl));
+  // the base transaction is a part of the block blob
+  serialized->transactions.reserve(entry.transactions.size() - 1);
+  for (size_t i = 1; i < entry.transactions.size(); ++i) {
+    serialized->transactions.push_back(asString(toBinaryArray(entry.transactions[i].tx)));
+  }
+
+  m_serializedBlocks.insert(blockHash, serialized);
+  return serialized;
+}
+
 bool Blockchain::getBlockByHash(const Crypto::Hash& blockHash, Block& b) {
   std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
 
@@ -1163,22 +1211,17 @@ bool Blockchain::getBlocks(uint32_t start_offset, uint32_t count, std::list<Bloc
 bool Blockchain::handleGetObjects(NOTIFY_REQUEST_GET_OBJECTS::request& arg, NOTIFY_RESPONSE_GET_OBJECTS::request& rsp) { //Deprecated. Should be removed with CryptoNoteProtocolHandler.
   std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   rsp.current_blockchain_height = getCurrentBlockchainHeight();
-  std::list<Block> blocks;
-  getBlocks(arg.blocks, blocks, rsp.missed_ids);
-
-  for (const auto& bl : blocks) {
-    std::list<Crypto::Hash> missed_tx_id;
-    std::list<Transaction> txs;
-    getTransactions(bl.transactionHashes, txs, rsp.missed_ids);
-    if (!(!missed_tx_id.size())) { logger(ERROR, BRIGHT_RED) << "Internal error: have missed missed_tx_id.size()=" << missed_tx_id.size() << ENDL << "for block id = " << get_block_hash(bl); return false; } //WTF???
+  for (const auto& blockHash : arg.blocks) {
+    auto block = getSerializedBlock(blockHash);
+    if (block == nullptr) {
+      rsp.missed_ids.push_back(blockHash);
+      continue;
+    }
+
     rsp.blocks.push_back(block_complete_entry());
     block_complete_entry& e = rsp.blocks.back();
-    //pack block
-    e.block = asString(toBinaryArray(bl));
-    //pack transactions
-    for (Transaction& tx : txs) {
-      e.txs.push_back(asString(toBinaryArray(tx)));
-    }
+    e.block = block->block;
+    e.txs.assign(block->transactions.begin(), block->transactions.end());
   }
 
   //get another transactions, if need
@@ -1360,6 +1403,23 @@ std::vector<Crypto::Hash> Blockchain::findBlockchainSupplement(const std::vector
   return m_blockIndex.getBlockIds(startBlockIndex, static_cast<uint32_t>(maxCount));
 }
 
+bool Blockchain::checkBlockProofOfWork(const Block& block) {
+  difficulty_type currentDifficulty;
+  {
+    std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+    if (m_blocks.empty() || block.previousBlockHash != getTailId() || m_checkpoints.is_in_checkpoint_zone(getCurrentBlockchainHeight())) {
+      return false;
+    }
+
+    currentDifficulty = getDifficultyForNextBlock();
+  }
+
+  // the slow hash is computed without the lock, so it doesn't wait for the validation of another block
+  Crypto::cn_context context;
+  Crypto::Hash proofOfWork = NULL_HASH;
+  return currentDifficulty != 0 && m_currency.checkProofOfWork(context, block, currentDifficulty, proofOfWork);
+}
+
 bool Blockchain::haveBlock(const Crypto::Hash& id) {
   std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   if (m_blockIndex.hasBlock(id))
@@ -1511,11 +1571,27 @@ bool Blockchain::is_tx_spendtime_unlocked(uint64_t unlock_time) {
 bool Blockchain::check_tx_input(const KeyInput& txin, const Crypto::Hash& tx_prefix_hash, const std::vector<Crypto::Signature>& sig, uint32_t* pmax_related_block_height) {
   std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
 
+  std::vector<Crypto::PublicKey> output_keys;
+  if (!getRingPublicKeys(txin, output_keys, pmax_related_block_height)) {
+    return false;
+  }
+
+  if (!(sig.size() == output_keys.size())) { logger(ERROR, BRIGHT_RED) << "internal error: tx signatures count=" << sig.size() << " mismatch with outputs keys count for inputs=" << output_keys.size(); return false; }
+  if (m_is_in_checkpoint_zone) {
+    return true;
+  }
+
+  return checkRingSignature(txin, tx_prefix_hash, output_keys, sig);
+}
+
+bool Blockchain::getRingPublicKeys(const KeyInput& txin, std::vector<Crypto::PublicKey>& output_keys, uint32_t* pmax_related_block_height) {
+  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+
   struct outputs_visitor {
-    std::vector<const Crypto::PublicKey *>& m_results_collector;
+    std::vector<Crypto::PublicKey>& m_results_collector;
     Blockchain& m_bch;
     LoggerRef logger;
-    outputs_visitor(std::vector<const Crypto::PublicKey *>& results_collector, Blockchain& bch, ILogger& logger) :m_results_collector(results_collector), m_bch(bch), logger(logger, "outputs_visitor") {
+    outputs_visitor(std::vector<Crypto::PublicKey>& results_collector, Blockchain& bch, ILogger& logger) :m_results_collector(results_collector), m_bch(bch), logger(logger, "outputs_visitor") {
     }
 
     bool handle_output(const Transaction& tx, const TransactionOutput& out, size_t transactionOutputIndex) {
@@ -1532,13 +1608,11 @@ bool Blockchain::check_tx_input(const KeyInput& txin, const Crypto::Hash& tx_pre
         return false;
       }
 
-      m_results_collector.push_back(&boost::get<KeyOutput>(out.target).key);
+      m_results_collector.push_back(boost::get<KeyOutput>(out.target).key);
       return true;
     }
   };
 
-  //check ring signature
-  std::vector<const Crypto::PublicKey *> output_keys;
   outputs_visitor vi(output_keys, *this, logger.getLogger());
   if (!scanOutputKeysForIndexes(txin, vi, pmax_related_block_height)) {
     logger(INFO, BRIGHT_WHITE) <<
@@ -1553,18 +1627,99 @@ bool Blockchain::check_tx_input(const KeyInput& txin, const Crypto::Hash& tx_pre
     return false;
   }
 
-  if (!(sig.size() == output_keys.size())) { logger(ERROR, BRIGHT_RED) << "internal error: tx signatures count=" << sig.size() << " mismatch with outputs keys count for inputs=" << output_keys.size(); return false; }
-  if (m_is_in_checkpoint_zone) {
-    return true;
-  }
+  return true;
+}
 
+/**
+* \pre ring members are resolved, m_blockchain_lock is not required
+*/
+bool Blockchain::checkRingSignature(const KeyInput& txin, const Crypto::Hash& tx_prefix_hash, const std::vector<Crypto::PublicKey>& output_keys, const std::vector<Crypto::Signature>& sig) {
   static const Crypto::KeyImage I = { {0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 } };
   static const Crypto::KeyImage L = { {0xed, 0xd3, 0xf5, 0x5c, 0x1a, 0x63, 0x12, 0x58, 0xd6, 0x9c, 0xf7, 0xa2, 0xde, 0xf9, 0xde, 0x14, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10 } };
   if (!(scalarmultKey(txin.keyImage, L) == I)) {
     return false;
   }
 
-  return Crypto::check_ring_signature(tx_prefix_hash, txin.keyImage, output_keys, sig.data());
+  std::vector<const Crypto::PublicKey*> output_keys_ptrs;
+  output_keys_ptrs.reserve(output_keys.size());
+  for (const auto& key : output_keys) {
+    output_keys_ptrs.push_back(&key);
+  }
+
+  return Crypto::check_ring_signature(tx_prefix_hash, txin.keyImage, output_keys_ptrs, sig.data());
+}
+
+bool Blockchain::verifyTransactionInputs(const Transaction& tx, BlockInfo& maxUsedBlock) {
+  Crypto::Hash transactionHash = getObjectHash(tx);
+  Crypto::Hash tx_prefix_hash = getObjectHash(*static_cast<const TransactionPrefix*>(&tx));
+  std::vector<std::vector<Crypto::PublicKey>> rings;
+  bool inCheckpointZone;
+
+  {
+    std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+
+    maxUsedBlock.height = 0;
+    size_t inputIndex = 0;
+    for (const auto& txin : tx.inputs) {
+      assert(inputIndex < tx.signatures.size());
+      if (txin.type() == typeid(KeyInput)) {
+        const KeyInput& in_to_key = boost::get<KeyInput>(txin);
+        if (in_to_key.outputIndexes.empty()) { logger(ERROR, BRIGHT_RED) << "empty in_to_key.outputIndexes in transaction with id " << transactionHash; return false; }
+
+        if (have_tx_keyimg_as_spent(in_to_key.keyImage)) {
+          logger(DEBUGGING) <<
+            "Key image already spent in blockchain: " << Common::podToHex(in_to_key.keyImage);
+          return false;
+        }
+
+        rings.emplace_back();
+        if (!getRingPublicKeys(in_to_key, rings.back(), &maxUsedBlock.height)) {
+          logger(INFO, BRIGHT_WHITE) <<
+            "Failed to check ring signature for tx " << transactionHash;
+          return false;
+        }
+
+        if (!(tx.signatures[inputIndex].size() == rings.back().size())) { logger(ERROR, BRIGHT_RED) << "internal error: tx signatures count=" << tx.signatures[inputIndex].size() << " mismatch with outputs keys count for inputs=" << rings.back().size(); return false; }
+      } else if (txin.type() == typeid(MultisignatureInput)) {
+        if (!validateInput(::boost::get<MultisignatureInput>(txin), transactionHash, tx_prefix_hash, tx.signatures[inputIndex])) {
+          return false;
+        }
+      } else {
+        logger(INFO, BRIGHT_WHITE) <<
+          "Transaction << " << transactionHash << " contains input of unsupported type.";
+        return false;
+      }
+
+      ++inputIndex;
+    }
+
+    if (!check_tx_outputs(tx)) {
+      return false;
+    }
+
+    if (!(maxUsedBlock.height < m_blocks.size())) { logger(ERROR, BRIGHT_RED) << "internal error: max used block index=" << maxUsedBlock.height << " is not less then blockchain size = " << m_blocks.size(); return false; }
+    get_block_hash(m_blocks[maxUsedBlock.height].bl, maxUsedBlock.id);
+    inCheckpointZone = m_is_in_checkpoint_zone;
+  }
+
+  if (inCheckpointZone) {
+    return true;
+  }
+
+  size_t ringIndex = 0;
+  for (size_t inputIndex = 0; inputIndex < tx.inputs.size(); ++inputIndex) {
+    if (tx.inputs[inputIndex].type() != typeid(KeyInput)) {
+      continue;
+    }
+
+    if (!checkRingSignature(boost::get<KeyInput>(tx.inputs[inputIndex]), tx_prefix_hash, rings[ringIndex++], tx.signatures[inputIndex])) {
+      logger(INFO, BRIGHT_WHITE) <<
+        "Failed to check ring signature for tx " << transactionHash;
+      return false;
+    }
+  }
+
+  return true;
 }
 
 uint64_t Blockchain::get_adjusted_time() {
@@ -1997,6 +2152,7 @@ void Blockchain::popBlock(const Crypto::Hash& blockHash) {
   m_depositIndex.popBlock();
   m_blocks.pop_back();
   m_blockIndex.pop();
+  m_serializedBlocks.remove(blockHash);
 
   assert(m_blockIndex.size() == m_blocks.size());
 
@@ -29,6 +29,7 @@
 #include "CryptoNoteCore/MessageQueue.h"
 #include "CryptoNoteCore/BlockchainMessages.h"
 #include "CryptoNoteCore/IntrusiveLinkedList.h"
+#include "CryptoNoteCore/SerializedBlockCache.h"
 
 #include <Logging/LoggerRef.h>
 
@@ -70,6 +71,11 @@ namespace CryptoNote {
     Crypto::Hash getBlockIdByHeight(uint32_t height);
     bool getBlockByHash(const Crypto::Hash &h, Block &blk);
     bool getBlockHeight(const Crypto::Hash& blockId, uint32_t& blockHeight);
+    // nullptr when the block isn't in the main chain
+    std::shared_ptr<const SerializedBlock> getSerializedBlock(const Crypto::Hash& blockHash);
+    std::shared_ptr<const SerializedBlock> getSerializedBlock(uint32_t height);
+    // of a main chain block, read without serializing the block
+    uint64_t getBlockTimestamp(uint32_t height);
 
     template<class archive_t> void serialize(archive_t & ar, const unsigned int version);
 
@@ -83,6 +89,9 @@ namespace CryptoNote {
     uint64_t getCoinsInCirculation();
     uint8_t get_block_major_version_for_height(uint64_t height) const;
     bool addNewBlock(const Block& bl_, block_verification_context& bvc);
+    // block builds on the tail and its proof of work meets the next difficulty, nothing else is checked.
+    // The lock is held only to read the tail, so the hash may be computed in parallel with block validation
+    bool checkBlockProofOfWork(const Block& block);
     bool resetAndSetGenesisBlock(const Block& b);
     bool haveBlock(const Crypto::Hash& id);
     size_t getTotalTransactions();
@@ -97,6 +106,9 @@ namespace CryptoNote {
     bool getTransactionOutputGlobalIndexes(const Crypto::Hash& tx_id, std::vector<uint32_t>& indexs);
     bool get_out_by_msig_gindex(uint64_t amount, uint64_t gindex, MultisignatureOutput& out);
     bool checkTransactionInputs(const Transaction& tx, uint32_t& pmax_used_block_height, Crypto::Hash& max_used_block_id, BlockInfo* tail = 0);
+    // Same checks as checkTransactionInputs, but ring signatures are checked after m_blockchain_lock is released,
+    // so that several transactions can be verified in parallel
+    bool verifyTransactionInputs(const Transaction& tx, BlockInfo& maxUsedBlock);
     uint64_t getCurrentCumulativeBlocksizeLimit();
     uint64_t blockDifficulty(size_t i);
     bool getBlockContainingTransaction(const Crypto::Hash& txId, Crypto::Hash& blockId, uint32_t& blockHeight);
@@ -255,6 +267,7 @@ namespace CryptoNote {
 
     Blocks m_blocks;
     CryptoNote::BlockIndex m_blockIndex;
+    SerializedBlockCache m_serializedBlocks;
     CryptoNote::DepositIndex m_depositIndex;
     TransactionMap m_transactionMap;
     MultisignatureOutputsContainer m_multisignatureOutputs;
@@ -288,10 +301,13 @@ namespace CryptoNote {
     bool complete_timestamps_vector(uint64_t start_height, std::vector<uint64_t>& timestamps);
     bool checkBlockVersion(const Block& b, const Crypto::Hash& blockHash);
     bool checkCumulativeBlockSize(const Crypto::Hash& blockId, size_t cumulativeBlockSize, uint64_t height);
+    std::shared_ptr<const SerializedBlock> serializeBlock(uint32_t height, const Crypto::Hash& blockHash);
     std::vector<Crypto::Hash> doBuildSparseChain(const Crypto::Hash& startBlockId) const;
     bool getBlockCumulativeSize(const Block& block, size_t& cumulativeSize);
     bool update_next_comulative_size_limit();
     bool check_tx_input(const KeyInput& txin, const Crypto::Hash& tx_prefix_hash, const std::vector<Crypto::Signature>& sig, uint32_t* pmax_related_block_height = NULL);
+    bool getRingPublicKeys(const KeyInput& txin, std::vector<Crypto::PublicKey>& output_keys, uint32_t* pmax_related_block_height);
+    bool checkRingSignature(const KeyInput& txin, const Crypto::Hash& tx_prefix_hash, const std::vector<Crypto::PublicKey>& output_keys, const std::vector<Crypto::Signature>& sig);
     bool checkTransactionInputs(const Transaction& tx, const Crypto::Hash& tx_prefix_hash, uint32_t* pmax_used_block_height = NULL);
     bool checkTransactionInputs(const Transaction& tx, uint32_t* pmax_used_block_height = NULL);
     bool check_tx_outputs(const Transaction& tx) const;
@@ -8,6 +8,7 @@
 #include "Core.h"
 
 #include <sstream>
+#include <thread>
 #include <unordered_set>
 #include "../CryptoNoteConfig.h"
 #include "../Common/CommandLine.h"
@@ -119,6 +120,7 @@ size_t core::get_alternative_blocks_count() {
   //-----------------------------------------------------------------------------------------------
   bool core::init(const CoreConfig& config, const MinerConfig& minerConfig, bool load_existing) {
     m_config_folder = config.configFolder;
+    m_mempool.setMaxPoolSize(static_cast<size_t>(config.mempoolMaxSize));
     bool r = m_mempool.init(m_config_folder);
   if (!(r)) { logger(ERROR, BRIGHT_RED) << "Failed to initialize memory pool"; return false; }
 
@@ -128,6 +130,7 @@ size_t core::get_alternative_blocks_count() {
     r = m_miner->init(minerConfig);
   if (!(r)) { logger(ERROR, BRIGHT_RED) << "Failed to initialize blockchain storage"; return false; }
 
+  m_verificationPool.start(std::max(1u, std::thread::hardware_concurrency()));
   return load_state_data();
 }
 
@@ -142,6 +145,7 @@ bool core::load_state_data() {
 
 bool core::deinit() {
   m_miner->stop();
+  m_verificationPool.stop();
   m_mempool.deinit();
   m_blockchain.deinit();
   return true;
@@ -295,7 +299,7 @@ size_t core::get_blockchain_total_transactions() {
 //  return m_blockchain.get_outs(amount, pkeys);
 //}
 
-bool core::add_new_tx(const Transaction& tx, const Crypto::Hash& tx_hash, size_t blob_size, tx_verification_context& tvc, bool keeped_by_block, uint32_t height) {
+bool core::add_new_tx(const Transaction& tx, const Crypto::Hash& tx_hash, size_t blob_size, tx_verification_context& tvc, bool keeped_by_block, uint32_t height, const BlockInfo* verifiedMaxUsedBlock) {
   //Locking on m_mempool and m_blockchain closes possibility to add tx to memory pool which is already in blockchain 
   std::lock_guard<decltype(m_mempool)> lk(m_mempool);
   LockedBlockchainStorage lbs(m_blockchain);
@@ -309,7 +313,7 @@ bool core::add_new_tx(const Transaction& tx, const Crypto::Hash& tx_hash, size_t
     logger(TRACE) << "tx " << tx_hash << " is already in transaction pool";
     return true;
   }
-  return m_mempool.add_tx(tx, tx_hash, blob_size, tvc, keeped_by_block, height);
+  return m_mempool.add_tx(tx, tx_hash, blob_size, tvc, keeped_by_block, height, verifiedMaxUsedBlock);
 }
 
 bool core::get_block_template(Block& b, const AccountPublicAddress& adr, difficulty_type& diffic, uint32_t& height, const BinaryArray& ex_nonce) {
@@ -503,6 +507,10 @@ bool core::handle_incoming_block_blob(const BinaryArray& block_blob, block_verif
   return handle_incoming_block(b, bvc, control_miner, relay_block);
 }
 
+bool core::checkBlockProofOfWork(const Block& block) {
+  return m_blockchain.checkBlockProofOfWork(block);
+}
+
 bool core::handle_incoming_block(const Block& b, block_verification_context& bvc, bool control_miner, bool relay_block) {
   if (control_miner) {
     pause_mining();
@@ -552,10 +560,18 @@ size_t core::get_pool_transactions_count() {
   return m_mempool.get_transactions_count();
 }
 
+tx_memory_pool::PoolStatistics core::getPoolStatistics() {
+  return m_mempool.getStatistics();
+}
+
 bool core::have_block(const Crypto::Hash& id) {
   return m_blockchain.haveBlock(id);
 }
 
+bool core::haveTransaction(const Crypto::Hash& id) {
+  return m_mempool.have_tx(id) || m_blockchain.haveTransaction(id);
+}
+
 bool core::parse_tx_from_blob(Transaction& tx, Crypto::Hash& tx_hash, Crypto::Hash& tx_prefix_hash, const BinaryArray& blob) {
   return parseAndValidateTransactionFromBinaryArray(blob, tx, tx_hash, tx_prefix_hash);
 }
@@ -698,26 +714,19 @@ bool core::queryBlocks(const std::vector<Crypto::Hash>& knownBlockIds, uint64_t
     return true;
   }
 
-  std::list<Block> blocks;
-  lbs->getBlocks(startFullOffset, blocksLeft, blocks);
-
-  for (auto& b : blocks) {
+  uint32_t endHeight = std::min(startFullOffset + blocksLeft, currentHeight);
+  for (uint32_t height = startFullOffset; height < endHeight; ++height) {
     BlockFullInfo item;
+    item.block_id = lbs->getBlockIdByHeight(height);
 
-    item.block_id = get_block_hash(b);
-
-    if (b.timestamp >= timestamp) {
-      // query transactions
-      std::list<Transaction> txs;
-      std::list<Crypto::Hash> missedTxs;
-      lbs->getTransactions(b.transactionHashes, txs, missedTxs);
+    // only the blobs sent are serialized and cached
+    if (lbs->getBlockTimestamp(height) >= timestamp) {
+      auto block = lbs->getSerializedBlock(height);
+      assert(block != nullptr);
 
-      // fill data
       block_complete_entry& completeEntry = item;
-      completeEntry.block = asString(toBinaryArray(b));
-      for (auto& tx : txs) {
-        completeEntry.txs.push_back(asString(toBinaryArray(tx)));
-      }
+      completeEntry.block = block->block;
+      completeEntry.txs.assign(block->transactions.begin(), block->transactions.end());
     }
 
     entries.push_back(std::move(item));
@@ -981,6 +990,98 @@ bool core::handleIncomingTransaction(const Transaction& tx, const Crypto::Hash&
   }
 
   bool r = add_new_tx(tx, txHash, blobSize, tvc, keptByBlock, height);
+  logTransactionVerification(txHash, tvc);
+  if (tvc.m_added_to_pool) {
+    poolUpdated();
+  }
+
+  return r;
+}
+
+void core::handleIncomingTransactions(const std::vector<BinaryArray>& txBlobs, std::vector<tx_verification_context>& tvcs) {
+  struct IncomingTransaction {
+    size_t index;
+    Transaction tx;
+    Crypto::Hash hash;
+    uint32_t height;
+    BlockInfo maxUsedBlock;
+    bool inputsValid;
+  };
+
+  tvcs.assign(txBlobs.size(), boost::value_initialized<tx_verification_context>());
+
+  // cheap checks and de-duplication, in the calling thread
+  std::vector<IncomingTransaction> transactions;
+  transactions.reserve(txBlobs.size());
+  std::unordered_set<Crypto::Hash> batchHashes;
+  uint32_t currentHeight = get_current_blockchain_height();
+  for (size_t i = 0; i < txBlobs.size(); ++i) {
+    tx_verification_context& tvc = tvcs[i];
+    if (txBlobs[i].size() > m_currency.maxTxSize()) {
+      logger(INFO) << "WRONG TRANSACTION BLOB, too big size " << txBlobs[i].size() << ", rejected";
+      tvc.m_verifivation_failed = true;
+      continue;
+    }
+
+    // the hash of a transaction is the hash of its blob, known ones are skipped before parsing
+    Crypto::Hash blobHash = getBinaryArrayHash(txBlobs[i]);
+    if (!batchHashes.insert(blobHash).second || m_mempool.have_tx(blobHash) || m_blockchain.haveTransaction(blobHash)) {
+      logger(TRACE) << "tx " << blobHash << " is already known";
+      continue;
+    }
+
+    IncomingTransaction incoming;
+    incoming.index = i;
+    incoming.height = currentHeight;
+    incoming.inputsValid = false;
+    Crypto::Hash prefixHash;
+    if (!parse_tx_from_blob(incoming.tx, incoming.hash, prefixHash, txBlobs[i])) {
+      logger(INFO) << "WRONG TRANSACTION BLOB, Failed to parse, rejected";
+      tvc.m_verifivation_failed = true;
+      continue;
+    }
+
+    if (!check_tx_syntax(incoming.tx)) {
+      logger(INFO) << "WRONG TRANSACTION BLOB, Failed to check tx " << incoming.hash << " syntax, rejected";
+      tvc.m_verifivation_failed = true;
+      continue;
+    }
+
+    if (!check_tx_semantic(incoming.tx, false, incoming.height)) {
+      logger(INFO) << "WRONG TRANSACTION BLOB, Failed to check tx " << incoming.hash << " semantic, rejected";
+      tvc.m_verifivation_failed = true;
+      continue;
+    }
+
+    transactions.push_back(std::move(incoming));
+  }
+
+  // ring signatures, spread over the verification pool
+  m_verificationPool.run(transactions.size(), [this, &transactions](size_t i) {
+    transactions[i].inputsValid = m_blockchain.verifyTransactionInputs(transactions[i].tx, transactions[i].maxUsedBlock);
+  });
+
+  // insertion under pool and blockchain locks
+  bool poolChanged = false;
+  for (auto& incoming : transactions) {
+    tx_verification_context& tvc = tvcs[incoming.index];
+    if (!incoming.inputsValid) {
+      logger(INFO) << "tx used wrong inputs, rejected";
+      tvc.m_verifivation_failed = true;
+    } else {
+      add_new_tx(incoming.tx, incoming.hash, txBlobs[incoming.index].size(), tvc, false, incoming.height, &incoming.maxUsedBlock);
+    }
+
+    logTransactionVerification(incoming.hash, tvc);
+    poolChanged = poolChanged || tvc.m_added_to_pool;
+  }
+
+  if (poolChanged) {
+    poolUpdated();
+  }
+}
+
+void core::logTransactionVerification(const Crypto::Hash& txHash, const tx_verification_context& tvc) {
   if (tvc.m_verifivation_failed) {
     if (!tvc.m_tx_fee_too_small) {
       logger(ERROR) << "Transaction verification failed: " << txHash;
@@ -993,10 +1094,11 @@ bool core::handleIncomingTransaction(const Transaction& tx, const Crypto::Hash&
 
   if (tvc.m_added_to_pool) {
     logger(DEBUGGING) << "tx added: " << txHash;
-    poolUpdated();
   }
+}
 
-  return r;
+std::shared_ptr<const SerializedBlock> core::getSerializedBlock(const Crypto::Hash& blockId) {
+  return m_blockchain.getSerializedBlock(blockId);
 }
 
 std::unique_ptr<IBlock> core::getBlock(const Crypto::Hash& blockId) {
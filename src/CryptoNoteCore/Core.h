@@ -17,6 +17,7 @@
 #include "Blockchain.h"
 #include "CryptoNoteCore/IMinerHandler.h"
 #include "CryptoNoteCore/MinerConfig.h"
+#include "CryptoNoteCore/VerificationPool.h"
 #include "ICore.h"
 #include "ICoreObserver.h"
 #include "Common/ObserverManager.h"
@@ -41,6 +42,7 @@ namespace CryptoNote {
      bool on_idle() override;
      virtual bool handle_incoming_tx(const BinaryArray& tx_blob, tx_verification_context& tvc, bool keeped_by_block) override; //Deprecated. Should be removed with CryptoNoteProtocolHandler.
      bool handle_incoming_block_blob(const BinaryArray& block_blob, block_verification_context& bvc, bool control_miner, bool relay_block) override;
+     bool checkBlockProofOfWork(const Block& block) override;
      virtual i_cryptonote_protocol* get_protocol() override {return m_pprotocol;}
      virtual const Currency& currency() const override { return m_currency; }
 
@@ -76,7 +78,10 @@ namespace CryptoNote {
      virtual bool getTransactionsByPaymentId(const Crypto::Hash& paymentId, std::vector<Transaction>& transactions) override;
      virtual bool getOutByMSigGIndex(uint64_t amount, uint64_t gindex, MultisignatureOutput& out) override;
      virtual std::unique_ptr<IBlock> getBlock(const Crypto::Hash& blocksId) override;
+     // blobs of a main chain block, nullptr for any other block
+     std::shared_ptr<const SerializedBlock> getSerializedBlock(const Crypto::Hash& blockId);
      virtual bool handleIncomingTransaction(const Transaction& tx, const Crypto::Hash& txHash, size_t blobSize, tx_verification_context& tvc, bool keptByBlock, uint32_t height) override;
+     virtual void handleIncomingTransactions(const std::vector<BinaryArray>& txBlobs, std::vector<tx_verification_context>& tvcs) override;
      virtual std::error_code executeLocked(const std::function<std::error_code()>& func) override;
      
      virtual bool addMessageQueue(MessageQueue<BlockchainMessage>& messageQueue) override;
@@ -84,6 +89,7 @@ namespace CryptoNote {
 
      uint32_t get_current_blockchain_height();
      bool have_block(const Crypto::Hash& id) override;
+     bool haveTransaction(const Crypto::Hash& id) override;
      std::vector<Crypto::Hash> buildSparseChain() override;
      std::vector<Crypto::Hash> buildSparseChain(const Crypto::Hash& startBlockId) override;
      void on_synchronized() override;
@@ -116,6 +122,7 @@ namespace CryptoNote {
 
      std::vector<Transaction> getPoolTransactions() override;
      size_t get_pool_transactions_count();
+     tx_memory_pool::PoolStatistics getPoolStatistics();
      size_t get_blockchain_total_transactions();
      //bool get_outs(uint64_t amount, std::list<Crypto::PublicKey>& pkeys);
      virtual std::vector<Crypto::Hash> findBlockchainSupplement(const std::vector<Crypto::Hash>& remoteBlockIds, size_t maxCount,
@@ -148,7 +155,8 @@ namespace CryptoNote {
      uint64_t depositInterestAtHeight(size_t height) const;
 
    private:
-     bool add_new_tx(const Transaction& tx, const Crypto::Hash& tx_hash, size_t blob_size, tx_verification_context& tvc, bool keeped_by_block, uint32_t height);
+     bool add_new_tx(const Transaction& tx, const Crypto::Hash& tx_hash, size_t blob_size, tx_verification_context& tvc, bool keeped_by_block, uint32_t height, const BlockInfo* verifiedMaxUsedBlock = nullptr);
+     void logTransactionVerification(const Crypto::Hash& txHash, const tx_verification_context& tvc);
      bool load_state_data();
      bool parse_tx_from_blob(Transaction& tx, Crypto::Hash& tx_hash, Crypto::Hash& tx_prefix_hash, const BinaryArray& blob);
      bool handle_incoming_block(const Block& b, block_verification_context& bvc, bool control_miner, bool relay_block);
@@ -185,5 +193,7 @@ namespace CryptoNote {
      friend class tx_validate_inputs;
      std::atomic<bool> m_starter_message_showed;
      Tools::ObserverManager<ICoreObserver> m_observerManager;
+     // ring signatures of incoming transactions, shared by the batches of all connections
+     VerificationPool m_verificationPool;
    };
 }
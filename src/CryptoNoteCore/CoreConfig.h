@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <cstdint>
 #include <string>
 
 #include <boost/program_options.hpp>
@@ -22,6 +23,7 @@ public:
 
   std::string configFolder;
   bool configFolderDefaulted = true;
+  uint64_t mempoolMaxSize;
 };
 
 } //namespace CryptoNote
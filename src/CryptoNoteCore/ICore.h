@@ -51,6 +51,8 @@ public:
   virtual bool removeObserver(ICoreObserver* observer) = 0;
 
   virtual bool have_block(const Crypto::Hash& id) = 0;
+  // in the blockchain or in the pool
+  virtual bool haveTransaction(const Crypto::Hash& id) = 0;
   virtual std::vector<Crypto::Hash> buildSparseChain() = 0;
   virtual std::vector<Crypto::Hash> buildSparseChain(const Crypto::Hash& startBlockId) = 0;
   virtual bool get_stat_info(CryptoNote::core_stat_info& st_inf) = 0;
@@ -58,6 +60,8 @@ public:
   virtual void pause_mining() = 0;
   virtual void update_block_template_and_resume_mining() = 0;
   virtual bool handle_incoming_block_blob(const CryptoNote::BinaryArray& block_blob, CryptoNote::block_verification_context& bvc, bool control_miner, bool relay_block) = 0;
+  // cheap check of a new block before its full validation: it extends the main chain and has enough proof of work
+  virtual bool checkBlockProofOfWork(const Block& block) = 0;
   virtual bool handle_get_objects(NOTIFY_REQUEST_GET_OBJECTS_request& arg, NOTIFY_RESPONSE_GET_OBJECTS_request& rsp) = 0; //Deprecated. Should be removed with CryptoNoteProtocolHandler.
   virtual void on_synchronized() = 0;
   virtual size_t addChain(const std::vector<const IBlock*>& chain) = 0;
@@ -104,6 +108,8 @@ public:
 
   virtual std::unique_ptr<IBlock> getBlock(const Crypto::Hash& blocksId) = 0;
   virtual bool handleIncomingTransaction(const Transaction& tx, const Crypto::Hash& txHash, size_t blobSize, tx_verification_context& tvc, bool keptByBlock, uint32_t height) = 0;
+  // Admits a batch of relayed transactions, ring signatures are checked in parallel. tvcs receives one result per blob.
+  virtual void handleIncomingTransactions(const std::vector<BinaryArray>& txBlobs, std::vector<tx_verification_context>& tvcs) = 0;
   virtual std::error_code executeLocked(const std::function<std::error_code()>& func) = 0;
 
   virtual bool addMessageQueue(MessageQueue<BlockchainMessage>& messageQueue) = 0;
@@ -38,15 +38,20 @@ namespace CryptoNote
     m_stop(true),
     m_template(boost::value_initialized<Block>()),
     m_template_no(0),
+    m_template_time(0),
     m_diffic(0),
     m_handler(handler),
     m_pausers_count(0),
     m_threads_total(0),
     m_starter_nonce(0),
     m_last_hr_merge_time(0),
-    m_hashes(0),
+    m_blocks_found(0),
+    m_blocks_rejected(0),
+    m_last_template_age(0),
+    m_total_template_age(0),
     m_do_print_hashrate(false),
     m_do_mining(false),
+    m_cpu_affinity(false),
     m_current_hash_rate(0),
     m_update_block_template_interval(5),
     m_update_merge_hr_interval(2)
@@ -56,12 +61,22 @@ namespace CryptoNote
   miner::~miner() {
     stop();
   }
+
+  uint64_t millisecondsSinceEpoch() {
+    auto now = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count();
+  }
+
+  uint64_t microsecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+  }
   //-----------------------------------------------------------------------------------------------------
   bool miner::set_block_template(const Block& bl, const difficulty_type& di) {
     std::lock_guard<decltype(m_template_lock)> lk(m_template_lock);
 
     m_template = bl;
     m_diffic = di;
+    m_template_time = millisecondsSinceEpoch();
     ++m_template_no;
     m_starter_nonce = Crypto::rand<uint32_t>();
     return true;
@@ -115,16 +130,28 @@ namespace CryptoNote
     m_do_print_hashrate = do_hr;
   }
 
-  uint64_t millisecondsSinceEpoch() {
-    auto now = std::chrono::steady_clock::now();
-    return std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count();
-  }
-
   //-----------------------------------------------------------------------------------------------------
   void miner::merge_hr()
   {
-    if(m_last_hr_merge_time && is_mining()) {
-      m_current_hash_rate = m_hashes * 1000 / (millisecondsSinceEpoch() - m_last_hr_merge_time + 1);
+    uint64_t now = millisecondsSinceEpoch();
+    bool merge = m_last_hr_merge_time && is_mining();
+    uint64_t hashes = 0;
+
+    {
+      std::lock_guard<std::mutex> lk(m_statistics_lock);
+      for (auto& thread : m_thread_statistics) {
+        uint64_t threadHashes = thread.hashes;
+        if (merge) {
+          thread.hashRate = (threadHashes - thread.mergedHashes) * 1000 / (now - m_last_hr_merge_time + 1);
+          hashes += threadHashes - thread.mergedHashes;
+        }
+
+        thread.mergedHashes = threadHashes;
+      }
+    }
+
+    if(merge) {
+      m_current_hash_rate = hashes * 1000 / (now - m_last_hr_merge_time + 1);
       std::lock_guard<std::mutex> lk(m_last_hash_rates_lock);
       m_last_hash_rates.push_back(m_current_hash_rate);
       if(m_last_hash_rates.size() > 19)
@@ -137,8 +164,7 @@ namespace CryptoNote
       }
     }
     
-    m_last_hr_merge_time = millisecondsSinceEpoch();
-    m_hashes = 0;
+    m_last_hr_merge_time = now;
   }
 
   bool miner::init(const MinerConfig& config) {
@@ -182,6 +208,14 @@ namespace CryptoNote
       }
     }
 
+    if (config.miningCpuAffinity) {
+      if (m_thread_placement.isAvailable()) {
+        m_cpu_affinity = true;
+      } else {
+        logger(WARNING) << "CPU topology is not available, mining threads won't be pinned";
+      }
+    }
+
     return true;
   }
   //-----------------------------------------------------------------------------------------------------
@@ -208,6 +242,11 @@ namespace CryptoNote
     m_threads_total = static_cast<uint32_t>(threads_count);
     m_starter_nonce = Crypto::rand<uint32_t>();
 
+    {
+      std::lock_guard<std::mutex> statisticsLock(m_statistics_lock);
+      m_thread_statistics = std::vector<ThreadStatistics>(threads_count);
+    }
+
     if (!m_template_no) {
       request_block_template(); //lets update block template
     }
@@ -231,6 +270,30 @@ namespace CryptoNote
       return 0;
   }
   
+  //-----------------------------------------------------------------------------------------------------
+  MinerStatistics miner::getStatistics()
+  {
+    MinerStatistics statistics;
+    statistics.mining = is_mining();
+    statistics.hashRate = get_speed();
+
+    std::lock_guard<std::mutex> lk(m_statistics_lock);
+    for (const auto& thread : m_thread_statistics) {
+      MinerThreadStatistics threadStatistics;
+      threadStatistics.hashes = thread.hashes;
+      threadStatistics.hashRate = statistics.mining ? thread.hashRate : 0;
+      threadStatistics.hashingTime = thread.hashingTime / 1000;
+      threadStatistics.waitingTime = thread.waitingTime / 1000;
+      statistics.threads.push_back(threadStatistics);
+    }
+
+    statistics.blocksFound = m_blocks_found;
+    statistics.blocksRejected = m_blocks_rejected;
+    statistics.lastTemplateAge = m_last_template_age;
+    statistics.averageTemplateAge = averageTemplateAge(m_total_template_age, m_blocks_found, m_blocks_rejected);
+    return statistics;
+  }
+
   //-----------------------------------------------------------------------------------------------------
   void miner::send_stop_signal() 
   {
@@ -341,17 +404,32 @@ namespace CryptoNote
   bool miner::worker_thread(uint32_t th_local_index)
   {
     logger(INFO) << "Miner thread was started ["<< th_local_index << "]";
+    // before the hashing context is created, so its scratchpad is allocated on this CPU's NUMA node
+    if (m_cpu_affinity) {
+      unsigned cpu = m_thread_placement.cpuForThread(th_local_index);
+      if (MinerThreadPlacement::pinCurrentThread(cpu)) {
+        logger(DEBUGGING) << "Miner thread [" << th_local_index << "] pinned to CPU " << cpu;
+      } else {
+        logger(WARNING) << "Failed to pin miner thread [" << th_local_index << "] to CPU " << cpu;
+      }
+    }
+
     uint32_t nonce = m_starter_nonce + th_local_index;
     difficulty_type local_diff = 0;
     uint32_t local_template_ver = 0;
+    uint64_t local_template_time = 0;
     Crypto::cn_context context;
     Block b;
+    ThreadStatistics& statistics = m_thread_statistics[th_local_index];
 
     while(!m_stop)
     {
+      auto iterationStart = std::chrono::steady_clock::now();
+
       if(m_pausers_count) //anti split workaround
       {
         std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        statistics.waitingTime += microsecondsSince(iterationStart);
         continue;
       }
 
@@ -359,6 +437,7 @@ namespace CryptoNote
         std::unique_lock<std::mutex> lk(m_template_lock);
         b = m_template;
         local_diff = m_diffic;
+        local_template_time = m_template_time;
         lk.unlock();
 
         local_template_ver = m_template_no;
@@ -369,6 +448,7 @@ namespace CryptoNote
       {
         logger(TRACE) << "Block template not set yet";
         std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+        statistics.waitingTime += microsecondsSince(iterationStart);
         continue;
       }
 
@@ -379,14 +459,20 @@ namespace CryptoNote
         m_stop = true;
       }
 
-      if (!m_stop && check_hash(h, local_diff))
+      bool found = !m_stop && check_hash(h, local_diff);
+      ++statistics.hashes;
+      statistics.hashingTime += microsecondsSince(iterationStart);
+
+      if (found)
       {
         //we lucky!
         ++m_config.current_extra_message_index;
 
         logger(INFO, GREEN) << "Found block for difficulty: " << local_diff;
 
-        if(!m_handler.handle_block_found(b)) {
+        bool accepted = m_handler.handle_block_found(b);
+        onBlockFound(accepted, local_template_time);
+        if(!accepted) {
           --m_config.current_extra_message_index;
         } else {
           //success update, lets update config
@@ -395,10 +481,24 @@ namespace CryptoNote
       }
 
       nonce += m_threads_total;
-      ++m_hashes;
     }
     logger(INFO) << "Miner thread stopped ["<< th_local_index << "]";
     return true;
   }
   //-----------------------------------------------------------------------------------------------------
+  void miner::onBlockFound(bool accepted, uint64_t templateTime)
+  {
+    uint64_t templateAge = millisecondsSinceEpoch() - templateTime;
+
+    std::lock_guard<std::mutex> lk(m_statistics_lock);
+    if (accepted) {
+      ++m_blocks_found;
+    } else {
+      ++m_blocks_rejected;
+    }
+
+    m_last_template_age = templateAge;
+    m_total_template_age += templateAge;
+  }
+  //-----------------------------------------------------------------------------------------------------
 }
@@ -17,6 +17,8 @@
 #include "CryptoNoteCore/Difficulty.h"
 #include "CryptoNoteCore/IMinerHandler.h"
 #include "CryptoNoteCore/MinerConfig.h"
+#include "CryptoNoteCore/MinerStatistics.h"
+#include "CryptoNoteCore/MinerThreadPlacement.h"
 #include "CryptoNoteCore/OnceInInterval.h"
 
 #include <Logging/LoggerRef.h>
@@ -34,6 +36,7 @@ namespace CryptoNote {
     bool on_block_chain_update();
     bool start(const AccountPublicAddress& adr, size_t threads_count);
     uint64_t get_speed();
+    MinerStatistics getStatistics();
     void send_stop_signal();
     bool stop();
     bool is_mining();
@@ -50,6 +53,18 @@ namespace CryptoNote {
     bool request_block_template();
     void  merge_hr();
 
+    struct ThreadStatistics {
+      std::atomic<uint64_t> hashes;
+      std::atomic<uint64_t> hashingTime; // microseconds
+      std::atomic<uint64_t> waitingTime; // microseconds
+      uint64_t mergedHashes;
+      uint64_t hashRate;
+
+      ThreadStatistics() : hashes(0), hashingTime(0), waitingTime(0), mergedHashes(0), hashRate(0) {}
+    };
+
+    void onBlockFound(bool accepted, uint64_t templateTime);
+
     struct miner_config
     {
       uint64_t current_extra_message_index;
@@ -65,6 +80,7 @@ namespace CryptoNote {
     std::mutex m_template_lock;
     Block m_template;
     std::atomic<uint32_t> m_template_no;
+    std::atomic<uint64_t> m_template_time;
     std::atomic<uint32_t> m_starter_nonce;
     difficulty_type m_diffic;
 
@@ -73,6 +89,8 @@ namespace CryptoNote {
     std::mutex m_miners_count_lock;
 
     std::list<std::thread> m_threads;
+    MinerThreadPlacement m_thread_placement;
+    bool m_cpu_affinity;
     std::mutex m_threads_lock;
     IMinerHandler& m_handler;
     AccountPublicAddress m_mine_address;
@@ -83,8 +101,13 @@ namespace CryptoNote {
     miner_config m_config;
     std::string m_config_folder_path;
     std::atomic<uint64_t> m_last_hr_merge_time;
-    std::atomic<uint64_t> m_hashes;
     std::atomic<uint64_t> m_current_hash_rate;
+    std::mutex m_statistics_lock;
+    std::vector<ThreadStatistics> m_thread_statistics;
+    uint64_t m_blocks_found;
+    uint64_t m_blocks_rejected;
+    uint64_t m_last_template_age;
+    uint64_t m_total_template_age;
     std::mutex m_last_hash_rates_lock;
     std::list<uint64_t> m_last_hash_rates;
     bool m_do_print_hashrate;
@@ -0,0 +1,55 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2014-2017 XDN developers
+// Copyright (c) 2016-2017 BXC developers
+// Copyright (c) 2017 Doppler developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "MinerStatistics.h"
+
+#include <iomanip>
+#include <sstream>
+
+namespace CryptoNote {
+
+namespace {
+
+double hashingShare(const MinerThreadStatistics& thread) {
+  uint64_t total = thread.hashingTime + thread.waitingTime;
+  return total == 0 ? 0.0 : 100.0 * static_cast<double>(thread.hashingTime) / static_cast<double>(total);
+}
+
+}
+
+uint64_t totalHashRate(const std::vector<MinerThreadStatistics>& threads) {
+  uint64_t hashRate = 0;
+  for (const MinerThreadStatistics& thread : threads) {
+    hashRate += thread.hashRate;
+  }
+
+  return hashRate;
+}
+
+uint64_t averageTemplateAge(uint64_t totalTemplateAge, uint64_t blocksFound, uint64_t blocksRejected) {
+  uint64_t blocksTotal = blocksFound + blocksRejected;
+  return blocksTotal == 0 ? 0 : totalTemplateAge / blocksTotal;
+}
+
+std::string printMinerStatistics(const MinerStatistics& statistics) {
+  std::stringstream ss;
+
+  ss << "Mining: " << (statistics.mining ? "yes" : "no") << ", hashrate: " << statistics.hashRate << " H/s" << std::endl;
+  ss << "Blocks found: " << statistics.blocksFound << ", rejected: " << statistics.blocksRejected << std::endl;
+  ss << "Template age at block find: last " << statistics.lastTemplateAge << " ms, average " << statistics.averageTemplateAge << " ms" << std::endl;
+
+  for (size_t i = 0; i < statistics.threads.size(); ++i) {
+    const MinerThreadStatistics& thread = statistics.threads[i];
+    ss << "Thread " << i << ": " << thread.hashRate << " H/s, " << thread.hashes << " hashes, hashing " <<
+      thread.hashingTime << " ms, waiting " << thread.waitingTime << " ms (" <<
+      std::fixed << std::setprecision(1) << hashingShare(thread) << "% busy)" << std::endl;
+  }
+
+  return ss.str();
+}
+
+}
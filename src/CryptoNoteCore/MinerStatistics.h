@@ -0,0 +1,38 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2014-2017 XDN developers
+// Copyright (c) 2016-2017 BXC developers
+// Copyright (c) 2017 Doppler developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace CryptoNote {
+
+struct MinerThreadStatistics {
+  uint64_t hashes;
+  uint64_t hashRate;
+  uint64_t hashingTime; // milliseconds
+  uint64_t waitingTime; // milliseconds spent paused or without a block template
+};
+
+struct MinerStatistics {
+  bool mining;
+  uint64_t hashRate;
+  std::vector<MinerThreadStatistics> threads;
+  uint64_t blocksFound;
+  uint64_t blocksRejected;
+  uint64_t lastTemplateAge;    // milliseconds between receiving a template and finding a block on it
+  uint64_t averageTemplateAge;
+};
+
+uint64_t totalHashRate(const std::vector<MinerThreadStatistics>& threads);
+// milliseconds, 0 until the first block is found or rejected
+uint64_t averageTemplateAge(uint64_t totalTemplateAge, uint64_t blocksFound, uint64_t blocksRejected);
+std::string printMinerStatistics(const MinerStatistics& statistics);
+
+}
@@ -0,0 +1,233 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2014-2017 XDN developers
+// Copyright (c) 2016-2017 BXC developers
+// Copyright (c) 2017 Doppler developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "MinerThreadPlacement.h"
+
+#include <algorithm>
+#include <thread>
+
+#ifdef __linux__
+#include <fstream>
+#include <map>
+#include <sstream>
+
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace CryptoNote {
+
+namespace {
+
+const size_t SCRATCHPAD_SIZE = 2 * 1024 * 1024; // CryptoNight scratchpad, see crypto/slow-hash.c
+const std::string CPU_SYSFS_PATH = "/sys/devices/system/cpu/";
+
+#ifdef __linux__
+
+bool readLine(const std::string& path, std::string& line) {
+  std::ifstream file(path);
+  return static_cast<bool>(std::getline(file, line));
+}
+
+// parses lists like "0-3,8-11"
+std::vector<unsigned> parseCpuList(const std::string& list) {
+  std::vector<unsigned> cpus;
+  std::stringstream ss(list);
+  std::string range;
+  while (std::getline(ss, range, ',')) {
+    unsigned first;
+    unsigned last;
+    char dash;
+    std::stringstream rangeStream(range);
+    if (!(rangeStream >> first)) {
+      continue;
+    }
+
+    if (!(rangeStream >> dash >> last)) {
+      last = first;
+    }
+
+    for (unsigned cpu = first; cpu <= last; ++cpu) {
+      cpus.push_back(cpu);
+    }
+  }
+
+  return cpus;
+}
+
+// "32768K" -> bytes
+size_t parseCacheSize(const std::string& size) {
+  std::stringstream ss(size);
+  size_t value = 0;
+  char unit = 0;
+  ss >> value >> unit;
+  switch (unit) {
+    case 'K': return value * 1024;
+    case 'M': return value * 1024 * 1024;
+    default: return value;
+  }
+}
+
+struct CacheDomain {
+  size_t size;
+  size_t capacity; // cores whose scratchpads fit into the cache, filled before any remaining core
+  std::vector<std::vector<unsigned>> cores; // logical CPUs of each physical core
+};
+
+#endif
+
+}
+
+MinerThreadPlacement::MinerThreadPlacement() : MinerThreadPlacement(CPU_SYSFS_PATH) {
+}
+
+MinerThreadPlacement::MinerThreadPlacement(const std::string& cpuSysfsPath) : m_defaultThreadCount(std::max(1u, std::thread::hardware_concurrency())) {
+#ifdef __linux__
+  std::string online;
+  if (!readLine(cpuSysfsPath + "online", online)) {
+    return;
+  }
+
+  // physical cores keyed by (package, core id), each holding its SMT siblings
+  std::map<std::pair<unsigned, unsigned>, std::vector<unsigned>> cores;
+  // L3 caches keyed by their shared CPU list, so cores sharing a cache land in one domain
+  std::map<std::string, CacheDomain> domains;
+  std::map<std::pair<unsigned, unsigned>, std::string> coreDomains;
+
+  for (unsigned cpu : parseCpuList(online)) {
+    std::string cpuPath = cpuSysfsPath + "cpu" + std::to_string(cpu) + "/";
+    std::string package;
+    std::string coreId;
+    if (!readLine(cpuPath + "topology/physical_package_id", package) || !readLine(cpuPath + "topology/core_id", coreId)) {
+      return;
+    }
+
+    auto core = std::make_pair(static_cast<unsigned>(std::stoul(package)), static_cast<unsigned>(std::stoul(coreId)));
+    cores[core].push_back(cpu);
+    if (coreDomains.count(core) != 0) {
+      continue;
+    }
+
+    std::string domain = "package" + package;
+    size_t cacheSize = 0;
+    for (unsigned index = 0;; ++index) {
+      std::string cachePath = cpuPath + "cache/index" + std::to_string(index) + "/";
+      std::string level;
+      if (!readLine(cachePath + "level", level)) {
+        break;
+      }
+
+      std::string sharedCpus;
+      std::string size;
+      if (level == "3" && readLine(cachePath + "shared_cpu_list", sharedCpus) && readLine(cachePath + "size", size)) {
+        domain = sharedCpus;
+        cacheSize = parseCacheSize(size);
+      }
+    }
+
+    coreDomains[core] = domain;
+    domains[domain].size = cacheSize;
+  }
+
+  for (const auto& core : cores) {
+    domains[coreDomains[core.first]].cores.push_back(core.second);
+  }
+
+  size_t maxCores = 0;
+  size_t maxSiblings = 0;
+  m_defaultThreadCount = 0;
+  for (auto& domain : domains) {
+    size_t coreCount = domain.second.cores.size();
+    size_t capacity = domain.second.size == 0 ? coreCount : std::max<size_t>(1, domain.second.size / SCRATCHPAD_SIZE);
+    domain.second.capacity = std::min(coreCount, capacity);
+    m_defaultThreadCount += domain.second.capacity;
+    maxCores = std::max(maxCores, coreCount);
+    for (const auto& core : domain.second.cores) {
+      maxSiblings = std::max(maxSiblings, core.size());
+    }
+  }
+
+  // first the cores each domain has cache for, then its remaining cores, then SMT siblings
+  for (size_t core = 0; core < maxCores; ++core) {
+    for (const auto& domain : domains) {
+      if (core < domain.second.capacity) {
+        m_cpus.push_back(domain.second.cores[core].front());
+      }
+    }
+  }
+
+  for (size_t core = 0; core < maxCores; ++core) {
+    for (const auto& domain : domains) {
+      if (core >= domain.second.capacity && core < domain.second.cores.size()) {
+        m_cpus.push_back(domain.second.cores[core].front());
+      }
+    }
+  }
+
+  for (size_t sibling = 1; sibling < maxSiblings; ++sibling) {
+    for (size_t core = 0; core < maxCores; ++core) {
+      for (const auto& domain : domains) {
+        const auto& domainCores = domain.second.cores;
+        if (core < domainCores.size() && sibling < domainCores[core].size()) {
+          m_cpus.push_back(domainCores[core][sibling]);
+        }
+      }
+    }
+  }
+
+  m_defaultThreadCount = std::max<size_t>(1, m_defaultThreadCount);
+#endif
+}
+
+bool MinerThreadPlacement::isAvailable() const {
+  return !m_cpus.empty();
+}
+
+size_t MinerThreadPlacement::defaultThreadCount() const {
+  return m_defaultThreadCount;
+}
+
+unsigned MinerThreadPlacement::cpuForThread(size_t threadIndex) const {
+  return m_cpus.empty() ? 0 : m_cpus[threadIndex % m_cpus.size()];
+}
+
+bool MinerThreadPlacement::pinCurrentThread(unsigned cpu) {
+  return setCurrentThreadCpus({cpu});
+}
+
+std::vector<unsigned> MinerThreadPlacement::getCurrentThreadCpus() {
+  std::vector<unsigned> cpus;
+#ifdef __linux__
+  cpu_set_t cpuSet;
+  CPU_ZERO(&cpuSet);
+  if (pthread_getaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet) == 0) {
+    for (unsigned cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+      if (CPU_ISSET(cpu, &cpuSet)) {
+        cpus.push_back(cpu);
+      }
+    }
+  }
+#endif
+
+  return cpus;
+}
+
+bool MinerThreadPlacement::setCurrentThreadCpus(const std::vector<unsigned>& cpus) {
+#ifdef __linux__
+  cpu_set_t cpuSet;
+  CPU_ZERO(&cpuSet);
+  for (unsigned cpu : cpus) {
+    CPU_SET(cpu, &cpuSet);
+  }
+
+  return !cpus.empty() && pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet) == 0;
+#else
+  return false;
+#endif
+}
+
+}
@@ -0,0 +1,43 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2014-2017 XDN developers
+// Copyright (c) 2016-2017 BXC developers
+// Copyright (c) 2017 Doppler developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace CryptoNote {
+
+// Maps mining threads to logical CPUs using the cache topology from /sys/devices/system/cpu.
+// Threads go round robin over L3 caches to as many distinct physical cores of each as its
+// scratchpads fit into, then to the remaining cores, and SMT siblings are only used once
+// every core is taken. A thread pinned before it creates its
+// Crypto::cn_context gets its scratchpad on the local NUMA node, as pages are placed on first touch.
+class MinerThreadPlacement {
+public:
+  MinerThreadPlacement();
+  // reads the topology from a copy of that tree, "/" terminated
+  explicit MinerThreadPlacement(const std::string& cpuSysfsPath);
+
+  // false where topology isn't known, threads are left to the scheduler then
+  bool isAvailable() const;
+  // one thread per physical core, but no more per L3 cache than scratchpads it can hold
+  size_t defaultThreadCount() const;
+  unsigned cpuForThread(size_t threadIndex) const;
+
+  static bool pinCurrentThread(unsigned cpu);
+  // the CPUs the current thread may run on, empty where affinity isn't supported
+  static std::vector<unsigned> getCurrentThreadCpus();
+  static bool setCurrentThreadCpus(const std::vector<unsigned>& cpus);
+
+private:
+  std::vector<unsigned> m_cpus;
+  size_t m_defaultThreadCount;
+};
+
+}
@@ -0,0 +1,79 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2014-2017 XDN developers
+// Copyright (c) 2016-2017 BXC developers
+// Copyright (c) 2017 Doppler developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "SerializedBlockCache.h"
+
+#include <cassert>
+#include <iterator>
+
+namespace CryptoNote {
+
+SerializedBlockCache::SerializedBlockCache(size_t maxSize) : m_maxSize(maxSize), m_size(0) {
+}
+
+std::shared_ptr<const SerializedBlock> SerializedBlockCache::find(const Crypto::Hash& blockHash) {
+  auto it = m_index.find(blockHash);
+  if (it == m_index.end()) {
+    return nullptr;
+  }
+
+  m_entries.splice(m_entries.begin(), m_entries, it->second);
+  return it->second->second;
+}
+
+void SerializedBlockCache::insert(const Crypto::Hash& blockHash, std::shared_ptr<const SerializedBlock> block) {
+  assert(block != nullptr);
+  remove(blockHash);
+
+  size_t size = blobSize(*block);
+  if (size > m_maxSize) {
+    return;
+  }
+
+  while (m_size + size > m_maxSize) {
+    assert(!m_entries.empty());
+    erase(std::prev(m_entries.end()));
+  }
+
+  m_entries.emplace_front(blockHash, std::move(block));
+  m_index.emplace(blockHash, m_entries.begin());
+  m_size += size;
+}
+
+void SerializedBlockCache::remove(const Crypto::Hash& blockHash) {
+  auto it = m_index.find(blockHash);
+  if (it != m_index.end()) {
+    erase(it->second);
+  }
+}
+
+void SerializedBlockCache::clear() {
+  m_entries.clear();
+  m_index.clear();
+  m_size = 0;
+}
+
+size_t SerializedBlockCache::size() const {
+  return m_size;
+}
+
+size_t SerializedBlockCache::blobSize(const SerializedBlock& block) {
+  size_t size = block.block.size();
+  for (const auto& transaction : block.transactions) {
+    size += transaction.size();
+  }
+
+  return size;
+}
+
+void SerializedBlockCache::erase(Entries::iterator it) {
+  m_size -= blobSize(*it->second);
+  m_index.erase(it->first);
+  m_entries.erase(it);
+}
+
+}
@@ -0,0 +1,55 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2014-2017 XDN developers
+// Copyright (c) 2016-2017 BXC developers
+// Copyright (c) 2017 Doppler developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "crypto/hash.h"
+
+namespace CryptoNote {
+
+// A block and its transactions, except the base one, as they are sent to peers and wallets
+struct SerializedBlock {
+  uint64_t timestamp;
+  std::string block;
+  std::vector<std::string> transactions;
+};
+
+// Least recently used blobs of main chain blocks, limited by their total size. A block below the tip never changes,
+// so an entry only has to be removed when its block is popped. Not synchronized, the owner serializes access.
+class SerializedBlockCache {
+public:
+  explicit SerializedBlockCache(size_t maxSize);
+
+  std::shared_ptr<const SerializedBlock> find(const Crypto::Hash& blockHash);
+  // a block larger than the whole cache isn't kept
+  void insert(const Crypto::Hash& blockHash, std::shared_ptr<const SerializedBlock> block);
+  void remove(const Crypto::Hash& blockHash);
+  void clear();
+
+  // bytes of the blobs kept
+  size_t size() const;
+
+private:
+  typedef std::list<std::pair<Crypto::Hash, std::shared_ptr<const SerializedBlock>>> Entries;
+
+  static size_t blobSize(const SerializedBlock& block);
+  void erase(Entries::iterator it);
+
+  size_t m_maxSize;
+  size_t m_size;
+  // most recently used first
+  Entries m_entries;
+  std::unordered_map<Crypto::Hash, Entries::iterator> m_index;
+};
+
+}
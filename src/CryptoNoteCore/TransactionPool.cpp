@@ -8,7 +8,10 @@
 #include "TransactionPool.h"
 
 #include <algorithm>
+#include <cmath>
 #include <ctime>
+#include <limits>
+#include <memory>
 #include <vector>
 #include <unordered_set>
 
@@ -35,6 +38,25 @@ using namespace Logging;
 
 namespace CryptoNote {
 
+  namespace {
+    const uint8_t JOURNAL_TRANSACTION_ADDED = 1;
+    const uint8_t JOURNAL_TRANSACTION_REMOVED = 2;
+
+    // fee per kilobyte of transaction blob, saturates instead of overflowing
+    uint64_t getFeeRate(uint64_t fee, size_t blobSize) {
+      if (blobSize == 0) {
+        return std::numeric_limits<uint64_t>::max();
+      }
+
+      uint64_t productHi;
+      uint64_t productLo = mul128(fee, 1000, &productHi);
+      uint64_t quotientHi;
+      uint64_t quotientLo;
+      div128_32(productHi, productLo, static_cast<uint32_t>(blobSize), &quotientHi, &quotientLo);
+      return quotientHi != 0 ? std::numeric_limits<uint64_t>::max() : quotientLo;
+    }
+  }
+
   //---------------------------------------------------------------------------------
   // BlockTemplate
   //---------------------------------------------------------------------------------
@@ -102,10 +124,21 @@ namespace CryptoNote {
     m_timeProvider(timeProvider), 
     m_txCheckInterval(60, timeProvider),
     m_fee_index(boost::get<1>(m_transactions)),
-    logger(log, "txpool") {
+    logger(log, "txpool"),
+    m_poolSize(0),
+    m_maxPoolSize(parameters::CRYPTONOTE_MEMPOOL_MAX_SIZE),
+    m_evictedCount(0),
+    m_minimumFeeRate(0),
+    m_minimumFeeRateUpdateTime(0),
+    m_journal(log) {
   }
   //---------------------------------------------------------------------------------
-  bool tx_memory_pool::add_tx(const Transaction &tx, /*const Crypto::Hash& tx_prefix_hash,*/ const Crypto::Hash &id, size_t blobSize, tx_verification_context& tvc, bool keptByBlock, uint32_t height) {
+  void tx_memory_pool::setMaxPoolSize(size_t maxSize) {
+    std::lock_guard<std::recursive_mutex> lock(m_transactions_lock);
+    m_maxPoolSize = maxSize;
+  }
+  //---------------------------------------------------------------------------------
+  bool tx_memory_pool::add_tx(const Transaction &tx, /*const Crypto::Hash& tx_prefix_hash,*/ const Crypto::Hash &id, size_t blobSize, tx_verification_context& tvc, bool keptByBlock, uint32_t height, const BlockInfo* verifiedMaxUsedBlock) {
     if (!check_inputs_types_supported(tx)) {
       tvc.m_verifivation_failed = true;
       return false;
@@ -160,6 +193,15 @@ namespace CryptoNote {
     //check key images for transaction if it is not kept by block
     if (!keptByBlock) {
       std::lock_guard<std::recursive_mutex> lock(m_transactions_lock);
+      updateMinimumFeeRate();
+      if (getFeeRate(fee, blobSize) < m_minimumFeeRate) {
+        logger(INFO) << "transaction fee rate is below pool minimum: tx = " << id << ", fee = " << m_currency.formatAmount(fee) <<
+          ", size = " << blobSize << ", minimum fee per kB: " << m_currency.formatAmount(m_minimumFeeRate);
+        tvc.m_verifivation_failed = true;
+        tvc.m_tx_fee_too_small = true;
+        return false;
+      }
+
       if (haveSpentInputs(tx)) {
         logger(INFO) << "Transaction with id= " << id << " used already spent inputs";
         tvc.m_verifivation_failed = true;
@@ -168,9 +210,17 @@ namespace CryptoNote {
     }
 
     BlockInfo maxUsedBlock;
+    bool inputsValid;
 
     // check inputs
-    bool inputsValid = m_validator.checkTransactionInputs(tx, maxUsedBlock);
+    if (verifiedMaxUsedBlock != nullptr) {
+      // ring signatures are already checked, only make sure that the chain they were checked against is still current
+      maxUsedBlock = *verifiedMaxUsedBlock;
+      BlockInfo lastFailedBlock;
+      inputsValid = !m_validator.haveSpentKeyImages(tx) && m_validator.checkTransactionInputs(tx, maxUsedBlock, lastFailedBlock);
+    } else {
+      inputsValid = m_validator.checkTransactionInputs(tx, maxUsedBlock);
+    }
 
     if (!inputsValid) {
       if (!keptByBlock) {
@@ -221,6 +271,7 @@ namespace CryptoNote {
         logger(ERROR, BRIGHT_RED) << "transaction already exists at inserting in memory pool";
         return false;
       }
+      journalTransactionAdded(*txd_p.first);
       m_paymentIdIndex.add(txd.tx);
       m_timestampIndex.add(txd.receiveTime, txd.id);
 
@@ -236,6 +287,19 @@ namespace CryptoNote {
     if (!addTransactionInputs(id, tx, keptByBlock))
       return false;
 
+    m_poolSize += blobSize;
+    if (m_poolSize > m_maxPoolSize && removeLowestFeeTransactions() > 0) {
+      m_observerManager.notify(&ITxPoolObserver::txDeletedFromPool);
+
+      if (m_transactions.count(id) == 0) {
+        logger(INFO) << "Transaction " << id << " was evicted from full pool, minimum fee per kB: " << m_currency.formatAmount(m_minimumFeeRate);
+        tvc.m_added_to_pool = false;
+        tvc.m_should_be_relayed = false;
+        tvc.m_tx_fee_too_small = true;
+        return false;
+      }
+    }
+
     tvc.m_verifivation_failed = false;
     //succeed
     return true;
@@ -271,6 +335,18 @@ namespace CryptoNote {
     return m_transactions.size();
   }
   //---------------------------------------------------------------------------------
+  tx_memory_pool::PoolStatistics tx_memory_pool::getStatistics() const {
+    std::lock_guard<std::recursive_mutex> lock(m_transactions_lock);
+
+    PoolStatistics statistics;
+    statistics.transactionsCount = m_transactions.size();
+    statistics.size = m_poolSize;
+    statistics.maxSize = m_maxPoolSize;
+    statistics.evictedCount = m_evictedCount;
+    statistics.minimumFeeRate = m_minimumFeeRate;
+    return statistics;
+  }
+  //---------------------------------------------------------------------------------
   void tx_memory_pool::get_transactions(std::list<Transaction>& txs) const {
     std::lock_guard<std::recursive_mutex> lock(m_transactions_lock);
     for (const auto& tx_vt : m_transactions) {
@@ -441,26 +517,37 @@ namespace CryptoNote {
 
     m_config_folder = config_folder;
     std::string state_file_path = config_folder + "/" + m_currency.txPoolFileName();
+    std::string journal_file_path = config_folder + "/" + m_currency.txPoolJournalFileName();
     boost::system::error_code ec;
-    if (!boost::filesystem::exists(state_file_path, ec)) {
-      return true;
-    }
-
-    if (!loadFromBinaryFile(*this, state_file_path)) {
+    if (boost::filesystem::exists(state_file_path, ec) && !loadFromBinaryFile(*this, state_file_path)) {
       logger(ERROR) << "Failed to load memory pool from file " << state_file_path;
 
       m_transactions.clear();
       m_spent_key_images.clear();
       m_spentOutputs.clear();
+    }
 
-      m_paymentIdIndex.clear();
-      m_timestampIndex.clear();
-      m_ttlIndex.clear();
-    } else {
-      buildIndices();
+    // journal is left behind only if the node was not shut down cleanly
+    std::vector<BinaryArray> journalRecords;
+    if (TransactionPoolJournal::load(journal_file_path, journalRecords) && !journalRecords.empty()) {
+      replayJournal(journalRecords);
     }
 
+    m_paymentIdIndex.clear();
+    m_timestampIndex.clear();
+    m_ttlIndex.clear();
+    buildIndices();
+
     removeExpiredTransactions();
+    if (m_poolSize > m_maxPoolSize) {
+      size_t evicted = removeLowestFeeTransactions();
+      logger(INFO) << "Evicted " << evicted << " transactions exceeding pool size limit of " << m_maxPoolSize << " bytes";
+    }
+
+    if (Tools::create_directories_if_necessary(m_config_folder)) {
+      m_journal.start(journal_file_path, state_file_path);
+      compactJournal();
+    }
 
     // Ignore deserialization error
     return true;
@@ -472,10 +559,15 @@ namespace CryptoNote {
       return false;
     }
 
+    m_journal.stop();
+
     std::string state_file_path = m_config_folder + "/" + m_currency.txPoolFileName();
 
     if (!storeToBinaryFile(*this, state_file_path)) {
       logger(INFO) << "Failed to serialize memory pool to file " << state_file_path;
+    } else {
+      boost::system::error_code ec;
+      boost::filesystem::remove(m_config_folder + "/" + m_currency.txPoolJournalFileName(), ec);
     }
 
     m_paymentIdIndex.clear();
@@ -525,9 +617,109 @@ namespace CryptoNote {
     KV_MEMBER(m_recentlyDeletedTransactions);
   }
 
+  //---------------------------------------------------------------------------------
+  void tx_memory_pool::Snapshot::serialize(ISerializer& s) {
+    uint8_t version = CURRENT_MEMPOOL_ARCHIVE_VER;
+    s(version, "version");
+    writeSequence<TransactionDetails>(transactions.begin(), transactions.end(), "transactions", s);
+    s(spentKeyImages, "m_spent_key_images");
+    s(spentOutputs, "m_spentOutputs");
+    s(recentlyDeletedTransactions, "m_recentlyDeletedTransactions");
+  }
+
+  //---------------------------------------------------------------------------------
+  void tx_memory_pool::journalTransactionAdded(const TransactionDetails& txd) {
+    if (!m_journal.isStarted()) {
+      return;
+    }
+
+    BinaryArray record;
+    Common::VectorOutputStream stream(record);
+    BinaryOutputStreamSerializer s(stream);
+    uint8_t type = JOURNAL_TRANSACTION_ADDED;
+    s(type, "type");
+    CryptoNote::serialize(const_cast<TransactionDetails&>(txd), s);
+    m_journal.append(std::move(record));
+  }
+
+  //---------------------------------------------------------------------------------
+  void tx_memory_pool::journalTransactionRemoved(const Crypto::Hash& id) {
+    if (!m_journal.isStarted()) {
+      return;
+    }
+
+    BinaryArray record;
+    Common::VectorOutputStream stream(record);
+    BinaryOutputStreamSerializer s(stream);
+    uint8_t type = JOURNAL_TRANSACTION_REMOVED;
+    s(type, "type");
+    s(const_cast<Crypto::Hash&>(id), "id");
+    m_journal.append(std::move(record));
+  }
+
+  //---------------------------------------------------------------------------------
+  void tx_memory_pool::replayJournal(const std::vector<BinaryArray>& records) {
+    // records may repeat what the snapshot already has, so applying them is idempotent.
+    // Verification state (maxUsedBlock) is kept, transactions are not checked again.
+    size_t replayed = 0;
+    for (const auto& record : records) {
+      try {
+        Common::MemoryInputStream stream(record.data(), record.size());
+        BinaryInputStreamSerializer s(stream);
+        uint8_t type;
+        s(type, "type");
+
+        if (type == JOURNAL_TRANSACTION_ADDED) {
+          TransactionDetails txd;
+          CryptoNote::serialize(txd, s);
+          if (m_transactions.count(txd.id) == 0 && (txd.keptByBlock || !haveSpentInputs(txd.tx)) &&
+              addTransactionInputs(txd.id, txd.tx, txd.keptByBlock)) {
+            m_transactions.insert(std::move(txd));
+          }
+        } else if (type == JOURNAL_TRANSACTION_REMOVED) {
+          Crypto::Hash id;
+          s(id, "id");
+          auto it = m_transactions.find(id);
+          if (it != m_transactions.end()) {
+            removeTransactionInputs(it->id, it->tx, it->keptByBlock);
+            m_transactions.erase(it);
+          }
+        } else {
+          logger(WARNING) << "Unknown memory pool journal record type " << static_cast<int>(type) << ", rest of the journal is ignored";
+          break;
+        }
+      } catch (std::exception& e) {
+        logger(WARNING) << "Broken memory pool journal record, rest of the journal is ignored: " << e.what();
+        break;
+      }
+
+      ++replayed;
+    }
+
+    logger(INFO) << "Replayed " << replayed << " of " << records.size() << " memory pool journal records";
+  }
+
+  //---------------------------------------------------------------------------------
+  void tx_memory_pool::compactJournal() {
+    // only the copy is made under the pool lock, the journal thread serializes it
+    auto snapshot = std::make_shared<Snapshot>();
+    snapshot->transactions.assign(m_transactions.begin(), m_transactions.end());
+    snapshot->spentKeyImages = m_spent_key_images;
+    snapshot->spentOutputs = m_spentOutputs;
+    snapshot->recentlyDeletedTransactions = m_recentlyDeletedTransactions;
+    m_journal.compact([snapshot] { return storeToBinary(*snapshot); });
+  }
+
   //---------------------------------------------------------------------------------
   void tx_memory_pool::on_idle() {
     m_txCheckInterval.call([this](){ return removeExpiredTransactions(); });
+
+    std::lock_guard<std::recursive_mutex> lock(m_transactions_lock);
+    updateMinimumFeeRate();
+
+    if (m_journal.size() > std::max<uint64_t>(m_poolSize, parameters::CRYPTONOTE_MEMPOOL_JOURNAL_COMPACTION_SIZE)) {
+      compactJournal();
+    }
   }
 
   //---------------------------------------------------------------------------------
@@ -577,7 +769,68 @@ namespace CryptoNote {
     return true;
   }
 
+  //---------------------------------------------------------------------------------
+  size_t tx_memory_pool::removeLowestFeeTransactions() {
+    size_t removedCount = 0;
+    time_t now = m_timeProvider.now();
+
+    // fee index is sorted by descending fee rate, so walk it from the end.
+    // Transactions kept by block are required for chain switching and are never evicted.
+    auto it = m_fee_index.end();
+    while (m_poolSize > m_maxPoolSize && it != m_fee_index.begin()) {
+      auto victim = std::prev(it);
+      if (victim->keptByBlock) {
+        it = victim;
+        continue;
+      }
+
+      uint64_t evictedFeeRate = getFeeRate(victim->fee, victim->blobSize);
+      uint64_t raisedFeeRate = evictedFeeRate + parameters::CRYPTONOTE_MEMPOOL_MIN_FEE_RATE_INCREMENT;
+      if (raisedFeeRate > m_minimumFeeRate) {
+        m_minimumFeeRate = raisedFeeRate;
+      }
+      m_minimumFeeRateUpdateTime = now;
+
+      logger(DEBUGGING) << "Tx " << victim->id << " evicted from tx pool, fee per kB: " << m_currency.formatAmount(evictedFeeRate);
+      removeTransaction(m_transactions.project<0>(victim));
+      ++removedCount;
+    }
+
+    m_evictedCount += removedCount;
+    return removedCount;
+  }
+
+  //---------------------------------------------------------------------------------
+  void tx_memory_pool::updateMinimumFeeRate() {
+    if (m_minimumFeeRate == 0) {
+      return;
+    }
+
+    time_t now = m_timeProvider.now();
+    if (now <= m_minimumFeeRateUpdateTime) {
+      return;
+    }
+
+    // decay faster when pressure is gone
+    double halfLife = static_cast<double>(parameters::CRYPTONOTE_MEMPOOL_MIN_FEE_RATE_HALF_LIFE);
+    if (m_poolSize < m_maxPoolSize / 4) {
+      halfLife /= 4;
+    } else if (m_poolSize < m_maxPoolSize / 2) {
+      halfLife /= 2;
+    }
+
+    double elapsed = static_cast<double>(now - m_minimumFeeRateUpdateTime);
+    m_minimumFeeRate = static_cast<uint64_t>(static_cast<double>(m_minimumFeeRate) / std::pow(2.0, elapsed / halfLife));
+    m_minimumFeeRateUpdateTime = now;
+
+    if (m_minimumFeeRate < parameters::CRYPTONOTE_MEMPOOL_MIN_FEE_RATE_INCREMENT / 2) {
+      m_minimumFeeRate = 0;
+    }
+  }
+
   tx_memory_pool::tx_container_t::iterator tx_memory_pool::removeTransaction(tx_memory_pool::tx_container_t::iterator i) {
+    journalTransactionRemoved(i->id);
+    m_poolSize -= i->blobSize;
     removeTransactionInputs(i->id, i->tx, i->keptByBlock);
     m_paymentIdIndex.remove(i->tx);
     m_timestampIndex.remove(i->receiveTime, i->id);
@@ -677,7 +930,9 @@ namespace CryptoNote {
 
   void tx_memory_pool::buildIndices() {
     std::lock_guard<std::recursive_mutex> lock(m_transactions_lock);
+    m_poolSize = 0;
     for (auto it = m_transactions.begin(); it != m_transactions.end(); it++) {
+      m_poolSize += it->blobSize;
       m_paymentIdIndex.add(it->tx);
       m_timestampIndex.add(it->receiveTime, it->id);
 
@@ -30,6 +30,7 @@
 #include "CryptoNoteCore/ITimeProvider.h"
 #include "CryptoNoteCore/ITransactionValidator.h"
 #include "CryptoNoteCore/ITxPoolObserver.h"
+#include "CryptoNoteCore/TransactionPoolJournal.h"
 #include "CryptoNoteCore/VerificationContext.h"
 #include "CryptoNoteCore/BlockchainIndices.h"
 
@@ -86,8 +87,12 @@ namespace CryptoNote {
     bool init(const std::string& config_folder);
     bool deinit();
 
+    // total size of transaction blobs the pool may hold, lowest fee rate transactions are evicted above it
+    void setMaxPoolSize(size_t maxSize);
+
     bool have_tx(const Crypto::Hash &id) const;
-    bool add_tx(const Transaction &tx, const Crypto::Hash &id, size_t blobSize, tx_verification_context& tvc, bool keeped_by_block, uint32_t height);
+    // verifiedMaxUsedBlock is set when the caller has already checked transaction inputs against that block
+    bool add_tx(const Transaction &tx, const Crypto::Hash &id, size_t blobSize, tx_verification_context& tvc, bool keeped_by_block, uint32_t height, const BlockInfo* verifiedMaxUsedBlock = nullptr);
     bool add_tx(const Transaction &tx, tx_verification_context& tvc, bool keeped_by_block, uint32_t height);
     //gets tx and remove it from pool
     bool take_tx(const Crypto::Hash &id, Transaction &tx, size_t& blobSize, uint64_t& fee);
@@ -140,6 +145,16 @@ namespace CryptoNote {
       time_t receiveTime;
     };
 
+    struct PoolStatistics {
+      uint64_t transactionsCount;
+      uint64_t size;
+      uint64_t maxSize;
+      uint64_t evictedCount;
+      uint64_t minimumFeeRate; // atomic units per kilobyte
+    };
+
+    PoolStatistics getStatistics() const;
+
   private:
 
     struct TransactionPriorityComparator {
@@ -174,6 +189,15 @@ namespace CryptoNote {
     typedef std::set<GlobalOutput> GlobalOutputsContainer;
     typedef std::unordered_map<Crypto::KeyImage, std::unordered_set<Crypto::Hash> > key_images_container;
 
+    // a copy of the pool state, serialized the same way as the pool
+    struct Snapshot {
+      std::vector<TransactionDetails> transactions;
+      key_images_container spentKeyImages;
+      GlobalOutputsContainer spentOutputs;
+      std::unordered_map<Crypto::Hash, uint64_t> recentlyDeletedTransactions;
+
+      void serialize(ISerializer& s);
+    };
 
     // double spending checking
     bool addTransactionInputs(const Crypto::Hash& id, const Transaction& tx, bool keptByBlock);
@@ -182,10 +206,17 @@ namespace CryptoNote {
 
     tx_container_t::iterator removeTransaction(tx_container_t::iterator i);
     bool removeExpiredTransactions();
+    size_t removeLowestFeeTransactions();
+    void updateMinimumFeeRate();
     bool is_transaction_ready_to_go(const Transaction& tx, TransactionCheckInfo& txd) const;
 
     void buildIndices();
 
+    void journalTransactionAdded(const TransactionDetails& txd);
+    void journalTransactionRemoved(const Crypto::Hash& id);
+    void replayJournal(const std::vector<BinaryArray>& records);
+    void compactJournal();
+
     Tools::ObserverManager<ITxPoolObserver> m_observerManager;
     const CryptoNote::Currency& m_currency;
     OnceInTimeInterval m_txCheckInterval;
@@ -206,5 +237,13 @@ namespace CryptoNote {
     PaymentIdIndex m_paymentIdIndex;
     TimestampTransactionsIndex m_timestampIndex;
     std::unordered_map<Crypto::Hash, uint64_t> m_ttlIndex;
+
+    size_t m_poolSize;
+    size_t m_maxPoolSize;
+    uint64_t m_evictedCount;
+    uint64_t m_minimumFeeRate;
+    time_t m_minimumFeeRateUpdateTime;
+
+    TransactionPoolJournal m_journal;
   };
 }
@@ -0,0 +1,277 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2014-2017 XDN developers
+// Copyright (c) 2016-2017 BXC developers
+// Copyright (c) 2017 Doppler developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "TransactionPoolJournal.h"
+
+#include <cassert>
+
+#include <boost/filesystem/operations.hpp>
+
+#include "CryptoNoteConfig.h"
+#include "crypto/hash.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#undef ERROR
+
+using namespace Logging;
+
+namespace CryptoNote {
+
+namespace {
+
+// the record size and the first bytes of the hash of the record
+const size_t RECORD_HEADER_SIZE = 2 * sizeof(uint32_t);
+// a record holds a single transaction, so a larger size can only come from a damaged header
+const size_t MAX_RECORD_SIZE = parameters::CRYPTONOTE_MEMPOOL_MAX_SIZE + 64 * 1024;
+
+uint32_t readUint32(const uint8_t* data) {
+  return static_cast<uint32_t>(data[0]) | static_cast<uint32_t>(data[1]) << 8 |
+    static_cast<uint32_t>(data[2]) << 16 | static_cast<uint32_t>(data[3]) << 24;
+}
+
+void writeUint32(uint8_t* data, uint32_t value) {
+  data[0] = static_cast<uint8_t>(value);
+  data[1] = static_cast<uint8_t>(value >> 8);
+  data[2] = static_cast<uint8_t>(value >> 16);
+  data[3] = static_cast<uint8_t>(value >> 24);
+}
+
+uint32_t recordChecksum(const BinaryArray& record) {
+  Crypto::Hash hash = Crypto::cn_fast_hash(record.data(), record.size());
+  return readUint32(reinterpret_cast<const uint8_t*>(&hash));
+}
+
+// writes the cached data of a file, or the entries of a directory, to the disk
+bool syncPath(const std::string& path, bool isDirectory) {
+#ifdef _WIN32
+  if (isDirectory) {
+    // directories can't be flushed on Windows, NTFS journals renames itself
+    return true;
+  }
+
+  HANDLE file = CreateFileA(path.c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING,
+    FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+
+  bool synced = FlushFileBuffers(file) != 0;
+  CloseHandle(file);
+  return synced;
+#else
+  int fd = open(path.c_str(), O_RDONLY | (isDirectory ? O_DIRECTORY : 0));
+  if (fd == -1) {
+    return false;
+  }
+
+  bool synced = fsync(fd) == 0;
+  close(fd);
+  return synced;
+#endif
+}
+
+std::string directoryOf(const std::string& path) {
+  std::string directory = boost::filesystem::path(path).parent_path().string();
+  return directory.empty() ? "." : directory;
+}
+
+}
+
+TransactionPoolJournal::TransactionPoolJournal(Logging::ILogger& logger) :
+  logger(logger, "txpool_journal"), m_started(false), m_stopping(false), m_size(0) {
+}
+
+TransactionPoolJournal::~TransactionPoolJournal() {
+  stop();
+}
+
+void TransactionPoolJournal::start(const std::string& journalPath, const std::string& snapshotPath) {
+  assert(!m_started);
+
+  m_journalPath = journalPath;
+  m_snapshotPath = snapshotPath;
+  m_journalFile.open(m_journalPath, std::ios_base::binary | std::ios_base::out | std::ios_base::app);
+  if (m_journalFile.fail()) {
+    logger(ERROR, BRIGHT_RED) << "Failed to open memory pool journal " << m_journalPath;
+  }
+
+  m_size = 0;
+  m_stopping = false;
+  m_started = true;
+  m_writer = std::thread(&TransactionPoolJournal::writerLoop, this);
+}
+
+void TransactionPoolJournal::stop() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_started) {
+      return;
+    }
+
+    m_stopping = true;
+  }
+
+  m_hasTasks.notify_one();
+  m_writer.join();
+  m_journalFile.close();
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_started = false;
+}
+
+bool TransactionPoolJournal::isStarted() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_started;
+}
+
+void TransactionPoolJournal::append(BinaryArray&& record) {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_started || m_stopping) {
+      return;
+    }
+
+    m_size += RECORD_HEADER_SIZE + record.size();
+    m_tasks.push_back({ false, std::move(record), nullptr });
+  }
+
+  m_hasTasks.notify_one();
+}
+
+void TransactionPoolJournal::compact(std::function<BinaryArray()>&& makeSnapshot) {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_started || m_stopping) {
+      return;
+    }
+
+    m_size = 0;
+    m_tasks.push_back({ true, BinaryArray(), std::move(makeSnapshot) });
+  }
+
+  m_hasTasks.notify_one();
+}
+
+uint64_t TransactionPoolJournal::size() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_size;
+}
+
+bool TransactionPoolJournal::load(const std::string& journalPath, std::vector<BinaryArray>& records) {
+  std::ifstream journalFile(journalPath, std::ios_base::binary | std::ios_base::in);
+  if (journalFile.fail()) {
+    return false;
+  }
+
+  journalFile.seekg(0, std::ios_base::end);
+  uint64_t bytesLeft = static_cast<uint64_t>(journalFile.tellg());
+  journalFile.seekg(0, std::ios_base::beg);
+
+  // everything from a damaged record on is dropped, the records after it can't be trusted to follow it
+  for (;;) {
+    uint8_t header[RECORD_HEADER_SIZE];
+    if (bytesLeft < sizeof(header) || !journalFile.read(reinterpret_cast<char*>(header), sizeof(header))) {
+      break;
+    }
+
+    bytesLeft -= sizeof(header);
+    uint32_t recordSize = readUint32(header);
+    if (recordSize > MAX_RECORD_SIZE || recordSize > bytesLeft) {
+      break;
+    }
+
+    BinaryArray record(recordSize);
+    if (!journalFile.read(reinterpret_cast<char*>(record.data()), recordSize) ||
+      recordChecksum(record) != readUint32(header + sizeof(uint32_t))) {
+      break;
+    }
+
+    bytesLeft -= recordSize;
+    records.push_back(std::move(record));
+  }
+
+  return true;
+}
+
+void TransactionPoolJournal::writerLoop() {
+  for (;;) {
+    std::deque<Task> tasks;
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_hasTasks.wait(lock, [this] { return m_stopping || !m_tasks.empty(); });
+      if (m_tasks.empty()) {
+        break;
+      }
+
+      tasks.swap(m_tasks);
+    }
+
+    for (const auto& task : tasks) {
+      if (task.isSnapshot) {
+        writeSnapshot(task.makeSnapshot());
+      } else {
+        writeRecord(task.data);
+      }
+    }
+
+    m_journalFile.flush();
+    if (!syncPath(m_journalPath, false)) {
+      logger(WARNING) << "Failed to sync memory pool journal " << m_journalPath;
+    }
+  }
+}
+
+void TransactionPoolJournal::writeRecord(const BinaryArray& record) {
+  uint8_t header[RECORD_HEADER_SIZE];
+  writeUint32(header, static_cast<uint32_t>(record.size()));
+  writeUint32(header + sizeof(uint32_t), recordChecksum(record));
+
+  m_journalFile.write(reinterpret_cast<const char*>(header), sizeof(header));
+  m_journalFile.write(reinterpret_cast<const char*>(record.data()), record.size());
+}
+
+void TransactionPoolJournal::writeSnapshot(const BinaryArray& snapshot) {
+  std::string tempPath = m_snapshotPath + ".tmp";
+  {
+    std::ofstream snapshotFile(tempPath, std::ios_base::binary | std::ios_base::out | std::ios_base::trunc);
+    snapshotFile.write(reinterpret_cast<const char*>(snapshot.data()), snapshot.size());
+    snapshotFile.close();
+    if (snapshotFile.fail() || !syncPath(tempPath, false)) {
+      logger(ERROR, BRIGHT_RED) << "Failed to write memory pool snapshot " << tempPath;
+      return;
+    }
+  }
+
+  // records written so far are covered by the new snapshot, but stay valid until it is on the disk in place
+  boost::system::error_code ec;
+  boost::filesystem::rename(tempPath, m_snapshotPath, ec);
+  if (ec) {
+    logger(ERROR, BRIGHT_RED) << "Failed to replace memory pool snapshot " << m_snapshotPath << ": " << ec.message();
+    return;
+  }
+
+  if (!syncPath(directoryOf(m_snapshotPath), true)) {
+    logger(ERROR, BRIGHT_RED) << "Failed to sync memory pool snapshot " << m_snapshotPath << ", journal is kept";
+    return;
+  }
+
+  m_journalFile.close();
+  m_journalFile.open(m_journalPath, std::ios_base::binary | std::ios_base::out | std::ios_base::trunc);
+  if (m_journalFile.fail()) {
+    logger(ERROR, BRIGHT_RED) << "Failed to truncate memory pool journal " << m_journalPath;
+  }
+
+  logger(DEBUGGING) << "Memory pool journal compacted, snapshot size " << snapshot.size();
+}
+
+}
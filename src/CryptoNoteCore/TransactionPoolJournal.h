@@ -0,0 +1,72 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2014-2017 XDN developers
+// Copyright (c) 2016-2017 BXC developers
+// Copyright (c) 2017 Doppler developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "CryptoNote.h"
+
+#include <Logging/LoggerRef.h>
+
+namespace CryptoNote {
+
+// Append-only log of memory pool changes. Records and snapshots are written by a background thread
+// in the order they were queued, so the latest snapshot with the journal replayed over it gives
+// the pool state at the moment of the last written record.
+class TransactionPoolJournal {
+public:
+  TransactionPoolJournal(Logging::ILogger& logger);
+  ~TransactionPoolJournal();
+
+  void start(const std::string& journalPath, const std::string& snapshotPath);
+  // writes everything queued so far and stops the writer thread
+  void stop();
+  bool isStarted() const;
+
+  void append(BinaryArray&& record);
+  // replaces the snapshot and starts an empty journal, the snapshot is made by the writer thread
+  void compact(std::function<BinaryArray()>&& makeSnapshot);
+  // bytes appended since the last compaction
+  uint64_t size() const;
+
+  // reads records up to the first incomplete or damaged one, an interrupted write leaves an incomplete one behind
+  static bool load(const std::string& journalPath, std::vector<BinaryArray>& records);
+
+private:
+  struct Task {
+    bool isSnapshot;
+    BinaryArray data;
+    std::function<BinaryArray()> makeSnapshot;
+  };
+
+  void writerLoop();
+  void writeRecord(const BinaryArray& record);
+  void writeSnapshot(const BinaryArray& snapshot);
+
+  Logging::LoggerRef logger;
+  std::string m_journalPath;
+  std::string m_snapshotPath;
+  std::ofstream m_journalFile;
+
+  mutable std::mutex m_mutex;
+  std::condition_variable m_hasTasks;
+  std::deque<Task> m_tasks;
+  std::thread m_writer;
+  bool m_started;
+  bool m_stopping;
+  uint64_t m_size;
+};
+
+}
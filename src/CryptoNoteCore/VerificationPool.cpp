@@ -0,0 +1,106 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2014-2017 XDN developers
+// Copyright (c) 2016-2017 BXC developers
+// Copyright (c) 2017 Doppler developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "VerificationPool.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace CryptoNote {
+
+VerificationPool::VerificationPool() : m_stopped(true) {
+}
+
+VerificationPool::~VerificationPool() {
+  stop();
+}
+
+void VerificationPool::start(size_t threadCount) {
+  assert(m_threads.empty());
+  m_stopped = false;
+  m_threads.reserve(threadCount);
+  for (size_t i = 0; i < threadCount; ++i) {
+    m_threads.emplace_back(&VerificationPool::workerLoop, this);
+  }
+}
+
+void VerificationPool::stop() {
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_stopped = true;
+    m_condition.notify_all();
+  }
+
+  for (auto& thread : m_threads) {
+    thread.join();
+  }
+
+  m_threads.clear();
+}
+
+void VerificationPool::run(size_t count, const std::function<void(size_t)>& job) {
+  Batch batch;
+  batch.job = &job;
+  batch.count = count;
+  batch.next = 0;
+  batch.done = 0;
+
+  std::unique_lock<std::mutex> lock(m_mutex);
+  if (!m_stopped && count > 1) {
+    m_batches.push_back(&batch);
+    m_condition.notify_all();
+  }
+
+  while (batch.next < batch.count) {
+    size_t index = takeIndex(batch);
+    lock.unlock();
+    job(index);
+    lock.lock();
+    ++batch.done;
+  }
+
+  while (batch.done < batch.count) {
+    batch.finished.wait(lock);
+  }
+}
+
+void VerificationPool::workerLoop() {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  for (;;) {
+    while (m_batches.empty() && !m_stopped) {
+      m_condition.wait(lock);
+    }
+
+    if (m_batches.empty()) {
+      return;
+    }
+
+    Batch& batch = *m_batches.front();
+    size_t index = takeIndex(batch);
+    lock.unlock();
+    (*batch.job)(index);
+    lock.lock();
+    if (++batch.done == batch.count) {
+      batch.finished.notify_one();
+    }
+  }
+}
+
+size_t VerificationPool::takeIndex(Batch& batch) {
+  assert(batch.next < batch.count);
+  size_t index = batch.next++;
+  if (batch.next == batch.count) {
+    auto it = std::find(m_batches.begin(), m_batches.end(), &batch);
+    if (it != m_batches.end()) {
+      m_batches.erase(it);
+    }
+  }
+
+  return index;
+}
+
+}
@@ -0,0 +1,55 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2014-2017 XDN developers
+// Copyright (c) 2016-2017 BXC developers
+// Copyright (c) 2017 Doppler developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace CryptoNote {
+
+// A fixed number of threads shared by all callers to check signatures in parallel. The calling thread works on its
+// own batch too, so a batch completes even while the workers are busy with the batches of other callers.
+class VerificationPool {
+public:
+  VerificationPool();
+  VerificationPool(const VerificationPool&) = delete;
+  ~VerificationPool();
+  VerificationPool& operator=(const VerificationPool&) = delete;
+
+  void start(size_t threadCount);
+  // batches being run are completed by their callers
+  void stop();
+
+  // calls job for every index below count and returns once all the calls are done, the job must not throw
+  void run(size_t count, const std::function<void(size_t)>& job);
+
+private:
+  struct Batch {
+    const std::function<void(size_t)>* job;
+    size_t count;
+    size_t next;
+    size_t done;
+    std::condition_variable finished;
+  };
+
+  void workerLoop();
+  // takes the next index of the batch, a batch leaves the queue once all its indexes are taken
+  size_t takeIndex(Batch& batch);
+
+  std::mutex m_mutex;
+  std::condition_variable m_condition;
+  std::deque<Batch*> m_batches;
+  std::vector<std::thread> m_threads;
+  bool m_stopped;
+};
+
+}
@@ -0,0 +1,274 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2014-2017 XDN developers
+// Copyright (c) 2016-2017 BXC developers
+// Copyright (c) 2017 Doppler developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "BlockDownloadScheduler.h"
+
+#include <algorithm>
+
+#include <boost/uuid/nil_generator.hpp>
+
+namespace CryptoNote {
+
+BlockDownloadScheduler::BlockDownloadScheduler(size_t chunkSize, size_t windowChunks, size_t chunksPerPeer, std::chrono::seconds chunkTimeout, std::chrono::seconds stallTimeout) :
+  m_chunkSize(chunkSize),
+  m_windowChunks(windowChunks),
+  m_chunksPerPeer(chunksPerPeer),
+  m_chunkTimeout(chunkTimeout),
+  m_stallTimeout(stallTimeout),
+  m_nextHeight(0),
+  m_blockIdsRequested(false) {
+}
+
+bool BlockDownloadScheduler::empty() const {
+  return m_chunks.empty();
+}
+
+uint32_t BlockDownloadScheduler::nextHeight() const {
+  return m_nextHeight;
+}
+
+bool BlockDownloadScheduler::addBlockIds(uint32_t startHeight, const std::vector<Crypto::Hash>& ids) {
+  m_blockIdsRequested = false;
+
+  if (ids.empty()) {
+    return false;
+  }
+
+  // ids.front() is the block the entry builds on, it is known to the caller
+  size_t first = 1;
+  if (m_nextHeight != 0) {
+    uint32_t lastHeight = m_nextHeight - 1;
+    if (lastHeight >= startHeight && lastHeight - startHeight < ids.size() && ids[lastHeight - startHeight] == m_lastId) {
+      first = lastHeight - startHeight + 1;
+    } else if (!m_chunks.empty()) {
+      return false;
+    }
+  }
+
+  uint32_t height = startHeight + static_cast<uint32_t>(first);
+  for (size_t i = first; i < ids.size(); ++i, ++height) {
+    Chunk* chunk = nullptr;
+    if (!m_chunks.empty()) {
+      Chunk& last = m_chunks.rbegin()->second;
+      if (last.ids.size() < m_chunkSize && last.requests.empty() && !last.downloaded) {
+        chunk = &last;
+      }
+    }
+
+    if (chunk == nullptr) {
+      chunk = &m_chunks[height];
+      chunk->downloaded = false;
+      chunk->timedOutPeer = boost::uuids::nil_uuid();
+    }
+
+    chunk->ids.push_back(ids[i]);
+    m_chunkHeights[ids[i]] = height - static_cast<uint32_t>(chunk->ids.size() - 1);
+  }
+
+  m_nextHeight = height;
+  m_lastId = ids.back();
+  return first < ids.size();
+}
+
+bool BlockDownloadScheduler::requestBlockIds(const PeerId& peer, Clock::time_point now) {
+  if (m_chunks.size() >= m_windowChunks) {
+    return false;
+  }
+
+  if (m_blockIdsRequested && now - m_blockIdsRequestTime < m_chunkTimeout) {
+    return false;
+  }
+
+  m_blockIdsRequested = true;
+  m_blockIdsPeer = peer;
+  m_blockIdsRequestTime = now;
+  return true;
+}
+
+bool BlockDownloadScheduler::assignChunk(const PeerId& peer, uint32_t peerHeight, Clock::time_point now, std::vector<Crypto::Hash>& chunk) {
+  Peer& state = getPeer(peer);
+  if (state.inFlight >= state.limit) {
+    return false;
+  }
+
+  size_t index = 0;
+  for (auto it = m_chunks.begin(); it != m_chunks.end() && index < m_windowChunks; ++it, ++index) {
+    Chunk& candidate = it->second;
+    bool timedOut = candidate.timedOutPeer == peer && now - candidate.timeoutTime < m_stallTimeout;
+    if (!candidate.downloaded && candidate.requests.empty() && !timedOut && it->first + candidate.ids.size() <= peerHeight) {
+      startRequest(candidate, peer, now);
+      chunk = candidate.ids;
+      return true;
+    }
+  }
+
+  if (m_chunks.empty()) {
+    return false;
+  }
+
+  // the oldest chunk holds every downloaded one back, don't wait for its timeout
+  auto head = m_chunks.begin();
+  Chunk& stalled = head->second;
+  if (!stalled.downloaded && stalled.requests.size() == 1 && stalled.requests.front().peer != peer &&
+    now - stalled.requests.front().time >= m_stallTimeout && head->first + stalled.ids.size() <= peerHeight) {
+    startRequest(stalled, peer, now);
+    chunk = stalled.ids;
+    return true;
+  }
+
+  return false;
+}
+
+size_t BlockDownloadScheduler::inFlight(const PeerId& peer) const {
+  auto it = m_peers.find(peer);
+  return it == m_peers.end() ? 0 : it->second.inFlight;
+}
+
+bool BlockDownloadScheduler::isPending(const Crypto::Hash& id) const {
+  auto height = m_chunkHeights.find(id);
+  return height != m_chunkHeights.end() && !m_chunks.at(height->second).downloaded;
+}
+
+BlockDownloadScheduler::Delivery BlockDownloadScheduler::deliver(const PeerId& peer, const std::vector<Crypto::Hash>& hashes,
+  std::vector<block_complete_entry>&& blocks, const std::vector<Crypto::Hash>& missed) {
+  const Crypto::Hash* key = !hashes.empty() ? &hashes.front() : (!missed.empty() ? &missed.front() : nullptr);
+  if (key == nullptr) {
+    return Delivery::STALE;
+  }
+
+  auto height = m_chunkHeights.find(*key);
+  if (height == m_chunkHeights.end()) {
+    return Delivery::STALE;
+  }
+
+  Chunk& chunk = m_chunks.at(height->second);
+  if (chunk.downloaded) {
+    return Delivery::STALE;
+  }
+
+  bool complete = missed.empty() && hashes.size() == chunk.ids.size() && blocks.size() == hashes.size();
+  std::vector<block_complete_entry> ordered;
+  if (complete) {
+    std::unordered_map<Crypto::Hash, size_t> positions;
+    for (size_t i = 0; i < chunk.ids.size(); ++i) {
+      positions[chunk.ids[i]] = i;
+    }
+
+    ordered.resize(chunk.ids.size());
+    std::vector<bool> filled(chunk.ids.size(), false);
+    for (size_t i = 0; i < hashes.size() && complete; ++i) {
+      auto position = positions.find(hashes[i]);
+      if (position == positions.end() || filled[position->second]) {
+        complete = false;
+      } else {
+        filled[position->second] = true;
+        ordered[position->second] = std::move(blocks[i]);
+      }
+    }
+  }
+
+  if (!complete) {
+    releaseRequest(chunk, peer);
+    return Delivery::INCOMPLETE;
+  }
+
+  releaseRequests(chunk);
+  chunk.blocks = std::move(ordered);
+  chunk.deliveredBy = peer;
+  chunk.downloaded = true;
+
+  Peer& state = getPeer(peer);
+  state.limit = std::min(state.limit + 1, m_chunksPerPeer);
+  return Delivery::ACCEPTED;
+}
+
+bool BlockDownloadScheduler::popReady(std::vector<block_complete_entry>& blocks, PeerId& deliveredBy) {
+  if (m_chunks.empty() || !m_chunks.begin()->second.downloaded) {
+    return false;
+  }
+
+  Chunk& chunk = m_chunks.begin()->second;
+  blocks = std::move(chunk.blocks);
+  deliveredBy = chunk.deliveredBy;
+  for (const auto& id : chunk.ids) {
+    m_chunkHeights.erase(id);
+  }
+
+  m_chunks.erase(m_chunks.begin());
+  return true;
+}
+
+size_t BlockDownloadScheduler::expire(Clock::time_point now, PeerRequests& expired) {
+  size_t count = 0;
+  for (auto& item : m_chunks) {
+    auto& requests = item.second.requests;
+    for (auto it = requests.begin(); it != requests.end();) {
+      if (now - it->time < m_chunkTimeout) {
+        ++it;
+        continue;
+      }
+
+      Peer& state = getPeer(it->peer);
+      --state.inFlight;
+      state.limit = 1;
+      item.second.timedOutPeer = it->peer;
+      item.second.timeoutTime = now;
+      auto& ids = expired[it->peer];
+      ids.insert(ids.end(), item.second.ids.begin(), item.second.ids.end());
+      it = requests.erase(it);
+      ++count;
+    }
+  }
+
+  return count;
+}
+
+void BlockDownloadScheduler::removePeer(const PeerId& peer) {
+  for (auto& item : m_chunks) {
+    releaseRequest(item.second, peer);
+  }
+
+  m_peers.erase(peer);
+  if (m_blockIdsRequested && m_blockIdsPeer == peer) {
+    m_blockIdsRequested = false;
+  }
+}
+
+void BlockDownloadScheduler::reset() {
+  m_chunks.clear();
+  m_chunkHeights.clear();
+  m_peers.clear();
+  m_nextHeight = 0;
+  m_blockIdsRequested = false;
+}
+
+BlockDownloadScheduler::Peer& BlockDownloadScheduler::getPeer(const PeerId& peer) {
+  return m_peers.emplace(peer, Peer{ 0, m_chunksPerPeer }).first->second;
+}
+
+void BlockDownloadScheduler::startRequest(Chunk& chunk, const PeerId& peer, Clock::time_point now) {
+  chunk.requests.push_back(Request{ peer, now });
+  ++getPeer(peer).inFlight;
+}
+
+void BlockDownloadScheduler::releaseRequest(Chunk& chunk, const PeerId& peer) {
+  auto it = std::find_if(chunk.requests.begin(), chunk.requests.end(), [&peer](const Request& request) { return request.peer == peer; });
+  if (it != chunk.requests.end()) {
+    --getPeer(peer).inFlight;
+    chunk.requests.erase(it);
+  }
+}
+
+void BlockDownloadScheduler::releaseRequests(Chunk& chunk) {
+  for (const auto& request : chunk.requests) {
+    --getPeer(request.peer).inFlight;
+  }
+
+  chunk.requests.clear();
+}
+
+}
@@ -0,0 +1,112 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2014-2017 XDN developers
+// Copyright (c) 2016-2017 BXC developers
+// Copyright (c) 2017 Doppler developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <chrono>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/functional/hash.hpp>
+#include <boost/uuid/uuid.hpp>
+
+#include "CryptoNoteProtocol/CryptoNoteProtocolDefinitions.h"
+#include "crypto/hash.h"
+
+namespace CryptoNote {
+
+// Splits the block span being synchronized into chunks and hands them out to several peers at once.
+// Only the first windowChunks chunks are downloaded ahead of the oldest unprocessed one, every peer keeps
+// a limited number of chunks in flight, and downloaded chunks are given back strictly in height order.
+// Requests that time out are handed to other peers, as is the oldest chunk when it holds back a full window.
+class BlockDownloadScheduler {
+public:
+  typedef std::chrono::steady_clock Clock;
+  typedef boost::uuids::uuid PeerId;
+  typedef std::unordered_map<PeerId, std::vector<Crypto::Hash>, boost::hash<PeerId>> PeerRequests;
+
+  enum class Delivery {
+    ACCEPTED,
+    STALE,      // chunk is already downloaded or was dropped by reset
+    INCOMPLETE  // peer doesn't have all the blocks, the chunk goes to someone else
+  };
+
+  BlockDownloadScheduler(size_t chunkSize, size_t windowChunks, size_t chunksPerPeer, std::chrono::seconds chunkTimeout, std::chrono::seconds stallTimeout);
+
+  bool empty() const;
+  // height following the last scheduled block
+  uint32_t nextHeight() const;
+
+  // Appends block ids of a chain entry starting at startHeight. Ids overlapping the scheduled span have to
+  // match it, so an entry from a peer on another chain is refused while the current span is downloaded.
+  bool addBlockIds(uint32_t startHeight, const std::vector<Crypto::Hash>& ids);
+  // true when the peer should be asked for more block ids; only one such request is outstanding at a time
+  bool requestBlockIds(const PeerId& peer, Clock::time_point now);
+
+  // picks the next chunk for a peer that has blocks below peerHeight, false if it has nothing to do
+  bool assignChunk(const PeerId& peer, uint32_t peerHeight, Clock::time_point now, std::vector<Crypto::Hash>& chunk);
+  size_t inFlight(const PeerId& peer) const;
+  // the block belongs to a chunk that isn't downloaded yet, a late response may still bring it
+  bool isPending(const Crypto::Hash& id) const;
+
+  // blocks must go along with their hashes, missed are the ids peer reported as unknown
+  Delivery deliver(const PeerId& peer, const std::vector<Crypto::Hash>& hashes, std::vector<block_complete_entry>&& blocks, const std::vector<Crypto::Hash>& missed);
+  // takes the oldest chunk if it is downloaded
+  bool popReady(std::vector<block_complete_entry>& blocks, PeerId& deliveredBy);
+
+  // releases timed out requests into expired by peer, returns their count; the peers that failed them
+  // get one chunk at a time
+  size_t expire(Clock::time_point now, PeerRequests& expired);
+  void removePeer(const PeerId& peer);
+  void reset();
+
+private:
+  struct Request {
+    PeerId peer;
+    Clock::time_point time;
+  };
+
+  struct Chunk {
+    std::vector<Crypto::Hash> ids;
+    std::vector<Request> requests;
+    std::vector<block_complete_entry> blocks;
+    PeerId deliveredBy;
+    bool downloaded;
+    // peer that let the last request time out gets the chunk back only if nobody else takes it for a while
+    PeerId timedOutPeer;
+    Clock::time_point timeoutTime;
+  };
+
+  struct Peer {
+    size_t inFlight;
+    size_t limit;
+  };
+
+  Peer& getPeer(const PeerId& peer);
+  void startRequest(Chunk& chunk, const PeerId& peer, Clock::time_point now);
+  void releaseRequest(Chunk& chunk, const PeerId& peer);
+  void releaseRequests(Chunk& chunk);
+
+  const size_t m_chunkSize;
+  const size_t m_windowChunks;
+  const size_t m_chunksPerPeer;
+  const std::chrono::seconds m_chunkTimeout;
+  const std::chrono::seconds m_stallTimeout;
+
+  std::map<uint32_t, Chunk> m_chunks; // by height of the first block
+  std::unordered_map<Crypto::Hash, uint32_t> m_chunkHeights; // block id -> chunk
+  std::unordered_map<PeerId, Peer, boost::hash<PeerId>> m_peers;
+  uint32_t m_nextHeight;
+  Crypto::Hash m_lastId;
+
+  bool m_blockIdsRequested;
+  PeerId m_blockIdsPeer;
+  Clock::time_point m_blockIdsRequestTime;
+};
+
+}
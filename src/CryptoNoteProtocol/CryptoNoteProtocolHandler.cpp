@@ -8,9 +8,11 @@
 #include "CryptoNoteProtocolHandler.h"
 
 #include <future>
+#include <limits>
 #include <boost/scope_exit.hpp>
 #include <boost/uuid/uuid_io.hpp>
 #include <System/Dispatcher.h>
+#include <System/RemoteContext.h>
 
 #include "CryptoNoteCore/CryptoNoteBasicImpl.h"
 #include "CryptoNoteCore/CryptoNoteFormatUtils.h"
@@ -31,11 +33,6 @@ bool post_notify(IP2pEndpoint& p2p, typename t_parametr::request& arg, const Cry
   return p2p.invoke_notify_to_peer(t_parametr::ID, LevinProtocol::encode(arg), context);
 }
 
-template<class t_parametr>
-void relay_post_notify(IP2pEndpoint& p2p, typename t_parametr::request& arg, const net_connection_id* excludeConnection = nullptr) {
-  p2p.relay_notify_to_all(t_parametr::ID, LevinProtocol::encode(arg), excludeConnection);
-}
-
 }
 
 CryptoNoteProtocolHandler::CryptoNoteProtocolHandler(const Currency& currency, System::Dispatcher& dispatcher, ICore& rcore, IP2pEndpoint* p_net_layout, Logging::ILogger& log) :
@@ -47,6 +44,13 @@ CryptoNoteProtocolHandler::CryptoNoteProtocolHandler(const Currency& currency, S
   m_stop(false),
   m_observedHeight(0),
   m_peersCount(0),
+  m_blockDownload(BLOCKS_SYNCHRONIZING_CHUNK_COUNT, BLOCKS_SYNCHRONIZING_WINDOW_CHUNKS, BLOCKS_SYNCHRONIZING_CHUNKS_PER_PEER,
+    std::chrono::seconds(BLOCKS_SYNCHRONIZING_CHUNK_TIMEOUT), std::chrono::seconds(BLOCKS_SYNCHRONIZING_STALL_TIMEOUT)),
+  m_earlyBlockRelay(false),
+  m_txRelay(P2P_TX_KNOWN_PER_PEER, P2P_TX_ANNOUNCE_MAX_COUNT, P2P_TX_QUEUED_PER_PEER, P2P_TX_REQUESTS_PER_PEER, P2P_TX_REQUESTS_MAX_COUNT,
+    P2P_TX_ANNOUNCERS_PER_REQUEST, std::chrono::milliseconds(P2P_TX_ANNOUNCE_INTERVAL), std::chrono::seconds(P2P_TX_REQUEST_TIMEOUT)),
+  m_processingBlocks(false),
+  m_validationContext(dispatcher),
   logger(log, "protocol") {
   
   if (!m_p2p) {
@@ -65,10 +69,18 @@ void CryptoNoteProtocolHandler::set_p2p_endpoint(IP2pEndpoint* p2p) {
     m_p2p = &m_p2p_stub;
 }
 
+void CryptoNoteProtocolHandler::setEarlyBlockRelay(bool enabled) {
+  m_earlyBlockRelay = enabled;
+}
+
 void CryptoNoteProtocolHandler::onConnectionOpened(CryptoNoteConnectionContext& context) {
 }
 
 void CryptoNoteProtocolHandler::onConnectionClosed(CryptoNoteConnectionContext& context) {
+  m_blockDownload.removePeer(context.m_connection_id);
+  m_pendingCompactBlocks.erase(context.m_connection_id);
+  m_txRelay.removePeer(context.m_connection_id);
+
   bool updated = false;
   {
     std::lock_guard<std::mutex> lock(m_observedHeightMutex);
@@ -98,7 +110,6 @@ bool CryptoNoteProtocolHandler::start_sync(CryptoNoteConnectionContext& context)
   logger(Logging::TRACE) << context << "Starting synchronization";
 
   if (context.m_state == CryptoNoteConnectionContext::state_synchronizing) {
-    assert(context.m_needed_objects.empty());
     assert(context.m_requested_objects.empty());
 
     NOTIFY_REQUEST_CHAIN::request r = boost::value_initialized<NOTIFY_REQUEST_CHAIN::request>();
@@ -119,7 +130,7 @@ void CryptoNoteProtocolHandler::log_connections() {
 
   ss << std::setw(25) << std::left << "Remote Host"
     << std::setw(20) << "Peer id"
-    << std::setw(25) << "Recv/Sent (inactive,sec)"
+    << std::setw(35) << "Recv/Sent bytes (inactive,sec)"
     << std::setw(25) << "State"
     << std::setw(20) << "Lifetime(seconds)" << ENDL;
 
@@ -127,7 +138,8 @@ void CryptoNoteProtocolHandler::log_connections() {
     ss << std::setw(25) << std::left << std::string(cntxt.m_is_income ? "[INC]" : "[OUT]") +
       Common::ipAddressToString(cntxt.m_remote_ip) + ":" + std::to_string(cntxt.m_remote_port)
       << std::setw(20) << std::hex << peer_id
-      // << std::setw(25) << std::to_string(cntxt.m_recv_cnt) + "(" + std::to_string(time(NULL) - cntxt.m_last_recv) + ")" + "/" + std::to_string(cntxt.m_send_cnt) + "(" + std::to_string(time(NULL) - cntxt.m_last_send) + ")"
+      << std::setw(35) << std::dec << std::to_string(cntxt.m_recv_cnt) + "(" + (cntxt.m_last_recv ? std::to_string(time(NULL) - cntxt.m_last_recv) : "-") + ")" + "/" +
+        std::to_string(cntxt.m_send_cnt) + "(" + (cntxt.m_last_send ? std::to_string(time(NULL) - cntxt.m_last_send) : "-") + ")"
       << std::setw(25) << get_protocol_state_string(cntxt.m_state)
       << std::setw(20) << std::to_string(time(NULL) - cntxt.m_started) << ENDL;
   });
@@ -215,6 +227,11 @@ int CryptoNoteProtocolHandler::handleCommand(bool is_notify, int command, const
     HANDLE_NOTIFY(NOTIFY_REQUEST_CHAIN, &CryptoNoteProtocolHandler::handle_request_chain)
     HANDLE_NOTIFY(NOTIFY_RESPONSE_CHAIN_ENTRY, &CryptoNoteProtocolHandler::handle_response_chain_entry)
     HANDLE_NOTIFY(NOTIFY_REQUEST_TX_POOL, &CryptoNoteProtocolHandler::handleRequestTxPool)
+    HANDLE_NOTIFY(NOTIFY_NEW_COMPACT_BLOCK, &CryptoNoteProtocolHandler::handleNotifyNewCompactBlock)
+    HANDLE_NOTIFY(NOTIFY_REQUEST_BLOCK_TXS, &CryptoNoteProtocolHandler::handleRequestBlockTxs)
+    HANDLE_NOTIFY(NOTIFY_RESPONSE_BLOCK_TXS, &CryptoNoteProtocolHandler::handleResponseBlockTxs)
+    HANDLE_NOTIFY(NOTIFY_TX_INVENTORY, &CryptoNoteProtocolHandler::handleTxInventory)
+    HANDLE_NOTIFY(NOTIFY_REQUEST_TXS, &CryptoNoteProtocolHandler::handleRequestTxs)
 
   default:
     handled = false;
@@ -236,28 +253,79 @@ int CryptoNoteProtocolHandler::handle_notify_new_block(int command, NOTIFY_NEW_B
     return 1;
   }
 
+  addNewBlock(arg, context);
+  return 1;
+}
+
+void CryptoNoteProtocolHandler::addNewBlock(NOTIFY_NEW_BLOCK::request& arg, CryptoNoteConnectionContext& context) {
   for (auto tx_blob_it = arg.b.txs.begin(); tx_blob_it != arg.b.txs.end(); tx_blob_it++) {
     CryptoNote::tx_verification_context tvc = boost::value_initialized<decltype(tvc)>();
     m_core.handle_incoming_tx(asBinaryArray(*tx_blob_it), tvc, true);
     if (tvc.m_verifivation_failed) {
       logger(Logging::INFO) << context << "Block verification failed: transaction verification failed, dropping connection";
+      m_p2p->report_invalid_data(context);
       context.m_state = CryptoNoteConnectionContext::state_shutdown;
-      return 1;
+      return;
     }
   }
 
+  Block b;
+  if (!fromBinaryArray(b, asBinaryArray(arg.b.block))) {
+    logger(Logging::INFO) << context << "Failed to parse block, dropping connection";
+    m_p2p->report_invalid_data(context);
+    context.m_state = CryptoNoteConnectionContext::state_shutdown;
+    return;
+  }
+
+  // the same block from another peer is being validated already
+  auto blockHash = get_block_hash(b);
+  if (!m_blocksInValidation.insert(blockHash).second) {
+    return;
+  }
+
+  BOOST_SCOPE_EXIT_ALL(this, &blockHash) { m_blocksInValidation.erase(blockHash); };
+
+  bool relayedEarly = false;
+  bool proofOfWorkValid = false;
+  if (m_earlyBlockRelay) {
+    // the slow hash is computed off the dispatcher thread, as the validation below
+    System::RemoteContext<bool> proofOfWorkCheck(m_dispatcher, [this, &b] {
+      return m_core.checkBlockProofOfWork(b);
+    });
+
+    proofOfWorkValid = proofOfWorkCheck.get();
+  }
+
+  if (proofOfWorkValid) {
+    logger(Logging::DEBUGGING) << context << "Relaying block " << Common::podToHex(blockHash) << " before its validation";
+    relayCompactBlock(arg.b.block, arg.current_blockchain_height, arg.hop + 1, &context.m_connection_id);
+    relayedEarly = true;
+  }
+
+  // validation runs outside of the dispatcher thread, the early relay is sent and other connections are served meanwhile
   block_verification_context bvc = boost::value_initialized<block_verification_context>();
-  m_core.handle_incoming_block_blob(asBinaryArray(arg.b.block), bvc, true, false);
+  System::RemoteContext<void> validation(m_dispatcher, [this, &arg, &bvc] {
+    m_core.handle_incoming_block_blob(asBinaryArray(arg.b.block), bvc, true, false);
+  });
+
+  validation.get();
   if (bvc.m_verifivation_failed) {
+    if (relayedEarly) {
+      logger(Logging::WARNING) << context << "Block " << Common::podToHex(blockHash) << " relayed before validation turned out invalid";
+    }
+
     logger(Logging::DEBUGGING) << context << "Block verification failed, dropping connection";
+    m_p2p->report_invalid_data(context);
     context.m_state = CryptoNoteConnectionContext::state_shutdown;
-    return 1;
+    return;
   }
   if (bvc.m_added_to_main_chain) {
     ++arg.hop;
-    //TODO: Add here announce protocol usage
-    relay_post_notify<NOTIFY_NEW_BLOCK>(*m_p2p, arg, &context.m_connection_id);
-    // relay_block(arg, context);
+    if (relayedEarly) {
+      relayFullBlock(arg, &context.m_connection_id);
+    } else {
+      relayBlock(arg, &context.m_connection_id);
+    }
 
     if (bvc.m_switched_to_alt_chain) {
       requestMissingPoolTransactions(context);
@@ -269,36 +337,240 @@ int CryptoNoteProtocolHandler::handle_notify_new_block(int command, NOTIFY_NEW_B
     logger(Logging::TRACE) << context << "-->>NOTIFY_REQUEST_CHAIN: m_block_ids.size()=" << r.block_ids.size();
     post_notify<NOTIFY_REQUEST_CHAIN>(*m_p2p, r, context);
   }
+}
+
+int CryptoNoteProtocolHandler::handleNotifyNewCompactBlock(int command, NOTIFY_NEW_COMPACT_BLOCK::request& arg, CryptoNoteConnectionContext& context) {
+  logger(Logging::TRACE) << context << "NOTIFY_NEW_COMPACT_BLOCK (hop " << arg.hop << ")";
+
+  updateObservedHeight(arg.current_blockchain_height, context);
+
+  context.m_remote_blockchain_height = arg.current_blockchain_height;
+
+  if (context.m_state != CryptoNoteConnectionContext::state_normal) {
+    return 1;
+  }
+
+  Block b;
+  if (!fromBinaryArray(b, asBinaryArray(arg.block))) {
+    logger(Logging::INFO) << context << "Failed to parse compact block, dropping connection";
+    m_p2p->report_invalid_data(context);
+    context.m_state = CryptoNoteConnectionContext::state_shutdown;
+    return 1;
+  }
+
+  auto blockHash = get_block_hash(b);
+  if (m_core.have_block(blockHash)) {
+    return 1;
+  }
+
+  std::list<Transaction> poolTxs;
+  std::list<Crypto::Hash> missedTxs;
+  m_core.getTransactions(b.transactionHashes, poolTxs, missedTxs, true);
+
+  NOTIFY_NEW_BLOCK::request block;
+  block.b.block = std::move(arg.block);
+  block.current_blockchain_height = arg.current_blockchain_height;
+  block.hop = arg.hop;
+
+  if (missedTxs.empty()) {
+    addNewBlock(block, context);
+    return 1;
+  }
+
+  NOTIFY_REQUEST_BLOCK_TXS::request request;
+  request.block_hash = blockHash;
+  request.txs.assign(missedTxs.begin(), missedTxs.end());
+
+  // a newer block from the same peer replaces the one still waiting
+  PendingCompactBlock& pending = m_pendingCompactBlocks[context.m_connection_id];
+  pending.hash = blockHash;
+  pending.block = std::move(block);
+  pending.missedTxs = request.txs;
+  pending.requestTime = std::chrono::steady_clock::now();
+
+  logger(Logging::TRACE) << context << "-->>NOTIFY_REQUEST_BLOCK_TXS: txs.size()=" << request.txs.size() << " of " << b.transactionHashes.size();
+  post_notify<NOTIFY_REQUEST_BLOCK_TXS>(*m_p2p, request, context);
+  return 1;
+}
+
+int CryptoNoteProtocolHandler::handleRequestBlockTxs(int command, NOTIFY_REQUEST_BLOCK_TXS::request& arg, CryptoNoteConnectionContext& context) {
+  logger(Logging::TRACE) << context << "NOTIFY_REQUEST_BLOCK_TXS: txs.size()=" << arg.txs.size();
+
+  NOTIFY_RESPONSE_BLOCK_TXS::request response;
+  response.block_hash = arg.block_hash;
+
+  // only transactions of the block are served, an unknown block gets an empty response
+  Block block;
+  std::vector<Crypto::Hash> blockTxs;
+  if (m_core.getBlockByHash(arg.block_hash, block)) {
+    std::unordered_set<Crypto::Hash> requested(arg.txs.begin(), arg.txs.end());
+    for (const auto& hash : block.transactionHashes) {
+      if (requested.count(hash) != 0) {
+        blockTxs.push_back(hash);
+      }
+    }
+  }
+
+  // the block has just been added, so its transactions are in the blockchain, or in the pool after a switch
+  std::list<Transaction> txs;
+  std::list<Crypto::Hash> missedTxs;
+  m_core.getTransactions(blockTxs, txs, missedTxs, true);
+
+  for (const auto& tx : txs) {
+    response.txs.push_back(asString(toBinaryArray(tx)));
+  }
+
+  logger(Logging::TRACE) << context << "-->>NOTIFY_RESPONSE_BLOCK_TXS: txs.size()=" << response.txs.size() << ", missed " << missedTxs.size();
+  post_notify<NOTIFY_RESPONSE_BLOCK_TXS>(*m_p2p, response, context);
+  return 1;
+}
+
+int CryptoNoteProtocolHandler::handleResponseBlockTxs(int command, NOTIFY_RESPONSE_BLOCK_TXS::request& arg, CryptoNoteConnectionContext& context) {
+  logger(Logging::TRACE) << context << "NOTIFY_RESPONSE_BLOCK_TXS: txs.size()=" << arg.txs.size();
+
+  auto it = m_pendingCompactBlocks.find(context.m_connection_id);
+  if (it == m_pendingCompactBlocks.end() || it->second.hash != arg.block_hash) {
+    return 1;
+  }
+
+  PendingCompactBlock pending = std::move(it->second);
+  m_pendingCompactBlocks.erase(it);
+
+  if (context.m_state != CryptoNoteConnectionContext::state_normal || m_core.have_block(pending.hash)) {
+    return 1;
+  }
+
+  if (arg.txs.size() != pending.missedTxs.size()) {
+    requestChainForCompactBlock(context, pending.hash, "Peer didn't return all transactions of compact block ");
+    return 1;
+  }
 
+  pending.block.b.txs = std::move(arg.txs);
+  addNewBlock(pending.block, context);
   return 1;
 }
 
+void CryptoNoteProtocolHandler::requestChainForCompactBlock(CryptoNoteConnectionContext& context, const Crypto::Hash& blockHash, const char* reason) {
+  // fall back to the full block, it comes by the usual synchronization
+  logger(Logging::DEBUGGING) << context << reason << Common::podToHex(blockHash) << ", requesting full block";
+  context.m_state = CryptoNoteConnectionContext::state_synchronizing;
+  NOTIFY_REQUEST_CHAIN::request r = boost::value_initialized<NOTIFY_REQUEST_CHAIN::request>();
+  r.block_ids = m_core.buildSparseChain();
+  logger(Logging::TRACE) << context << "-->>NOTIFY_REQUEST_CHAIN: m_block_ids.size()=" << r.block_ids.size();
+  post_notify<NOTIFY_REQUEST_CHAIN>(*m_p2p, r, context);
+}
+
+void CryptoNoteProtocolHandler::expireCompactBlocks() {
+  if (m_pendingCompactBlocks.empty()) {
+    return;
+  }
+
+  auto now = std::chrono::steady_clock::now();
+  m_p2p->for_each_connection([this, now](CryptoNoteConnectionContext& context, PeerIdType peerId) {
+    auto it = m_pendingCompactBlocks.find(context.m_connection_id);
+    if (it == m_pendingCompactBlocks.end() || now - it->second.requestTime < std::chrono::seconds(P2P_BLOCK_TXS_REQUEST_TIMEOUT)) {
+      return;
+    }
+
+    Crypto::Hash blockHash = it->second.hash;
+    m_pendingCompactBlocks.erase(it);
+    if (context.m_state == CryptoNoteConnectionContext::state_normal && !m_core.have_block(blockHash)) {
+      requestChainForCompactBlock(context, blockHash, "Missing transactions didn't arrive in time for compact block ");
+    }
+  });
+}
+
 int CryptoNoteProtocolHandler::handle_notify_new_transactions(int command, NOTIFY_NEW_TRANSACTIONS::request& arg, CryptoNoteConnectionContext& context) {
   logger(Logging::TRACE) << context << "NOTIFY_NEW_TRANSACTIONS";
   if (context.m_state != CryptoNoteConnectionContext::state_normal)
     return 1;
 
-  for (auto tx_blob_it = arg.txs.begin(); tx_blob_it != arg.txs.end();) {
-    CryptoNote::tx_verification_context tvc = boost::value_initialized<decltype(tvc)>();
-    m_core.handle_incoming_tx(asBinaryArray(*tx_blob_it), tvc, false);
-    if (tvc.m_verifivation_failed) {
+  std::vector<BinaryArray> txBlobs;
+  txBlobs.reserve(arg.txs.size());
+  for (const auto& tx_blob : arg.txs) {
+    txBlobs.push_back(asBinaryArray(tx_blob));
+
+    Crypto::Hash txHash = getBinaryArrayHash(txBlobs.back());
+    m_txRelay.received(txHash);
+    m_txRelay.markKnown(context.m_connection_id, txHash);
+  }
+
+  // verification runs outside of the dispatcher thread, other connections are served meanwhile
+  std::vector<tx_verification_context> tvcs;
+  System::RemoteContext<void> verification(m_dispatcher, [this, &txBlobs, &tvcs] {
+    m_core.handleIncomingTransactions(txBlobs, tvcs);
+  });
+
+  verification.get();
+
+  std::vector<std::string> relayedTxs;
+  for (size_t i = 0; i < tvcs.size(); ++i) {
+    if (tvcs[i].m_verifivation_failed) {
       logger(Logging::INFO) << context << "Tx verification failed";
     }
-    if (!tvc.m_verifivation_failed && tvc.m_should_be_relayed) {
-      ++tx_blob_it;
-    } else {
-      tx_blob_it = arg.txs.erase(tx_blob_it);
+    if (!tvcs[i].m_verifivation_failed && tvcs[i].m_should_be_relayed) {
+      relayedTxs.push_back(std::move(arg.txs[i]));
     }
   }
 
-  if (arg.txs.size()) {
-    //TODO: add announce usage here
-    relay_post_notify<NOTIFY_NEW_TRANSACTIONS>(*m_p2p, arg, &context.m_connection_id);
+  if (!relayedTxs.empty()) {
+    relayTransactions(relayedTxs, &context.m_connection_id);
   }
 
   return true;
 }
 
+int CryptoNoteProtocolHandler::handleTxInventory(int command, NOTIFY_TX_INVENTORY::request& arg, CryptoNoteConnectionContext& context) {
+  logger(Logging::TRACE) << context << "NOTIFY_TX_INVENTORY: txs.size()=" << arg.txs.size();
+  if (arg.txs.size() > P2P_TX_ANNOUNCE_MAX_COUNT) {
+    logger(Logging::INFO) << context << "Transaction inventory of " << arg.txs.size() << " hashes exceeds the limit, dropping connection";
+    m_p2p->report_invalid_data(context);
+    context.m_state = CryptoNoteConnectionContext::state_shutdown;
+    return 1;
+  }
+
+  if (context.m_state != CryptoNoteConnectionContext::state_normal) {
+    return 1;
+  }
+
+  std::vector<Crypto::Hash> unknownTxs;
+  for (const auto& tx : arg.txs) {
+    m_txRelay.markKnown(context.m_connection_id, tx);
+    if (!m_core.haveTransaction(tx)) {
+      unknownTxs.push_back(tx);
+    }
+  }
+
+  NOTIFY_REQUEST_TXS::request request;
+  m_txRelay.request(context.m_connection_id, unknownTxs, TransactionRelay::Clock::now(), request.txs);
+  if (!request.txs.empty()) {
+    logger(Logging::TRACE) << context << "-->>NOTIFY_REQUEST_TXS: txs.size()=" << request.txs.size();
+    post_notify<NOTIFY_REQUEST_TXS>(*m_p2p, request, context);
+  }
+
+  return 1;
+}
+
+int CryptoNoteProtocolHandler::handleRequestTxs(int command, NOTIFY_REQUEST_TXS::request& arg, CryptoNoteConnectionContext& context) {
+  logger(Logging::TRACE) << context << "NOTIFY_REQUEST_TXS: txs.size()=" << arg.txs.size();
+
+  std::list<Transaction> txs;
+  std::list<Crypto::Hash> missedTxs;
+  m_core.getTransactions(arg.txs, txs, missedTxs, true);
+
+  if (!txs.empty()) {
+    NOTIFY_NEW_TRANSACTIONS::request response;
+    for (const auto& tx : txs) {
+      response.txs.push_back(asString(toBinaryArray(tx)));
+    }
+
+    logger(Logging::TRACE) << context << "-->>NOTIFY_NEW_TRANSACTIONS: txs.size()=" << response.txs.size() << ", missed " << missedTxs.size();
+    post_notify<NOTIFY_NEW_TRANSACTIONS>(*m_p2p, response, context);
+  }
+
+  return 1;
+}
+
 int CryptoNoteProtocolHandler::handle_request_get_objects(int command, NOTIFY_REQUEST_GET_OBJECTS::request& arg, CryptoNoteConnectionContext& context) {
   logger(Logging::TRACE) << context << "NOTIFY_REQUEST_GET_OBJECTS";
   NOTIFY_RESPONSE_GET_OBJECTS::request rsp;
@@ -326,31 +598,30 @@ int CryptoNoteProtocolHandler::handle_response_get_objects(int command, NOTIFY_R
 
   context.m_remote_blockchain_height = arg.current_blockchain_height;
 
-  size_t count = 0;
+  // requests are pipelined, the next response starts to come when this one is received
+  auto now = BlockDownloadScheduler::Clock::now();
+  uint64_t size = 0;
+  std::vector<Crypto::Hash> hashes;
+  hashes.reserve(arg.blocks.size());
   for (const block_complete_entry& block_entry : arg.blocks) {
-    ++count;
+    size += block_entry.block.size();
+    for (const auto& tx : block_entry.txs) {
+      size += tx.size();
+    }
+
     Block b;
     if (!fromBinaryArray(b, asBinaryArray(block_entry.block))) {
       logger(Logging::ERROR) << context << "sent wrong block: failed to parse and validate block: \r\n"
         << toHex(asBinaryArray(block_entry.block)) << "\r\n dropping connection";
+      m_p2p->report_invalid_data(context);
       context.m_state = CryptoNoteConnectionContext::state_shutdown;
       return 1;
     }
 
-    //to avoid concurrency in core between connections, suspend connections which delivered block later then first one
-    if (count == 2) {
-      if (m_core.have_block(get_block_hash(b))) {
-        context.m_state = CryptoNoteConnectionContext::state_idle;
-        context.m_needed_objects.clear();
-        context.m_requested_objects.clear();
-        logger(Logging::DEBUGGING) << context << "Connection set to idle state.";
-        return 1;
-      }
-    }
-
     auto blockHash = get_block_hash(b);
     auto req_it = context.m_requested_objects.find(blockHash);
-    if (req_it == context.m_requested_objects.end()) {
+    // a request that timed out is no longer in m_requested_objects, but its chunk may still be missing
+    if (req_it == context.m_requested_objects.end() && !m_blockDownload.isPending(blockHash)) {
       logger(Logging::ERROR) << context << "sent wrong NOTIFY_RESPONSE_GET_OBJECTS: block with id=" << Common::podToHex(blockHash)
         << " wasn't requested, dropping connection";
       context.m_state = CryptoNoteConnectionContext::state_shutdown;
@@ -363,41 +634,105 @@ int CryptoNoteProtocolHandler::handle_response_get_objects(int command, NOTIFY_R
       return 1;
     }
 
-    context.m_requested_objects.erase(req_it);
+    context.m_requested_objects.erase(blockHash);
+    hashes.push_back(blockHash);
   }
 
-  if (context.m_requested_objects.size()) {
-    logger(Logging::ERROR, Logging::BRIGHT_RED) << context <<
-      "returned not all requested objects (context.m_requested_objects.size()="
-      << context.m_requested_objects.size() << "), dropping connection";
-    context.m_state = CryptoNoteConnectionContext::state_shutdown;
-    return 1;
+  for (const auto& id : arg.missed_ids) {
+    context.m_requested_objects.erase(id);
   }
 
-  {
-    m_core.pause_mining();
+  if (!arg.blocks.empty()) {
+    m_p2p->report_download(context, size, std::chrono::duration_cast<std::chrono::milliseconds>(now - context.m_download_started));
+  }
 
-    BOOST_SCOPE_EXIT_ALL(this) { m_core.update_block_template_and_resume_mining(); };
+  context.m_download_started = now;
+
+  switch (m_blockDownload.deliver(context.m_connection_id, hashes, std::move(arg.blocks), arg.missed_ids)) {
+  case BlockDownloadScheduler::Delivery::ACCEPTED:
+    break;
+  case BlockDownloadScheduler::Delivery::STALE:
+    logger(Logging::DEBUGGING) << context << "Blocks were already downloaded from another peer, ignoring them";
+    break;
+  case BlockDownloadScheduler::Delivery::INCOMPLETE:
+    logger(Logging::DEBUGGING) << context << "Returned not all requested blocks, connection set to idle state";
+    m_blockDownload.removePeer(context.m_connection_id);
+    context.m_state = CryptoNoteConnectionContext::state_idle;
+    context.m_requested_objects.clear();
+    break;
+  }
 
-    int result = processObjects(context, arg.blocks);
-    if (result != 0) {
-      return result;
-    }
+  if (!m_stop && context.m_state == CryptoNoteConnectionContext::state_synchronizing) {
+    request_missing_objects(context);
+  }
+
+  processDownloadedBlocks();
+  return 1;
+}
+
+void CryptoNoteProtocolHandler::processDownloadedBlocks() {
+  // chunks downloaded while one is validated wait in the scheduler window, which holds back further requests
+  if (m_processingBlocks || m_stop) {
+    return;
+  }
+
+  m_processingBlocks = true;
+  m_validationContext.spawn(std::bind(&CryptoNoteProtocolHandler::validateDownloadedBlocks, this));
+}
+
+void CryptoNoteProtocolHandler::validateDownloadedBlocks() {
+  BOOST_SCOPE_EXIT_ALL(this) { m_processingBlocks = false; };
+
+  std::vector<block_complete_entry> blocks;
+  net_connection_id deliveredBy;
+  if (!m_blockDownload.popReady(blocks, deliveredBy)) {
+    return;
   }
 
+  m_core.pause_mining();
+  BOOST_SCOPE_EXIT_ALL(this) { m_core.update_block_template_and_resume_mining(); };
+
+  do {
+    // the window has moved, peers fetch further chunks while this one is validated
+    requestMissingObjects();
+
+    // validation runs outside of the dispatcher thread, so responses keep being read and answered meanwhile
+    std::string error;
+    System::RemoteContext<bool> validation(m_dispatcher, [this, &blocks, &error] {
+      return processObjects(blocks, error);
+    });
+
+    if (!validation.get()) {
+      dropConnection(deliveredBy, error);
+      // the blocks scheduled after the failed one can't be added either, and the peer gets no more chunks
+      m_blockDownload.removePeer(deliveredBy);
+      m_blockDownload.reset();
+      return;
+    }
+  } while (!m_stop && m_blockDownload.popReady(blocks, deliveredBy));
+
   uint32_t height;
   Crypto::Hash top;
   m_core.get_blockchain_top(height, top);
   logger(DEBUGGING, BRIGHT_GREEN) << "Local blockchain updated, new height = " << height;
 
-  if (!m_stop && context.m_state == CryptoNoteConnectionContext::state_synchronizing) {
-    request_missing_objects(context, true);
-  }
+  // peers which had nothing left to download may be synchronized now
+  m_processingBlocks = false;
+  requestMissingObjects();
+}
 
-  return 1;
+void CryptoNoteProtocolHandler::dropConnection(const net_connection_id& connectionId, const std::string& reason) {
+  m_p2p->for_each_connection([&](CryptoNoteConnectionContext& context, PeerIdType peerId) {
+    if (context.m_connection_id == connectionId) {
+      logger(Logging::INFO) << context << reason << ", dropping connection";
+      m_p2p->report_invalid_data(context);
+      context.m_state = CryptoNoteConnectionContext::state_shutdown;
+      m_p2p->drop_connection(context);
+    }
+  });
 }
 
-int CryptoNoteProtocolHandler::processObjects(CryptoNoteConnectionContext& context, const std::vector<block_complete_entry>& blocks) {
+bool CryptoNoteProtocolHandler::processObjects(const std::vector<block_complete_entry>& blocks, std::string& error) {
 
   for (const block_complete_entry& block_entry : blocks) {
     if (m_stop) {
@@ -409,10 +744,8 @@ int CryptoNoteProtocolHandler::processObjects(CryptoNoteConnectionContext& conte
       tx_verification_context tvc = boost::value_initialized<decltype(tvc)>();
       m_core.handle_incoming_tx(asBinaryArray(tx_blob), tvc, true);
       if (tvc.m_verifivation_failed) {
-        logger(Logging::ERROR) << context << "transaction verification failed on NOTIFY_RESPONSE_GET_OBJECTS, \r\ntx_id = "
-          << Common::podToHex(getBinaryArrayHash(asBinaryArray(tx_blob))) << ", dropping connection";
-        context.m_state = CryptoNoteConnectionContext::state_shutdown;
-        return 1;
+        error = "Transaction verification failed on NOTIFY_RESPONSE_GET_OBJECTS, tx_id = " + Common::podToHex(getBinaryArrayHash(asBinaryArray(tx_blob)));
+        return false;
       }
     }
 
@@ -421,30 +754,41 @@ int CryptoNoteProtocolHandler::processObjects(CryptoNoteConnectionContext& conte
     m_core.handle_incoming_block_blob(asBinaryArray(block_entry.block), bvc, false, false);
 
     if (bvc.m_verifivation_failed) {
-      logger(Logging::DEBUGGING) << context << "Block verification failed, dropping connection";
-      context.m_state = CryptoNoteConnectionContext::state_shutdown;
-      return 1;
+      error = "Block verification failed";
+      return false;
     } else if (bvc.m_marked_as_orphaned) {
-      logger(Logging::INFO) << context << "Block received at sync phase was marked as orphaned, dropping connection";
-      context.m_state = CryptoNoteConnectionContext::state_shutdown;
-      return 1;
-    } else if (bvc.m_already_exists) {
-      logger(Logging::DEBUGGING) << context << "Block already exists, switching to idle state";
-      context.m_state = CryptoNoteConnectionContext::state_idle;
-      context.m_needed_objects.clear();
-      context.m_requested_objects.clear();
-      return 1;
+      error = "Block received at sync phase was marked as orphaned";
+      return false;
     }
 
-    m_dispatcher.yield();
+    // a block which already exists came by relay meanwhile, nothing to do with it
   }
 
-  return 0;
+  return true;
 
 }
 
 
 bool CryptoNoteProtocolHandler::on_idle() {
+  BlockDownloadScheduler::PeerRequests expiredRequests;
+  size_t expired = m_blockDownload.expire(BlockDownloadScheduler::Clock::now(), expiredRequests);
+  if (expired != 0) {
+    logger(Logging::DEBUGGING) << expired << " block requests timed out, requesting blocks from other peers";
+    m_p2p->for_each_connection([&expiredRequests](CryptoNoteConnectionContext& context, PeerIdType peerId) {
+      auto it = expiredRequests.find(context.m_connection_id);
+      if (it != expiredRequests.end()) {
+        for (const auto& id : it->second) {
+          context.m_requested_objects.erase(id);
+        }
+      }
+    });
+  }
+
+  expireCompactBlocks();
+  if (!m_stop) {
+    requestMissingObjects();
+  }
+
   return m_core.on_idle();
 }
 
@@ -471,50 +815,59 @@ int CryptoNoteProtocolHandler::handle_request_chain(int command, NOTIFY_REQUEST_
   return 1;
 }
 
-bool CryptoNoteProtocolHandler::request_missing_objects(CryptoNoteConnectionContext& context, bool check_having_blocks) {
-  if (context.m_needed_objects.size()) {
-    //we know objects that we need, request this objects
-    NOTIFY_REQUEST_GET_OBJECTS::request req;
-    size_t count = 0;
-    auto it = context.m_needed_objects.begin();
-
-    while (it != context.m_needed_objects.end() && count < BLOCKS_SYNCHRONIZING_DEFAULT_COUNT) {
-      if (!(check_having_blocks && m_core.have_block(*it))) {
-        req.blocks.push_back(*it);
-        ++count;
-        context.m_requested_objects.insert(*it);
-      }
-      it = context.m_needed_objects.erase(it);
+void CryptoNoteProtocolHandler::requestMissingObjects() {
+  // the best scored peers are the first to take chunks of the download window
+  std::vector<std::pair<double, CryptoNoteConnectionContext*>> peers;
+  m_p2p->for_each_connection([this, &peers](CryptoNoteConnectionContext& context, PeerIdType peerId) {
+    if (context.m_state == CryptoNoteConnectionContext::state_synchronizing) {
+      peers.emplace_back(m_p2p->get_peer_score(context), &context);
     }
+  });
+
+  std::stable_sort(peers.begin(), peers.end(), [](const std::pair<double, CryptoNoteConnectionContext*>& a, const std::pair<double, CryptoNoteConnectionContext*>& b) {
+    return a.first > b.first;
+  });
+
+  for (const auto& peer : peers) {
+    request_missing_objects(*peer.second);
+  }
+}
+
+bool CryptoNoteProtocolHandler::request_missing_objects(CryptoNoteConnectionContext& context) {
+  auto now = BlockDownloadScheduler::Clock::now();
+
+  NOTIFY_REQUEST_GET_OBJECTS::request req;
+  if (m_blockDownload.inFlight(context.m_connection_id) == 0) {
+    context.m_download_started = now;
+  }
+
+  while (m_blockDownload.assignChunk(context.m_connection_id, context.m_remote_blockchain_height, now, req.blocks)) {
+    context.m_requested_objects.insert(req.blocks.begin(), req.blocks.end());
     logger(Logging::TRACE) << context << "-->>NOTIFY_REQUEST_GET_OBJECTS: blocks.size()=" << req.blocks.size() << ", txs.size()=" << req.txs.size();
     post_notify<NOTIFY_REQUEST_GET_OBJECTS>(*m_p2p, req, context);
-  } else if (context.m_last_response_height < context.m_remote_blockchain_height - 1) {//we have to fetch more objects ids, request blockchain entry
+  }
 
-    NOTIFY_REQUEST_CHAIN::request r = boost::value_initialized<NOTIFY_REQUEST_CHAIN::request>();
-    r.block_ids = m_core.buildSparseChain();
-    logger(Logging::TRACE) << context << "-->>NOTIFY_REQUEST_CHAIN: m_block_ids.size()=" << r.block_ids.size();
-    post_notify<NOTIFY_REQUEST_CHAIN>(*m_p2p, r, context);
-  } else {
-    if (!(context.m_last_response_height ==
-      context.m_remote_blockchain_height - 1 &&
-      !context.m_needed_objects.size() &&
-      !context.m_requested_objects.size())) {
-      logger(Logging::ERROR, Logging::BRIGHT_RED)
-        << "request_missing_blocks final condition failed!"
-        << "\r\nm_last_response_height=" << context.m_last_response_height
-        << "\r\nm_remote_blockchain_height=" << context.m_remote_blockchain_height
-        << "\r\nm_needed_objects.size()=" << context.m_needed_objects.size()
-        << "\r\nm_requested_objects.size()=" << context.m_requested_objects.size() 
-        << "\r\non connection [" << context << "]";
-      return false;
-    }
+  if (m_blockDownload.inFlight(context.m_connection_id) != 0) {
+    return true;
+  }
 
+  uint32_t localHeight = get_current_blockchain_height() + 1;
+  if (context.m_remote_blockchain_height > std::max(localHeight, m_blockDownload.nextHeight())) {
+    //we have to fetch more objects ids, request blockchain entry
+    if (m_blockDownload.requestBlockIds(context.m_connection_id, now)) {
+      NOTIFY_REQUEST_CHAIN::request r = boost::value_initialized<NOTIFY_REQUEST_CHAIN::request>();
+      r.block_ids = m_core.buildSparseChain();
+      logger(Logging::TRACE) << context << "-->>NOTIFY_REQUEST_CHAIN: m_block_ids.size()=" << r.block_ids.size();
+      post_notify<NOTIFY_REQUEST_CHAIN>(*m_p2p, r, context);
+    }
+  } else if (context.m_remote_blockchain_height <= localHeight && m_blockDownload.empty() && !m_processingBlocks) {
     requestMissingPoolTransactions(context);
 
     context.m_state = CryptoNoteConnectionContext::state_normal;
     logger(Logging::INFO, Logging::BRIGHT_GREEN) << context << "SYNCHRONIZED OK";
     on_connection_synchronized();
   }
+
   return true;
 }
 
@@ -568,14 +921,21 @@ int CryptoNoteProtocolHandler::handle_response_chain_entry(int command, NOTIFY_R
       << arg.total_height << "\r\nm_start_height=" << arg.start_height
       << "\r\nm_block_ids.size()=" << arg.m_block_ids.size();
     context.m_state = CryptoNoteConnectionContext::state_shutdown;
+    return 1;
+  }
+
+  // the scheduler gets the entry from the last known block on
+  size_t known = 0;
+  while (known + 1 < arg.m_block_ids.size() && m_core.have_block(arg.m_block_ids[known + 1])) {
+    ++known;
   }
 
-  for (auto& bl_id : arg.m_block_ids) {
-    if (!m_core.have_block(bl_id))
-      context.m_needed_objects.push_back(bl_id);
+  std::vector<Crypto::Hash> ids(arg.m_block_ids.begin() + known, arg.m_block_ids.end());
+  if (!m_blockDownload.addBlockIds(arg.start_height + static_cast<uint32_t>(known), ids)) {
+    logger(Logging::DEBUGGING) << context << "NOTIFY_RESPONSE_CHAIN_ENTRY adds no blocks to the ones being downloaded";
   }
 
-  request_missing_objects(context, false);
+  requestMissingObjects();
   return 1;
 }
 
@@ -591,6 +951,7 @@ int CryptoNoteProtocolHandler::handleRequestTxPool(int command, NOTIFY_REQUEST_T
     NOTIFY_NEW_TRANSACTIONS::request notification;
     for (auto& tx : addedTransactions) {
       notification.txs.push_back(asString(toBinaryArray(tx)));
+      m_txRelay.markKnown(context.m_connection_id, Crypto::cn_fast_hash(notification.txs.back().data(), notification.txs.back().size()));
     }
 
     bool ok = post_notify<NOTIFY_NEW_TRANSACTIONS>(*m_p2p, notification, context);
@@ -604,13 +965,119 @@ int CryptoNoteProtocolHandler::handleRequestTxPool(int command, NOTIFY_REQUEST_T
 
 
 void CryptoNoteProtocolHandler::relay_block(NOTIFY_NEW_BLOCK::request& arg) {
-  auto buf = LevinProtocol::encode(arg);
-  m_p2p->externalRelayNotifyToAll(NOTIFY_NEW_BLOCK::ID, buf);
+  // can be called from external threads
+  m_dispatcher.remoteSpawn([this, arg]() mutable {
+    relayBlock(arg, nullptr);
+  });
+}
+
+void CryptoNoteProtocolHandler::relayBlock(NOTIFY_NEW_BLOCK::request& arg, const net_connection_id* excludeConnection) {
+  relayCompactBlock(arg.b.block, arg.current_blockchain_height, arg.hop, excludeConnection);
+  relayFullBlock(arg, excludeConnection);
+}
+
+void CryptoNoteProtocolHandler::relayCompactBlock(const std::string& block, uint32_t currentHeight, uint32_t hop, const net_connection_id* excludeConnection) {
+  NOTIFY_NEW_COMPACT_BLOCK::request compact;
+  compact.block = block;
+  compact.current_blockchain_height = currentHeight;
+  compact.hop = hop;
+  m_p2p->relay_notify_to_all(NOTIFY_NEW_COMPACT_BLOCK::ID, LevinProtocol::encode(compact), excludeConnection,
+    P2PProtocolVersion::V2, std::numeric_limits<uint8_t>::max());
+}
+
+void CryptoNoteProtocolHandler::relayFullBlock(NOTIFY_NEW_BLOCK::request& arg, const net_connection_id* excludeConnection) {
+  bool legacyPeers = false;
+  m_p2p->for_each_connection([&legacyPeers](CryptoNoteConnectionContext& context, PeerIdType peerId) {
+    legacyPeers = legacyPeers || (peerId != 0 && context.version < P2PProtocolVersion::V2);
+  });
+
+  if (!legacyPeers) {
+    return;
+  }
+
+  Block b;
+  if (arg.b.txs.empty() && fromBinaryArray(b, asBinaryArray(arg.b.block)) && !b.transactionHashes.empty()) {
+    // assembled from a compact block, the transactions are in the blockchain now
+    std::list<Transaction> txs;
+    std::list<Crypto::Hash> missedTxs;
+    m_core.getTransactions(b.transactionHashes, txs, missedTxs);
+    if (!missedTxs.empty()) {
+      return;
+    }
+
+    for (const auto& tx : txs) {
+      arg.b.txs.push_back(asString(toBinaryArray(tx)));
+    }
+  }
+
+  m_p2p->relay_notify_to_all(NOTIFY_NEW_BLOCK::ID, LevinProtocol::encode(arg), excludeConnection,
+    P2PProtocolVersion::V0, P2PProtocolVersion::V1);
 }
 
 void CryptoNoteProtocolHandler::relay_transactions(NOTIFY_NEW_TRANSACTIONS::request& arg) {
-  auto buf = LevinProtocol::encode(arg);
-  m_p2p->externalRelayNotifyToAll(NOTIFY_NEW_TRANSACTIONS::ID, buf);
+  // can be called from external threads
+  m_dispatcher.remoteSpawn([this, arg]() mutable {
+    relayTransactions(arg.txs, nullptr);
+  });
+}
+
+void CryptoNoteProtocolHandler::relayTransactions(std::vector<std::string>& txBlobs, const net_connection_id* excludeConnection) {
+  std::vector<Crypto::Hash> txHashes;
+  txHashes.reserve(txBlobs.size());
+  for (const auto& txBlob : txBlobs) {
+    txHashes.push_back(Crypto::cn_fast_hash(txBlob.data(), txBlob.size()));
+  }
+
+  bool legacyPeers = false;
+  m_p2p->for_each_connection([&](CryptoNoteConnectionContext& context, PeerIdType peerId) {
+    if (peerId == 0 || (excludeConnection != nullptr && context.m_connection_id == *excludeConnection)) {
+      return;
+    }
+
+    if (context.version < P2PProtocolVersion::V3) {
+      legacyPeers = true;
+    } else if (context.m_state == CryptoNoteConnectionContext::state_normal || context.m_state == CryptoNoteConnectionContext::state_synchronizing) {
+      for (const auto& txHash : txHashes) {
+        m_txRelay.queue(context.m_connection_id, txHash);
+      }
+    }
+  });
+
+  if (legacyPeers) {
+    NOTIFY_NEW_TRANSACTIONS::request notification;
+    notification.txs.swap(txBlobs);
+    m_p2p->relay_notify_to_all(NOTIFY_NEW_TRANSACTIONS::ID, LevinProtocol::encode(notification), excludeConnection,
+      P2PProtocolVersion::V0, P2PProtocolVersion::V2);
+  }
+}
+
+void CryptoNoteProtocolHandler::relayTransactionInventory() {
+  auto now = TransactionRelay::Clock::now();
+  TransactionRelay::PeerRequests retries;
+  size_t expired = m_txRelay.expire(now, retries);
+  if (expired != 0) {
+    logger(Logging::DEBUGGING) << expired << " transaction requests timed out, " << retries.size() << " peers are asked instead";
+  }
+
+  m_p2p->for_each_connection([&](CryptoNoteConnectionContext& context, PeerIdType peerId) {
+    if (peerId == 0 || context.version < P2PProtocolVersion::V3) {
+      return;
+    }
+
+    auto it = retries.find(context.m_connection_id);
+    if (it != retries.end()) {
+      NOTIFY_REQUEST_TXS::request request;
+      request.txs = std::move(it->second);
+      logger(Logging::TRACE) << context << "-->>NOTIFY_REQUEST_TXS: txs.size()=" << request.txs.size();
+      post_notify<NOTIFY_REQUEST_TXS>(*m_p2p, request, context);
+    }
+
+    NOTIFY_TX_INVENTORY::request inventory;
+    if (m_txRelay.takeAnnouncement(context.m_connection_id, now, inventory.txs)) {
+      logger(Logging::TRACE) << context << "-->>NOTIFY_TX_INVENTORY: txs.size()=" << inventory.txs.size();
+      post_notify<NOTIFY_TX_INVENTORY>(*m_p2p, inventory, context);
+    }
+  });
 }
 
 void CryptoNoteProtocolHandler::requestMissingPoolTransactions(const CryptoNoteConnectionContext& context) {
@@ -8,15 +8,20 @@
 #pragma once
 
 #include <atomic>
+#include <unordered_map>
+#include <unordered_set>
 
 #include <Common/ObserverManager.h>
+#include <System/ContextGroup.h>
 
 #include "CryptoNoteCore/ICore.h"
 
+#include "CryptoNoteProtocol/BlockDownloadScheduler.h"
 #include "CryptoNoteProtocol/CryptoNoteProtocolDefinitions.h"
 #include "CryptoNoteProtocol/CryptoNoteProtocolHandlerCommon.h"
 #include "CryptoNoteProtocol/ICryptoNoteProtocolObserver.h"
 #include "CryptoNoteProtocol/ICryptoNoteProtocolQuery.h"
+#include "CryptoNoteProtocol/TransactionRelay.h"
 
 #include "P2p/P2pProtocolDefinitions.h"
 #include "P2p/NetNodeCommon.h"
@@ -44,6 +49,8 @@ namespace CryptoNote
     virtual bool removeObserver(ICryptoNoteProtocolObserver* observer) override;
 
     void set_p2p_endpoint(IP2pEndpoint* p2p);
+    // new blocks which build on the tip and have enough proof of work are relayed before their full validation
+    void setEarlyBlockRelay(bool enabled);
     // ICore& get_core() { return m_core; }
     virtual bool isSynchronized() const override { return m_synchronized; }
     void log_connections();
@@ -61,6 +68,8 @@ namespace CryptoNote
     virtual size_t getPeerCount() const override;
     virtual uint32_t getObservedHeight() const override;
     void requestMissingPoolTransactions(const CryptoNoteConnectionContext& context);
+    // announces queued transactions to the peers whose timers fired and repeats timed out requests
+    void relayTransactionInventory();
 
   private:
     //----------------- commands handlers ----------------------------------------------
@@ -71,6 +80,11 @@ namespace CryptoNote
     int handle_request_chain(int command, NOTIFY_REQUEST_CHAIN::request& arg, CryptoNoteConnectionContext& context);
     int handle_response_chain_entry(int command, NOTIFY_RESPONSE_CHAIN_ENTRY::request& arg, CryptoNoteConnectionContext& context);
     int handleRequestTxPool(int command, NOTIFY_REQUEST_TX_POOL::request& arg, CryptoNoteConnectionContext& context);
+    int handleNotifyNewCompactBlock(int command, NOTIFY_NEW_COMPACT_BLOCK::request& arg, CryptoNoteConnectionContext& context);
+    int handleRequestBlockTxs(int command, NOTIFY_REQUEST_BLOCK_TXS::request& arg, CryptoNoteConnectionContext& context);
+    int handleResponseBlockTxs(int command, NOTIFY_RESPONSE_BLOCK_TXS::request& arg, CryptoNoteConnectionContext& context);
+    int handleTxInventory(int command, NOTIFY_TX_INVENTORY::request& arg, CryptoNoteConnectionContext& context);
+    int handleRequestTxs(int command, NOTIFY_REQUEST_TXS::request& arg, CryptoNoteConnectionContext& context);
 
     //----------------- i_cryptonote_protocol ----------------------------------
     virtual void relay_block(NOTIFY_NEW_BLOCK::request& arg) override;
@@ -78,11 +92,25 @@ namespace CryptoNote
 
     //----------------------------------------------------------------------------------
     uint32_t get_current_blockchain_height();
-    bool request_missing_objects(CryptoNoteConnectionContext& context, bool check_having_blocks);
+    void addNewBlock(NOTIFY_NEW_BLOCK::request& arg, CryptoNoteConnectionContext& context);
+    // compact form to peers which support it, full block to the others
+    void relayBlock(NOTIFY_NEW_BLOCK::request& arg, const net_connection_id* excludeConnection);
+    void relayCompactBlock(const std::string& block, uint32_t currentHeight, uint32_t hop, const net_connection_id* excludeConnection);
+    void relayFullBlock(NOTIFY_NEW_BLOCK::request& arg, const net_connection_id* excludeConnection);
+    // hashes are queued for peers which support announcements, blobs go to the others
+    void relayTransactions(std::vector<std::string>& txBlobs, const net_connection_id* excludeConnection);
+    bool request_missing_objects(CryptoNoteConnectionContext& context);
+    void requestMissingObjects();
+    void processDownloadedBlocks();
+    void validateDownloadedBlocks();
+    void dropConnection(const net_connection_id& connectionId, const std::string& reason);
+    // the block of a compact block whose transactions didn't come is requested along with synchronization
+    void requestChainForCompactBlock(CryptoNoteConnectionContext& context, const Crypto::Hash& blockHash, const char* reason);
+    void expireCompactBlocks();
     bool on_connection_synchronized();
     void updateObservedHeight(uint32_t peerHeight, const CryptoNoteConnectionContext& context);
     void recalculateMaxObservedHeight(const CryptoNoteConnectionContext& context);
-    int processObjects(CryptoNoteConnectionContext& context, const std::vector<block_complete_entry>& blocks);
+    bool processObjects(const std::vector<block_complete_entry>& blocks, std::string& error);
     Logging::LoggerRef logger;
 
   private:
@@ -100,6 +128,23 @@ namespace CryptoNote
     uint32_t m_observedHeight;
 
     std::atomic<size_t> m_peersCount;
+    BlockDownloadScheduler m_blockDownload;
+
+    // compact block waiting for the transactions missing in the pool
+    struct PendingCompactBlock {
+      Crypto::Hash hash;
+      NOTIFY_NEW_BLOCK::request block;
+      std::vector<Crypto::Hash> missedTxs;
+      std::chrono::steady_clock::time_point requestTime;
+    };
+
+    std::unordered_map<net_connection_id, PendingCompactBlock, boost::hash<net_connection_id>> m_pendingCompactBlocks;
+    bool m_earlyBlockRelay;
+    std::unordered_set<Crypto::Hash> m_blocksInValidation;
+    TransactionRelay m_txRelay;
+    bool m_processingBlocks;
     Tools::ObserverManager<ICryptoNoteProtocolObserver> m_observerManager;
+    // runs block validation off the connection contexts, goes last to be stopped before the state it uses
+    System::ContextGroup m_validationContext;
   };
 }
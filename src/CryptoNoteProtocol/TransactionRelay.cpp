@@ -0,0 +1,186 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2014-2017 XDN developers
+// Copyright (c) 2016-2017 BXC developers
+// Copyright (c) 2017 Doppler developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "TransactionRelay.h"
+
+#include <algorithm>
+
+namespace CryptoNote {
+
+TransactionRelay::TransactionRelay(size_t knownTxsPerPeer, size_t maxAnnouncement, size_t maxQueuedPerPeer, size_t maxRequestsPerPeer, size_t maxRequests,
+  size_t maxAnnouncers, std::chrono::milliseconds announceInterval, std::chrono::seconds requestTimeout) :
+  m_knownTxsPerPeer(knownTxsPerPeer),
+  m_maxAnnouncement(maxAnnouncement),
+  m_maxQueuedPerPeer(maxQueuedPerPeer),
+  m_maxRequestsPerPeer(maxRequestsPerPeer),
+  m_maxRequests(maxRequests),
+  m_maxAnnouncers(maxAnnouncers),
+  m_requestTimeout(requestTimeout),
+  m_generator(std::random_device()()),
+  m_interval(1.0 / std::max<std::chrono::milliseconds::rep>(announceInterval.count(), 1)) {
+}
+
+void TransactionRelay::markKnown(const PeerId& peer, const Crypto::Hash& tx) {
+  Peer& state = getPeer(peer);
+  if (state.known.insert(tx).second && state.known.size() >= m_knownTxsPerPeer / 2) {
+    state.previousKnown.clear();
+    state.previousKnown.swap(state.known);
+  }
+}
+
+bool TransactionRelay::isKnown(const PeerId& peer, const Crypto::Hash& tx) const {
+  auto it = m_peers.find(peer);
+  return it != m_peers.end() && (it->second.known.count(tx) != 0 || it->second.previousKnown.count(tx) != 0);
+}
+
+bool TransactionRelay::queue(const PeerId& peer, const Crypto::Hash& tx) {
+  if (isKnown(peer, tx)) {
+    return false;
+  }
+
+  markKnown(peer, tx);
+  Peer& state = getPeer(peer);
+  if (state.queued.size() >= m_maxQueuedPerPeer) {
+    state.queued.pop_front();
+  }
+
+  state.queued.push_back(tx);
+  return true;
+}
+
+bool TransactionRelay::takeAnnouncement(const PeerId& peer, Clock::time_point now, std::vector<Crypto::Hash>& txs) {
+  auto it = m_peers.find(peer);
+  if (it == m_peers.end() || it->second.queued.empty()) {
+    return false;
+  }
+
+  Peer& state = it->second;
+  if (state.nextAnnouncement == Clock::time_point()) {
+    // the first transaction starts the timer, so the announcement doesn't tell when it was received
+    state.nextAnnouncement = now + nextInterval();
+  }
+
+  if (now < state.nextAnnouncement) {
+    return false;
+  }
+
+  size_t count = std::min(state.queued.size(), m_maxAnnouncement);
+  txs.assign(state.queued.begin(), state.queued.begin() + count);
+  state.queued.erase(state.queued.begin(), state.queued.begin() + count);
+  state.nextAnnouncement = now + nextInterval();
+  return true;
+}
+
+void TransactionRelay::request(const PeerId& peer, const std::vector<Crypto::Hash>& txs, Clock::time_point now, std::vector<Crypto::Hash>& toRequest) {
+  for (const auto& tx : txs) {
+    markKnown(peer, tx);
+
+    auto it = m_requests.find(tx);
+    if (it == m_requests.end()) {
+      if (!canRequest(peer) || m_requests.size() >= m_maxRequests) {
+        continue;
+      }
+
+      Request& request = m_requests[tx];
+      request.peer = peer;
+      request.time = now;
+      ++getPeer(peer).requested;
+      toRequest.push_back(tx);
+      continue;
+    }
+
+    Request& request = it->second;
+    if (request.peer != peer && request.announcers.size() < m_maxAnnouncers &&
+      std::find(request.announcers.begin(), request.announcers.end(), peer) == request.announcers.end()) {
+      request.announcers.push_back(peer);
+    }
+  }
+}
+
+void TransactionRelay::received(const Crypto::Hash& tx) {
+  auto it = m_requests.find(tx);
+  if (it != m_requests.end()) {
+    releaseRequest(it->second.peer);
+    m_requests.erase(it);
+  }
+}
+
+size_t TransactionRelay::expire(Clock::time_point now, PeerRequests& retries) {
+  size_t expired = 0;
+  for (auto it = m_requests.begin(); it != m_requests.end();) {
+    Request& request = it->second;
+    if (now - request.time < m_requestTimeout) {
+      ++it;
+      continue;
+    }
+
+    ++expired;
+    releaseRequest(request.peer);
+    // announcers that have as many requests in flight as allowed are passed over
+    auto next = std::find_if(request.announcers.begin(), request.announcers.end(), [this](const PeerId& peer) { return canRequest(peer); });
+    if (next == request.announcers.end()) {
+      it = m_requests.erase(it);
+      continue;
+    }
+
+    request.peer = *next;
+    request.announcers.erase(request.announcers.begin(), next + 1);
+    request.time = now;
+    ++getPeer(request.peer).requested;
+    retries[request.peer].push_back(it->first);
+    ++it;
+  }
+
+  return expired;
+}
+
+void TransactionRelay::removePeer(const PeerId& peer) {
+  m_peers.erase(peer);
+
+  for (auto it = m_requests.begin(); it != m_requests.end();) {
+    Request& request = it->second;
+    request.announcers.erase(std::remove(request.announcers.begin(), request.announcers.end(), peer), request.announcers.end());
+    if (request.peer != peer) {
+      ++it;
+    } else if (request.announcers.empty()) {
+      it = m_requests.erase(it);
+    } else {
+      // the next announcer is asked by the following expire()
+      request.time = Clock::time_point();
+      ++it;
+    }
+  }
+}
+
+TransactionRelay::Peer& TransactionRelay::getPeer(const PeerId& peer) {
+  auto result = m_peers.emplace(peer, Peer());
+  if (result.second) {
+    result.first->second.nextAnnouncement = Clock::time_point();
+    result.first->second.requested = 0;
+  }
+
+  return result.first->second;
+}
+
+bool TransactionRelay::canRequest(const PeerId& peer) const {
+  auto it = m_peers.find(peer);
+  return it == m_peers.end() || it->second.requested < m_maxRequestsPerPeer;
+}
+
+void TransactionRelay::releaseRequest(const PeerId& peer) {
+  // the peer may be removed already
+  auto it = m_peers.find(peer);
+  if (it != m_peers.end() && it->second.requested != 0) {
+    --it->second.requested;
+  }
+}
+
+TransactionRelay::Clock::duration TransactionRelay::nextInterval() {
+  return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(m_interval(m_generator)));
+}
+
+}
@@ -0,0 +1,92 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2014-2017 XDN developers
+// Copyright (c) 2016-2017 BXC developers
+// Copyright (c) 2017 Doppler developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <chrono>
+#include <deque>
+#include <random>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <boost/functional/hash.hpp>
+#include <boost/uuid/uuid.hpp>
+
+#include "crypto/hash.h"
+
+namespace CryptoNote {
+
+// Keeps the transaction inventory of every peer for hash announcement relay. A transaction is queued only
+// for peers that don't know it yet and is announced in batches, when the randomized timer of the peer fires.
+// Announced transactions are requested from one peer at a time, the others that announced them are asked
+// in turn if the request times out. Queues, requests and announcers are bounded, so a flood of announcements
+// costs no more than the limits allow.
+class TransactionRelay {
+public:
+  typedef std::chrono::steady_clock Clock;
+  typedef boost::uuids::uuid PeerId;
+  typedef std::unordered_map<PeerId, std::vector<Crypto::Hash>, boost::hash<PeerId>> PeerRequests;
+
+  TransactionRelay(size_t knownTxsPerPeer, size_t maxAnnouncement, size_t maxQueuedPerPeer, size_t maxRequestsPerPeer, size_t maxRequests,
+    size_t maxAnnouncers, std::chrono::milliseconds announceInterval, std::chrono::seconds requestTimeout);
+
+  // the transaction is neither announced to the peer nor requested from it anymore
+  void markKnown(const PeerId& peer, const Crypto::Hash& tx);
+  bool isKnown(const PeerId& peer, const Crypto::Hash& tx) const;
+  // queues the transaction for announcement, false if the peer already knows it; a full queue drops its oldest hash
+  bool queue(const PeerId& peer, const Crypto::Hash& tx);
+  // takes the batch due to the peer, false until its timer fires or if nothing is queued
+  bool takeAnnouncement(const PeerId& peer, Clock::time_point now, std::vector<Crypto::Hash>& txs);
+
+  // txs were announced by the peer and are unknown to the node, picks those not requested from someone else;
+  // once the peer or the node has as many requests in flight as allowed, the announcement is only remembered
+  void request(const PeerId& peer, const std::vector<Crypto::Hash>& txs, Clock::time_point now, std::vector<Crypto::Hash>& toRequest);
+  // the transaction arrived from any peer
+  void received(const Crypto::Hash& tx);
+  // timed out requests go to the next peer that announced the transaction, returns the number of timed out requests
+  size_t expire(Clock::time_point now, PeerRequests& retries);
+
+  void removePeer(const PeerId& peer);
+
+private:
+  struct Peer {
+    // two generations, the older one is dropped when the newer is full
+    std::unordered_set<Crypto::Hash> known;
+    std::unordered_set<Crypto::Hash> previousKnown;
+    std::deque<Crypto::Hash> queued;
+    Clock::time_point nextAnnouncement;
+    size_t requested; // requests in flight
+  };
+
+  struct Request {
+    PeerId peer;
+    Clock::time_point time;
+    std::vector<PeerId> announcers;
+  };
+
+  Peer& getPeer(const PeerId& peer);
+  bool canRequest(const PeerId& peer) const;
+  void releaseRequest(const PeerId& peer);
+  Clock::duration nextInterval();
+
+  const size_t m_knownTxsPerPeer;
+  const size_t m_maxAnnouncement;
+  const size_t m_maxQueuedPerPeer;
+  const size_t m_maxRequestsPerPeer;
+  const size_t m_maxRequests;
+  const size_t m_maxAnnouncers;
+  const std::chrono::seconds m_requestTimeout;
+
+  std::unordered_map<PeerId, Peer, boost::hash<PeerId>> m_peers;
+  std::unordered_map<Crypto::Hash, Request> m_requests;
+
+  std::default_random_engine m_generator;
+  std::exponential_distribution<double> m_interval; // milliseconds
+};
+
+}
@@ -23,7 +23,7 @@
 #include "CryptoNoteProtocol/CryptoNoteProtocolHandler.h"
 #include "P2p/NetNode.h"
 #include "P2p/NetNodeConfig.h"
-#include "Rpc/RpcServer.h"
+#include "Rpc/RpcServerPool.h"
 #include "Rpc/RpcServerConfig.h"
 #include "version.h"
 
@@ -300,7 +300,7 @@ int main(int argc, char* argv[])
 
     CryptoNote::CryptoNoteProtocolHandler cprotocol(currency, dispatcher, ccore, nullptr, logManager);
     CryptoNote::NodeServer p2psrv(dispatcher, cprotocol, logManager);
-    CryptoNote::RpcServer rpcServer(dispatcher, logManager, ccore, p2psrv, cprotocol);
+    CryptoNote::RpcServerPool rpcServer(logManager, ccore, p2psrv, cprotocol);
 
     cprotocol.set_p2p_endpoint(&p2psrv);
     ccore.set_cryptonote_protocol(&cprotocol);
@@ -334,10 +334,16 @@ int main(int argc, char* argv[])
       dch.start_handling();
     }
 
-    logger(INFO) << "Starting core rpc server on address " << rpcConfig.getBindAddress();
-    rpcServer.start(rpcConfig.bindIp, rpcConfig.bindPort);
+    logger(INFO) << "Starting core rpc server on address " << rpcConfig.getBindAddress() << ", threads: " << rpcConfig.threads;
+    rpcServer.start(rpcConfig.bindIp, rpcConfig.bindPort, rpcConfig.threads);
     logger(INFO) << "Core rpc server started ok";
 
+    // the RPC threads relay through the p2p dispatcher, so they are stopped while it still runs
+    p2psrv.setStopHandler([&logger, &rpcServer] {
+      logger(INFO) << "Stopping core rpc server...";
+      rpcServer.stop();
+    });
+
     Tools::SignalHandler::install([&dch, &p2psrv] {
       dch.stop_handling();
       p2psrv.sendStopSignal();
@@ -349,10 +355,6 @@ int main(int argc, char* argv[])
 
     dch.stop_handling();
 
-    //stop components
-    logger(INFO) << "Stopping core rpc server...";
-    rpcServer.stop();
-
     //deinitialize components
     logger(INFO) << "Deinitializing core...";
     ccore.deinit();
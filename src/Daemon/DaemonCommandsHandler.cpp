@@ -29,6 +29,7 @@ DaemonCommandsHandler::DaemonCommandsHandler(CryptoNote::core& core, CryptoNote:
   m_consoleHandler.setHandler("exit", boost::bind(&DaemonCommandsHandler::exit, this, _1), "Shutdown the daemon");
   m_consoleHandler.setHandler("help", boost::bind(&DaemonCommandsHandler::help, this, _1), "Show this help");
   m_consoleHandler.setHandler("print_pl", boost::bind(&DaemonCommandsHandler::print_pl, this, _1), "Print peer list");
+  m_consoleHandler.setHandler("print_ps", boost::bind(&DaemonCommandsHandler::print_ps, this, _1), "Print peer scores: connection round trip, block download rate, invalid data and uptime");
   m_consoleHandler.setHandler("print_cn", boost::bind(&DaemonCommandsHandler::print_cn, this, _1), "Print connections");
   m_consoleHandler.setHandler("print_bc", boost::bind(&DaemonCommandsHandler::print_bc, this, _1), "Print blockchain info in a given blocks range, print_bc <begin_height> [<end_height>]");
   //m_consoleHandler.setHandler("print_bci", boost::bind(&DaemonCommandsHandler::print_bci, this, _1));
@@ -42,6 +43,7 @@ DaemonCommandsHandler::DaemonCommandsHandler(CryptoNote::core& core, CryptoNote:
   m_consoleHandler.setHandler("print_pool_sh", boost::bind(&DaemonCommandsHandler::print_pool_sh, this, _1), "Print transaction pool (short format)");
   m_consoleHandler.setHandler("show_hr", boost::bind(&DaemonCommandsHandler::show_hr, this, _1), "Start showing hash rate");
   m_consoleHandler.setHandler("hide_hr", boost::bind(&DaemonCommandsHandler::hide_hr, this, _1), "Stop showing hash rate");
+  m_consoleHandler.setHandler("print_mining_stats", boost::bind(&DaemonCommandsHandler::print_mining_stats, this, _1), "Print per-thread hash rate, template age and found blocks");
   m_consoleHandler.setHandler("set_log", boost::bind(&DaemonCommandsHandler::set_log, this, _1), "set_log <level> - Change current log level, <level> is a number 0-4");
 }
 
@@ -76,6 +78,11 @@ bool DaemonCommandsHandler::print_pl(const std::vector<std::string>& args) {
   return true;
 }
 //--------------------------------------------------------------------------------
+bool DaemonCommandsHandler::print_ps(const std::vector<std::string>& args) {
+  m_srv.log_peer_scores();
+  return true;
+}
+//--------------------------------------------------------------------------------
 bool DaemonCommandsHandler::show_hr(const std::vector<std::string>& args)
 {
   if (!m_core.get_miner().is_mining())
@@ -94,6 +101,12 @@ bool DaemonCommandsHandler::hide_hr(const std::vector<std::string>& args)
   return true;
 }
 //--------------------------------------------------------------------------------
+bool DaemonCommandsHandler::print_mining_stats(const std::vector<std::string>& args)
+{
+  std::cout << CryptoNote::printMinerStatistics(m_core.get_miner().getStatistics());
+  return true;
+}
+//--------------------------------------------------------------------------------
 bool DaemonCommandsHandler::print_bc_outs(const std::vector<std::string>& args)
 {
   if (args.size() != 1)
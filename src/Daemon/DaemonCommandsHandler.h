@@ -48,8 +48,10 @@ private:
   bool exit(const std::vector<std::string>& args);
   bool help(const std::vector<std::string>& args);
   bool print_pl(const std::vector<std::string>& args);
+  bool print_ps(const std::vector<std::string>& args);
   bool show_hr(const std::vector<std::string>& args);
   bool hide_hr(const std::vector<std::string>& args);
+  bool print_mining_stats(const std::vector<std::string>& args);
   bool print_bc_outs(const std::vector<std::string>& args);
   bool print_cn(const std::vector<std::string>& args);
   bool print_bc(const std::vector<std::string>& args);
@@ -8,11 +8,35 @@
 #include "HttpParser.h"
 
 #include <algorithm>
+#include <cstring>
 
 #include "HttpParserErrorCodes.h"
 
 namespace {
 
+// the head is buffered whole before parsing, a longer one is rejected
+const size_t MAX_HEAD_SIZE = 64 * 1024;
+// a body is read in parts of this size, so memory grows with the data received rather than the announced length
+const size_t BODY_CHUNK_SIZE = 64 * 1024;
+const char HEAD_END[] = "\r\n\r\n";
+
+const char* findByte(const char* begin, const char* end, char byte) {
+  const void* found = memchr(begin, byte, end - begin);
+  return found != nullptr ? static_cast<const char*>(found) : end;
+}
+
+std::string trimSpaces(const char* begin, const char* end) {
+  while (begin != end && (*begin == ' ' || *begin == '\t')) {
+    ++begin;
+  }
+
+  while (end != begin && (end[-1] == ' ' || end[-1] == '\t')) {
+    --end;
+  }
+
+  return std::string(begin, end);
+}
+
 void throwIfNotGood(std::istream& stream) {
   if (!stream.good()) {
     if (stream.eof()) {
@@ -39,12 +63,45 @@ HttpResponse::HTTP_STATUS HttpParser::parseResponseStatusFromString(const std::s
 }
 
 
+size_t HttpParser::parseRequest(const char* data, size_t size, HttpRequest& request) {
+  if (m_headSize == 0) {
+    // the end of the head may straddle the data scanned before
+    size_t offset = m_scannedSize < sizeof(HEAD_END) - 1 ? 0 : m_scannedSize - (sizeof(HEAD_END) - 1);
+    const char* headEnd = std::search(data + offset, data + size, HEAD_END, HEAD_END + sizeof(HEAD_END) - 1);
+    if (headEnd == data + size) {
+      if (size > MAX_HEAD_SIZE) {
+        throw std::system_error(make_error_code(CryptoNote::error::HttpParserErrorCodes::HEAD_TOO_LONG));
+      }
+
+      m_scannedSize = size;
+      return 0;
+    }
+
+    m_headSize = headEnd - data + sizeof(HEAD_END) - 1;
+    parseHead(data, m_headSize, request);
+    m_bodySize = getBodyLen(request.headers);
+  }
+
+  if (size < m_headSize + m_bodySize) {
+    return 0;
+  }
+
+  request.body.assign(data + m_headSize, m_bodySize);
+  size_t requestSize = m_headSize + m_bodySize;
+  m_scannedSize = 0;
+  m_headSize = 0;
+  m_bodySize = 0;
+  return requestSize;
+}
+
+size_t HttpParser::getRequiredSize() const {
+  return m_headSize + m_bodySize;
+}
+
 void HttpParser::receiveRequest(std::istream& stream, HttpRequest& request) {
   readWord(stream, request.method);
   readWord(stream, request.url);
-
-  std::string httpVersion;
-  readWord(stream, httpVersion);
+  readWord(stream, request.version);
 
   readHeaders(stream, request.headers);
 
@@ -90,13 +147,8 @@ void HttpParser::receiveResponse(std::istream& stream, HttpResponse& response) {
   }
 
   response.addHeader(name, value);
-  auto headers = response.getHeaders();
-  size_t length = 0;
-  auto it = headers.find("content-length");
-  if (it != headers.end()) {
-    length = std::stoul(it->second);
-  }
-  
+  size_t length = getBodyLen(response.getHeaders());
+
   std::string body;
   if (length) {
     readBody(stream, body, length);
@@ -193,23 +245,69 @@ bool HttpParser::readHeader(std::istream& stream, std::string& name, std::string
 
 size_t HttpParser::getBodyLen(const HttpRequest::Headers& headers) {
   auto it = headers.find("content-length");
-  if (it != headers.end()) {
-    size_t bytes = std::stoul(it->second);
-    return bytes;
+  if (it == headers.end()) {
+    return 0;
+  }
+
+  if (it->second.empty()) {
+    throw std::system_error(make_error_code(CryptoNote::error::HttpParserErrorCodes::UNEXPECTED_SYMBOL));
+  }
+
+  size_t bytes = 0;
+  for (char c : it->second) {
+    if (c < '0' || c > '9') {
+      throw std::system_error(make_error_code(CryptoNote::error::HttpParserErrorCodes::UNEXPECTED_SYMBOL));
+    }
+
+    bytes = bytes * 10 + (c - '0');
+    if (bytes > MAX_BODY_SIZE) {
+      throw std::system_error(make_error_code(CryptoNote::error::HttpParserErrorCodes::BODY_TOO_LONG));
+    }
   }
 
-  return 0;
+  return bytes;
 }
 
 void HttpParser::readBody(std::istream& stream, std::string& body, const size_t bodyLen) {
-  size_t read = 0;
+  body.clear();
+  while (body.size() < bodyLen) {
+    size_t offset = body.size();
+    size_t chunkSize = std::min(bodyLen - offset, BODY_CHUNK_SIZE);
+    body.resize(offset + chunkSize);
+    stream.read(&body[offset], chunkSize);
+    throwIfNotGood(stream);
+  }
+}
 
-  while (stream.good() && read < bodyLen) {
-    body += stream.get();
-    ++read;
+// The head ends with the empty line, every line of it ends with CRLF
+void HttpParser::parseHead(const char* data, size_t size, HttpRequest& request) {
+  const char* end = data + size - 2;
+  const char* lineEnd = std::search(data, end, HEAD_END, HEAD_END + 2);
+  const char* methodEnd = findByte(data, lineEnd, ' ');
+  const char* urlEnd = findByte(std::min(methodEnd + 1, lineEnd), lineEnd, ' ');
+  if (methodEnd == data || methodEnd == lineEnd || urlEnd == methodEnd + 1) {
+    throw std::system_error(make_error_code(CryptoNote::error::HttpParserErrorCodes::UNEXPECTED_SYMBOL));
   }
 
-  throwIfNotGood(stream);
+  request.method.assign(data, methodEnd);
+  request.url.assign(methodEnd + 1, urlEnd);
+  request.version.assign(std::min(urlEnd + 1, lineEnd), lineEnd);
+
+  for (const char* line = lineEnd + 2; line != end; line = lineEnd + 2) {
+    lineEnd = std::search(line, end, HEAD_END, HEAD_END + 2);
+    const char* colon = findByte(line, lineEnd, ':');
+    if (colon == lineEnd) {
+      throw std::system_error(make_error_code(CryptoNote::error::HttpParserErrorCodes::UNEXPECTED_SYMBOL));
+    }
+
+    if (colon == line) {
+      throw std::system_error(make_error_code(CryptoNote::error::HttpParserErrorCodes::EMPTY_HEADER));
+    }
+
+    std::string name(line, colon);
+    std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+    request.headers[name] = trimSpaces(colon + 1, lineEnd);
+  }
 }
 
 }
@@ -19,7 +19,17 @@ namespace CryptoNote {
 //Blocking HttpParser
 class HttpParser {
 public:
-  HttpParser() {};
+  // a larger Content-Length is rejected before anything is allocated for the body
+  static const size_t MAX_BODY_SIZE = 32 * 1024 * 1024;
+
+  HttpParser() : m_scannedSize(0), m_headSize(0), m_bodySize(0) {};
+
+  // Parses the request at the start of the received data without reading it byte by byte. Returns the size of the
+  // request, or 0 while the data ends before the request does; the next call then gets the same data with more appended
+  // and the same request, which keeps what the head filled in.
+  size_t parseRequest(const char* data, size_t size, HttpRequest& request);
+  // size of the incomplete request, 0 until its head is complete
+  size_t getRequiredSize() const;
 
   void receiveRequest(std::istream& stream, HttpRequest& request);
   void receiveResponse(std::istream& stream, HttpResponse& response);
@@ -30,6 +40,11 @@ private:
   bool readHeader(std::istream& stream, std::string& name, std::string& value);
   size_t getBodyLen(const HttpRequest::Headers& headers);
   void readBody(std::istream& stream, std::string& body, const size_t bodyLen);
+  void parseHead(const char* data, size_t size, HttpRequest& request);
+
+  size_t m_scannedSize;
+  size_t m_headSize;
+  size_t m_bodySize;
 };
 
 } //namespace CryptoNote
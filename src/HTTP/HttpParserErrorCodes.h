@@ -17,7 +17,9 @@ enum HttpParserErrorCodes {
   STREAM_NOT_GOOD = 1,
   END_OF_STREAM,
   UNEXPECTED_SYMBOL,
-  EMPTY_HEADER
+  EMPTY_HEADER,
+  HEAD_TOO_LONG,
+  BODY_TOO_LONG
 };
 
 // custom category:
@@ -39,6 +41,8 @@ public:
       case END_OF_STREAM: return "The stream is ended";
       case UNEXPECTED_SYMBOL: return "Unexpected symbol";
       case EMPTY_HEADER: return "The header name is empty";
+      case HEAD_TOO_LONG: return "The request head is too long";
+      case BODY_TOO_LONG: return "The body is too long";
       default: return "Unknown error";
     }
   }
@@ -50,6 +50,8 @@ namespace CryptoNote {
 HttpResponse::HttpResponse() {
   status = STATUS_200;
   headers["Server"] = "CryptoNote-based HTTP server";
+  // a kept alive connection needs the length of an empty body as well
+  headers["Content-Length"] = "0";
 }
 
 void HttpResponse::setStatus(HTTP_STATUS s) {
@@ -66,20 +68,27 @@ void HttpResponse::addHeader(const std::string& name, const std::string& value)
 
 void HttpResponse::setBody(const std::string& b) {
   body = b;
-  if (!body.empty()) {
-    headers["Content-Length"] = std::to_string(body.size());
-  } else {
-    headers.erase("Content-Length");
+  headers["Content-Length"] = std::to_string(body.size());
+}
+
+void HttpResponse::appendHead(std::string& buffer) const {
+  buffer += "HTTP/1.1 ";
+  buffer += getStatusString(status);
+  buffer += "\r\n";
+  for (const auto& pair : headers) {
+    buffer += pair.first;
+    buffer += ": ";
+    buffer += pair.second;
+    buffer += "\r\n";
   }
+
+  buffer += "\r\n";
 }
 
 std::ostream& HttpResponse::printHttpResponse(std::ostream& os) const {
-  os << "HTTP/1.1 " << getStatusString(status) << "\r\n";
-
-  for (auto pair: headers) {
-    os << pair.first << ": " << pair.second << "\r\n";
-  }
-  os << "\r\n";
+  std::string head;
+  appendHead(head);
+  os << head;
 
   if (!body.empty()) {
     os << body;
@@ -31,6 +31,8 @@ namespace CryptoNote {
     const std::map<std::string, std::string>& getHeaders() const { return headers; }
     HTTP_STATUS getStatus() const { return status; }
     const std::string& getBody() const { return body; }
+    // the status line and the headers, the body goes after them
+    void appendHead(std::string& buffer) const;
 
   private:
     friend std::ostream& operator<<(std::ostream& os, const HttpResponse& resp);
@@ -22,8 +22,6 @@
 #include "HTTP/HttpResponse.h"
 
 #include "Common/JsonValue.h"
-#include "Serialization/JsonInputValueSerializer.h"
-#include "Serialization/JsonOutputStreamSerializer.h"
 
 namespace CryptoNote {
 
@@ -60,13 +58,16 @@ void JsonRpcServer::processRequest(const CryptoNote::HttpRequest& req, CryptoNot
         return;
       }
 
-      processJsonRpcRequest(jsonRpcRequest, jsonRpcResponse);
+      std::string result;
+      processJsonRpcRequest(jsonRpcRequest, jsonRpcResponse, result);
 
-      std::ostringstream jsonOutputStream;
-      jsonOutputStream << jsonRpcResponse;
+      std::string body = jsonRpcResponse.toString();
+      if (!result.empty()) {
+        body.insert(body.size() - 1, ",\"result\":" + result);
+      }
 
       resp.setStatus(CryptoNote::HttpResponse::STATUS_200);
-      resp.setBody(jsonOutputStream.str());
+      resp.setBody(body);
 
     } else {
       logger(Logging::WARNING) << "Requested url \"" << req.getUrl() << "\" is not found";
@@ -154,10 +155,6 @@ void JsonRpcServer::makeMethodNotFoundResponse(Common::JsonValue& resp) {
   resp.insert("error", error);
 }
 
-void JsonRpcServer::fillJsonResponse(const Common::JsonValue& v, Common::JsonValue& resp) {
-  resp.insert("result", v);
-}
-
 void JsonRpcServer::makeJsonParsingErrorResponse(Common::JsonValue& resp) {
   using Common::JsonValue;
 
@@ -42,11 +42,11 @@ protected:
   static void makeErrorResponse(const std::error_code& ec, Common::JsonValue& resp);
   static void makeMethodNotFoundResponse(Common::JsonValue& resp);
   static void makeGenericErrorReponse(Common::JsonValue& resp, const char* what, int errorCode = -32001);
-  static void fillJsonResponse(const Common::JsonValue& v, Common::JsonValue& resp);
   static void prepareJsonResponse(const Common::JsonValue& req, Common::JsonValue& resp);
   static void makeJsonParsingErrorResponse(Common::JsonValue& resp);
 
-  virtual void processJsonRpcRequest(const Common::JsonValue& req, Common::JsonValue& resp) = 0;
+  // a successful call writes the JSON text of its result to the string, it is appended to the response object
+  virtual void processJsonRpcRequest(const Common::JsonValue& req, Common::JsonValue& resp, std::string& result) = 0;
 
 private:
   // HttpServer
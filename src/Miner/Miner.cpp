@@ -7,12 +7,14 @@
 
 #include "Miner.h"
 
+#include <chrono>
 #include <functional>
 
 #include "crypto/crypto.h"
 #include "CryptoNoteCore/CryptoNoteFormatUtils.h"
 
 #include <System/InterruptedException.h>
+#include "Common/ScopeExit.h"
 
 namespace CryptoNote {
 
@@ -20,6 +22,7 @@ Miner::Miner(System::Dispatcher& dispatcher, Logging::ILogger& logger) :
   m_dispatcher(dispatcher),
   m_miningStopped(dispatcher),
   m_state(MiningState::MINING_STOPPED),
+  m_cpuAffinity(false),
   m_logger(logger, "Miner") {
 }
 
@@ -60,17 +63,41 @@ void Miner::stop() {
   }
 }
 
+bool Miner::setCpuAffinity(bool pinThreads) {
+  m_cpuAffinity = pinThreads && m_threadPlacement.isAvailable();
+  return m_cpuAffinity == pinThreads;
+}
+
+std::vector<MinerThreadStatistics> Miner::getThreadStatistics() const {
+  std::vector<MinerThreadStatistics> threads;
+
+  for (const auto& thread : m_threadStatistics) {
+    MinerThreadStatistics threadStatistics;
+    threadStatistics.hashes = thread.hashes;
+    threadStatistics.hashingTime = thread.hashingTime / 1000;
+    threadStatistics.hashRate = thread.hashingTime == 0 ? 0 : threadStatistics.hashes * 1000000 / thread.hashingTime;
+    threadStatistics.waitingTime = 0;
+    threads.push_back(threadStatistics);
+  }
+
+  return threads;
+}
+
 void Miner::runWorkers(BlockMiningParameters blockMiningParameters, size_t threadCount) {
   assert(threadCount > 0);
 
   m_logger(Logging::INFO) << "Starting mining for difficulty " << blockMiningParameters.difficulty;
 
+  if (m_threadStatistics.size() != threadCount) {
+    m_threadStatistics = std::vector<ThreadStatistics>(threadCount);
+  }
+
   try {
     blockMiningParameters.blockTemplate.nonce = Crypto::rand<uint32_t>();
 
     for (size_t i = 0; i < threadCount; ++i) {
       m_workers.emplace_back(std::unique_ptr<System::RemoteContext<void>> (
-        new System::RemoteContext<void>(m_dispatcher, std::bind(&Miner::workerFunc, this, blockMiningParameters.blockTemplate, blockMiningParameters.difficulty, threadCount)))
+        new System::RemoteContext<void>(m_dispatcher, std::bind(&Miner::workerFunc, this, blockMiningParameters.blockTemplate, blockMiningParameters.difficulty, threadCount, i)))
       );
 
       blockMiningParameters.blockTemplate.nonce++;
@@ -86,12 +113,30 @@ void Miner::runWorkers(BlockMiningParameters blockMiningParameters, size_t threa
   m_miningStopped.set();
 }
 
-void Miner::workerFunc(const Block& blockTemplate, difficulty_type difficulty, uint32_t nonceStep) {
+void Miner::workerFunc(const Block& blockTemplate, difficulty_type difficulty, uint32_t nonceStep, size_t threadIndex) {
+  // the dispatcher's pool thread runs other operations later, so it gets its CPUs back when mining is done
+  std::vector<unsigned> previousCpus;
+  Tools::ScopeExit restoreCpus([&previousCpus] {
+    if (!previousCpus.empty()) {
+      MinerThreadPlacement::setCurrentThreadCpus(previousCpus);
+    }
+  });
+
   try {
+    // before the hashing context is created, so its scratchpad is allocated on this CPU's NUMA node
+    if (m_cpuAffinity) {
+      previousCpus = MinerThreadPlacement::getCurrentThreadCpus();
+      if (!MinerThreadPlacement::pinCurrentThread(m_threadPlacement.cpuForThread(threadIndex))) {
+        m_logger(Logging::WARNING) << "Failed to pin miner thread " << threadIndex << " to CPU " << m_threadPlacement.cpuForThread(threadIndex);
+      }
+    }
+
     Block block = blockTemplate;
     Crypto::cn_context cryptoContext;
+    ThreadStatistics& statistics = m_threadStatistics[threadIndex];
 
     while (m_state == MiningState::MINING_IN_PROGRESS) {
+      auto hashingStart = std::chrono::steady_clock::now();
       Crypto::Hash hash;
       if (!get_block_longhash(cryptoContext, block, hash)) {
         //error occured
@@ -100,7 +145,11 @@ void Miner::workerFunc(const Block& blockTemplate, difficulty_type difficulty, u
         return;
       }
 
-      if (check_hash(hash, difficulty)) {
+      bool found = check_hash(hash, difficulty);
+      ++statistics.hashes;
+      statistics.hashingTime += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - hashingStart).count();
+
+      if (found) {
         m_logger(Logging::INFO) << "Found block for difficulty " << difficulty;
 
         if (!setStateBlockFound()) {
@@ -16,6 +16,8 @@
 
 #include "CryptoNote.h"
 #include "CryptoNoteCore/Difficulty.h"
+#include "CryptoNoteCore/MinerStatistics.h"
+#include "CryptoNoteCore/MinerThreadPlacement.h"
 
 #include "Logging/LoggerRef.h"
 
@@ -36,6 +38,12 @@ public:
   //NOTE! this is blocking method
   void stop();
 
+  // pins worker threads to CPU cores, returns false if the CPU topology is unknown
+  bool setCpuAffinity(bool pinThreads);
+
+  // waitingTime is left zero, threads only exist while there is a block template to mine
+  std::vector<MinerThreadStatistics> getThreadStatistics() const;
+
 private:
   System::Dispatcher& m_dispatcher;
   System::Event m_miningStopped;
@@ -45,12 +53,24 @@ private:
 
   std::vector<std::unique_ptr<System::RemoteContext<void>>>  m_workers;
 
+  struct ThreadStatistics {
+    std::atomic<uint64_t> hashes;
+    std::atomic<uint64_t> hashingTime; // microseconds
+
+    ThreadStatistics() : hashes(0), hashingTime(0) {}
+  };
+
+  std::vector<ThreadStatistics> m_threadStatistics;
+
+  MinerThreadPlacement m_threadPlacement;
+  bool m_cpuAffinity;
+
   Block m_block;
 
   Logging::LoggerRef m_logger;
 
   void runWorkers(BlockMiningParameters blockMiningParameters, size_t threadCount);
-  void workerFunc(const Block& blockTemplate, difficulty_type difficulty, uint32_t nonceStep);
+  void workerFunc(const Block& blockTemplate, difficulty_type difficulty, uint32_t nonceStep, size_t threadIndex);
   bool setStateBlockFound();
 };
 
@@ -38,6 +38,10 @@ MinerEvent BlockchainUpdatedEvent() {
   return event;
 }
 
+uint64_t millisecondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
 }
 
 MinerManager::MinerManager(System::Dispatcher& dispatcher, const CryptoNote::MiningConfig& config, Logging::ILogger& logger) :
@@ -49,9 +53,21 @@ MinerManager::MinerManager(System::Dispatcher& dispatcher, const CryptoNote::Min
   m_blockchainMonitor(dispatcher, m_config.daemonHost, m_config.daemonPort, m_config.scanPeriod, logger),
   m_eventOccurred(dispatcher),
   m_httpEvent(dispatcher),
-  m_lastBlockTimestamp(0) {
+  m_lastBlockTimestamp(0),
+  m_mining(false),
+  m_miningStopTime(std::chrono::steady_clock::now()),
+  m_waitingTime(0),
+  m_minedTemplateAge(0),
+  m_blocksFound(0),
+  m_blocksRejected(0),
+  m_lastTemplateAge(0),
+  m_totalTemplateAge(0) {
 
   m_httpEvent.set();
+
+  if (!m_miner.setCpuAffinity(m_config.cpuAffinity)) {
+    m_logger(Logging::WARNING) << "CPU topology is not available, mining threads won't be pinned";
+  }
 }
 
 MinerManager::~MinerManager() {
@@ -80,9 +96,32 @@ void MinerManager::start() {
   startBlockchainMonitoring();
   startMining(params);
 
+  if (m_config.statsPeriod != 0) {
+    startStatisticsPrinting();
+  }
+
   eventLoop();
 }
 
+CryptoNote::MinerStatistics MinerManager::getStatistics() const {
+  MinerStatistics statistics;
+  statistics.mining = m_mining;
+  statistics.threads = m_miner.getThreadStatistics();
+
+  uint64_t waitingTime = m_waitingTime + (m_mining ? 0 : millisecondsSince(m_miningStopTime));
+  for (auto& thread : statistics.threads) {
+    thread.waitingTime = waitingTime;
+  }
+
+  statistics.hashRate = totalHashRate(statistics.threads);
+
+  statistics.blocksFound = m_blocksFound;
+  statistics.blocksRejected = m_blocksRejected;
+  statistics.lastTemplateAge = m_lastTemplateAge;
+  statistics.averageTemplateAge = averageTemplateAge(m_totalTemplateAge, m_blocksFound, m_blocksRejected);
+  return statistics;
+}
+
 void MinerManager::eventLoop() {
   size_t blocksMined = 0;
 
@@ -95,11 +134,22 @@ void MinerManager::eventLoop() {
         m_logger(Logging::DEBUGGING) << "got BLOCK_MINED event";
         stopBlockchainMonitoring();
 
-        if (submitBlock(m_minedBlock, m_config.daemonHost, m_config.daemonPort)) {
+        bool submitted = submitBlock(m_minedBlock, m_config.daemonHost, m_config.daemonPort);
+        if (submitted) {
+          ++m_blocksFound;
+        } else {
+          ++m_blocksRejected;
+        }
+
+        m_lastTemplateAge = m_minedTemplateAge;
+        m_totalTemplateAge += m_minedTemplateAge;
+
+        if (submitted) {
           m_lastBlockTimestamp = m_minedBlock.timestamp;
 
           if (m_config.blocksLimit != 0 && ++blocksMined == m_config.blocksLimit) {
             m_logger(Logging::INFO) << "Miner mined requested " << m_config.blocksLimit << " blocks. Quitting";
+            printStatistics();
             return;
           }
         }
@@ -149,12 +199,20 @@ void MinerManager::pushEvent(MinerEvent&& event) {
 }
 
 void MinerManager::startMining(const CryptoNote::BlockMiningParameters& params) {
+  m_waitingTime += millisecondsSince(m_miningStopTime);
+  m_templateTime = std::chrono::steady_clock::now();
+  m_mining = true;
+
   m_contextGroup.spawn([this, params] () {
     try {
       m_minedBlock = m_miner.mine(params, m_config.threadCount);
+      m_minedTemplateAge = millisecondsSince(m_templateTime);
+      onMiningStopped();
       pushEvent(BlockMinedEvent());
     } catch (System::InterruptedException&) {
+      onMiningStopped();
     } catch (std::exception& e) {
+      onMiningStopped();
       m_logger(Logging::ERROR) << "Miner context unexpectedly finished: " << e.what();
     }
   });
@@ -164,6 +222,28 @@ void MinerManager::stopMining() {
   m_miner.stop();
 }
 
+void MinerManager::onMiningStopped() {
+  m_mining = false;
+  m_miningStopTime = std::chrono::steady_clock::now();
+}
+
+void MinerManager::startStatisticsPrinting() {
+  m_contextGroup.spawn([this] () {
+    try {
+      System::Timer timer(m_dispatcher);
+      for (;;) {
+        timer.sleep(std::chrono::seconds(m_config.statsPeriod));
+        printStatistics();
+      }
+    } catch (System::InterruptedException&) {
+    }
+  });
+}
+
+void MinerManager::printStatistics() const {
+  m_logger(Logging::INFO) << "Mining statistics:" << std::endl << printMinerStatistics(getStatistics());
+}
+
 void MinerManager::startBlockchainMonitoring() {
   m_contextGroup.spawn([this] () {
     try {
@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <chrono>
 #include <queue>
 
 #include <System/ContextGroup.h>
@@ -31,6 +32,8 @@ public:
 
   void start();
 
+  CryptoNote::MinerStatistics getStatistics() const;
+
 private:
   System::Dispatcher& m_dispatcher;
   Logging::LoggerRef m_logger;
@@ -47,12 +50,26 @@ private:
 
   uint64_t m_lastBlockTimestamp;
 
+  bool m_mining;
+  std::chrono::steady_clock::time_point m_templateTime;
+  std::chrono::steady_clock::time_point m_miningStopTime;
+  uint64_t m_waitingTime;
+  uint64_t m_minedTemplateAge;
+  uint64_t m_blocksFound;
+  uint64_t m_blocksRejected;
+  uint64_t m_lastTemplateAge;
+  uint64_t m_totalTemplateAge;
+
   void eventLoop();
   MinerEvent waitEvent();
   void pushEvent(MinerEvent&& event);
 
   void startMining(const CryptoNote::BlockMiningParameters& params);
   void stopMining();
+  void onMiningStopped();
+
+  void startStatisticsPrinting();
+  void printStatistics() const;
 
   void startBlockchainMonitoring();
   void stopBlockchainMonitoring();
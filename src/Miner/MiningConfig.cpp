@@ -16,6 +16,7 @@
 #include <boost/program_options.hpp>
 
 #include "CryptoNoteConfig.h"
+#include "CryptoNoteCore/MinerThreadPlacement.h"
 #include "Logging/ILogger.h"
 
 namespace po = boost::program_options;
@@ -27,6 +28,7 @@ namespace {
 const size_t DEFAULT_SCANT_PERIOD = 30;
 const char* DEFAULT_DAEMON_HOST = "127.0.0.1";
 const size_t CONCURRENCY_LEVEL = std::thread::hardware_concurrency();
+const size_t DEFAULT_THREAD_COUNT = MinerThreadPlacement().defaultThreadCount();
 
 po::options_description cmdOptions;
 
@@ -60,8 +62,11 @@ MiningConfig::MiningConfig(): help(false) {
       ("daemon-host", po::value<std::string>()->default_value(DEFAULT_DAEMON_HOST), "Daemon host")
       ("daemon-rpc-port", po::value<uint16_t>()->default_value(static_cast<uint16_t>(RPC_DEFAULT_PORT)), "Daemon's RPC port")
       ("daemon-address", po::value<std::string>(), "Daemon host:port. If you use this option you must not use --daemon-host and --daemon-port options")
-      ("threads", po::value<size_t>()->default_value(CONCURRENCY_LEVEL), "Mining threads count. Must not be greater than you concurrency level. Default value is your hardware concurrency level")
+      ("threads", po::value<size_t>()->default_value(DEFAULT_THREAD_COUNT), "Mining threads count. Must not be greater than you concurrency level. Default value is one thread per physical core, "
+                                                                          "limited by how many scratchpads fit into L3 cache")
+      ("cpu-affinity", po::bool_switch(), "Pin mining threads to CPU cores by cache topology")
       ("scan-time", po::value<size_t>()->default_value(DEFAULT_SCANT_PERIOD), "Blockchain polling interval (seconds). How often miner will check blockchain for updates")
+      ("stats-period", po::value<size_t>()->default_value(0), "Mining statistics print interval (seconds). 0 means print statistics only once --limit blocks are mined")
       ("log-level", po::value<int>()->default_value(1), "Log level. Must be 0..5")
       ("limit", po::value<size_t>()->default_value(0), "Mine exact quantity of blocks. 0 means no limit")
       ("first-block-timestamp", po::value<uint64_t>()->default_value(0), "Set timestamp to the first mined block. 0 means leave timestamp unchanged")
@@ -101,11 +106,15 @@ void MiningConfig::parse(int argc, char** argv) {
     throw std::runtime_error("--threads option must be 1.." + std::to_string(CONCURRENCY_LEVEL));
   }
 
+  cpuAffinity = options["cpu-affinity"].as<bool>();
+
   scanPeriod = options["scan-time"].as<size_t>();
   if (scanPeriod == 0) {
     throw std::runtime_error("--scan-time must not be zero");
   }
 
+  statsPeriod = options["stats-period"].as<size_t>();
+
   logLevel = static_cast<uint8_t>(options["log-level"].as<int>());
   if (logLevel > static_cast<uint8_t>(Logging::TRACE)) {
     throw std::runtime_error("--log-level value is too big");
@@ -22,7 +22,9 @@ struct MiningConfig {
   std::string daemonHost;
   uint16_t daemonPort;
   size_t threadCount;
+  bool cpuAffinity;
   size_t scanPeriod;
+  size_t statsPeriod;
   uint8_t logLevel;
   size_t blocksLimit;
   uint64_t firstBlockTimestamp;
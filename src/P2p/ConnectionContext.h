@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <chrono>
 #include <list>
 #include <ostream>
 #include <unordered_set>
@@ -36,10 +37,16 @@ struct CryptoNoteConnectionContext {
   };
 
   state m_state = state_befor_handshake;
-  std::list<Crypto::Hash> m_needed_objects;
   std::unordered_set<Crypto::Hash> m_requested_objects;
   uint32_t m_remote_blockchain_height = 0;
   uint32_t m_last_response_height = 0;
+  // when the block response being awaited started to come, for the download rate of the peer
+  std::chrono::steady_clock::time_point m_download_started;
+  // bytes of the messages with their headers
+  uint64_t m_recv_cnt = 0;
+  uint64_t m_send_cnt = 0;
+  time_t m_last_recv = 0;
+  time_t m_last_send = 0;
 };
 
 inline std::string get_protocol_state_string(CryptoNoteConnectionContext::state s) {
@@ -7,6 +7,7 @@
 
 #include "LevinProtocol.h"
 #include <System/TcpConnection.h>
+#include "ReceiveBufferPool.h"
 
 using namespace CryptoNote;
 
@@ -32,16 +33,24 @@ struct bucket_head2
 };
 #pragma pack(pop)
 
+static_assert(sizeof(bucket_head2) == LevinProtocol::HEADER_SIZE, "Levin header size mismatch");
+
 }
 
 bool LevinProtocol::Command::needReply() const {
   return !(isNotify || isResponse);
 }
 
-LevinProtocol::LevinProtocol(System::TcpConnection& connection) 
-  : m_conn(connection) {}
+LevinProtocol::LevinProtocol(System::TcpConnection& connection, ReceiveBufferPool* receiveBuffers)
+  : m_conn(connection), m_receiveBuffers(receiveBuffers) {}
 
 void LevinProtocol::sendMessage(uint32_t command, const BinaryArray& out, bool needResponse) {
+  // write header and body in one operation
+  BinaryArray writeBuffer = frameMessage(command, out, needResponse);
+  writeStrict(writeBuffer.data(), writeBuffer.size());
+}
+
+BinaryArray LevinProtocol::frameMessage(uint32_t command, const BinaryArray& out, bool needResponse) {
   bucket_head2 head = { 0 };
   head.m_signature = LEVIN_SIGNATURE;
   head.m_cb = out.size();
@@ -50,15 +59,13 @@ void LevinProtocol::sendMessage(uint32_t command, const BinaryArray& out, bool n
   head.m_protocol_version = LEVIN_PROTOCOL_VER_1;
   head.m_flags = LEVIN_PACKET_REQUEST;
 
-  // write header and body in one operation
   BinaryArray writeBuffer;
   writeBuffer.reserve(sizeof(head) + out.size());
 
   Common::VectorOutputStream stream(writeBuffer);
   stream.writeSome(&head, sizeof(head));
   stream.writeSome(out.data(), out.size());
-
-  writeStrict(writeBuffer.data(), writeBuffer.size());
+  return writeBuffer;
 }
 
 bool LevinProtocol::readCommand(Command& cmd) {
@@ -76,17 +83,19 @@ bool LevinProtocol::readCommand(Command& cmd) {
     throw std::runtime_error("Levin packet size is too big");
   }
 
-  BinaryArray buf;
+  // the body goes to the buffer of the previous command, it is only allocated when it has no room
+  if (head.m_cb > cmd.buf.capacity() && m_receiveBuffers != nullptr) {
+    cmd.buf = m_receiveBuffers->take(head.m_cb);
+  }
 
+  cmd.buf.resize(head.m_cb);
   if (head.m_cb != 0) {
-    buf.resize(head.m_cb);
-    if (!readStrict(&buf[0], head.m_cb)) {
+    if (!readStrict(&cmd.buf[0], head.m_cb)) {
       return false;
     }
   }
 
   cmd.command = head.m_command;
-  cmd.buf = std::move(buf);
   cmd.isNotify = !head.m_have_to_return_data;
   cmd.isResponse = (head.m_flags & LEVIN_PACKET_RESPONSE) == LEVIN_PACKET_RESPONSE;
 
@@ -94,6 +103,36 @@ bool LevinProtocol::readCommand(Command& cmd) {
 }
 
 void LevinProtocol::sendReply(uint32_t command, const BinaryArray& out, int32_t returnCode) {
+  BinaryArray writeBuffer = frameReply(command, out, returnCode);
+  writeStrict(writeBuffer.data(), writeBuffer.size());
+}
+
+void LevinProtocol::sendPackets(const std::vector<std::shared_ptr<const BinaryArray>>& packets) {
+  std::vector<std::pair<const uint8_t*, size_t>> buffers;
+  buffers.reserve(packets.size());
+  for (const auto& packet : packets) {
+    buffers.emplace_back(packet->data(), packet->size());
+  }
+
+  while (!buffers.empty()) {
+    size_t written = m_conn.write(buffers);
+
+    // drop what has been sent, a partially sent buffer stays in front
+    auto sent = buffers.begin();
+    while (sent != buffers.end() && written >= sent->second) {
+      written -= sent->second;
+      ++sent;
+    }
+
+    buffers.erase(buffers.begin(), sent);
+    if (written != 0) {
+      buffers.front().first += written;
+      buffers.front().second -= written;
+    }
+  }
+}
+
+BinaryArray LevinProtocol::frameReply(uint32_t command, const BinaryArray& out, int32_t returnCode) {
   bucket_head2 head = { 0 };
   head.m_signature = LEVIN_SIGNATURE;
   head.m_cb = out.size();
@@ -109,8 +148,7 @@ void LevinProtocol::sendReply(uint32_t command, const BinaryArray& out, int32_t
   Common::VectorOutputStream stream(writeBuffer);
   stream.writeSome(&head, sizeof(head));
   stream.writeSome(out.data(), out.size());
-
-  writeStrict(writeBuffer.data(), writeBuffer.size());
+  return writeBuffer;
 }
 
 void LevinProtocol::writeStrict(const uint8_t* ptr, size_t size) {
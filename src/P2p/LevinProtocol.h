@@ -7,6 +7,8 @@
 
 #pragma once
 
+#include <memory>
+
 #include "CryptoNote.h"
 #include <Common/MemoryInputStream.h>
 #include <Common/VectorOutputStream.h>
@@ -19,6 +21,8 @@ class TcpConnection;
 
 namespace CryptoNote {
 
+class ReceiveBufferPool;
+
 enum class LevinError: int32_t {
   OK = 0,
   ERROR_CONNECTION = -1,
@@ -35,7 +39,8 @@ const int32_t LEVIN_PROTOCOL_RETCODE_SUCCESS = 1;
 class LevinProtocol {
 public:
 
-  LevinProtocol(System::TcpConnection& connection);
+  // commands larger than the buffer of the command being read are read into a buffer taken from receiveBuffers
+  LevinProtocol(System::TcpConnection& connection, ReceiveBufferPool* receiveBuffers = nullptr);
 
   template <typename Request, typename Response>
   bool invoke(uint32_t command, const Request& request, Response& response) {
@@ -67,14 +72,22 @@ public:
 
   bool readCommand(Command& cmd);
 
+  // bytes preceding the body of every message
+  static const size_t HEADER_SIZE = 33;
+
   void sendMessage(uint32_t command, const BinaryArray& out, bool needResponse);
   void sendReply(uint32_t command, const BinaryArray& out, int32_t returnCode);
+  // writes packets made by frameMessage/frameReply, gathering them into as few sends as possible
+  void sendPackets(const std::vector<std::shared_ptr<const BinaryArray>>& packets);
+
+  // header and body in one buffer, so a message can be framed once and written to any number of connections
+  static BinaryArray frameMessage(uint32_t command, const BinaryArray& out, bool needResponse);
+  static BinaryArray frameReply(uint32_t command, const BinaryArray& out, int32_t returnCode);
 
   template <typename T>
   static bool decode(const BinaryArray& buf, T& value) {
     try {
-      Common::MemoryInputStream stream(buf.data(), buf.size());
-      KVBinaryInputStreamSerializer serializer(stream);
+      KVBinaryInputStreamSerializer serializer(buf.data(), buf.size());
       serialize(value, serializer);
     } catch (std::exception&) {
       return false;
@@ -98,6 +111,7 @@ private:
   bool readStrict(uint8_t* ptr, size_t size);
   void writeStrict(const uint8_t* ptr, size_t size);
   System::TcpConnection& m_conn;
+  ReceiveBufferPool* m_receiveBuffers;
 };
 
 }
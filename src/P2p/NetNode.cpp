@@ -9,6 +9,8 @@
 
 #include <algorithm>
 #include <fstream>
+#include <limits>
+#include <numeric>
 
 #include <boost/foreach.hpp>
 #include <boost/uuid/random_generator.hpp>
@@ -49,12 +51,23 @@ using namespace CryptoNote;
 
 namespace {
 
-size_t get_random_index_with_fixed_probability(size_t max_index) {
-  //divide by zero workaround
-  if (!max_index)
-    return 0;
-  size_t x = Crypto::rand<size_t>() % (max_index + 1);
-  return (x*x*x) / (max_index*max_index); //parabola \/
+// responses serving a synchronizing peer, they yield to relay when bandwidth is limited
+bool is_bulk_command(uint32_t command) {
+  return command == NOTIFY_RESPONSE_GET_OBJECTS::ID || command == NOTIFY_RESPONSE_CHAIN_ENTRY::ID;
+}
+
+size_t get_random_index_with_weights(const std::vector<double>& weights) {
+  double total = std::accumulate(weights.begin(), weights.end(), 0.0);
+  double x = total * (static_cast<double>(Crypto::rand<uint32_t>()) / std::numeric_limits<uint32_t>::max());
+  for (size_t i = 0; i + 1 < weights.size(); ++i) {
+    if (x < weights[i]) {
+      return i;
+    }
+
+    x -= weights[i];
+  }
+
+  return weights.size() - 1;
 }
 
 
@@ -127,41 +140,83 @@ namespace CryptoNote
   }
 
 
+  //-----------------------------------------------------------------------------------
+  // P2pMessage implementation
+  //-----------------------------------------------------------------------------------
+
+  P2pMessage::P2pMessage(Type type, uint32_t command, const BinaryArray& buffer, int32_t returnCode) :
+    type(type), command(command), packet(std::make_shared<const BinaryArray>(type == REPLY ?
+      LevinProtocol::frameReply(command, buffer, returnCode) : LevinProtocol::frameMessage(command, buffer, type == COMMAND))) {
+  }
+
   //-----------------------------------------------------------------------------------
   // P2pConnectionContext implementation
   //-----------------------------------------------------------------------------------
 
   bool P2pConnectionContext::pushMessage(P2pMessage&& msg) {
-    writeQueueSize += msg.size();
+    size_t size = msg.size();
 
-    if (writeQueueSize > P2P_CONNECTION_MAX_WRITE_BUFFER_SIZE) {
+    if (writeQueueSize + size > P2P_CONNECTION_MAX_WRITE_BUFFER_SIZE) {
       logger(DEBUGGING) << *this << "Write queue overflows. Interrupt connection";
       interrupt();
       return false;
     }
 
-    writeQueue.push_back(std::move(msg));
+    // a connection holding nothing may always queue, so a full budget stops only the peers that don't read
+    if (writeQueueSize + writingSize != 0 && sendBudget->used + size > sendBudget->limit) {
+      logger(DEBUGGING) << *this << "Send buffers of all connections are full. Interrupt connection";
+      interrupt();
+      return false;
+    }
+
+    writeQueueSize += size;
+    sendBudget->used += size;
+    if (msg.type == P2pMessage::NOTIFY && is_bulk_command(msg.command)) {
+      bulkQueue.push_back(std::move(msg));
+    } else {
+      relayQueue.push_back(std::move(msg));
+    }
+
     queueEvent.set();
     return true;
   }
 
   std::vector<P2pMessage> P2pConnectionContext::popBuffer() {
-    writeOperationStartTime = TimePoint();
+    sendBudget->used -= writingSize;
+    writingSize = 0;
 
-    while (writeQueue.empty() && !stopped) {
+    while (relayQueue.empty() && bulkQueue.empty() && !stopped) {
       queueEvent.wait();
     }
 
-    std::vector<P2pMessage> msgs(std::move(writeQueue));
-    writeQueue.clear();
-    writeQueueSize = 0;
-    writeOperationStartTime = Clock::now();
     queueEvent.clear();
+    if (!relayQueue.empty() || stopped) {
+      return popRelayMessages();
+    }
+
+    std::vector<P2pMessage> msgs;
+    msgs.push_back(std::move(bulkQueue.front()));
+    bulkQueue.pop_front();
+    writingSize += msgs.back().size();
+    writeQueueSize -= msgs.back().size();
+    return msgs;
+  }
+
+  std::vector<P2pMessage> P2pConnectionContext::popRelayMessages() {
+    std::vector<P2pMessage> msgs(std::move(relayQueue));
+    relayQueue.clear();
+    for (auto& msg : msgs) {
+      writingSize += msg.size();
+      writeQueueSize -= msg.size();
+    }
+
     return msgs;
   }
 
-  uint64_t P2pConnectionContext::writeDuration(TimePoint now) const { // in milliseconds
-    return writeOperationStartTime == TimePoint() ? 0 : std::chrono::duration_cast<std::chrono::milliseconds>(now - writeOperationStartTime).count();
+  void P2pConnectionContext::releaseSendBudget() {
+    sendBudget->used -= writeQueueSize + writingSize;
+    writeQueueSize = 0;
+    writingSize = 0;
   }
 
   void P2pConnectionContext::interrupt() {
@@ -194,7 +249,9 @@ namespace CryptoNote
   NodeServer::NodeServer(System::Dispatcher& dispatcher, CryptoNote::CryptoNoteProtocolHandler& payload_handler, Logging::ILogger& log) :
     m_dispatcher(dispatcher),
     m_workingContextGroup(dispatcher),
+    m_connectionContextGroup(dispatcher),
     m_payload_handler(payload_handler),
+    m_peerScores(P2P_PEER_SCORES_LIMIT),
     m_allow_local_ip(false),
     m_hide_my_port(false),
     m_network_id(CRYPTONOTE_NETWORK),
@@ -203,7 +260,19 @@ namespace CryptoNote
     m_idleTimer(m_dispatcher),
     m_timedSyncTimer(m_dispatcher),
     m_timeoutTimer(m_dispatcher),
+    m_relayTimer(m_dispatcher),
     m_stop(false),
+    m_connectionsCount(0),
+    m_outgoingConnectionsCount(0),
+    m_whitePeersCount(0),
+    m_grayPeersCount(0),
+    m_sendBudget({ P2P_DEFAULT_SEND_BUFFER_SIZE, 0 }),
+    m_maxIncomingConnections(P2P_DEFAULT_MAX_INCOMING_CONNECTIONS),
+    m_writeTimeouts(std::chrono::seconds(1), 512, TimeoutWheel::Clock::now()),
+    m_idleTimeouts(std::chrono::seconds(1), 512, TimeoutWheel::Clock::now()),
+    m_peerUploadLimit(0),
+    m_peerDownloadLimit(0),
+    m_contextStackSize(P2P_DEFAULT_CONTEXT_STACK_SIZE),
     // intervals
     // m_peer_handshake_idle_maker_interval(CryptoNote::P2P_DEFAULT_HANDSHAKE_INTERVAL),
     m_connections_maker_interval(1),
@@ -211,15 +280,19 @@ namespace CryptoNote
   }
 
   void NodeServer::serialize(ISerializer& s) {
-    uint8_t version = 1;
+    uint8_t version = 2;
     s(version, "version");
     
-    if (version != 1) {
+    if (version != 1 && version != 2) {
       return;
     }
 
     s(m_peerlist, "peerlist");
     s(m_config.m_peer_id, "peer_id");
+
+    if (version >= 2) {
+      s(m_peerScores, "peer_scores");
+    }
   }
 
 #define INVOKE_HANDLER(CMD, Handler) case CMD::ID: { ret = invokeAdaptor<CMD>(cmd.buf, out, ctx,  boost::bind(Handler, this, _1, _2, _3, _4)); break; }
@@ -326,6 +399,43 @@ namespace CryptoNote
     });
   }
 
+  void NodeServer::report_download(const CryptoNoteConnectionContext& context, uint64_t bytes, std::chrono::milliseconds duration) {
+    NetworkAddress address;
+    if (get_peer_address(context, address)) {
+      m_peerScores.addDownload(address, bytes, duration, time(nullptr));
+    }
+  }
+
+  void NodeServer::report_invalid_data(const CryptoNoteConnectionContext& context) {
+    NetworkAddress address;
+    if (get_peer_address(context, address)) {
+      m_peerScores.addInvalidData(address, time(nullptr));
+    }
+  }
+
+  void NodeServer::drop_connection(const CryptoNoteConnectionContext& context) {
+    auto it = m_connections.find(context.m_connection_id);
+    if (it != m_connections.end() && it->second.context != nullptr) {
+      it->second.interrupt();
+    }
+  }
+
+  double NodeServer::get_peer_score(const CryptoNoteConnectionContext& context) {
+    NetworkAddress address;
+    return get_peer_address(context, address) ? m_peerScores.score(address) : 1.0;
+  }
+
+  bool NodeServer::get_peer_address(const CryptoNoteConnectionContext& context, NetworkAddress& address) {
+    auto it = m_connections.find(context.m_connection_id);
+    if (it == m_connections.end() || it->second.peerPort == 0) {
+      return false;
+    }
+
+    address.ip = it->second.m_remote_ip;
+    address.port = it->second.peerPort;
+    return true;
+  }
+
   //-----------------------------------------------------------------------------------
   bool NodeServer::make_default_config()
   {
@@ -394,6 +504,21 @@ namespace CryptoNote
     std::copy(seedNodes.begin(), seedNodes.end(), std::back_inserter(m_seed_nodes));
 
     m_hide_my_port = config.getHideMyPort();
+    m_payload_handler.setEarlyBlockRelay(config.getRelayBlocksEarly());
+    m_maxIncomingConnections = config.getMaxIncomingConnections();
+    m_sendBudget.limit = config.getSendBufferSize();
+    m_uploadLimit.setRate(config.getUploadLimit());
+    m_downloadLimit.setRate(config.getDownloadLimit());
+    m_peerUploadLimit = config.getPeerUploadLimit();
+    m_peerDownloadLimit = config.getPeerDownloadLimit();
+    m_contextStackSize = config.getContextStackSize();
+    if (m_contextStackSize < P2P_MIN_CONTEXT_STACK_SIZE) {
+      logger(WARNING) << "P2p context stack size " << m_contextStackSize / 1024 << " KiB is too small, using " <<
+        P2P_MIN_CONTEXT_STACK_SIZE / 1024 << " KiB";
+      m_contextStackSize = P2P_MIN_CONTEXT_STACK_SIZE;
+    }
+
+    m_connectionContextGroup = System::ContextGroup(m_dispatcher, m_contextStackSize);
     return true;
   }
 
@@ -494,12 +619,18 @@ namespace CryptoNote
     m_workingContextGroup.spawn(std::bind(&NodeServer::onIdle, this));
     m_workingContextGroup.spawn(std::bind(&NodeServer::timedSyncLoop, this));
     m_workingContextGroup.spawn(std::bind(&NodeServer::timeoutLoop, this));
+    m_workingContextGroup.spawn(std::bind(&NodeServer::relayLoop, this));
 
     m_stopEvent.wait();
+    if (m_stopHandler) {
+      m_stopHandler();
+    }
 
     logger(INFO) << "Stopping NodeServer and it's" << m_connections.size() << " connections...";
     m_workingContextGroup.interrupt();
+    m_connectionContextGroup.interrupt();
     m_workingContextGroup.wait();
+    m_connectionContextGroup.wait();
 
     logger(INFO) << "NodeServer loop stopped";
     return true;
@@ -508,7 +639,7 @@ namespace CryptoNote
   //-----------------------------------------------------------------------------------
   
   uint64_t NodeServer::get_connections_count() {
-    return m_connections.size();
+    return m_connectionsCount;
   }
   //-----------------------------------------------------------------------------------
   
@@ -558,6 +689,12 @@ namespace CryptoNote
     return true;
   }
 
+  //-----------------------------------------------------------------------------------
+
+  void NodeServer::setStopHandler(std::function<void()>&& handler) {
+    m_stopHandler = std::move(handler);
+  }
+
   //----------------------------------------------------------------------------------- 
   bool NodeServer::handshake(CryptoNote::LevinProtocol& proto, P2pConnectionContext& context, bool just_take_peerlist) {
     COMMAND_HANDSHAKE::request arg;
@@ -687,23 +824,80 @@ namespace CryptoNote
     if(m_config.m_peer_id == peer.id)
       return true; //dont make connections to ourself
 
-    for (const auto& kv : m_connections) {
-      const auto& cntxt = kv.second;
-      if(cntxt.peerId == peer.id || (!cntxt.m_is_income && peer.adr.ip == cntxt.m_remote_ip && peer.adr.port == cntxt.m_remote_port)) {
-        return true;
-      }
-    }
-    return false;
+    return m_connectedPeerIds.count(peer.id) != 0 || is_addr_connected(peer.adr);
   }
   //-----------------------------------------------------------------------------------
   
   bool NodeServer::is_addr_connected(const NetworkAddress& peer) {
-    for (const auto& conn : m_connections) {
-      if (!conn.second.m_is_income && peer.ip == conn.second.m_remote_ip && peer.port == conn.second.m_remote_port) {
-        return true;
+    return m_outgoingAddresses.count(peer) != 0;
+  }
+
+  bool NodeServer::is_incoming_connection_allowed(uint32_t ip) {
+    if (m_connections.size() - m_outgoingAddresses.size() >= m_maxIncomingConnections) {
+      return false;
+    }
+
+    auto it = m_incomingConnectionsPerIp.find(ip);
+    return it == m_incomingConnectionsPerIp.end() || it->second < P2P_MAX_INCOMING_CONNECTIONS_PER_IP;
+  }
+
+  NodeServer::ConnectionIterator NodeServer::addConnection(P2pConnectionContext&& context) {
+    auto it = m_connections.emplace(context.m_connection_id, std::move(context)).first;
+    P2pConnectionContext& connection = it->second;
+    connection.uploadLimit.setRate(m_peerUploadLimit);
+    connection.downloadLimit.setRate(m_peerDownloadLimit);
+    if (connection.m_is_income) {
+      ++m_incomingConnectionsPerIp[connection.m_remote_ip];
+    } else {
+      m_outgoingAddresses.insert({ connection.m_remote_ip, connection.m_remote_port });
+    }
+
+    if (connection.peerId != 0) {
+      m_connectedPeerIds.insert(connection.peerId);
+    }
+
+    m_connectionsCount = m_connections.size();
+    m_outgoingConnectionsCount = m_outgoingAddresses.size();
+    return it;
+  }
+
+  void NodeServer::removeConnection(const boost::uuids::uuid& connectionId) {
+    auto it = m_connections.find(connectionId);
+    if (it == m_connections.end()) {
+      return;
+    }
+
+    P2pConnectionContext& connection = it->second;
+    if (connection.m_is_income) {
+      auto ipIt = m_incomingConnectionsPerIp.find(connection.m_remote_ip);
+      if (--ipIt->second == 0) {
+        m_incomingConnectionsPerIp.erase(ipIt);
       }
+    } else {
+      m_outgoingAddresses.erase(m_outgoingAddresses.find({ connection.m_remote_ip, connection.m_remote_port }));
+    }
+
+    if (connection.peerId != 0) {
+      m_connectedPeerIds.erase(m_connectedPeerIds.find(connection.peerId));
+    }
+
+    m_writeTimeouts.cancel(connectionId);
+    m_idleTimeouts.cancel(connectionId);
+    m_connections.erase(it);
+
+    m_connectionsCount = m_connections.size();
+    m_outgoingConnectionsCount = m_outgoingAddresses.size();
+  }
+
+  void NodeServer::setConnectionPeerId(P2pConnectionContext& context, PeerIdType peerId) {
+    if (context.peerId != 0) {
+      m_connectedPeerIds.erase(m_connectedPeerIds.find(context.peerId));
+    }
+
+    context.peerId = peerId;
+    if (peerId != 0) {
+      m_connectedPeerIds.insert(peerId);
     }
-    return false;
   }
 
 
@@ -714,6 +908,7 @@ namespace CryptoNote
 
     try {
       System::TcpConnection connection;
+      auto connectStart = std::chrono::steady_clock::now();
 
       try {
         System::Context<System::TcpConnection> connectionContext(m_dispatcher, [&] {
@@ -733,11 +928,17 @@ namespace CryptoNote
         return false;
       }
 
-      P2pConnectionContext ctx(m_dispatcher, logger.getLogger(), std::move(connection));
+      // TCP handshake takes a single round trip, unlike ours which waits for the peer to ping back
+      if (!just_take_peerlist) {
+        m_peerScores.addConnectRtt(na, std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - connectStart), time(nullptr));
+      }
+
+      P2pConnectionContext ctx(m_dispatcher, logger.getLogger(), std::move(connection), m_sendBudget);
 
       ctx.m_connection_id = boost::uuids::random_generator()();
       ctx.m_remote_ip = na.ip;
       ctx.m_remote_port = na.port;
+      ctx.peerPort = na.port;
       ctx.m_is_income = false;
       ctx.m_started = time(nullptr);
 
@@ -779,11 +980,11 @@ namespace CryptoNote
         throw System::InterruptedException();
       }
 
-      auto iter = m_connections.emplace(ctx.m_connection_id, std::move(ctx)).first;
+      auto iter = addConnection(std::move(ctx));
       const boost::uuids::uuid& connectionId = iter->first;
       P2pConnectionContext& connectionContext = iter->second;
 	  
-      m_workingContextGroup.spawn(std::bind(&NodeServer::connectionHandler, this, std::cref(connectionId), std::ref(connectionContext)));
+      m_connectionContextGroup.spawn(std::bind(&NodeServer::connectionHandler, this, std::cref(connectionId), std::ref(connectionContext)));
 	  
       return true;
     } catch (System::InterruptedException&) {
@@ -805,30 +1006,35 @@ namespace CryptoNote
 
     size_t max_random_index = std::min<uint64_t>(local_peers_count -1, 20);
 
-    std::set<size_t> tried_peers;
-
-    size_t try_count = 0;
-    size_t rand_count = 0;
-    while(rand_count < (max_random_index+1)*3 &&  try_count < 10 && !m_stop) {
-      ++rand_count;
-      size_t random_index = get_random_index_with_fixed_probability(max_random_index);
-      if (!(random_index < local_peers_count)) { logger(ERROR, BRIGHT_RED) << "random_starter_index < peers_local.size() failed!!"; return false; }
-
-      if(tried_peers.count(random_index))
-        continue;
-
-      tried_peers.insert(random_index);
+    // the most recently seen peers are candidates, each one is picked with probability proportional to its score
+    std::vector<PeerlistEntry> candidates;
+    std::vector<double> weights;
+    for (size_t i = 0; i <= max_random_index; ++i) {
       PeerlistEntry pe = boost::value_initialized<PeerlistEntry>();
-      bool r = use_white_list ? m_peerlist.get_white_peer_by_index(pe, random_index):m_peerlist.get_gray_peer_by_index(pe, random_index);
-      if (!(r)) { logger(ERROR, BRIGHT_RED) << "Failed to get random peer from peerlist(white:" << use_white_list << ")"; return false; }
+      bool r = use_white_list ? m_peerlist.get_white_peer_by_index(pe, i):m_peerlist.get_gray_peer_by_index(pe, i);
+      if (!(r)) { logger(ERROR, BRIGHT_RED) << "Failed to get peer from peerlist(white:" << use_white_list << ")"; return false; }
 
+      if (!is_peer_used(pe)) {
+        candidates.push_back(pe);
+        weights.push_back(m_peerScores.score(pe.adr));
+      }
+    }
+
+    size_t try_count = 0;
+    while(!candidates.empty() && try_count < 10 && !m_stop) {
       ++try_count;
+      size_t index = get_random_index_with_weights(weights);
+      PeerlistEntry pe = candidates[index];
+      candidates.erase(candidates.begin() + index);
+      weights.erase(weights.begin() + index);
 
+      // connecting to a previous candidate may have taken a while
       if(is_peer_used(pe))
         continue;
 
       logger(DEBUGGING) << "Selected peer: " << pe.id << " " << pe.adr << " [white=" << use_white_list
-                    << "] last_seen: " << (pe.last_seen ? Common::timeIntervalToString(time(NULL) - pe.last_seen) : "never");
+                    << "] last_seen: " << (pe.last_seen ? Common::timeIntervalToString(time(NULL) - pe.last_seen) : "never")
+                    << " score: " << m_peerScores.score(pe.adr);
       
       if(!try_to_connect_and_handshake_with_new_peer(pe.adr, false, pe.last_seen, use_white_list))
         continue;
@@ -914,12 +1120,15 @@ namespace CryptoNote
 
   //-----------------------------------------------------------------------------------
   size_t NodeServer::get_outgoing_connections_count() {
-    size_t count = 0;
-    for (const auto& cntxt : m_connections) {
-      if (!cntxt.second.m_is_income)
-        ++count;
-    }
-    return count;
+    return m_outgoingConnectionsCount;
+  }
+
+  size_t NodeServer::getWhitePeersCount() const {
+    return m_whitePeersCount;
+  }
+
+  size_t NodeServer::getGrayPeersCount() const {
+    return m_grayPeersCount;
   }
 
   //-----------------------------------------------------------------------------------
@@ -930,6 +1139,9 @@ namespace CryptoNote
     } catch (std::exception& e) {
       logger(DEBUGGING) << "exception in idle_worker: " << e.what();
     }
+
+    m_whitePeersCount = m_peerlist.get_white_peers_count();
+    m_grayPeersCount = m_peerlist.get_gray_peers_count();
     return true;
   }
 
@@ -1065,13 +1277,21 @@ namespace CryptoNote
   //-----------------------------------------------------------------------------------
   
   void NodeServer::relay_notify_to_all(int command, const BinaryArray& data_buff, const net_connection_id* excludeConnection) {
+    relay_notify_to_all(command, data_buff, excludeConnection, 0, std::numeric_limits<uint8_t>::max());
+  }
+
+  //-----------------------------------------------------------------------------------
+
+  void NodeServer::relay_notify_to_all(int command, const BinaryArray& data_buff, const net_connection_id* excludeConnection, uint8_t minVersion, uint8_t maxVersion) {
     net_connection_id excludeId = excludeConnection ? *excludeConnection : boost::value_initialized<net_connection_id>();
+    // framed once, every connection queues a reference to the same packet
+    auto packet = std::make_shared<const BinaryArray>(LevinProtocol::frameMessage(command, data_buff, false));
 
     forEachConnection([&](P2pConnectionContext& conn) {
-      if (conn.peerId && conn.m_connection_id != excludeId &&
+      if (conn.peerId && conn.m_connection_id != excludeId && conn.version >= minVersion && conn.version <= maxVersion &&
           (conn.m_state == CryptoNoteConnectionContext::state_normal ||
            conn.m_state == CryptoNoteConnectionContext::state_synchronizing)) {
-        conn.pushMessage(P2pMessage(P2pMessage::NOTIFY, command, data_buff));
+        conn.pushMessage(P2pMessage(P2pMessage::NOTIFY, command, packet));
       }
     });
   }
@@ -1179,7 +1399,7 @@ namespace CryptoNote
       return 1;
     }
     //associate peer_id with this connection
-    context.peerId = arg.node_data.peer_id;
+    setConnectionPeerId(context, arg.node_data.peer_id);
 
     if(arg.node_data.peer_id != m_config.m_peer_id && arg.node_data.my_port) {
       PeerIdType peer_id_l = arg.node_data.peer_id;
@@ -1193,6 +1413,7 @@ namespace CryptoNote
           pe.last_seen = time(nullptr);
           pe.id = peer_id_l;
           m_peerlist.append_with_peer_white(pe);
+          context.peerPort = port_l;
 
           logger(Logging::TRACE) << context << "BACK PING SUCCESS, " << Common::ipAddressToString(context.m_remote_ip) << ":" << port_l << " added to whitelist";
       }
@@ -1232,6 +1453,22 @@ namespace CryptoNote
     return true;
   }
   //-----------------------------------------------------------------------------------
+
+  bool NodeServer::log_peer_scores() {
+    std::stringstream ss;
+    for (const auto& entry : m_peerScores.getAll()) {
+      const PeerScore& score = entry.second;
+      ss << entry.first << " \tscore: " << std::fixed << std::setprecision(2) << m_peerScores.score(entry.first)
+        << " \trtt: " << (score.connectRtt ? std::to_string(score.connectRtt) + " ms" : "-")
+        << " \tdownload: " << (score.downloadRate ? std::to_string(score.downloadRate / 1024) + " KiB/s" : "-")
+        << " \tinvalid: " << score.invalidData
+        << " \tuptime: " << Common::timeIntervalToString(score.uptime) << std::endl;
+    }
+
+    logger(INFO) << "Peer scores: \r\n" << ss.str();
+    return true;
+  }
+  //-----------------------------------------------------------------------------------
   
   std::string NodeServer::print_connections_container() {
 
@@ -1258,6 +1495,12 @@ namespace CryptoNote
   void NodeServer::on_connection_close(P2pConnectionContext& context)
   {
     logger(TRACE) << context << "CLOSE CONNECTION";
+    if (context.peerPort != 0) {
+      NetworkAddress address = { context.m_remote_ip, context.peerPort };
+      time_t now = time(nullptr);
+      m_peerScores.addUptime(address, now - context.m_started, now);
+    }
+
     m_payload_handler.onConnectionClosed(context);
   }
   
@@ -1299,7 +1542,7 @@ namespace CryptoNote
   void NodeServer::acceptLoop() {
     for (;;) {
       try {
-        P2pConnectionContext ctx(m_dispatcher, logger.getLogger(), m_listener.accept());
+        P2pConnectionContext ctx(m_dispatcher, logger.getLogger(), m_listener.accept(), m_sendBudget);
         ctx.m_connection_id = boost::uuids::random_generator()();
         ctx.m_is_income = true;
         ctx.m_started = time(nullptr);
@@ -1308,11 +1551,16 @@ namespace CryptoNote
         ctx.m_remote_ip = hostToNetwork(addressAndPort.first.getValue());
         ctx.m_remote_port = addressAndPort.second;
 
-        auto iter = m_connections.emplace(ctx.m_connection_id, std::move(ctx)).first;
+        if (!is_incoming_connection_allowed(ctx.m_remote_ip)) {
+          logger(DEBUGGING) << ctx << "Too many incoming connections, closing connection";
+          continue;
+        }
+
+        auto iter = addConnection(std::move(ctx));
         const boost::uuids::uuid& connectionId = iter->first;
         P2pConnectionContext& connection = iter->second;
 
-        m_workingContextGroup.spawn(std::bind(&NodeServer::connectionHandler, this, std::cref(connectionId), std::ref(connection)));
+        m_connectionContextGroup.spawn(std::bind(&NodeServer::connectionHandler, this, std::cref(connectionId), std::ref(connection)));
       } catch (System::InterruptedException&) {
         logger(DEBUGGING) << "acceptLoop() is interrupted";
         break;
@@ -1344,15 +1592,29 @@ namespace CryptoNote
 
   void NodeServer::timeoutLoop() {
     try {
+      std::vector<boost::uuids::uuid> expired;
       while (!m_stop) {
-        m_timeoutTimer.sleep(std::chrono::seconds(10));
-        auto now = P2pConnectionContext::Clock::now();
-
-        for (auto& kv : m_connections) {
-          auto& ctx = kv.second;
-          if (ctx.writeDuration(now) > P2P_DEFAULT_INVOKE_TIMEOUT) {
-            logger(WARNING) << ctx << "write operation timed out, stopping connection";
-            ctx.interrupt();
+        m_timeoutTimer.sleep(std::chrono::seconds(1));
+        auto now = TimeoutWheel::Clock::now();
+
+        expired.clear();
+        m_writeTimeouts.expire(now, expired);
+        for (const auto& connectionId : expired) {
+          auto it = m_connections.find(connectionId);
+          if (it != m_connections.end()) {
+            logger(WARNING) << it->second << "write operation timed out, stopping connection";
+            it->second.interrupt();
+          }
+        }
+
+        expired.clear();
+        m_idleTimeouts.expire(now, expired);
+        for (const auto& connectionId : expired) {
+          auto it = m_connections.find(connectionId);
+          if (it != m_connections.end()) {
+            logger(DEBUGGING) << it->second << (it->second.m_state == CryptoNoteConnectionContext::state_befor_handshake ?
+              "handshake timed out" : "connection is idle") << ", stopping connection";
+            it->second.interrupt();
           }
         }
       }
@@ -1363,6 +1625,19 @@ namespace CryptoNote
     }
   }
 
+  void NodeServer::relayLoop() {
+    try {
+      while (!m_stop) {
+        m_relayTimer.sleep(std::chrono::milliseconds(P2P_TX_RELAY_INTERVAL));
+        m_payload_handler.relayTransactionInventory();
+      }
+    } catch (System::InterruptedException&) {
+      logger(DEBUGGING) << "relayLoop() is interrupted";
+    } catch (std::exception& e) {
+      logger(WARNING) << "Exception in relayLoop: " << e.what();
+    }
+  }
+
   void NodeServer::timedSyncLoop() {
     try {
       for (;;) {
@@ -1381,13 +1656,19 @@ namespace CryptoNote
   void NodeServer::connectionHandler(const boost::uuids::uuid& connectionId, P2pConnectionContext& ctx) {
     // This inner context is necessary in order to stop connection handler at any moment
     System::Context<> context(m_dispatcher, [this, &connectionId, &ctx] {
-      System::Context<> writeContext(m_dispatcher, std::bind(&NodeServer::writeHandler, this, std::ref(ctx)));
+      System::Context<> writeContext(m_dispatcher, std::bind(&NodeServer::writeHandler, this, std::ref(ctx)), m_contextStackSize);
 
       try {
         on_connection_new(ctx);
 		
-        LevinProtocol proto(ctx.connection);
+        LevinProtocol proto(ctx.connection, &m_receiveBuffers);
         LevinProtocol::Command cmd;
+        System::Timer shapingTimer(m_dispatcher);
+
+        // an incoming peer has to handshake soon, then any command it sends postpones the idle timeout
+        auto now = TimeoutWheel::Clock::now();
+        m_idleTimeouts.set(connectionId, ctx.m_is_income ?
+          now + std::chrono::milliseconds(m_config.m_net_config.connection_timeout * 3) : now + std::chrono::seconds(P2P_IDLE_CONNECTION_TIMEOUT));
 
         for (;;) {
           if (ctx.m_state == CryptoNoteConnectionContext::state_sync_required) {
@@ -1402,6 +1683,15 @@ namespace CryptoNote
             break;
           }
 
+          auto received = TimeoutWheel::Clock::now();
+          m_idleTimeouts.set(connectionId, received + std::chrono::seconds(P2P_IDLE_CONNECTION_TIMEOUT));
+
+          uint64_t size = LevinProtocol::HEADER_SIZE + cmd.buf.size();
+          ctx.m_recv_cnt += size;
+          ctx.m_last_recv = time(nullptr);
+          ctx.downloadLimit.consume(received, size);
+          m_downloadLimit.consume(received, size);
+
           BinaryArray response;
           bool handled = false;
           auto retcode = handleCommand(cmd, response, ctx, handled);
@@ -1416,9 +1706,20 @@ namespace CryptoNote
             ctx.pushMessage(P2pMessage(P2pMessage::REPLY, cmd.command, std::move(response), retcode));
           }
 		  
+          // commands are decoded into their own structures by now, a large buffer goes back to the pool
+          if (cmd.buf.capacity() > P2P_CONNECTION_RECEIVE_BUFFER_SIZE) {
+            m_receiveBuffers.put(std::move(cmd.buf));
+            cmd.buf = BinaryArray();
+          }
+
           if (ctx.m_state == CryptoNoteConnectionContext::state_shutdown) {
             break;
           }
+
+          // the next command isn't read until the download limits allow, so the peer slows down sending
+          if (cmd.isNotify && is_bulk_command(cmd.command)) {
+            waitForTokens(ctx.downloadLimit, m_downloadLimit, shapingTimer);
+          }
         }
       } catch (System::InterruptedException&) {
         logger(DEBUGGING) << ctx << "connectionHandler() inner context is interrupted";
@@ -1429,10 +1730,11 @@ namespace CryptoNote
       ctx.interrupt();
       writeContext.interrupt();
       writeContext.get();
+      ctx.releaseSendBudget();
 
       on_connection_close(ctx);
-      m_connections.erase(connectionId);
-    });
+      removeConnection(connectionId);
+    }, m_contextStackSize);
 
     ctx.context = &context;
 
@@ -1448,29 +1750,25 @@ namespace CryptoNote
 
     try {
       LevinProtocol proto(ctx.connection);
+      System::Timer shapingTimer(m_dispatcher);
 
       for (;;) {
+        m_writeTimeouts.cancel(ctx.m_connection_id);
         auto msgs = ctx.popBuffer();
         if (msgs.empty()) {
           break;
         }
 
-        for (const auto& msg : msgs) {
-          logger(DEBUGGING) << ctx << "msg " << msg.type << ':' << msg.command;
-          switch (msg.type) {
-          case P2pMessage::COMMAND:
-            proto.sendMessage(msg.command, msg.buffer, true);
-            break;
-          case P2pMessage::NOTIFY:
-            proto.sendMessage(msg.command, msg.buffer, false);
-            break;
-          case P2pMessage::REPLY:
-            proto.sendReply(msg.command, msg.buffer, msg.returnCode);
-            break;
-          default:
-            assert(false);
+        // relay goes out at once, a bulk response waits for the upload limits and lets the relay queued meanwhile go first
+        if (msgs.front().type == P2pMessage::NOTIFY && is_bulk_command(msgs.front().command)) {
+          waitForTokens(ctx.uploadLimit, m_uploadLimit, shapingTimer);
+          auto relayMsgs = ctx.popRelayMessages();
+          if (!relayMsgs.empty()) {
+            sendMessages(proto, ctx, relayMsgs.begin(), relayMsgs.end());
           }
         }
+
+        sendMessages(proto, ctx, msgs.begin(), msgs.end());
       }
     } catch (System::InterruptedException&) {
       // connection stopped
@@ -1482,4 +1780,36 @@ namespace CryptoNote
 
     logger(DEBUGGING) << ctx << "writeHandler finished";
   }
+
+  void NodeServer::sendMessages(LevinProtocol& proto, P2pConnectionContext& ctx, std::vector<P2pMessage>::const_iterator begin, std::vector<P2pMessage>::const_iterator end) {
+    auto now = TimeoutWheel::Clock::now();
+    m_writeTimeouts.set(ctx.m_connection_id, now + std::chrono::milliseconds(P2P_DEFAULT_INVOKE_TIMEOUT));
+
+    uint64_t size = 0;
+    std::vector<std::shared_ptr<const BinaryArray>> packets;
+    packets.reserve(std::distance(begin, end));
+    for (auto it = begin; it != end; ++it) {
+      logger(DEBUGGING) << ctx << "msg " << it->type << ':' << it->command;
+      packets.push_back(it->packet);
+      size += it->packet->size();
+    }
+
+    ctx.uploadLimit.consume(now, size);
+    m_uploadLimit.consume(now, size);
+    proto.sendPackets(packets);
+    ctx.m_send_cnt += size;
+    ctx.m_last_send = time(nullptr);
+  }
+
+  void NodeServer::waitForTokens(TokenBucket& peerLimit, TokenBucket& limit, System::Timer& timer) {
+    for (;;) {
+      auto now = TokenBucket::Clock::now();
+      auto delay = std::max(peerLimit.delay(now), limit.delay(now));
+      if (delay == TokenBucket::Clock::duration::zero()) {
+        break;
+      }
+
+      timer.sleep(std::chrono::duration_cast<std::chrono::nanoseconds>(delay));
+    }
+  }
 }
@@ -7,8 +7,11 @@
 
 #pragma once
 
+#include <deque>
 #include <functional>
+#include <set>
 #include <unordered_map>
+#include <unordered_set>
 
 #include <boost/functional/hash.hpp>
 
@@ -32,6 +35,10 @@
 #include "P2pProtocolDefinitions.h"
 #include "P2pNetworks.h"
 #include "PeerListManager.h"
+#include "PeerScores.h"
+#include "ReceiveBufferPool.h"
+#include "TimeoutWheel.h"
+#include "TokenBucket.h"
 
 namespace System {
 class TcpConnection;
@@ -49,38 +56,43 @@ namespace CryptoNote
       NOTIFY
     };
 
-    P2pMessage(Type type, uint32_t command, const BinaryArray& buffer, int32_t returnCode = 0) :
-      type(type), command(command), buffer(buffer), returnCode(returnCode) {
-    }
-
-    P2pMessage(P2pMessage&& msg) :
-      type(msg.type), command(msg.command), buffer(std::move(msg.buffer)), returnCode(msg.returnCode) {
+    P2pMessage(Type type, uint32_t command, const BinaryArray& buffer, int32_t returnCode = 0);
+    // packet is already framed, it is shared by every connection the message is queued to
+    P2pMessage(Type type, uint32_t command, std::shared_ptr<const BinaryArray> packet) :
+      type(type), command(command), packet(std::move(packet)) {
     }
 
     size_t size() {
-      return buffer.size();
+      return packet->size();
     }
 
     Type type;
     uint32_t command;
-    const BinaryArray buffer;
-    int32_t returnCode;
+    std::shared_ptr<const BinaryArray> packet;
+  };
+
+  // bytes queued for sending on all connections together
+  struct P2pSendBudget {
+    size_t limit;
+    size_t used;
   };
 
   struct P2pConnectionContext : public CryptoNoteConnectionContext {
   public:
-    using Clock = std::chrono::steady_clock;
-    using TimePoint = Clock::time_point;
-
     System::Context<void>* context;
     PeerIdType peerId;
+    uint32_t peerPort; // listening port of the peer, 0 while unknown
     System::TcpConnection connection;
+    TokenBucket uploadLimit;
+    TokenBucket downloadLimit;
 
-    P2pConnectionContext(System::Dispatcher& dispatcher, Logging::ILogger& log, System::TcpConnection&& conn) :
+    P2pConnectionContext(System::Dispatcher& dispatcher, Logging::ILogger& log, System::TcpConnection&& conn, P2pSendBudget& sendBudget) :
       context(nullptr),
       peerId(0),
+      peerPort(0),
       connection(std::move(conn)),
       logger(log, "node_server"),
+      sendBudget(&sendBudget),
       queueEvent(dispatcher),
       stopped(false) {
     }
@@ -89,24 +101,34 @@ namespace CryptoNote
       CryptoNoteConnectionContext(std::move(ctx)),
       context(ctx.context),
       peerId(ctx.peerId),
+      peerPort(ctx.peerPort),
       connection(std::move(ctx.connection)),
+      uploadLimit(ctx.uploadLimit),
+      downloadLimit(ctx.downloadLimit),
       logger(ctx.logger.getLogger(), "node_server"),
+      sendBudget(ctx.sendBudget),
       queueEvent(std::move(ctx.queueEvent)),
       stopped(std::move(ctx.stopped)) {
     }
 
     bool pushMessage(P2pMessage&& msg);
+    // waits for messages and takes all the queued relay messages, or the oldest bulk one when there are none.
+    // The messages taken by the previous call are sent by now
     std::vector<P2pMessage> popBuffer();
+    // relay messages queued since the last call, without waiting
+    std::vector<P2pMessage> popRelayMessages();
+    // gives back to the budget what the connection still holds, once it is stopped
+    void releaseSendBudget();
     void interrupt();
 
-    uint64_t writeDuration(TimePoint now) const;
-
   private:
     Logging::LoggerRef logger;
-    TimePoint writeOperationStartTime;
+    P2pSendBudget* sendBudget;
     System::Event queueEvent;
-    std::vector<P2pMessage> writeQueue;
+    std::vector<P2pMessage> relayQueue;
+    std::deque<P2pMessage> bulkQueue;
     size_t writeQueueSize = 0;
+    size_t writingSize = 0;
     bool stopped;
   };
 
@@ -122,6 +144,8 @@ namespace CryptoNote
     bool init(const NetNodeConfig& config);
     bool deinit();
     bool sendStopSignal();
+    // called on the dispatcher thread once a stop is requested, while the connections are still served
+    void setStopHandler(std::function<void()>&& handler);
     uint32_t get_this_peer_port(){return m_listeningPort;}
     CryptoNote::CryptoNoteProtocolHandler& get_payload_object();
 
@@ -130,8 +154,12 @@ namespace CryptoNote
     // debug functions
     bool log_peerlist();
     bool log_connections();
+    bool log_peer_scores();
     virtual uint64_t get_connections_count() override;
     size_t get_outgoing_connections_count();
+    // peer list sizes as of the last idle loop, unlike the peer list these can be read from other threads
+    size_t getWhitePeersCount() const;
+    size_t getGrayPeersCount() const;
 
     CryptoNote::PeerlistManager& getPeerlistManager() { return m_peerlist; }
 
@@ -165,9 +193,14 @@ namespace CryptoNote
 
     //----------------- i_p2p_endpoint -------------------------------------------------------------
     virtual void relay_notify_to_all(int command, const BinaryArray& data_buff, const net_connection_id* excludeConnection) override;
+    virtual void relay_notify_to_all(int command, const BinaryArray& data_buff, const net_connection_id* excludeConnection, uint8_t minVersion, uint8_t maxVersion) override;
     virtual bool invoke_notify_to_peer(int command, const BinaryArray& req_buff, const CryptoNoteConnectionContext& context) override;
     virtual void for_each_connection(std::function<void(CryptoNote::CryptoNoteConnectionContext&, PeerIdType)> f) override;
     virtual void externalRelayNotifyToAll(int command, const BinaryArray& data_buff) override;
+    virtual void report_download(const CryptoNoteConnectionContext& context, uint64_t bytes, std::chrono::milliseconds duration) override;
+    virtual void report_invalid_data(const CryptoNoteConnectionContext& context) override;
+    virtual void drop_connection(const CryptoNoteConnectionContext& context) override;
+    virtual double get_peer_score(const CryptoNoteConnectionContext& context) override;
 
     //-----------------------------------------------------------------------------------------------
     bool handle_command_line(const boost::program_options::variables_map& vm);
@@ -188,6 +221,8 @@ namespace CryptoNote
     bool try_ping(basic_node_data& node_data, P2pConnectionContext& context);
     bool make_expected_connections_count(bool white_list, size_t expected_connections);
     bool is_priority_node(const NetworkAddress& na);
+    bool get_peer_address(const CryptoNoteConnectionContext& context, NetworkAddress& address);
+    bool is_incoming_connection_allowed(uint32_t ip);
 
     bool connect_to_peerlist(const std::vector<NetworkAddress>& peers);
 
@@ -201,12 +236,39 @@ namespace CryptoNote
     typedef ConnectionContainer::iterator ConnectionIterator;
     ConnectionContainer m_connections;
 
+    ConnectionIterator addConnection(P2pConnectionContext&& context);
+    void removeConnection(const boost::uuids::uuid& connectionId);
+    void setConnectionPeerId(P2pConnectionContext& context, PeerIdType peerId);
+
+    // indexes of m_connections
+    std::unordered_multiset<PeerIdType> m_connectedPeerIds;
+    std::multiset<NetworkAddress> m_outgoingAddresses;
+    std::unordered_map<uint32_t, size_t> m_incomingConnectionsPerIp;
+
+    P2pSendBudget m_sendBudget;
+    uint32_t m_maxIncomingConnections;
+    // deadlines of write operations, and of the next command or of the handshake
+    TimeoutWheel m_writeTimeouts;
+    TimeoutWheel m_idleTimeouts;
+
+    // all connections together, and the rates of every connection
+    TokenBucket m_uploadLimit;
+    TokenBucket m_downloadLimit;
+    uint64_t m_peerUploadLimit;
+    uint64_t m_peerDownloadLimit;
+    size_t m_contextStackSize;
+
+    ReceiveBufferPool m_receiveBuffers;
+
     void acceptLoop();
     void connectionHandler(const boost::uuids::uuid& connectionId, P2pConnectionContext& connection);
     void writeHandler(P2pConnectionContext& ctx);
+    void sendMessages(LevinProtocol& proto, P2pConnectionContext& ctx, std::vector<P2pMessage>::const_iterator begin, std::vector<P2pMessage>::const_iterator end);
+    void waitForTokens(TokenBucket& peerLimit, TokenBucket& limit, System::Timer& timer);
     void onIdle();
     void timedSyncLoop();
     void timeoutLoop();
+    void relayLoop();
 
     struct config
     {
@@ -233,15 +295,25 @@ namespace CryptoNote
 
     System::Dispatcher& m_dispatcher;
     System::ContextGroup m_workingContextGroup;
+    // the contexts serving connections, their stacks are of the configured size
+    System::ContextGroup m_connectionContextGroup;
     System::Event m_stopEvent;
     System::Timer m_idleTimer;
     System::Timer m_timeoutTimer;
+    System::Timer m_relayTimer;
     System::TcpListener m_listener;
     Logging::LoggerRef logger;
     std::atomic<bool> m_stop;
+    std::function<void()> m_stopHandler;
+    // counts kept for other threads, such as the RPC server
+    std::atomic<size_t> m_connectionsCount;
+    std::atomic<size_t> m_outgoingConnectionsCount;
+    std::atomic<size_t> m_whitePeersCount;
+    std::atomic<size_t> m_grayPeersCount;
 
     CryptoNoteProtocolHandler& m_payload_handler;
     PeerlistManager m_peerlist;
+    PeerScores m_peerScores;
 
     // OnceInInterval m_peer_handshake_idle_maker_interval;
     OnceInInterval m_connections_maker_interval;
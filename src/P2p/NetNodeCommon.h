@@ -7,6 +7,8 @@
 
 #pragma once
 
+#include <chrono>
+
 #include "CryptoNote.h"
 #include "P2pProtocolTypes.h"
 
@@ -16,18 +18,32 @@ namespace CryptoNote {
 
   struct IP2pEndpoint {
     virtual void relay_notify_to_all(int command, const BinaryArray& data_buff, const net_connection_id* excludeConnection) = 0;
+    // relays to connections whose protocol version is within [minVersion, maxVersion] only
+    virtual void relay_notify_to_all(int command, const BinaryArray& data_buff, const net_connection_id* excludeConnection, uint8_t minVersion, uint8_t maxVersion) = 0;
     virtual bool invoke_notify_to_peer(int command, const BinaryArray& req_buff, const CryptoNote::CryptoNoteConnectionContext& context) = 0;
     virtual uint64_t get_connections_count()=0;
     virtual void for_each_connection(std::function<void(CryptoNote::CryptoNoteConnectionContext&, PeerIdType)> f) = 0;
     // can be called from external threads
     virtual void externalRelayNotifyToAll(int command, const BinaryArray& data_buff) = 0;
+    // measurements of the peer behind the connection, they are kept after it closes
+    virtual void report_download(const CryptoNote::CryptoNoteConnectionContext& context, uint64_t bytes, std::chrono::milliseconds duration) = 0;
+    virtual void report_invalid_data(const CryptoNote::CryptoNoteConnectionContext& context) = 0;
+    // 1 for a peer never measured, higher is better
+    virtual double get_peer_score(const CryptoNote::CryptoNoteConnectionContext& context) = 0;
+    // closes the connection without waiting for its next command
+    virtual void drop_connection(const CryptoNote::CryptoNoteConnectionContext& context) = 0;
   };
 
   struct p2p_endpoint_stub: public IP2pEndpoint {
     virtual void relay_notify_to_all(int command, const BinaryArray& data_buff, const net_connection_id* excludeConnection) override {}
+    virtual void relay_notify_to_all(int command, const BinaryArray& data_buff, const net_connection_id* excludeConnection, uint8_t minVersion, uint8_t maxVersion) override {}
     virtual bool invoke_notify_to_peer(int command, const BinaryArray& req_buff, const CryptoNote::CryptoNoteConnectionContext& context) override { return true; }
     virtual void for_each_connection(std::function<void(CryptoNote::CryptoNoteConnectionContext&, PeerIdType)> f) override {}
     virtual uint64_t get_connections_count() override { return 0; }   
     virtual void externalRelayNotifyToAll(int command, const BinaryArray& data_buff) override {}
+    virtual void report_download(const CryptoNote::CryptoNoteConnectionContext& context, uint64_t bytes, std::chrono::milliseconds duration) override {}
+    virtual void report_invalid_data(const CryptoNote::CryptoNoteConnectionContext& context) override {}
+    virtual double get_peer_score(const CryptoNote::CryptoNoteConnectionContext& context) override { return 1; }
+    virtual void drop_connection(const CryptoNote::CryptoNoteConnectionContext& context) override {}
   };
 }
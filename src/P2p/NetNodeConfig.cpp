@@ -28,6 +28,16 @@ const command_line::arg_descriptor<std::vector<std::string> > arg_p2p_add_exclus
       " If this option is given the options add-priority-node and seed-node are ignored"};
 const command_line::arg_descriptor<std::vector<std::string> > arg_p2p_seed_node   = {"seed-node", "Connect to a node to retrieve peer addresses, and disconnect"};
 const command_line::arg_descriptor<bool> arg_p2p_hide_my_port   =    {"hide-my-port", "Do not announce yourself as peerlist candidate", false, true};
+const command_line::arg_descriptor<bool> arg_p2p_relay_blocks_early = {"relay-blocks-before-validation", "Relay new blocks to peers as soon as their proof of work is checked, before full validation"};
+const command_line::arg_descriptor<uint32_t> arg_p2p_max_incoming_connections = {"p2p-max-incoming-connections", "Maximum number of incoming p2p connections", P2P_DEFAULT_MAX_INCOMING_CONNECTIONS};
+const command_line::arg_descriptor<uint32_t> arg_p2p_send_buffer_size = {"p2p-send-buffer-size", "Megabytes queued for sending on all p2p connections together, a peer that doesn't read is disconnected when it's full",
+  static_cast<uint32_t>(P2P_DEFAULT_SEND_BUFFER_SIZE / (1024 * 1024))};
+const command_line::arg_descriptor<uint32_t> arg_p2p_upload_limit = {"p2p-upload-limit", "Upload rate of all p2p connections together, KiB/s, 0 is unlimited", 0};
+const command_line::arg_descriptor<uint32_t> arg_p2p_download_limit = {"p2p-download-limit", "Download rate of all p2p connections together, KiB/s, 0 is unlimited", 0};
+const command_line::arg_descriptor<uint32_t> arg_p2p_peer_upload_limit = {"p2p-peer-upload-limit", "Upload rate of a single p2p connection, KiB/s, 0 is unlimited", 0};
+const command_line::arg_descriptor<uint32_t> arg_p2p_peer_download_limit = {"p2p-peer-download-limit", "Download rate of a single p2p connection, KiB/s, 0 is unlimited", 0};
+const command_line::arg_descriptor<uint32_t> arg_p2p_stack_size = {"p2p-stack-size", "Stack size of the contexts serving a p2p connection, KiB, at least 64, a connection takes three of them",
+  static_cast<uint32_t>(P2P_DEFAULT_CONTEXT_STACK_SIZE / 1024)};
 
 bool parsePeerFromString(NetworkAddress& pe, const std::string& node_addr) {
   return Common::parseIpAddressAndPort(pe.ip, pe.port, node_addr);
@@ -61,6 +71,14 @@ void NetNodeConfig::initOptions(boost::program_options::options_description& des
   command_line::add_arg(desc, arg_p2p_add_exclusive_node);
   command_line::add_arg(desc, arg_p2p_seed_node);
   command_line::add_arg(desc, arg_p2p_hide_my_port);
+  command_line::add_arg(desc, arg_p2p_relay_blocks_early);
+  command_line::add_arg(desc, arg_p2p_max_incoming_connections);
+  command_line::add_arg(desc, arg_p2p_send_buffer_size);
+  command_line::add_arg(desc, arg_p2p_upload_limit);
+  command_line::add_arg(desc, arg_p2p_download_limit);
+  command_line::add_arg(desc, arg_p2p_peer_upload_limit);
+  command_line::add_arg(desc, arg_p2p_peer_download_limit);
+  command_line::add_arg(desc, arg_p2p_stack_size);
 }
 
 NetNodeConfig::NetNodeConfig() {
@@ -69,6 +87,14 @@ NetNodeConfig::NetNodeConfig() {
   externalPort = 0;
   allowLocalIp = false;
   hideMyPort = false;
+  relayBlocksEarly = false;
+  maxIncomingConnections = P2P_DEFAULT_MAX_INCOMING_CONNECTIONS;
+  sendBufferSize = P2P_DEFAULT_SEND_BUFFER_SIZE;
+  uploadLimit = 0;
+  downloadLimit = 0;
+  peerUploadLimit = 0;
+  peerDownloadLimit = 0;
+  contextStackSize = P2P_DEFAULT_CONTEXT_STACK_SIZE;
   configFolder = Tools::getDefaultDataDirectory();
   testnet = false;
 }
@@ -129,6 +155,38 @@ bool NetNodeConfig::init(const boost::program_options::variables_map& vm)
     hideMyPort = true;
   }
 
+  if (command_line::has_arg(vm, arg_p2p_relay_blocks_early)) {
+    relayBlocksEarly = true;
+  }
+
+  if (command_line::has_arg(vm, arg_p2p_max_incoming_connections)) {
+    maxIncomingConnections = command_line::get_arg(vm, arg_p2p_max_incoming_connections);
+  }
+
+  if (command_line::has_arg(vm, arg_p2p_send_buffer_size)) {
+    sendBufferSize = static_cast<size_t>(command_line::get_arg(vm, arg_p2p_send_buffer_size)) * 1024 * 1024;
+  }
+
+  if (command_line::has_arg(vm, arg_p2p_upload_limit)) {
+    uploadLimit = static_cast<uint64_t>(command_line::get_arg(vm, arg_p2p_upload_limit)) * 1024;
+  }
+
+  if (command_line::has_arg(vm, arg_p2p_download_limit)) {
+    downloadLimit = static_cast<uint64_t>(command_line::get_arg(vm, arg_p2p_download_limit)) * 1024;
+  }
+
+  if (command_line::has_arg(vm, arg_p2p_peer_upload_limit)) {
+    peerUploadLimit = static_cast<uint64_t>(command_line::get_arg(vm, arg_p2p_peer_upload_limit)) * 1024;
+  }
+
+  if (command_line::has_arg(vm, arg_p2p_peer_download_limit)) {
+    peerDownloadLimit = static_cast<uint64_t>(command_line::get_arg(vm, arg_p2p_peer_download_limit)) * 1024;
+  }
+
+  if (command_line::has_arg(vm, arg_p2p_stack_size)) {
+    contextStackSize = static_cast<size_t>(command_line::get_arg(vm, arg_p2p_stack_size)) * 1024;
+  }
+
   return true;
 }
 
@@ -184,6 +242,38 @@ bool NetNodeConfig::getHideMyPort() const {
   return hideMyPort;
 }
 
+bool NetNodeConfig::getRelayBlocksEarly() const {
+  return relayBlocksEarly;
+}
+
+uint32_t NetNodeConfig::getMaxIncomingConnections() const {
+  return maxIncomingConnections;
+}
+
+size_t NetNodeConfig::getSendBufferSize() const {
+  return sendBufferSize;
+}
+
+uint64_t NetNodeConfig::getUploadLimit() const {
+  return uploadLimit;
+}
+
+uint64_t NetNodeConfig::getDownloadLimit() const {
+  return downloadLimit;
+}
+
+uint64_t NetNodeConfig::getPeerUploadLimit() const {
+  return peerUploadLimit;
+}
+
+uint64_t NetNodeConfig::getPeerDownloadLimit() const {
+  return peerDownloadLimit;
+}
+
+size_t NetNodeConfig::getContextStackSize() const {
+  return contextStackSize;
+}
+
 std::string NetNodeConfig::getConfigFolder() const {
   return configFolder;
 }
@@ -228,6 +318,38 @@ void NetNodeConfig::setHideMyPort(bool hide) {
   hideMyPort = hide;
 }
 
+void NetNodeConfig::setRelayBlocksEarly(bool relayEarly) {
+  relayBlocksEarly = relayEarly;
+}
+
+void NetNodeConfig::setMaxIncomingConnections(uint32_t count) {
+  maxIncomingConnections = count;
+}
+
+void NetNodeConfig::setSendBufferSize(size_t size) {
+  sendBufferSize = size;
+}
+
+void NetNodeConfig::setUploadLimit(uint64_t limit) {
+  uploadLimit = limit;
+}
+
+void NetNodeConfig::setDownloadLimit(uint64_t limit) {
+  downloadLimit = limit;
+}
+
+void NetNodeConfig::setPeerUploadLimit(uint64_t limit) {
+  peerUploadLimit = limit;
+}
+
+void NetNodeConfig::setPeerDownloadLimit(uint64_t limit) {
+  peerDownloadLimit = limit;
+}
+
+void NetNodeConfig::setContextStackSize(size_t size) {
+  contextStackSize = size;
+}
+
 void NetNodeConfig::setConfigFolder(const std::string& folder) {
   configFolder = folder;
 }
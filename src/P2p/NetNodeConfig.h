@@ -33,6 +33,15 @@ public:
   std::vector<NetworkAddress> getExclusiveNodes() const;
   std::vector<NetworkAddress> getSeedNodes() const;
   bool getHideMyPort() const;
+  bool getRelayBlocksEarly() const;
+  uint32_t getMaxIncomingConnections() const;
+  size_t getSendBufferSize() const;
+  // bytes per second, 0 is unlimited
+  uint64_t getUploadLimit() const;
+  uint64_t getDownloadLimit() const;
+  uint64_t getPeerUploadLimit() const;
+  uint64_t getPeerDownloadLimit() const;
+  size_t getContextStackSize() const;
   std::string getConfigFolder() const;
 
   void setP2pStateFilename(const std::string& filename);
@@ -46,6 +55,14 @@ public:
   void setExclusiveNodes(const std::vector<NetworkAddress>& addresses);
   void setSeedNodes(const std::vector<NetworkAddress>& addresses);
   void setHideMyPort(bool hide);
+  void setRelayBlocksEarly(bool relayEarly);
+  void setMaxIncomingConnections(uint32_t count);
+  void setSendBufferSize(size_t size);
+  void setUploadLimit(uint64_t limit);
+  void setDownloadLimit(uint64_t limit);
+  void setPeerUploadLimit(uint64_t limit);
+  void setPeerDownloadLimit(uint64_t limit);
+  void setContextStackSize(size_t size);
   void setConfigFolder(const std::string& folder);
 
 private:
@@ -58,6 +75,14 @@ private:
   std::vector<NetworkAddress> exclusiveNodes;
   std::vector<NetworkAddress> seedNodes;
   bool hideMyPort;
+  bool relayBlocksEarly;
+  uint32_t maxIncomingConnections;
+  size_t sendBufferSize;
+  uint64_t uploadLimit;
+  uint64_t downloadLimit;
+  uint64_t peerUploadLimit;
+  uint64_t peerDownloadLimit;
+  size_t contextStackSize;
   std::string configFolder;
   std::string p2pStateFilename;
   bool testnet;
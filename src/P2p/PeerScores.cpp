@@ -0,0 +1,142 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2014-2017 XDN developers
+// Copyright (c) 2016-2017 BXC developers
+// Copyright (c) 2017 Doppler developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "PeerScores.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Serialization/ISerializer.h"
+#include "Serialization/SerializationOverloads.h"
+
+namespace CryptoNote {
+
+namespace {
+
+// measurements a peer without them is assumed to have, they score 1
+const uint64_t DEFAULT_CONNECT_RTT = 500;           // milliseconds
+const uint64_t DEFAULT_DOWNLOAD_RATE = 64 * 1024;   // bytes per second
+const uint64_t FULL_UPTIME = 24 * 60 * 60;          // seconds, doubles the score
+
+struct PeerScoreEntry {
+  NetworkAddress address;
+  PeerScore score;
+};
+
+void serialize(PeerScoreEntry& entry, ISerializer& s) {
+  s(entry.address.ip, "ip");
+  s(entry.address.port, "port");
+  s(entry.score.connectRtt, "connect_rtt");
+  s(entry.score.downloadRate, "download_rate");
+  s(entry.score.invalidData, "invalid_data");
+  s(entry.score.uptime, "uptime");
+  s(entry.score.lastUpdate, "last_update");
+}
+
+uint64_t average(uint64_t current, uint64_t sample) {
+  return current == 0 ? sample : (current * 3 + sample) / 4;
+}
+
+}
+
+PeerScores::PeerScores(size_t maxSize) : m_maxSize(maxSize) {
+}
+
+void PeerScores::addConnectRtt(const NetworkAddress& peer, std::chrono::milliseconds rtt, uint64_t now) {
+  PeerScore& score = update(peer, now);
+  score.connectRtt = average(score.connectRtt, std::max<uint64_t>(rtt.count(), 1));
+}
+
+void PeerScores::addDownload(const NetworkAddress& peer, uint64_t bytes, std::chrono::milliseconds duration, uint64_t now) {
+  PeerScore& score = update(peer, now);
+  score.downloadRate = average(score.downloadRate, std::max<uint64_t>(bytes * 1000 / std::max<uint64_t>(duration.count(), 1), 1));
+}
+
+void PeerScores::addInvalidData(const NetworkAddress& peer, uint64_t now) {
+  ++update(peer, now).invalidData;
+}
+
+void PeerScores::addUptime(const NetworkAddress& peer, uint64_t seconds, uint64_t now) {
+  update(peer, now).uptime += seconds;
+}
+
+bool PeerScores::get(const NetworkAddress& peer, PeerScore& score) const {
+  auto it = m_scores.find(peer);
+  if (it == m_scores.end()) {
+    return false;
+  }
+
+  score = it->second;
+  return true;
+}
+
+double PeerScores::score(const NetworkAddress& peer) const {
+  auto it = m_scores.find(peer);
+  return it == m_scores.end() ? 1.0 : score(it->second);
+}
+
+std::vector<std::pair<NetworkAddress, PeerScore>> PeerScores::getAll() const {
+  std::vector<std::pair<NetworkAddress, PeerScore>> scores(m_scores.begin(), m_scores.end());
+  std::stable_sort(scores.begin(), scores.end(), [this](const std::pair<NetworkAddress, PeerScore>& a, const std::pair<NetworkAddress, PeerScore>& b) {
+    return score(a.second) > score(b.second);
+  });
+
+  return scores;
+}
+
+void PeerScores::serialize(ISerializer& s) {
+  std::vector<PeerScoreEntry> entries;
+  if (s.type() == ISerializer::OUTPUT) {
+    entries.reserve(m_scores.size());
+    for (const auto& score : m_scores) {
+      entries.push_back({ score.first, score.second });
+    }
+  }
+
+  s(entries, "scores");
+
+  if (s.type() == ISerializer::INPUT) {
+    m_scores.clear();
+    for (const auto& entry : entries) {
+      m_scores[entry.address] = entry.score;
+    }
+  }
+}
+
+PeerScore& PeerScores::update(const NetworkAddress& peer, uint64_t now) {
+  auto result = m_scores.emplace(peer, PeerScore());
+  result.first->second.lastUpdate = now;
+
+  if (result.second && m_scores.size() > m_maxSize) {
+    // the peer not heard of for the longest time is forgotten
+    auto oldest = m_scores.end();
+    for (auto it = m_scores.begin(); it != m_scores.end(); ++it) {
+      if (it != result.first && (oldest == m_scores.end() || it->second.lastUpdate < oldest->second.lastUpdate)) {
+        oldest = it;
+      }
+    }
+
+    m_scores.erase(oldest);
+  }
+
+  return result.first->second;
+}
+
+double PeerScores::score(const PeerScore& score) const {
+  uint64_t rtt = score.connectRtt != 0 ? score.connectRtt : DEFAULT_CONNECT_RTT;
+  uint64_t rate = score.downloadRate != 0 ? score.downloadRate : DEFAULT_DOWNLOAD_RATE;
+
+  double latency = static_cast<double>(1000 + DEFAULT_CONNECT_RTT) / (1000 + rtt);
+  // square root and bounds keep a slow peer worth trying again and a fast one from taking every connection
+  double download = std::sqrt(std::min(std::max(static_cast<double>(rate) / DEFAULT_DOWNLOAD_RATE, 1.0 / 16), 16.0));
+  double stability = 1.0 + static_cast<double>(std::min(score.uptime, FULL_UPTIME)) / FULL_UPTIME;
+  double penalty = 1.0 + score.invalidData;
+
+  return latency * download * stability / (penalty * penalty);
+}
+
+}
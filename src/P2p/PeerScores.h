@@ -0,0 +1,56 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2014-2017 XDN developers
+// Copyright (c) 2016-2017 BXC developers
+// Copyright (c) 2017 Doppler developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <chrono>
+#include <map>
+#include <vector>
+
+#include "P2pProtocolTypes.h"
+
+namespace CryptoNote {
+
+class ISerializer;
+
+struct PeerScore {
+  uint64_t connectRtt = 0;    // milliseconds, moving average, 0 until measured
+  uint64_t downloadRate = 0;  // bytes per second of block responses, moving average, 0 until measured
+  uint32_t invalidData = 0;   // blocks and transactions that failed validation
+  uint64_t uptime = 0;        // seconds connected in total
+  uint64_t lastUpdate = 0;    // unix time
+};
+
+// Measurements of the peers the node was connected to, by their listening address. They survive restarts,
+// so connections and block downloads go to the peers that served well before. A peer never measured
+// scores 1, faster and longer connected peers score more and every invalid block or transaction cuts
+// the score down.
+class PeerScores {
+public:
+  explicit PeerScores(size_t maxSize);
+
+  void addConnectRtt(const NetworkAddress& peer, std::chrono::milliseconds rtt, uint64_t now);
+  void addDownload(const NetworkAddress& peer, uint64_t bytes, std::chrono::milliseconds duration, uint64_t now);
+  void addInvalidData(const NetworkAddress& peer, uint64_t now);
+  void addUptime(const NetworkAddress& peer, uint64_t seconds, uint64_t now);
+
+  bool get(const NetworkAddress& peer, PeerScore& score) const;
+  double score(const NetworkAddress& peer) const;
+  // best scored first
+  std::vector<std::pair<NetworkAddress, PeerScore>> getAll() const;
+
+  void serialize(ISerializer& s);
+
+private:
+  PeerScore& update(const NetworkAddress& peer, uint64_t now);
+  double score(const PeerScore& score) const;
+
+  const size_t m_maxSize;
+  std::map<NetworkAddress, PeerScore> m_scores;
+};
+
+}
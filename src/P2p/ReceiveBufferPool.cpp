@@ -0,0 +1,53 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2014-2017 XDN developers
+// Copyright (c) 2016-2017 BXC developers
+// Copyright (c) 2017 Doppler developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "ReceiveBufferPool.h"
+
+namespace CryptoNote {
+
+ReceiveBufferPool::ReceiveBufferPool(size_t maxSize) : m_maxSize(maxSize), m_size(0) {
+}
+
+BinaryArray ReceiveBufferPool::take(size_t size) {
+  auto best = m_buffers.end();
+  for (auto it = m_buffers.begin(); it != m_buffers.end(); ++it) {
+    if (it->capacity() >= size && (best == m_buffers.end() || it->capacity() < best->capacity())) {
+      best = it;
+    }
+  }
+
+  BinaryArray buffer;
+  if (best != m_buffers.end()) {
+    buffer = std::move(*best);
+    m_buffers.erase(best);
+    m_size -= buffer.capacity();
+  } else {
+    buffer.reserve(size);
+  }
+
+  return buffer;
+}
+
+void ReceiveBufferPool::put(BinaryArray&& buffer) {
+  if (m_size + buffer.capacity() > m_maxSize) {
+    return;
+  }
+
+  m_size += buffer.capacity();
+  m_buffers.push_back(std::move(buffer));
+  m_buffers.back().clear();
+}
+
+size_t ReceiveBufferPool::size() const {
+  return m_size;
+}
+
+size_t ReceiveBufferPool::count() const {
+  return m_buffers.size();
+}
+
+}
@@ -0,0 +1,38 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2014-2017 XDN developers
+// Copyright (c) 2016-2017 BXC developers
+// Copyright (c) 2017 Doppler developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "CryptoNoteConfig.h"
+#include "CryptoNote.h"
+
+namespace CryptoNote {
+
+// Buffers of large messages shared by all connections, so a message of a size seen before is read without allocating.
+// Only the capacity is kept, the contents of a taken buffer are unspecified.
+class ReceiveBufferPool {
+public:
+  // total capacity the pool keeps
+  explicit ReceiveBufferPool(size_t maxSize = P2P_RECEIVE_BUFFER_POOL_SIZE);
+
+  // the smallest kept buffer with room for size bytes, a new one if none has it
+  BinaryArray take(size_t size);
+  void put(BinaryArray&& buffer);
+
+  size_t size() const;
+  size_t count() const;
+
+private:
+  std::vector<BinaryArray> m_buffers;
+  size_t m_maxSize;
+  size_t m_size;
+};
+
+}
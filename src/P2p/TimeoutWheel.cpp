@@ -0,0 +1,74 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2014-2017 XDN developers
+// Copyright (c) 2016-2017 BXC developers
+// Copyright (c) 2017 Doppler developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "TimeoutWheel.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace CryptoNote {
+
+TimeoutWheel::TimeoutWheel(Clock::duration resolution, size_t slots, Clock::time_point start) :
+  m_resolution(resolution),
+  m_start(start),
+  m_slots(std::max<size_t>(slots, 1)),
+  m_nextTick(0) {
+  assert(resolution.count() > 0);
+}
+
+void TimeoutWheel::set(const ConnectionId& connection, Clock::time_point deadline) {
+  cancel(connection);
+
+  // the deadline is rounded up to a tick, a passed one goes to the tick checked next
+  uint64_t deadlineTick = deadline > m_start ? (deadline - m_start + m_resolution - Clock::duration(1)) / m_resolution : 0;
+  size_t slot = static_cast<size_t>(std::max(deadlineTick, m_nextTick) % m_slots.size());
+  m_slots[slot].push_back({ connection, deadline });
+  m_positions[connection] = { slot, std::prev(m_slots[slot].end()) };
+}
+
+void TimeoutWheel::cancel(const ConnectionId& connection) {
+  auto it = m_positions.find(connection);
+  if (it != m_positions.end()) {
+    m_slots[it->second.slot].erase(it->second.entry);
+    m_positions.erase(it);
+  }
+}
+
+size_t TimeoutWheel::size() const {
+  return m_positions.size();
+}
+
+void TimeoutWheel::expire(Clock::time_point now, std::vector<ConnectionId>& expired) {
+  uint64_t nowTick = tick(now);
+  if (nowTick < m_nextTick) {
+    return;
+  }
+
+  // a full round visits every slot, a longer pause doesn't need more
+  uint64_t ticks = std::min<uint64_t>(nowTick - m_nextTick + 1, m_slots.size());
+  for (uint64_t i = 0; i < ticks; ++i) {
+    size_t slot = static_cast<size_t>((m_nextTick + i) % m_slots.size());
+    Slot& entries = m_slots[slot];
+    for (auto it = entries.begin(); it != entries.end();) {
+      if (it->deadline <= now) {
+        expired.push_back(it->connection);
+        m_positions.erase(it->connection);
+        it = entries.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+
+  m_nextTick = nowTick + 1;
+}
+
+uint64_t TimeoutWheel::tick(Clock::time_point time) const {
+  return time > m_start ? (time - m_start) / m_resolution : 0;
+}
+
+}
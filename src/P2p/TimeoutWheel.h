@@ -0,0 +1,60 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2014-2017 XDN developers
+// Copyright (c) 2016-2017 BXC developers
+// Copyright (c) 2017 Doppler developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <chrono>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/functional/hash.hpp>
+#include <boost/uuid/uuid.hpp>
+
+namespace CryptoNote {
+
+// Deadlines of connections hashed into a ring of slots by their tick, so setting and cancelling one is O(1)
+// and expire() looks only at the slots of the ticks passed since its previous call. A deadline further away
+// than the ring spans stays in its slot for the following rounds. Every connection has one deadline at most.
+class TimeoutWheel {
+public:
+  typedef std::chrono::steady_clock Clock;
+  typedef boost::uuids::uuid ConnectionId;
+
+  TimeoutWheel(Clock::duration resolution, size_t slots, Clock::time_point start);
+
+  // replaces the previous deadline of the connection
+  void set(const ConnectionId& connection, Clock::time_point deadline);
+  void cancel(const ConnectionId& connection);
+  size_t size() const;
+
+  // connections whose deadline has passed, they are removed from the wheel
+  void expire(Clock::time_point now, std::vector<ConnectionId>& expired);
+
+private:
+  struct Entry {
+    ConnectionId connection;
+    Clock::time_point deadline;
+  };
+
+  typedef std::list<Entry> Slot;
+
+  struct Position {
+    size_t slot;
+    Slot::iterator entry;
+  };
+
+  uint64_t tick(Clock::time_point time) const;
+
+  const Clock::duration m_resolution;
+  const Clock::time_point m_start;
+  std::vector<Slot> m_slots;
+  std::unordered_map<ConnectionId, Position, boost::hash<ConnectionId>> m_positions;
+  uint64_t m_nextTick;
+};
+
+}
@@ -0,0 +1,61 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2014-2017 XDN developers
+// Copyright (c) 2016-2017 BXC developers
+// Copyright (c) 2017 Doppler developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "TokenBucket.h"
+
+#include <algorithm>
+
+namespace CryptoNote {
+
+TokenBucket::TokenBucket(uint64_t rate) : m_rate(rate), m_tokens(static_cast<double>(rate)) {
+}
+
+uint64_t TokenBucket::rate() const {
+  return m_rate;
+}
+
+void TokenBucket::setRate(uint64_t rate) {
+  m_rate = rate;
+  m_tokens = static_cast<double>(rate);
+  m_lastRefill = Clock::time_point();
+}
+
+void TokenBucket::consume(Clock::time_point now, uint64_t bytes) {
+  if (m_rate == 0) {
+    return;
+  }
+
+  refill(now);
+  m_tokens -= static_cast<double>(bytes);
+}
+
+TokenBucket::Clock::duration TokenBucket::delay(Clock::time_point now) {
+  if (m_rate == 0) {
+    return Clock::duration::zero();
+  }
+
+  // a debt below one byte is rounding of the refills
+  refill(now);
+  if (m_tokens > -1) {
+    return Clock::duration::zero();
+  }
+
+  return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(-m_tokens / m_rate)) + Clock::duration(1);
+}
+
+void TokenBucket::refill(Clock::time_point now) {
+  if (m_lastRefill != Clock::time_point() && now > m_lastRefill) {
+    double elapsed = std::chrono::duration<double>(now - m_lastRefill).count();
+    m_tokens = std::min(m_tokens + elapsed * m_rate, static_cast<double>(m_rate));
+  }
+
+  if (now > m_lastRefill) {
+    m_lastRefill = now;
+  }
+}
+
+}
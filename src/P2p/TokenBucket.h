@@ -0,0 +1,39 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2014-2017 XDN developers
+// Copyright (c) 2016-2017 BXC developers
+// Copyright (c) 2017 Doppler developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+namespace CryptoNote {
+
+// Byte rate limit holding up to one second of traffic. Bytes are taken even when there are not enough tokens,
+// the debt then delays the transfers that may wait, so traffic that must not wait still counts against the limit.
+class TokenBucket {
+public:
+  typedef std::chrono::steady_clock Clock;
+
+  // bytes per second, 0 is unlimited
+  explicit TokenBucket(uint64_t rate = 0);
+
+  uint64_t rate() const;
+  void setRate(uint64_t rate);
+
+  void consume(Clock::time_point now, uint64_t bytes);
+  // time until the debt is paid off
+  Clock::duration delay(Clock::time_point now);
+
+private:
+  void refill(Clock::time_point now);
+
+  uint64_t m_rate;
+  double m_tokens;
+  Clock::time_point m_lastRefill;
+};
+
+}
@@ -42,7 +42,7 @@ PaymentServiceJsonRpcServer::PaymentServiceJsonRpcServer(System::Dispatcher& sys
   handlers.emplace("getAddresses", jsonHandler<GetAddresses::Request, GetAddresses::Response>(std::bind(&PaymentServiceJsonRpcServer::handleGetAddresses, this, std::placeholders::_1, std::placeholders::_2)));
 }
 
-void PaymentServiceJsonRpcServer::processJsonRpcRequest(const Common::JsonValue& req, Common::JsonValue& resp) {
+void PaymentServiceJsonRpcServer::processJsonRpcRequest(const Common::JsonValue& req, Common::JsonValue& resp, std::string& result) {
   try {
     prepareJsonResponse(req, resp);
 
@@ -74,9 +74,10 @@ void PaymentServiceJsonRpcServer::processJsonRpcRequest(const Common::JsonValue&
       params = req("params");
     }
 
-    it->second(params, resp);
+    it->second(params, resp, result);
   } catch (std::exception& e) {
     logger(Logging::WARNING) << "Error occurred while processing JsonRpc request: " << e.what();
+    result.clear();
     makeGenericErrorReponse(resp, e.what());
   }
 }
@@ -13,7 +13,7 @@
 #include "JsonRpcServer/JsonRpcServer.h"
 #include "PaymentServiceJsonRpcMessages.h"
 #include "Serialization/JsonInputValueSerializer.h"
-#include "Serialization/JsonOutputStreamSerializer.h"
+#include "Serialization/JsonOutputBufferSerializer.h"
 
 namespace PaymentService {
 
@@ -25,17 +25,17 @@ public:
   PaymentServiceJsonRpcServer(const PaymentServiceJsonRpcServer&) = delete;
 
 protected:
-  virtual void processJsonRpcRequest(const Common::JsonValue& req, Common::JsonValue& resp) override;
+  virtual void processJsonRpcRequest(const Common::JsonValue& req, Common::JsonValue& resp, std::string& result) override;
 
 private:
   WalletService& service;
   Logging::LoggerRef logger;
 
-  typedef std::function<void (const Common::JsonValue& jsonRpcParams, Common::JsonValue& jsonResponse)> HandlerFunction;
+  typedef std::function<void (const Common::JsonValue& jsonRpcParams, Common::JsonValue& jsonResponse, std::string& result)> HandlerFunction;
 
   template <typename RequestType, typename ResponseType, typename RequestHandler>
   HandlerFunction jsonHandler(RequestHandler handler) {
-    return [handler] (const Common::JsonValue& jsonRpcParams, Common::JsonValue& jsonResponse) mutable {
+    return [handler] (const Common::JsonValue& jsonRpcParams, Common::JsonValue& jsonResponse, std::string& result) mutable {
       RequestType request;
       ResponseType response;
 
@@ -53,9 +53,9 @@ private:
         return;
       }
 
-      CryptoNote::JsonOutputStreamSerializer outputSerializer;
+      CryptoNote::JsonOutputBufferSerializer outputSerializer(result);
       serialize(response, outputSerializer);
-      fillJsonResponse(outputSerializer.getValue(), jsonResponse);
+      outputSerializer.finish();
     };
   }
 
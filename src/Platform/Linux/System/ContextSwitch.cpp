@@ -0,0 +1,184 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2014-2017 XDN developers
+// Copyright (c) 2016-2017 BXC developers
+// Copyright (c) 2017 Doppler developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "ContextSwitch.h"
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include "ErrorMessage.h"
+
+#if defined(__x86_64__)
+
+// The frame of a suspended coroutine, from its stack pointer up: MXCSR and x87 control word, r15, r14, r13, r12,
+// rbx, rbp and the address to resume at. A new coroutine resumes at the start routine with the procedure in r12
+// and its argument in r13.
+__asm__(
+  ".text\n"
+  ".globl system_switch_machine_context\n"
+  ".hidden system_switch_machine_context\n"
+  ".type system_switch_machine_context, @function\n"
+  ".align 16\n"
+  "system_switch_machine_context:\n"
+  "  pushq %rbp\n"
+  "  pushq %rbx\n"
+  "  pushq %r12\n"
+  "  pushq %r13\n"
+  "  pushq %r14\n"
+  "  pushq %r15\n"
+  "  subq $8, %rsp\n"
+  "  stmxcsr (%rsp)\n"
+  "  fnstcw 4(%rsp)\n"
+  "  movq %rsp, (%rdi)\n"
+  "  movq %rsi, %rsp\n"
+  "  ldmxcsr (%rsp)\n"
+  "  fldcw 4(%rsp)\n"
+  "  addq $8, %rsp\n"
+  "  popq %r15\n"
+  "  popq %r14\n"
+  "  popq %r13\n"
+  "  popq %r12\n"
+  "  popq %rbx\n"
+  "  popq %rbp\n"
+  "  ret\n"
+  ".size system_switch_machine_context, .-system_switch_machine_context\n"
+  ".globl system_start_machine_context\n"
+  ".hidden system_start_machine_context\n"
+  ".type system_start_machine_context, @function\n"
+  ".align 16\n"
+  "system_start_machine_context:\n"
+  "  movq %r13, %rdi\n"
+  "  callq *%r12\n"
+  "  ud2\n"
+  ".size system_start_machine_context, .-system_start_machine_context\n"
+);
+
+#elif defined(__aarch64__)
+
+// The frame of a suspended coroutine, from its stack pointer up: x19 to x28, x29, x30 and d8 to d15. A new
+// coroutine returns through x30 to the start routine with the procedure in x19 and its argument in x20.
+__asm__(
+  ".text\n"
+  ".globl system_switch_machine_context\n"
+  ".hidden system_switch_machine_context\n"
+  ".type system_switch_machine_context, %function\n"
+  ".align 4\n"
+  "system_switch_machine_context:\n"
+  "  sub sp, sp, #160\n"
+  "  stp x19, x20, [sp, #0]\n"
+  "  stp x21, x22, [sp, #16]\n"
+  "  stp x23, x24, [sp, #32]\n"
+  "  stp x25, x26, [sp, #48]\n"
+  "  stp x27, x28, [sp, #64]\n"
+  "  stp x29, x30, [sp, #80]\n"
+  "  stp d8, d9, [sp, #96]\n"
+  "  stp d10, d11, [sp, #112]\n"
+  "  stp d12, d13, [sp, #128]\n"
+  "  stp d14, d15, [sp, #144]\n"
+  "  mov x2, sp\n"
+  "  str x2, [x0]\n"
+  "  mov sp, x1\n"
+  "  ldp x19, x20, [sp, #0]\n"
+  "  ldp x21, x22, [sp, #16]\n"
+  "  ldp x23, x24, [sp, #32]\n"
+  "  ldp x25, x26, [sp, #48]\n"
+  "  ldp x27, x28, [sp, #64]\n"
+  "  ldp x29, x30, [sp, #80]\n"
+  "  ldp d8, d9, [sp, #96]\n"
+  "  ldp d10, d11, [sp, #112]\n"
+  "  ldp d12, d13, [sp, #128]\n"
+  "  ldp d14, d15, [sp, #144]\n"
+  "  add sp, sp, #160\n"
+  "  ret\n"
+  ".size system_switch_machine_context, .-system_switch_machine_context\n"
+  ".globl system_start_machine_context\n"
+  ".hidden system_start_machine_context\n"
+  ".type system_start_machine_context, %function\n"
+  ".align 4\n"
+  "system_start_machine_context:\n"
+  "  mov x0, x20\n"
+  "  blr x19\n"
+  "  brk #0\n"
+  ".size system_start_machine_context, .-system_start_machine_context\n"
+);
+
+#endif
+
+#if defined(__x86_64__) || defined(__aarch64__)
+
+extern "C" {
+void system_switch_machine_context(void** from, void* to);
+void system_start_machine_context();
+}
+
+namespace System {
+
+namespace {
+
+#if defined(__x86_64__)
+const size_t FRAME_SIZE = 8 * 8;
+const size_t PROCEDURE_SLOT = 4;
+const size_t ARGUMENT_SLOT = 3;
+const size_t RESUME_SLOT = 7;
+#else
+const size_t FRAME_SIZE = 20 * 8;
+const size_t PROCEDURE_SLOT = 0;
+const size_t ARGUMENT_SLOT = 1;
+const size_t RESUME_SLOT = 11;
+#endif
+
+}
+
+void makeMachineContext(MachineContext& context, void* stack, size_t stackSize, void (*procedure)(void*), void* argument) {
+  // the start routine runs with the stack aligned as after a call, 16 bytes below the top are left unused
+  uintptr_t top = (reinterpret_cast<uintptr_t>(stack) + stackSize) & ~static_cast<uintptr_t>(15);
+  uint64_t* frame = reinterpret_cast<uint64_t*>(top - 16 - FRAME_SIZE);
+  memset(frame, 0, FRAME_SIZE);
+
+#if defined(__x86_64__)
+  // default MXCSR and x87 control word
+  frame[0] = 0x1F80 | (static_cast<uint64_t>(0x037F) << 32);
+#endif
+
+  frame[PROCEDURE_SLOT] = reinterpret_cast<uintptr_t>(procedure);
+  frame[ARGUMENT_SLOT] = reinterpret_cast<uintptr_t>(argument);
+  frame[RESUME_SLOT] = reinterpret_cast<uintptr_t>(&system_start_machine_context);
+  context.stackPointer = frame;
+}
+
+void switchMachineContext(MachineContext& from, MachineContext& to) {
+  system_switch_machine_context(&from.stackPointer, to.stackPointer);
+}
+
+}
+
+#else
+
+namespace System {
+
+void makeMachineContext(MachineContext& context, void* stack, size_t stackSize, void (*procedure)(void*), void* argument) {
+  if (getcontext(&context.ucontext) == -1) { //makecontext precondition
+    throw std::runtime_error("makeMachineContext, getcontext failed, " + lastErrorMessage());
+  }
+
+  context.ucontext.uc_stack.ss_sp = stack;
+  context.ucontext.uc_stack.ss_size = stackSize;
+  context.ucontext.uc_link = nullptr;
+  makecontext(&context.ucontext, (void(*)())procedure, 1, reinterpret_cast<int*>(argument));
+}
+
+void switchMachineContext(MachineContext& from, MachineContext& to) {
+  if (swapcontext(&from.ucontext, &to.ucontext) == -1) {
+    throw std::runtime_error("switchMachineContext, swapcontext failed, " + lastErrorMessage());
+  }
+}
+
+}
+
+#endif
@@ -0,0 +1,34 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2014-2017 XDN developers
+// Copyright (c) 2016-2017 BXC developers
+// Copyright (c) 2017 Doppler developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <cstddef>
+
+#if !defined(__x86_64__) && !defined(__aarch64__)
+#include <ucontext.h>
+#endif
+
+namespace System {
+
+// Registers of a suspended coroutine. On x86-64 and aarch64 the callee-saved registers are pushed on the coroutine
+// stack and only the stack pointer is kept, so a switch is a few instructions without the signal mask syscall
+// of swapcontext. Other targets fall back to ucontext.
+struct MachineContext {
+#if defined(__x86_64__) || defined(__aarch64__)
+  void* stackPointer;
+#else
+  ucontext_t ucontext;
+#endif
+};
+
+// prepares context to call procedure(argument) on the stack when switched to, procedure must never return
+void makeMachineContext(MachineContext& context, void* stack, size_t stackSize, void (*procedure)(void*), void* argument);
+// saves the running coroutine to from and resumes to
+void switchMachineContext(MachineContext& from, MachineContext& to);
+
+}
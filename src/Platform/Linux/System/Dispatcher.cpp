@@ -6,16 +6,24 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include "Dispatcher.h"
+#include <algorithm>
 #include <cassert>
+#include <climits>
+#include <memory>
 
+#include <linux/io_uring.h>
+#include <poll.h>
 #include <sys/epoll.h>
 #include <sys/eventfd.h>
-#include <sys/timerfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
 #include <fcntl.h>
 #include <string.h>
-#include <ucontext.h>
 #include <unistd.h>
+#include "ContextSwitch.h"
 #include "ErrorMessage.h"
+#include <System/InterruptedException.h>
+#include <System/ThreadPool.h>
 
 namespace System {
 
@@ -23,7 +31,7 @@ namespace {
 
 struct ContextMakingData {
   Dispatcher* dispatcher;
-  void* ucontext;
+  MachineContext* machineContext;
 };
 
 class MutextGuard {
@@ -46,53 +54,98 @@ private:
 static_assert(Dispatcher::SIZEOF_PTHREAD_MUTEX_T == sizeof(pthread_mutex_t), "invalid pthread mutex size");
 
 const size_t STACK_SIZE = 64 * 1024;
+// idle stacks beyond this are unmapped at the next wait, a stack not taken for a whole interval too
+const size_t MAX_REUSABLE_STACK_SIZE = 32 * 1024 * 1024;
+const std::chrono::seconds STACK_TRIM_INTERVAL(30);
+const int MAX_EVENTS = 256;
+const unsigned RING_ENTRIES = 256;
+// a tick of the timer wheel, counted from the start of the dispatcher
+typedef std::chrono::milliseconds TimerTick;
+
+// completions of cancellations carry no operation, the poll of the epoll file is told apart by its tag
+const uint64_t CANCEL_TAG = 0;
+const uint64_t EPOLL_TAG = 1;
+
+size_t pageSize() {
+  static const size_t size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  return size;
+}
+
+const uint8_t RING_OPERATIONS[] = { IORING_OP_RECV, IORING_OP_SEND, IORING_OP_SENDMSG, IORING_OP_ACCEPT, IORING_OP_ASYNC_CANCEL,
+  IORING_OP_POLL_ADD };
+
+struct RingOperation {
+  NativeContext* context;
+  int result;
+  bool interrupted;
+};
 
 };
 
+struct Dispatcher::Ring {
+  int fd;
+  void* rings;
+  size_t ringsSize;
+  io_uring_sqe* entries;
+  size_t entriesSize;
+  unsigned* sqHead;
+  unsigned* sqTail;
+  unsigned sqMask;
+  unsigned sqEntries;
+  unsigned* cqHead;
+  unsigned* cqTail;
+  unsigned cqMask;
+  io_uring_cqe* completions;
+  bool epollPolled;
+  size_t operationCount;
+};
+
 Dispatcher::Dispatcher() {
   std::string message;
   epoll = ::epoll_create1(0);
   if (epoll == -1) {
     message = "epoll_create1 failed, " + lastErrorMessage();
   } else {
-    mainContext.ucontext = new ucontext_t;
-    if (getcontext(reinterpret_cast<ucontext_t*>(mainContext.ucontext)) == -1) {
-      message = "getcontext failed, " + lastErrorMessage();
+    remoteSpawnEvent = eventfd(0, O_NONBLOCK);
+    if(remoteSpawnEvent == -1) {
+      message = "eventfd failed, " + lastErrorMessage();
     } else {
-      remoteSpawnEvent = eventfd(0, O_NONBLOCK);
-      if(remoteSpawnEvent == -1) {
-        message = "eventfd failed, " + lastErrorMessage();
-      } else {
-        remoteSpawnEventContext.writeContext = nullptr;
-        remoteSpawnEventContext.readContext = nullptr;
-
-        epoll_event remoteSpawnEventEpollEvent;
-        remoteSpawnEventEpollEvent.events = EPOLLIN;
-        remoteSpawnEventEpollEvent.data.ptr = &remoteSpawnEventContext;
+      remoteSpawnEventContext.writeContext = nullptr;
+      remoteSpawnEventContext.readContext = nullptr;
 
-        if (epoll_ctl(epoll, EPOLL_CTL_ADD, remoteSpawnEvent, &remoteSpawnEventEpollEvent) == -1) {
-          message = "epoll_ctl failed, " + lastErrorMessage();
-        } else {
-          *reinterpret_cast<pthread_mutex_t*>(this->mutex) = pthread_mutex_t(PTHREAD_MUTEX_INITIALIZER);
-
-          mainContext.interrupted = false;
-          mainContext.group = &contextGroup;
-          mainContext.groupPrev = nullptr;
-          mainContext.groupNext = nullptr;
-          contextGroup.firstContext = nullptr;
-          contextGroup.lastContext = nullptr;
-          contextGroup.firstWaiter = nullptr;
-          contextGroup.lastWaiter = nullptr;
-          currentContext = &mainContext;
-          firstResumingContext = nullptr;
-          firstReusableContext = nullptr;
-          runningContextCount = 0;
-          return;
-        }
+      epoll_event remoteSpawnEventEpollEvent;
+      remoteSpawnEventEpollEvent.events = EPOLLIN;
+      remoteSpawnEventEpollEvent.data.ptr = &remoteSpawnEventContext;
 
-        auto result = close(remoteSpawnEvent);
-        assert(result == 0);
+      if (epoll_ctl(epoll, EPOLL_CTL_ADD, remoteSpawnEvent, &remoteSpawnEventEpollEvent) == -1) {
+        message = "epoll_ctl failed, " + lastErrorMessage();
+      } else {
+        *reinterpret_cast<pthread_mutex_t*>(this->mutex) = pthread_mutex_t(PTHREAD_MUTEX_INITIALIZER);
+
+        mainContext.interrupted = false;
+        mainContext.group = &contextGroup;
+        mainContext.groupPrev = nullptr;
+        mainContext.groupNext = nullptr;
+        contextGroup.firstContext = nullptr;
+        contextGroup.lastContext = nullptr;
+        contextGroup.firstWaiter = nullptr;
+        contextGroup.lastWaiter = nullptr;
+        mainContext.machineContext = new MachineContext;
+        currentContext = &mainContext;
+        firstResumingContext = nullptr;
+        creatingContext = nullptr;
+        reusableStackSize = 0;
+        lastStackTrim = std::chrono::steady_clock::now();
+        timerStart = lastStackTrim;
+        runningContextCount = 0;
+        threadPool = nullptr;
+        events = new epoll_event[MAX_EVENTS];
+        ring = createRing();
+        return;
       }
+
+      auto result = close(remoteSpawnEvent);
+      assert(result == 0);
     }
 
     auto result = close(epoll);
@@ -108,22 +161,20 @@ Dispatcher::~Dispatcher() {
   }
 
   yield();
+  // cancelled ring operations may complete later than the interrupts
+  while (ring != nullptr && ring->operationCount != 0) {
+    waitEvents(-1);
+    yield();
+  }
+
   assert(contextGroup.firstContext == nullptr);
   assert(contextGroup.firstWaiter == nullptr);
   assert(firstResumingContext == nullptr);
   assert(runningContextCount == 0);
-  while (firstReusableContext != nullptr) {
-    auto ucontext = static_cast<ucontext_t*>(firstReusableContext->ucontext);
-    auto stackPtr = static_cast<uint8_t *>(firstReusableContext->stackPtr);
-    firstReusableContext = firstReusableContext->next;
-    delete[] stackPtr;
-    delete ucontext;
-  }
-
-  while (!timers.empty()) {
-    int result = ::close(timers.top());
-    assert(result == 0);
-    timers.pop();
+  assert(timerWheel.empty());
+  delete threadPool;
+  for (auto& pool : stackPools) {
+    releaseReusableContexts(pool, pool.count);
   }
 
   auto result = close(epoll);
@@ -132,81 +183,29 @@ Dispatcher::~Dispatcher() {
   assert(result == 0);
   result = pthread_mutex_destroy(reinterpret_cast<pthread_mutex_t*>(this->mutex));
   assert(result == 0);
+  delete mainContext.machineContext;
+  delete[] events;
+  destroyRing();
 }
 
 void Dispatcher::clear() {
-  while (firstReusableContext != nullptr) {
-    auto ucontext = static_cast<ucontext_t*>(firstReusableContext->ucontext);
-    auto stackPtr = static_cast<uint8_t *>(firstReusableContext->stackPtr);
-    firstReusableContext = firstReusableContext->next;
-    delete[] stackPtr;
-    delete ucontext;
-  }
-
-  while (!timers.empty()) {
-    int result = ::close(timers.top());
-    if (result == -1) {
-      throw std::runtime_error("Dispatcher::clear, close failed, "  + lastErrorMessage());
-    }
-
-    timers.pop();
+  for (auto& pool : stackPools) {
+    releaseReusableContexts(pool, pool.count);
   }
 }
 
 void Dispatcher::dispatch() {
-  NativeContext* context;
-  for (;;) {
-    if (firstResumingContext != nullptr) {
-      context = firstResumingContext;
-      firstResumingContext = context->next;
-      break;
-    }
-
-    epoll_event event;
-    int count = epoll_wait(epoll, &event, 1, -1);
-    if (count == 1) {
-      ContextPair *contextPair = static_cast<ContextPair*>(event.data.ptr);
-      if(((event.events & (EPOLLIN | EPOLLOUT)) != 0) && contextPair->readContext == nullptr && contextPair->writeContext == nullptr) {
-        uint64_t buf;
-        auto transferred = read(remoteSpawnEvent, &buf, sizeof buf);
-        if(transferred == -1) {
-            throw std::runtime_error("Dispatcher::dispatch, read(remoteSpawnEvent) failed, " + lastErrorMessage());
-        }
-
-        MutextGuard guard(*reinterpret_cast<pthread_mutex_t*>(this->mutex));
-        while (!remoteSpawningProcedures.empty()) {
-          spawn(std::move(remoteSpawningProcedures.front()));
-          remoteSpawningProcedures.pop();
-        }
-
-        continue;
-      }
-
-      if ((event.events & EPOLLOUT) != 0) {
-        context = contextPair->writeContext->context;
-        contextPair->writeContext->events = event.events;
-      } else if ((event.events & EPOLLIN) != 0) {
-        context = contextPair->readContext->context;
-        contextPair->readContext->events = event.events;
-      } else {
-        continue;
-      }
-
-      assert(context != nullptr);
-      break;
-    }
-
-    if (errno != EINTR) {
-      throw std::runtime_error("Dispatcher::dispatch, epoll_wait failed, "  + lastErrorMessage());
-    }
+  while (firstResumingContext == nullptr) {
+    waitEvents(-1);
   }
 
+  NativeContext* context = firstResumingContext;
+  firstResumingContext = context->next;
+
   if (context != currentContext) {
-    ucontext_t* oldContext = static_cast<ucontext_t*>(currentContext->ucontext);
+    MachineContext* oldContext = currentContext->machineContext;
     currentContext = context;
-    if (swapcontext(oldContext, static_cast<ucontext_t *>(context->ucontext)) == -1) {
-      throw std::runtime_error("Dispatcher::dispatch, swapcontext failed, " + lastErrorMessage());
-    }
+    switchMachineContext(*oldContext, *context->machineContext);
   }
 }
 
@@ -285,130 +284,480 @@ void Dispatcher::spawn(std::function<void()>&& procedure) {
 }
 
 void Dispatcher::yield() {
-  for(;;){
-    epoll_event events[16];
-    int count = epoll_wait(epoll, events, 16, 0);
-    if (count == 0) {
+  for (;;) {
+    int count = waitEvents(0);
+    if (count >= 0 && count < MAX_EVENTS) {
       break;
     }
+  }
 
-    if(count > 0) {
-      for(int i = 0; i < count; ++i) {
-        ContextPair *contextPair = static_cast<ContextPair*>(events[i].data.ptr);
-        if(((events[i].events & (EPOLLIN | EPOLLOUT)) != 0) && contextPair->readContext == nullptr && contextPair->writeContext == nullptr) {
-          uint64_t buf;
-          auto transferred = read(remoteSpawnEvent, &buf, sizeof buf);
-          if(transferred == -1) {
-            throw std::runtime_error("Dispatcher::dispatch, read(remoteSpawnEvent) failed, " + lastErrorMessage());
-          }
+  if (firstResumingContext != nullptr) {
+    pushContext(currentContext);
+    dispatch();
+  }
+}
 
-          MutextGuard guard(*reinterpret_cast<pthread_mutex_t*>(this->mutex));
-          while (!remoteSpawningProcedures.empty()) {
-            spawn(std::move(remoteSpawningProcedures.front()));
-            remoteSpawningProcedures.pop();
-          }
+ThreadPool& Dispatcher::getThreadPool() {
+  if (threadPool == nullptr) {
+    unsigned threadCount = std::thread::hardware_concurrency();
+    threadPool = new ThreadPool(threadCount > 0 ? threadCount : 1);
+  }
 
-          continue;
-        }
+  return *threadPool;
+}
 
-        if ((events[i].events & EPOLLOUT) != 0) {
-          contextPair->writeContext->context->interruptProcedure = nullptr;
-          pushContext(contextPair->writeContext->context);
-          contextPair->writeContext->events = events[i].events;
-        } else if ((events[i].events & EPOLLIN) != 0) {
-          contextPair->readContext->context->interruptProcedure = nullptr;
-          pushContext(contextPair->readContext->context);
-          contextPair->readContext->events = events[i].events;
-        } else {
-          continue;
-        }
+// Moves every context whose operation completed or timer expired to the resuming queue. The interrupt procedures are
+// dropped as the operations are done, interrupting such a context only sets its flag. Idle stacks are trimmed before
+// blocking, which lasts until the next timer at most. Returns the number of epoll events taken.
+int Dispatcher::waitEvents(int timeout) {
+  if (timeout != 0) {
+    trimReusableContexts();
+    timeout = getTimerTimeout(timeout);
+  }
+
+  int count = ring == nullptr ? waitEpollEvents(timeout) : waitRingEvents(timeout);
+  expireTimers();
+  return count;
+}
+
+int Dispatcher::waitRingEvents(int timeout) {
+  // the ring is where the dispatcher blocks, epoll is polled through it and read only once it has events
+  if (timeout != 0 && !ring->epollPolled) {
+    io_uring_sqe* entry = getRingEntry();
+    entry->opcode = IORING_OP_POLL_ADD;
+    entry->fd = epoll;
+    entry->poll_events = POLLIN;
+    entry->user_data = EPOLL_TAG;
+    ring->epollPolled = true;
+  }
+
+  int wait = *ring->cqHead == __atomic_load_n(ring->cqTail, __ATOMIC_ACQUIRE) ? timeout : 0;
+  if ((*ring->sqTail != __atomic_load_n(ring->sqHead, __ATOMIC_ACQUIRE) || wait != 0) && !enterRing(wait)) {
+    return -1;
+  }
+
+  if (takeRingCompletions() || timeout == 0) {
+    return waitEpollEvents(0);
+  }
+
+  return 0;
+}
+
+// Milliseconds until the next timer tick, the wheel wakes up its timers no earlier than their deadlines
+int Dispatcher::getTimerTimeout(int timeout) const {
+  uint64_t tick = timerWheel.nextTick();
+  if (tick == UINT64_MAX) {
+    return timeout;
+  }
+
+  auto remaining = timerStart + TimerTick(tick) - std::chrono::steady_clock::now();
+  if (remaining <= std::chrono::steady_clock::duration::zero()) {
+    return 0;
+  }
+
+  auto milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(remaining + std::chrono::milliseconds(1) -
+    std::chrono::steady_clock::duration(1)).count();
+  if (milliseconds > INT_MAX || (timeout >= 0 && milliseconds > timeout)) {
+    return timeout < 0 ? INT_MAX : timeout;
+  }
+
+  return static_cast<int>(milliseconds);
+}
+
+void Dispatcher::expireTimers() {
+  if (timerWheel.empty()) {
+    return;
+  }
+
+  auto now = std::chrono::steady_clock::now();
+  TimerEntry* timer = timerWheel.advance(static_cast<uint64_t>(std::chrono::duration_cast<TimerTick>(now - timerStart).count()));
+  while (timer != nullptr) {
+    TimerEntry* next = timer->next;
+    timer->context->interruptProcedure = nullptr;
+    pushContext(timer->context);
+    timer = next;
+  }
+}
+
+int Dispatcher::waitEpollEvents(int timeout) {
+  int count = epoll_wait(epoll, events, MAX_EVENTS, timeout);
+  if (count == -1) {
+    if (errno != EINTR) {
+      throw std::runtime_error("Dispatcher::waitEvents, epoll_wait failed, " + lastErrorMessage());
+    }
+
+    return -1;
+  }
+
+  for (int i = 0; i < count; ++i) {
+    ContextPair *contextPair = static_cast<ContextPair*>(events[i].data.ptr);
+    if (((events[i].events & (EPOLLIN | EPOLLOUT)) != 0) && contextPair->readContext == nullptr && contextPair->writeContext == nullptr) {
+      uint64_t buf;
+      auto transferred = read(remoteSpawnEvent, &buf, sizeof buf);
+      if (transferred == -1) {
+        throw std::runtime_error("Dispatcher::waitEvents, read(remoteSpawnEvent) failed, " + lastErrorMessage());
       }
-    } else {
-      if (errno != EINTR) {
-        throw std::runtime_error("Dispatcher::dispatch, epoll_wait failed, " + lastErrorMessage());
+
+      MutextGuard guard(*reinterpret_cast<pthread_mutex_t*>(this->mutex));
+      while (!remoteSpawningProcedures.empty()) {
+        spawn(std::move(remoteSpawningProcedures.front()));
+        remoteSpawningProcedures.pop();
       }
+
+      continue;
+    }
+
+    OperationContext* operationContext;
+    if ((events[i].events & EPOLLOUT) != 0) {
+      operationContext = contextPair->writeContext;
+    } else if ((events[i].events & EPOLLIN) != 0) {
+      operationContext = contextPair->readContext;
+    } else {
+      continue;
     }
+
+    assert(operationContext->context != nullptr);
+    operationContext->events = events[i].events;
+    operationContext->context->interruptProcedure = nullptr;
+    pushContext(operationContext->context);
   }
 
-  if (firstResumingContext != nullptr) {
-    pushContext(currentContext);
-    dispatch();
+  return count;
+}
+
+bool Dispatcher::hasRing() const {
+  return ring != nullptr;
+}
+
+int Dispatcher::ringOperation(uint8_t opcode, int fd, const void* address, uint32_t length, uint64_t offset, uint32_t flags) {
+  assert(ring != nullptr);
+  RingOperation operation;
+  operation.context = currentContext;
+  operation.result = 0;
+  operation.interrupted = false;
+
+  io_uring_sqe* entry = getRingEntry();
+  entry->opcode = opcode;
+  entry->fd = fd;
+  entry->addr = reinterpret_cast<uint64_t>(address);
+  entry->len = length;
+  entry->off = offset;
+  entry->rw_flags = flags;
+  entry->user_data = reinterpret_cast<uint64_t>(&operation);
+  ++ring->operationCount;
+
+  currentContext->interruptProcedure = [&] {
+    io_uring_sqe* entry = getRingEntry();
+    entry->opcode = IORING_OP_ASYNC_CANCEL;
+    entry->fd = -1;
+    entry->addr = reinterpret_cast<uint64_t>(&operation);
+    entry->user_data = CANCEL_TAG;
+    operation.interrupted = true;
+  };
+
+  dispatch();
+  currentContext->interruptProcedure = nullptr;
+  assert(operation.context == currentContext);
+  if (operation.interrupted) {
+    if (operation.result == -ECANCELED || operation.result == -EINTR) {
+      throw InterruptedException();
+    }
+
+    // done before the cancellation reached it, the interrupt is left to the next operation
+    currentContext->interrupted = true;
   }
+
+  return operation.result;
 }
 
 int Dispatcher::getEpoll() const {
   return epoll;
 }
 
-NativeContext& Dispatcher::getReusableContext() {
-  if(firstReusableContext == nullptr) {
-    ucontext_t* newlyCreatedContext = new ucontext_t;
-    if (getcontext(newlyCreatedContext) == -1) { //makecontext precondition
-      throw std::runtime_error("Dispatcher::getReusableContext, getcontext failed, " + lastErrorMessage());
+NativeContext& Dispatcher::getReusableContext(size_t stackSize) {
+  StackPool& pool = getStackPool(stackSize);
+  if (pool.firstContext == nullptr) {
+    // stacks grow down, an overflow hits the guard page and faults instead of running into other memory
+    size_t guardSize = pageSize();
+    void* mapping = mmap(nullptr, guardSize + pool.stackSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0);
+    if (mapping == MAP_FAILED) {
+      throw std::runtime_error("Dispatcher::getReusableContext, mmap failed, " + lastErrorMessage());
     }
 
-    auto stackPointer = new uint8_t[STACK_SIZE];
-    newlyCreatedContext->uc_stack.ss_sp = stackPointer;
-    newlyCreatedContext->uc_stack.ss_size = STACK_SIZE;
-
-    ContextMakingData makingContextData {this, newlyCreatedContext};
-    makecontext(newlyCreatedContext, (void(*)())contextProcedureStatic, 1, reinterpret_cast<int*>(&makingContextData));
-
-    ucontext_t* oldContext = static_cast<ucontext_t*>(currentContext->ucontext);
-    if (swapcontext(oldContext, newlyCreatedContext) == -1) {
-      throw std::runtime_error("Dispatcher::getReusableContext, swapcontext failed, " + lastErrorMessage());
+    if (mprotect(mapping, guardSize, PROT_NONE) == -1) {
+      std::string message = "mprotect failed, " + lastErrorMessage();
+      munmap(mapping, guardSize + pool.stackSize);
+      throw std::runtime_error("Dispatcher::getReusableContext, " + message);
     }
 
-    assert(firstReusableContext != nullptr);
-    assert(firstReusableContext->ucontext == newlyCreatedContext);
-    firstReusableContext->stackPtr = stackPointer;
-  };
+    uint8_t* stackPointer = static_cast<uint8_t*>(mapping) + guardSize;
+    MachineContext* newlyCreatedContext = new MachineContext;
+    ContextMakingData makingContextData {this, newlyCreatedContext};
+    makeMachineContext(*newlyCreatedContext, stackPointer, pool.stackSize, contextProcedureStatic, &makingContextData);
+    switchMachineContext(*currentContext->machineContext, *newlyCreatedContext);
+
+    assert(creatingContext != nullptr);
+    assert(creatingContext->machineContext == newlyCreatedContext);
+    NativeContext* context = creatingContext;
+    creatingContext = nullptr;
+    context->stackPtr = stackPointer;
+    context->stackSize = pool.stackSize;
+    return *context;
+  }
 
-  NativeContext* context = firstReusableContext;
-  firstReusableContext = firstReusableContext-> next;
+  NativeContext* context = pool.firstContext;
+  pool.firstContext = context->next;
+  --pool.count;
+  pool.idleCount = std::min(pool.idleCount, pool.count);
+  reusableStackSize -= pool.stackSize;
   return *context;
 }
 
 void Dispatcher::pushReusableContext(NativeContext& context) {
-  context.next = firstReusableContext;
-  firstReusableContext = &context;
+  StackPool& pool = getStackPool(context.stackSize);
+  context.next = pool.firstContext;
+  pool.firstContext = &context;
+  ++pool.count;
+  reusableStackSize += pool.stackSize;
   --runningContextCount;
 }
 
-int Dispatcher::getTimer() {
-  int timer;
-  if (timers.empty()) {
-    timer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
-    epoll_event timerEvent;
-    timerEvent.events = 0;
-    timerEvent.data.ptr = nullptr;
+void Dispatcher::addTimer(std::chrono::steady_clock::time_point time, TimerEntry& timer) {
+  // rounded up, a timer never expires early
+  timer.deadline = 0;
+  if (time > timerStart) {
+    timer.deadline = static_cast<uint64_t>(std::chrono::duration_cast<TimerTick>(time - timerStart + TimerTick(1) -
+      std::chrono::steady_clock::duration(1)).count());
+  }
+
+  timerWheel.add(timer);
+}
+
+void Dispatcher::interruptTimer(TimerEntry& timer) {
+  timerWheel.remove(timer);
+  pushContext(timer.context);
+}
+
+Dispatcher::Ring* Dispatcher::createRing() {
+  io_uring_params params;
+  memset(&params, 0, sizeof params);
+  int fd = static_cast<int>(syscall(__NR_io_uring_setup, RING_ENTRIES, &params));
+  if (fd == -1) {
+    return nullptr;
+  }
+
+  const uint32_t features = IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP | IORING_FEAT_EXT_ARG;
+  if ((params.features & features) != features) {
+    close(fd);
+    return nullptr;
+  }
+
+  size_t probeSize = sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op);
+  std::unique_ptr<uint8_t[]> probeBuffer(new uint8_t[probeSize]());
+  io_uring_probe* probe = reinterpret_cast<io_uring_probe*>(probeBuffer.get());
+  if (syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, probe, 256) == -1) {
+    close(fd);
+    return nullptr;
+  }
+
+  for (uint8_t opcode : RING_OPERATIONS) {
+    if (opcode > probe->last_op || (probe->ops[opcode].flags & IO_URING_OP_SUPPORTED) == 0) {
+      close(fd);
+      return nullptr;
+    }
+  }
+
+  size_t ringsSize = std::max(params.sq_off.array + params.sq_entries * sizeof(unsigned),
+    params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe));
+  void* rings = mmap(nullptr, ringsSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+  if (rings == MAP_FAILED) {
+    close(fd);
+    return nullptr;
+  }
+
+  size_t entriesSize = params.sq_entries * sizeof(io_uring_sqe);
+  void* entries = mmap(nullptr, entriesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+  if (entries == MAP_FAILED) {
+    munmap(rings, ringsSize);
+    close(fd);
+    return nullptr;
+  }
+
+  uint8_t* base = static_cast<uint8_t*>(rings);
+  Ring* ring = new Ring;
+  ring->fd = fd;
+  ring->rings = rings;
+  ring->ringsSize = ringsSize;
+  ring->entries = static_cast<io_uring_sqe*>(entries);
+  ring->entriesSize = entriesSize;
+  ring->sqHead = reinterpret_cast<unsigned*>(base + params.sq_off.head);
+  ring->sqTail = reinterpret_cast<unsigned*>(base + params.sq_off.tail);
+  ring->sqMask = *reinterpret_cast<unsigned*>(base + params.sq_off.ring_mask);
+  ring->sqEntries = params.sq_entries;
+  ring->cqHead = reinterpret_cast<unsigned*>(base + params.cq_off.head);
+  ring->cqTail = reinterpret_cast<unsigned*>(base + params.cq_off.tail);
+  ring->cqMask = *reinterpret_cast<unsigned*>(base + params.cq_off.ring_mask);
+  ring->completions = reinterpret_cast<io_uring_cqe*>(base + params.cq_off.cqes);
+  ring->epollPolled = false;
+  ring->operationCount = 0;
+
+  // entry i always sits in slot i, so the array is filled once
+  unsigned* array = reinterpret_cast<unsigned*>(base + params.sq_off.array);
+  for (unsigned i = 0; i < params.sq_entries; ++i) {
+    array[i] = i;
+  }
+
+  return ring;
+}
+
+void Dispatcher::destroyRing() {
+  if (ring != nullptr) {
+    munmap(ring->entries, ring->entriesSize);
+    munmap(ring->rings, ring->ringsSize);
+    auto result = close(ring->fd);
+    assert(result == 0);
+    delete ring;
+    ring = nullptr;
+  }
+}
+
+io_uring_sqe* Dispatcher::getRingEntry() {
+  unsigned tail = *ring->sqTail;
+  while (tail - __atomic_load_n(ring->sqHead, __ATOMIC_ACQUIRE) == ring->sqEntries) {
+    if (!enterRing(0)) {
+      takeRingCompletions();
+    }
+  }
+
+  io_uring_sqe* entry = &ring->entries[tail & ring->sqMask];
+  memset(entry, 0, sizeof *entry);
+  __atomic_store_n(ring->sqTail, tail + 1, __ATOMIC_RELEASE);
+  return entry;
+}
+
+// Submits the queued entries and waits for a completion up to the timeout in milliseconds, 0 doesn't wait and -1
+// waits without a limit. False when the call was interrupted, timed out or the kernel asked to try again
+bool Dispatcher::enterRing(int timeout) {
+  unsigned count = *ring->sqTail - __atomic_load_n(ring->sqHead, __ATOMIC_ACQUIRE);
+  unsigned flags = timeout != 0 ? IORING_ENTER_GETEVENTS : 0;
+  __kernel_timespec expires;
+  io_uring_getevents_arg argument;
+  memset(&argument, 0, sizeof argument);
+  if (timeout > 0) {
+    expires.tv_sec = timeout / 1000;
+    expires.tv_nsec = (timeout % 1000) * 1000000;
+    argument.ts = reinterpret_cast<uint64_t>(&expires);
+    flags |= IORING_ENTER_EXT_ARG;
+  }
 
-    if (epoll_ctl(getEpoll(), EPOLL_CTL_ADD, timer, &timerEvent) == -1) {
-      throw std::runtime_error("Dispatcher::getTimer, epoll_ctl failed, "  + lastErrorMessage());
+  if (syscall(__NR_io_uring_enter, ring->fd, count, timeout != 0 ? 1 : 0, flags, timeout > 0 ? &argument : nullptr,
+    timeout > 0 ? sizeof argument : 0) == -1) {
+    if (errno != EINTR && errno != EAGAIN && errno != EBUSY && errno != ETIME) {
+      throw std::runtime_error("Dispatcher::enterRing, io_uring_enter failed, " + lastErrorMessage());
     }
+
+    return false;
+  }
+
+  return true;
+}
+
+// Resumes the contexts whose operations completed, true when epoll has events
+bool Dispatcher::takeRingCompletions() {
+  bool epollReady = false;
+  unsigned head = *ring->cqHead;
+  unsigned tail = __atomic_load_n(ring->cqTail, __ATOMIC_ACQUIRE);
+  for (; head != tail; ++head) {
+    const io_uring_cqe& completion = ring->completions[head & ring->cqMask];
+    if (completion.user_data == EPOLL_TAG) {
+      ring->epollPolled = false;
+      epollReady = true;
+    } else if (completion.user_data != CANCEL_TAG) {
+      RingOperation* operation = reinterpret_cast<RingOperation*>(completion.user_data);
+      operation->result = completion.res;
+      operation->context->interruptProcedure = nullptr;
+      pushContext(operation->context);
+      --ring->operationCount;
+    }
+  }
+
+  __atomic_store_n(ring->cqHead, head, __ATOMIC_RELEASE);
+  return epollReady;
+}
+
+Dispatcher::StackPool& Dispatcher::getStackPool(size_t stackSize) {
+  if (stackSize == 0) {
+    stackSize = STACK_SIZE;
   } else {
-    timer = timers.top();
-    timers.pop();
+    stackSize = (stackSize + pageSize() - 1) / pageSize() * pageSize();
+  }
+
+  for (auto& pool : stackPools) {
+    if (pool.stackSize == stackSize) {
+      return pool;
+    }
   }
 
-  return timer;
+  stackPools.push_back(StackPool{stackSize, nullptr, 0, 0});
+  return stackPools.back();
 }
 
-void Dispatcher::pushTimer(int timer) {
-  timers.push(timer);
+// Unmaps up to count stacks of the pool. A finished context waits for the next one on its own stack, that one is kept.
+size_t Dispatcher::releaseReusableContexts(StackPool& pool, size_t count) {
+  size_t released = 0;
+  NativeContext** link = &pool.firstContext;
+  while (*link != nullptr && released < count) {
+    NativeContext* context = *link;
+    if (context == currentContext) {
+      link = &context->next;
+      continue;
+    }
+
+    *link = context->next;
+    context->procedure = nullptr;
+    context->interruptProcedure = nullptr;
+    MachineContext* machineContext = context->machineContext;
+    uint8_t* mapping = static_cast<uint8_t*>(context->stackPtr) - pageSize();
+    auto result = munmap(mapping, pageSize() + pool.stackSize);
+    assert(result == 0);
+    delete machineContext;
+    ++released;
+  }
+
+  pool.count -= released;
+  pool.idleCount = std::min(pool.idleCount, pool.count);
+  reusableStackSize -= released * pool.stackSize;
+  return released;
 }
 
-void Dispatcher::contextProcedure(void* ucontext) {
-  assert(firstReusableContext == nullptr);
+void Dispatcher::trimReusableContexts() {
+  auto now = std::chrono::steady_clock::now();
+  if (now - lastStackTrim >= STACK_TRIM_INTERVAL) {
+    for (auto& pool : stackPools) {
+      releaseReusableContexts(pool, pool.idleCount);
+      pool.idleCount = pool.count;
+    }
+
+    lastStackTrim = now;
+  }
+
+  for (auto& pool : stackPools) {
+    if (reusableStackSize <= MAX_REUSABLE_STACK_SIZE) {
+      break;
+    }
+
+    releaseReusableContexts(pool, (reusableStackSize - MAX_REUSABLE_STACK_SIZE + pool.stackSize - 1) / pool.stackSize);
+  }
+}
+
+void Dispatcher::contextProcedure(MachineContext* machineContext) {
+  assert(creatingContext == nullptr);
   NativeContext context;
-  context.ucontext = ucontext;
+  context.machineContext = machineContext;
   context.interrupted = false;
   context.next = nullptr;
-  firstReusableContext = &context;
-  ucontext_t* oldContext = static_cast<ucontext_t*>(context.ucontext);
-  if (swapcontext(oldContext, static_cast<ucontext_t*>(currentContext->ucontext)) == -1) {
-    throw std::runtime_error("Dispatcher::contextProcedure, swapcontext failed, " + lastErrorMessage());
-  }
+  creatingContext = &context;
+  switchMachineContext(*context.machineContext, *currentContext->machineContext);
 
   for (;;) {
     ++runningContextCount;
@@ -459,7 +808,7 @@ void Dispatcher::contextProcedure(void* ucontext) {
 
 void Dispatcher::contextProcedureStatic(void *context) {
   ContextMakingData* makingContextData = reinterpret_cast<ContextMakingData*>(context);
-  makingContextData->dispatcher->contextProcedure(makingContextData->ucontext);
+  makingContextData->dispatcher->contextProcedure(makingContextData->machineContext);
 }
 
 }
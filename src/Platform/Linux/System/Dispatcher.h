@@ -7,18 +7,27 @@
 
 #pragma once
 
+#include <chrono>
 #include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <queue>
-#include <stack>
+#include <vector>
+#include "TimerWheel.h"
+
+struct epoll_event;
+struct io_uring_sqe;
 
 namespace System {
 
+struct MachineContext;
 struct NativeContextGroup;
+class ThreadPool;
 
 struct NativeContext {
-  void* ucontext;
+  MachineContext* machineContext;
   void* stackPtr;
+  size_t stackSize;
   bool interrupted;
   NativeContext* next;
   NativeContextGroup* group;
@@ -61,13 +70,23 @@ public:
   void pushContext(NativeContext* context);
   void remoteSpawn(std::function<void()>&& procedure);
   void yield();
+  // the pool RemoteContext runs its operations on, started with the first one
+  ThreadPool& getThreadPool();
 
   // system-dependent
   int getEpoll() const;
-  NativeContext& getReusableContext();
+  // stack size 0 is the default one, every stack has a guard page below it
+  NativeContext& getReusableContext(size_t stackSize = 0);
   void pushReusableContext(NativeContext&);
-  int getTimer();
-  void pushTimer(int timer);
+  // the timer resumes its context once the time comes, interrupting removes it and resumes the context at once
+  void addTimer(std::chrono::steady_clock::time_point time, TimerEntry& timer);
+  void interruptTimer(TimerEntry& timer);
+
+  // io_uring backend, set up when the kernel supports every operation the Tcp classes submit. An operation is
+  // submitted with the next wait for events and returns the completion result, a negated errno on failure. Interrupting
+  // the waiting context cancels the operation, InterruptedException is thrown once the cancellation completes.
+  bool hasRing() const;
+  int ringOperation(uint8_t opcode, int fd, const void* address, uint32_t length, uint64_t offset, uint32_t flags);
 
 #ifdef __x86_64__
 # if __WORDSIZE == 64
@@ -80,23 +99,53 @@ public:
 #endif
 
 private:
+  struct Ring;
+
+  // finished contexts kept for reuse, idleCount of them were not taken since the last trim
+  struct StackPool {
+    size_t stackSize;
+    NativeContext* firstContext;
+    size_t count;
+    size_t idleCount;
+  };
+
   void spawn(std::function<void()>&& procedure);
+  int waitEvents(int timeout);
+  int waitEpollEvents(int timeout);
+  int waitRingEvents(int timeout);
+  int getTimerTimeout(int timeout) const;
+  void expireTimers();
+  Ring* createRing();
+  void destroyRing();
+  io_uring_sqe* getRingEntry();
+  bool enterRing(int timeout);
+  bool takeRingCompletions();
+  StackPool& getStackPool(size_t stackSize);
+  size_t releaseReusableContexts(StackPool& pool, size_t count);
+  void trimReusableContexts();
   int epoll;
+  epoll_event* events;
+  Ring* ring;
   alignas(void*) uint8_t mutex[SIZEOF_PTHREAD_MUTEX_T];
   int remoteSpawnEvent;
   ContextPair remoteSpawnEventContext;
   std::queue<std::function<void()>> remoteSpawningProcedures;
-  std::stack<int> timers;
+  TimerWheel timerWheel;
+  std::chrono::steady_clock::time_point timerStart;
 
   NativeContext mainContext;
   NativeContextGroup contextGroup;
   NativeContext* currentContext;
   NativeContext* firstResumingContext;
   NativeContext* lastResumingContext;
-  NativeContext* firstReusableContext;
+  NativeContext* creatingContext;
+  std::vector<StackPool> stackPools;
+  size_t reusableStackSize;
+  std::chrono::steady_clock::time_point lastStackTrim;
   size_t runningContextCount;
+  ThreadPool* threadPool;
 
-  void contextProcedure(void* ucontext);
+  void contextProcedure(MachineContext* machineContext);
   static void contextProcedureStatic(void* context);
 };
 
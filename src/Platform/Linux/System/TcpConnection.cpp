@@ -7,9 +7,14 @@
 
 #include "TcpConnection.h"
 
+#include <algorithm>
 #include <arpa/inet.h>
 #include <cassert>
+#include <climits>
+#include <linux/io_uring.h>
 #include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 #include <System/ErrorMessage.h>
@@ -68,6 +73,19 @@ size_t TcpConnection::read(uint8_t* data, size_t size) {
     throw InterruptedException();
   }
 
+  // data is rarely there already, the receive is left to the ring instead of trying it first
+  if (dispatcher->hasRing()) {
+    int result = dispatcher->ringOperation(IORING_OP_RECV, connection, data, static_cast<uint32_t>(std::min<size_t>(size, UINT32_MAX)), 0, 0);
+    if (result != -EAGAIN) {
+      if (result < 0) {
+        throw std::runtime_error("TcpConnection::read, recv failed, " + errorMessage(-result));
+      }
+
+      assert(result <= static_cast<ssize_t>(size));
+      return result;
+    }
+  }
+
   std::string message;
   ssize_t transferred = ::recv(connection, (void *)data, size, 0);
   if (transferred == -1) {
@@ -156,7 +174,6 @@ std::size_t TcpConnection::write(const uint8_t* data, size_t size) {
     throw InterruptedException();
   }
 
-  std::string message;
   if(size == 0) {
     if(shutdown(connection, SHUT_WR) == -1) {
       throw std::runtime_error("TcpConnection::write, shutdown failed, " + lastErrorMessage());
@@ -165,86 +182,149 @@ std::size_t TcpConnection::write(const uint8_t* data, size_t size) {
     return 0;
   }
 
+  // the socket buffer usually has room, the ring only takes over the wait for it
   ssize_t transferred = ::send(connection, (void *)data, size, MSG_NOSIGNAL);
-  if (transferred == -1) {
-    if (errno != EAGAIN){
-      message = "send failed, " + lastErrorMessage();
-    } else {
-      epoll_event connectionEvent;
-      OperationContext operationContext;
-      operationContext.interrupted = false;
-      operationContext.context = dispatcher->getCurrentContext();
-      contextPair.writeContext = &operationContext;
-      connectionEvent.data.ptr = &contextPair;
+  if (transferred == -1 && errno == EAGAIN) {
+    if (dispatcher->hasRing()) {
+      int result = dispatcher->ringOperation(IORING_OP_SEND, connection, data, static_cast<uint32_t>(std::min<size_t>(size, UINT32_MAX)), 0, MSG_NOSIGNAL);
+      if (result != -EAGAIN) {
+        if (result < 0) {
+          throw std::runtime_error("TcpConnection::write, send failed, " + errorMessage(-result));
+        }
 
-      if(contextPair.readContext != nullptr) {
-        connectionEvent.events = EPOLLIN | EPOLLOUT | EPOLLONESHOT;
-      } else {
-        connectionEvent.events = EPOLLOUT | EPOLLONESHOT;
+        assert(result <= static_cast<ssize_t>(size));
+        return result;
       }
+    }
 
-      if (epoll_ctl(dispatcher->getEpoll(), EPOLL_CTL_MOD, connection, &connectionEvent) == -1) {
-        message = "epoll_ctl failed, " + lastErrorMessage();
-      } else {
-        dispatcher->getCurrentContext()->interruptProcedure = [&]() {
-            assert(dispatcher != nullptr);
-            assert(contextPair.writeContext != nullptr);
-            epoll_event connectionEvent;
-            connectionEvent.events = 0;
-            connectionEvent.data.ptr = nullptr;
+    waitWritable();
+    transferred = ::send(connection, (void *)data, size, MSG_NOSIGNAL);
+  }
 
-            if (epoll_ctl(dispatcher->getEpoll(), EPOLL_CTL_MOD, connection, &connectionEvent) == -1) {
-              throw std::runtime_error("TcpConnection::stop, epoll_ctl failed, " + lastErrorMessage());
-            }
+  if (transferred == -1) {
+    throw std::runtime_error("TcpConnection::write, send failed, " + lastErrorMessage());
+  }
 
-            contextPair.writeContext->interrupted = true;
-            dispatcher->pushContext(contextPair.writeContext->context);
-        };
+  assert(transferred <= static_cast<ssize_t>(size));
+  return transferred;
+}
 
-        dispatcher->dispatch();
-        dispatcher->getCurrentContext()->interruptProcedure = nullptr;
-        assert(dispatcher != nullptr);
-        assert(operationContext.context == dispatcher->getCurrentContext());
-        assert(contextPair.writeContext == &operationContext);
+std::size_t TcpConnection::write(const std::vector<std::pair<const uint8_t*, std::size_t>>& buffers) {
+  assert(dispatcher != nullptr);
+  assert(contextPair.writeContext == nullptr);
+  if (dispatcher->interrupted()) {
+    throw InterruptedException();
+  }
 
-        if (operationContext.interrupted) {
-          contextPair.writeContext = nullptr;
-          throw InterruptedException();
-        }
+  std::vector<iovec> vectors;
+  vectors.reserve(std::min<size_t>(buffers.size(), IOV_MAX));
+  size_t size = 0;
+  for (const auto& buffer : buffers) {
+    if (vectors.size() == IOV_MAX) {
+      break;
+    }
 
-        contextPair.writeContext = nullptr;
-        if(contextPair.readContext != nullptr) { //read is presented, rearm
-          epoll_event connectionEvent;
-          connectionEvent.events = EPOLLIN | EPOLLONESHOT;
-          connectionEvent.data.ptr = &contextPair;
+    if (buffer.second != 0) {
+      vectors.push_back(iovec{ const_cast<uint8_t*>(buffer.first), buffer.second });
+      size += buffer.second;
+    }
+  }
 
-          if (epoll_ctl(dispatcher->getEpoll(), EPOLL_CTL_MOD, connection, &connectionEvent) == -1) {
-            message = "epoll_ctl failed, " + lastErrorMessage();
-            throw std::runtime_error("TcpConnection::write, " + message);
-          }
-        }
+  if (size == 0) {
+    return 0;
+  }
 
-        if((operationContext.events & (EPOLLERR | EPOLLHUP)) != 0) {
-          throw std::runtime_error("TcpConnection::write, events & (EPOLLERR | EPOLLHUP) != 0");
+  msghdr message = {};
+  message.msg_iov = vectors.data();
+  message.msg_iovlen = vectors.size();
+
+  ssize_t transferred = ::sendmsg(connection, &message, MSG_NOSIGNAL);
+  if (transferred == -1 && errno == EAGAIN) {
+    if (dispatcher->hasRing()) {
+      int result = dispatcher->ringOperation(IORING_OP_SENDMSG, connection, &message, 1, 0, MSG_NOSIGNAL);
+      if (result != -EAGAIN) {
+        if (result < 0) {
+          throw std::runtime_error("TcpConnection::write, sendmsg failed, " + errorMessage(-result));
         }
 
-        ssize_t transferred = ::send(connection, (void *)data, size, 0);
-        if (transferred == -1) {
-          message = "send failed, "  + lastErrorMessage();
-        } else {
-          assert(transferred <= static_cast<ssize_t>(size));
-          return transferred;
-        }
+        assert(result <= static_cast<ssize_t>(size));
+        return result;
       }
     }
 
-    throw std::runtime_error("TcpConnection::write, " + message);
+    waitWritable();
+    transferred = ::sendmsg(connection, &message, MSG_NOSIGNAL);
+  }
+
+  if (transferred == -1) {
+    throw std::runtime_error("TcpConnection::write, sendmsg failed, " + lastErrorMessage());
   }
 
   assert(transferred <= static_cast<ssize_t>(size));
   return transferred;
 }
 
+void TcpConnection::waitWritable() {
+  epoll_event connectionEvent;
+  OperationContext operationContext;
+  operationContext.interrupted = false;
+  operationContext.context = dispatcher->getCurrentContext();
+  contextPair.writeContext = &operationContext;
+  connectionEvent.data.ptr = &contextPair;
+
+  if(contextPair.readContext != nullptr) {
+    connectionEvent.events = EPOLLIN | EPOLLOUT | EPOLLONESHOT;
+  } else {
+    connectionEvent.events = EPOLLOUT | EPOLLONESHOT;
+  }
+
+  if (epoll_ctl(dispatcher->getEpoll(), EPOLL_CTL_MOD, connection, &connectionEvent) == -1) {
+    contextPair.writeContext = nullptr;
+    throw std::runtime_error("TcpConnection::write, epoll_ctl failed, " + lastErrorMessage());
+  }
+
+  dispatcher->getCurrentContext()->interruptProcedure = [&]() {
+      assert(dispatcher != nullptr);
+      assert(contextPair.writeContext != nullptr);
+      epoll_event connectionEvent;
+      connectionEvent.events = 0;
+      connectionEvent.data.ptr = nullptr;
+
+      if (epoll_ctl(dispatcher->getEpoll(), EPOLL_CTL_MOD, connection, &connectionEvent) == -1) {
+        throw std::runtime_error("TcpConnection::stop, epoll_ctl failed, " + lastErrorMessage());
+      }
+
+      contextPair.writeContext->interrupted = true;
+      dispatcher->pushContext(contextPair.writeContext->context);
+  };
+
+  dispatcher->dispatch();
+  dispatcher->getCurrentContext()->interruptProcedure = nullptr;
+  assert(dispatcher != nullptr);
+  assert(operationContext.context == dispatcher->getCurrentContext());
+  assert(contextPair.writeContext == &operationContext);
+
+  if (operationContext.interrupted) {
+    contextPair.writeContext = nullptr;
+    throw InterruptedException();
+  }
+
+  contextPair.writeContext = nullptr;
+  if(contextPair.readContext != nullptr) { //read is presented, rearm
+    epoll_event connectionEvent;
+    connectionEvent.events = EPOLLIN | EPOLLONESHOT;
+    connectionEvent.data.ptr = &contextPair;
+
+    if (epoll_ctl(dispatcher->getEpoll(), EPOLL_CTL_MOD, connection, &connectionEvent) == -1) {
+      throw std::runtime_error("TcpConnection::write, epoll_ctl failed, " + lastErrorMessage());
+    }
+  }
+
+  if((operationContext.events & (EPOLLERR | EPOLLHUP)) != 0) {
+    throw std::runtime_error("TcpConnection::write, events & (EPOLLERR | EPOLLHUP) != 0");
+  }
+}
+
 std::pair<Ipv4Address, uint16_t> TcpConnection::getPeerAddressAndPort() const {
   sockaddr_in addr;
   socklen_t size = sizeof(addr);
@@ -10,6 +10,8 @@
 #include <cstddef>
 #include <cstdint>
 #include <string>
+#include <utility>
+#include <vector>
 #include "Dispatcher.h"
 
 namespace System {
@@ -26,6 +28,8 @@ public:
   TcpConnection& operator=(TcpConnection&& other);
   std::size_t read(uint8_t* data, std::size_t size);
   std::size_t write(const uint8_t* data, std::size_t size);
+  // gathers the buffers into a single send, returns how many bytes of them were written
+  std::size_t write(const std::vector<std::pair<const uint8_t*, std::size_t>>& buffers);
   std::pair<Ipv4Address, uint16_t> getPeerAddressAndPort() const;
 
 private:
@@ -37,6 +41,7 @@ private:
   ContextPair contextPair;
 
   TcpConnection(Dispatcher& dispatcher, int socket);
+  void waitWritable();
 };
 
 }
@@ -10,6 +10,7 @@
 #include <stdexcept>
 
 #include <fcntl.h>
+#include <linux/io_uring.h>
 #include <netdb.h>
 #include <sys/epoll.h>
 #include <unistd.h>
@@ -26,7 +27,7 @@ namespace System {
 TcpListener::TcpListener() : dispatcher(nullptr) {
 }
 
-TcpListener::TcpListener(Dispatcher& dispatcher, const Ipv4Address& addr, uint16_t port) : dispatcher(&dispatcher) {
+TcpListener::TcpListener(Dispatcher& dispatcher, const Ipv4Address& addr, uint16_t port, bool reusePort) : dispatcher(&dispatcher) {
   std::string message;
   listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
   if (listener == -1) {
@@ -37,7 +38,8 @@ TcpListener::TcpListener(Dispatcher& dispatcher, const Ipv4Address& addr, uint16
       message = "fcntl failed, " + lastErrorMessage();
     } else {
       int on = 1;
-      if (setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &on, sizeof on) == -1) {
+      if (setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &on, sizeof on) == -1 ||
+        (reusePort && setsockopt(listener, SOL_SOCKET, SO_REUSEPORT, &on, sizeof on) == -1)) {
         message = "setsockopt failed, " + lastErrorMessage();
       } else {
         sockaddr_in address;
@@ -113,6 +115,17 @@ TcpConnection TcpListener::accept() {
     throw InterruptedException();
   }
 
+  if (dispatcher->hasRing()) {
+    int connection = dispatcher->ringOperation(IORING_OP_ACCEPT, listener, nullptr, 0, 0, SOCK_NONBLOCK);
+    if (connection >= 0) {
+      return TcpConnection(*dispatcher, connection);
+    }
+
+    if (connection != -EAGAIN) {
+      throw std::runtime_error("TcpListener::accept, accept failed, " + errorMessage(-connection));
+    }
+  }
+
   ContextPair contextPair;
   OperationContext listenerContext;
   listenerContext.interrupted = false;
@@ -19,7 +19,8 @@ class TcpConnection;
 class TcpListener {
 public:
   TcpListener();
-  TcpListener(Dispatcher& dispatcher, const Ipv4Address& address, uint16_t port);
+  // with reusePort, listeners of any number of dispatchers can share the port and connections are spread among them
+  TcpListener(Dispatcher& dispatcher, const Ipv4Address& address, uint16_t port, bool reusePort = false);
   TcpListener(const TcpListener&) = delete;
   TcpListener(TcpListener&& other);
   ~TcpListener();
@@ -7,14 +7,8 @@
 
 #include "Timer.h"
 #include <cassert>
-#include <stdexcept>
-
-#include <sys/timerfd.h>
-#include <sys/epoll.h>
-#include <unistd.h>
 
 #include "Dispatcher.h"
-#include <System/ErrorMessage.h>
 #include <System/InterruptedException.h>
 
 namespace System {
@@ -22,13 +16,12 @@ namespace System {
 Timer::Timer() : dispatcher(nullptr) {
 }
 
-Timer::Timer(Dispatcher& dispatcher) : dispatcher(&dispatcher), context(nullptr), timer(-1) {
+Timer::Timer(Dispatcher& dispatcher) : dispatcher(&dispatcher), context(nullptr) {
 }
 
 Timer::Timer(Timer&& other) : dispatcher(other.dispatcher) {
   if (other.dispatcher != nullptr) {
     assert(other.context == nullptr);
-    timer = other.timer;
     context = nullptr;
     other.dispatcher = nullptr;
   }
@@ -43,10 +36,8 @@ Timer& Timer::operator=(Timer&& other) {
   dispatcher = other.dispatcher;
   if (other.dispatcher != nullptr) {
     assert(other.context == nullptr);
-    timer = other.timer;
     context = nullptr;
     other.dispatcher = nullptr;
-    other.timer = -1;
   }
 
   return *this;
@@ -62,68 +53,25 @@ void Timer::sleep(std::chrono::nanoseconds duration) {
   if(duration.count() == 0 ) {
     dispatcher->yield();
   } else {
-    timer = dispatcher->getTimer();
-
-    auto seconds = std::chrono::duration_cast<std::chrono::seconds>(duration);
-    itimerspec expires;
-    expires.it_interval.tv_nsec = expires.it_interval.tv_sec = 0;
-    expires.it_value.tv_sec = seconds.count();
-    expires.it_value.tv_nsec = std::chrono::duration_cast<std::chrono::nanoseconds>(duration - seconds).count();
-    timerfd_settime(timer, 0, &expires, NULL);
-
-    ContextPair contextPair;
-    OperationContext timerContext;
-    timerContext.interrupted = false;
-    timerContext.context = dispatcher->getCurrentContext();
-    contextPair.writeContext = nullptr;
-    contextPair.readContext = &timerContext;
-
-    epoll_event timerEvent;
-    timerEvent.events = EPOLLIN | EPOLLONESHOT;
-    timerEvent.data.ptr = &contextPair;
-
-    if (epoll_ctl(dispatcher->getEpoll(), EPOLL_CTL_MOD, timer, &timerEvent) == -1) {
-      throw std::runtime_error("Timer::sleep, epoll_ctl failed, " + lastErrorMessage());
-    }
+    TimerEntry timer;
+    timer.context = dispatcher->getCurrentContext();
+    bool interrupted = false;
+    dispatcher->addTimer(std::chrono::steady_clock::now() + duration, timer);
     dispatcher->getCurrentContext()->interruptProcedure = [&]() {
-        assert(dispatcher != nullptr);
-        assert(context != nullptr);
-        OperationContext* timerContext = static_cast<OperationContext*>(context);
-        if (!timerContext->interrupted) {
-          uint64_t value = 0;
-          if(::read(timer, &value, sizeof value) == -1 ){
-            if(errno == EAGAIN){
-              timerContext->interrupted = true;
-              dispatcher->pushContext(timerContext->context);
-            } else {
-              throw std::runtime_error("Timer::interrupt, read failed, "  + lastErrorMessage());
-            }
-          } else {
-            assert(value>0);
-            dispatcher->pushContext(timerContext->context);
-          }
-
-          epoll_event timerEvent;
-          timerEvent.events = 0;
-          timerEvent.data.ptr = nullptr;
-
-          if (epoll_ctl(dispatcher->getEpoll(), EPOLL_CTL_MOD, timer, &timerEvent) == -1) {
-            throw std::runtime_error("Timer::interrupt, epoll_ctl failed, " + lastErrorMessage());
-          }
-        }
+      assert(dispatcher != nullptr);
+      assert(context != nullptr);
+      dispatcher->interruptTimer(*static_cast<TimerEntry*>(context));
+      interrupted = true;
     };
 
-    context = &timerContext;
+    context = &timer;
     dispatcher->dispatch();
     dispatcher->getCurrentContext()->interruptProcedure = nullptr;
     assert(dispatcher != nullptr);
-    assert(timerContext.context == dispatcher->getCurrentContext());
-    assert(contextPair.writeContext == nullptr);
-    assert(context == &timerContext);
+    assert(timer.context == dispatcher->getCurrentContext());
+    assert(context == &timer);
     context = nullptr;
-    timerContext.context = nullptr;
-    dispatcher->pushTimer(timer);
-    if (timerContext.interrupted) {
+    if (interrupted) {
       throw InterruptedException();
     }
   }
@@ -27,7 +27,6 @@ public:
 private:
   Dispatcher* dispatcher;
   void* context;
-  int timer;
 };
 
 }
@@ -0,0 +1,167 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2014-2017 XDN developers
+// Copyright (c) 2016-2017 BXC developers
+// Copyright (c) 2017 Doppler developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "TimerWheel.h"
+#include <cassert>
+
+namespace System {
+
+TimerWheel::TimerWheel() : current(0), count(0) {
+  for (auto& level : slots) {
+    for (auto& slot : level) {
+      slot = nullptr;
+    }
+  }
+
+  for (auto& bits : occupied) {
+    bits = 0;
+  }
+}
+
+bool TimerWheel::empty() const {
+  return count == 0;
+}
+
+uint64_t TimerWheel::currentTick() const {
+  return current;
+}
+
+void TimerWheel::add(TimerEntry& timer) {
+  place(timer);
+  ++count;
+}
+
+void TimerWheel::remove(TimerEntry& timer) {
+  assert(count != 0);
+  if (timer.prev != nullptr) {
+    timer.prev->next = timer.next;
+  } else {
+    assert(slots[timer.level][timer.slot] == &timer);
+    slots[timer.level][timer.slot] = timer.next;
+    if (timer.next == nullptr && timer.level < LEVELS) {
+      occupied[timer.level] &= ~(uint64_t(1) << timer.slot);
+    }
+  }
+
+  if (timer.next != nullptr) {
+    timer.next->prev = timer.prev;
+  }
+
+  --count;
+}
+
+uint64_t TimerWheel::nextTick() const {
+  if (slots[LEVELS][DUE_SLOT] != nullptr) {
+    return current;
+  }
+
+  // the slots of a level are all ahead of the current one, the first occupied is the earliest of the level
+  uint64_t next = UINT64_MAX;
+  for (unsigned level = 0; level < LEVELS; ++level) {
+    if (occupied[level] != 0) {
+      unsigned shift = SLOT_BITS * level;
+      uint64_t span = (current >> (shift + SLOT_BITS)) << (shift + SLOT_BITS);
+      uint64_t tick = span + (static_cast<uint64_t>(__builtin_ctzll(occupied[level])) << shift);
+      if (tick < next) {
+        next = tick;
+      }
+    }
+  }
+
+  if (slots[LEVELS][FAR_SLOT] != nullptr) {
+    uint64_t tick = ((current >> (SLOT_BITS * LEVELS)) + 1) << (SLOT_BITS * LEVELS);
+    if (tick < next) {
+      next = tick;
+    }
+  }
+
+  return next;
+}
+
+TimerEntry* TimerWheel::advance(uint64_t tick) {
+  TimerEntry* expired = nullptr;
+  TimerEntry** expiredEnd = &expired;
+  for (;;) {
+    for (TimerEntry* timer = take(LEVELS, DUE_SLOT); timer != nullptr; timer = timer->next) {
+      *expiredEnd = timer;
+      expiredEnd = &timer->next;
+      --count;
+    }
+
+    uint64_t next = nextTick();
+    if (next > tick) {
+      break;
+    }
+
+    // the slots starting at this tick move down from the top, the timers of the tick itself land in the due list
+    current = next;
+    for (unsigned level = LEVELS + 1; level-- > 0;) {
+      unsigned shift = SLOT_BITS * level;
+      if ((current & ((uint64_t(1) << shift) - 1)) != 0) {
+        continue;
+      }
+
+      TimerEntry* timer = level == LEVELS ? take(LEVELS, FAR_SLOT) : take(level, (current >> shift) & (SLOTS - 1));
+      while (timer != nullptr) {
+        TimerEntry* nextTimer = timer->next;
+        place(*timer);
+        timer = nextTimer;
+      }
+    }
+  }
+
+  *expiredEnd = nullptr;
+  if (tick > current) {
+    current = tick;
+  }
+
+  return expired;
+}
+
+void TimerWheel::place(TimerEntry& timer) {
+  if (timer.deadline <= current) {
+    link(timer, LEVELS, DUE_SLOT);
+    return;
+  }
+
+  for (unsigned level = 0; level < LEVELS; ++level) {
+    unsigned shift = SLOT_BITS * (level + 1);
+    if ((timer.deadline >> shift) == (current >> shift)) {
+      link(timer, level, (timer.deadline >> (SLOT_BITS * level)) & (SLOTS - 1));
+      return;
+    }
+  }
+
+  link(timer, LEVELS, FAR_SLOT);
+}
+
+void TimerWheel::link(TimerEntry& timer, unsigned level, unsigned slot) {
+  timer.level = static_cast<uint8_t>(level);
+  timer.slot = static_cast<uint8_t>(slot);
+  timer.prev = nullptr;
+  timer.next = slots[level][slot];
+  if (timer.next != nullptr) {
+    timer.next->prev = &timer;
+  }
+
+  slots[level][slot] = &timer;
+  if (level < LEVELS) {
+    occupied[level] |= uint64_t(1) << slot;
+  }
+}
+
+TimerEntry* TimerWheel::take(unsigned level, unsigned slot) {
+  TimerEntry* first = slots[level][slot];
+  slots[level][slot] = nullptr;
+  if (level < LEVELS) {
+    occupied[level] &= ~(uint64_t(1) << slot);
+  }
+
+  return first;
+}
+
+}
@@ -0,0 +1,64 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2014-2017 XDN developers
+// Copyright (c) 2016-2017 BXC developers
+// Copyright (c) 2017 Doppler developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace System {
+
+struct NativeContext;
+
+// Lives with the waiting operation, linked into the wheel until it expires or is removed
+struct TimerEntry {
+  uint64_t deadline;
+  NativeContext* context;
+  TimerEntry* prev;
+  TimerEntry* next;
+  uint8_t level;
+  uint8_t slot;
+};
+
+// Hierarchical wheel of ticks. Level 0 has a slot per tick, a slot of every next level spans the whole previous one.
+// A timer sits in the lowest level where it shares the span with the current tick and moves down once the wheel
+// reaches its slot, so adding and removing are O(1) and advancing jumps over the ticks without timers.
+class TimerWheel {
+public:
+  TimerWheel();
+  TimerWheel(const TimerWheel&) = delete;
+  TimerWheel& operator=(const TimerWheel&) = delete;
+
+  bool empty() const;
+  uint64_t currentTick() const;
+  // a deadline not after the current tick expires with the next advance
+  void add(TimerEntry& timer);
+  void remove(TimerEntry& timer);
+  // the earliest tick advance has timers to move or expire at, UINT64_MAX without timers
+  uint64_t nextTick() const;
+  // moves the wheel to the tick, the expired timers are unlinked and returned chained by next
+  TimerEntry* advance(uint64_t tick);
+
+private:
+  static const unsigned LEVELS = 6;
+  static const unsigned SLOT_BITS = 6;
+  static const unsigned SLOTS = 1 << SLOT_BITS;
+  // the lists past the levels hold the timers already due and the ones beyond the top level
+  static const unsigned DUE_SLOT = 0;
+  static const unsigned FAR_SLOT = 1;
+
+  void place(TimerEntry& timer);
+  void link(TimerEntry& timer, unsigned level, unsigned slot);
+  TimerEntry* take(unsigned level, unsigned slot);
+
+  uint64_t current;
+  size_t count;
+  TimerEntry* slots[LEVELS + 1][SLOTS];
+  uint64_t occupied[LEVELS];
+};
+
+}
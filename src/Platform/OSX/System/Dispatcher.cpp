@@ -18,6 +18,7 @@
 #include <unistd.h>
 #include "Context.h"
 #include "ErrorMessage.h"
+#include <System/ThreadPool.h>
 
 namespace System {
 
@@ -83,6 +84,7 @@ Dispatcher::Dispatcher() : lastCreatedTimer(0) {
           firstResumingContext = nullptr;
           firstReusableContext = nullptr;
           runningContextCount = 0;
+          threadPool = nullptr;
           return;
         }
       }
@@ -113,6 +115,7 @@ Dispatcher::~Dispatcher() {
     delete ucontext;
   }
   
+  delete threadPool;
   auto result = close(kqueue);
   assert(result != -1);
   result = pthread_mutex_destroy(reinterpret_cast<pthread_mutex_t*>(this->mutex));
@@ -321,32 +324,58 @@ void Dispatcher::yield() {
   }
 }
 
+ThreadPool& Dispatcher::getThreadPool() {
+  if (threadPool == nullptr) {
+    unsigned threadCount = std::thread::hardware_concurrency();
+    threadPool = new ThreadPool(threadCount > 0 ? threadCount : 1);
+  }
+
+  return *threadPool;
+}
+
 int Dispatcher::getKqueue() const {
   return kqueue;
 }
 
-NativeContext& Dispatcher::getReusableContext() {
-  if(firstReusableContext == nullptr) {
+NativeContext& Dispatcher::getReusableContext(size_t stackSize) {
+  if (stackSize == 0) {
+    stackSize = STACK_SIZE;
+  }
+
+  NativeContext** link = &firstReusableContext;
+  while (*link != nullptr && (*link)->stackSize != stackSize) {
+    link = &(*link)->next;
+  }
+
+  if (*link == nullptr) {
+   // the new context announces itself through an empty list
+   NativeContext* reusableContexts = firstReusableContext;
+   firstReusableContext = nullptr;
    uctx* newlyCreatedContext = new uctx;
-   uint8_t* stackPointer = new uint8_t[STACK_SIZE];
+   uint8_t* stackPointer = new uint8_t[stackSize];
    static_cast<uctx*>(newlyCreatedContext)->uc_stack.ss_sp = stackPointer;
-   static_cast<uctx*>(newlyCreatedContext)->uc_stack.ss_size = STACK_SIZE;
+   static_cast<uctx*>(newlyCreatedContext)->uc_stack.ss_size = stackSize;
    
    ContextMakingData makingData{ newlyCreatedContext, this};
    makecontext(static_cast<uctx*>(newlyCreatedContext), reinterpret_cast<void(*)()>(contextProcedureStatic), reinterpret_cast<intptr_t>(&makingData));
    
    uctx* oldContext = static_cast<uctx*>(currentContext->uctx);
    if (swapcontext(oldContext, newlyCreatedContext) == -1) {
+     firstReusableContext = reusableContexts;
      throw std::runtime_error("Dispatcher::getReusableContext, swapcontext failed, " + lastErrorMessage());
    }
    
    assert(firstReusableContext != nullptr);
    assert(firstReusableContext->uctx == newlyCreatedContext);
-   firstReusableContext->stackPtr = stackPointer;
+   NativeContext* context = firstReusableContext;
+   firstReusableContext = reusableContexts;
+   context->stackPtr = stackPointer;
+   context->stackSize = stackSize;
+   return *context;
   }
   
-  NativeContext* context = firstReusableContext;
-  firstReusableContext = firstReusableContext->next;
+  NativeContext* context = *link;
+  *link = context->next;
   return *context;
 }
 
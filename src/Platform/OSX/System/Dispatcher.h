@@ -16,10 +16,12 @@
 namespace System {
 
 struct NativeContextGroup;
+class ThreadPool;
 
 struct NativeContext {
   void* uctx;
   void* stackPtr;
+  size_t stackSize;
   bool interrupted;
   NativeContext* next;
   NativeContextGroup* group;
@@ -56,9 +58,12 @@ public:
   void pushContext(NativeContext* context);
   void remoteSpawn(std::function<void()>&& procedure);
   void yield();
+  // the pool RemoteContext runs its operations on, started with the first one
+  ThreadPool& getThreadPool();
 
   int getKqueue() const;
-  NativeContext& getReusableContext();
+  // stack size 0 is the default one
+  NativeContext& getReusableContext(size_t stackSize = 0);
   void pushReusableContext(NativeContext&);
   int getTimer();
   void pushTimer(int timer);
@@ -86,6 +91,7 @@ private:
   NativeContext* lastResumingContext;
   NativeContext* firstReusableContext;
   size_t runningContextCount;
+  ThreadPool* threadPool;
 
   void contextProcedure(void* uctx);
   static void contextProcedureStatic(intptr_t context);
@@ -6,12 +6,15 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include "TcpConnection.h"
+#include <algorithm>
 #include <cassert>
+#include <climits>
 
 #include <netinet/in.h>
 #include <sys/event.h>
 #include <sys/errno.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 #include "Dispatcher.h"
@@ -140,7 +143,6 @@ size_t TcpConnection::write(const uint8_t* data, size_t size) {
     throw InterruptedException();
   }
 
-  std::string message;
   if (size == 0) {
     if (shutdown(connection, SHUT_WR) == -1) {
       throw std::runtime_error("TcpConnection::write, shutdown failed, " + lastErrorMessage());
@@ -150,64 +152,98 @@ size_t TcpConnection::write(const uint8_t* data, size_t size) {
   }
 
   ssize_t transferred = ::send(connection, (void *)data, size, 0);
+  if (transferred == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+    waitWritable();
+    transferred = ::send(connection, (void *)data, size, 0);
+  }
+
   if (transferred == -1) {
-    if (errno != EAGAIN  && errno != EWOULDBLOCK) {
-      message = "send failed, " + lastErrorMessage();
-    } else {
-      OperationContext context;
-      context.context = dispatcher->getCurrentContext();
-      context.interrupted = false;
-      struct kevent event;
-      EV_SET(&event, connection, EVFILT_WRITE, EV_ADD | EV_ENABLE, 0, 0, &context);
-      if (kevent(dispatcher->getKqueue(), &event, 1, NULL, 0, NULL) == -1) {
-        message = "kevent failed, " + lastErrorMessage();
-      } else {
-        writeContext = &context;
-        dispatcher->getCurrentContext()->interruptProcedure = [&] {
-          assert(dispatcher != nullptr);
-          assert(writeContext != nullptr);
-          OperationContext* context = static_cast<OperationContext*>(writeContext);
-          if (!context->interrupted) {
-            struct kevent event;
-            EV_SET(&event, connection, EVFILT_WRITE, EV_DELETE | EV_DISABLE, 0, 0, NULL);
-            
-            if (kevent(dispatcher->getKqueue(), &event, 1, NULL, 0, NULL) == -1) {
-              throw std::runtime_error("TcpListener::stop, kevent failed, " + lastErrorMessage());
-            }
-            
-            context->interrupted = true;
-            dispatcher->pushContext(context->context);            
-          }
-        };
-        
-        dispatcher->dispatch();
-        dispatcher->getCurrentContext()->interruptProcedure = nullptr;
-        assert(dispatcher != nullptr);
-        assert(context.context == dispatcher->getCurrentContext());
-        assert(writeContext == &context);
-        writeContext = nullptr;
-        context.context = nullptr;
-        if (context.interrupted) {
-          throw InterruptedException();
-        }
+    throw std::runtime_error("TcpConnection::write, send failed, " + lastErrorMessage());
+  }
 
-        ssize_t transferred = ::send(connection, (void *)data, size, 0);
-        if (transferred == -1) {
-          message = "send failed, " + lastErrorMessage();
-        } else {
-          assert(transferred <= static_cast<ssize_t>(size));
-          return transferred;
-        }
-      }
+  assert(transferred <= static_cast<ssize_t>(size));
+  return transferred;
+}
+
+size_t TcpConnection::write(const std::vector<std::pair<const uint8_t*, size_t>>& buffers) {
+  assert(dispatcher != nullptr);
+  assert(writeContext == nullptr);
+  if (dispatcher->interrupted()) {
+    throw InterruptedException();
+  }
+
+  std::vector<iovec> vectors;
+  vectors.reserve(std::min<size_t>(buffers.size(), IOV_MAX));
+  size_t size = 0;
+  for (const auto& buffer : buffers) {
+    if (vectors.size() == IOV_MAX) {
+      break;
+    }
+
+    if (buffer.second != 0) {
+      vectors.push_back(iovec{ const_cast<uint8_t*>(buffer.first), buffer.second });
+      size += buffer.second;
     }
+  }
+
+  if (size == 0) {
+    return 0;
+  }
 
-    throw std::runtime_error("TcpConnection::write, " + message);
+  ssize_t transferred = ::writev(connection, vectors.data(), static_cast<int>(vectors.size()));
+  if (transferred == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+    waitWritable();
+    transferred = ::writev(connection, vectors.data(), static_cast<int>(vectors.size()));
+  }
+
+  if (transferred == -1) {
+    throw std::runtime_error("TcpConnection::write, writev failed, " + lastErrorMessage());
   }
 
   assert(transferred <= static_cast<ssize_t>(size));
   return transferred;
 }
 
+void TcpConnection::waitWritable() {
+  OperationContext context;
+  context.context = dispatcher->getCurrentContext();
+  context.interrupted = false;
+  struct kevent event;
+  EV_SET(&event, connection, EVFILT_WRITE, EV_ADD | EV_ENABLE, 0, 0, &context);
+  if (kevent(dispatcher->getKqueue(), &event, 1, NULL, 0, NULL) == -1) {
+    throw std::runtime_error("TcpConnection::write, kevent failed, " + lastErrorMessage());
+  }
+
+  writeContext = &context;
+  dispatcher->getCurrentContext()->interruptProcedure = [&] {
+    assert(dispatcher != nullptr);
+    assert(writeContext != nullptr);
+    OperationContext* context = static_cast<OperationContext*>(writeContext);
+    if (!context->interrupted) {
+      struct kevent event;
+      EV_SET(&event, connection, EVFILT_WRITE, EV_DELETE | EV_DISABLE, 0, 0, NULL);
+
+      if (kevent(dispatcher->getKqueue(), &event, 1, NULL, 0, NULL) == -1) {
+        throw std::runtime_error("TcpListener::stop, kevent failed, " + lastErrorMessage());
+      }
+
+      context->interrupted = true;
+      dispatcher->pushContext(context->context);
+    }
+  };
+
+  dispatcher->dispatch();
+  dispatcher->getCurrentContext()->interruptProcedure = nullptr;
+  assert(dispatcher != nullptr);
+  assert(context.context == dispatcher->getCurrentContext());
+  assert(writeContext == &context);
+  writeContext = nullptr;
+  context.context = nullptr;
+  if (context.interrupted) {
+    throw InterruptedException();
+  }
+}
+
 std::pair<Ipv4Address, uint16_t> TcpConnection::getPeerAddressAndPort() const {
   sockaddr_in addr;
   socklen_t size = sizeof(addr);
@@ -28,7 +28,7 @@ namespace System {
 TcpListener::TcpListener() : dispatcher(nullptr) {
 }
 
-TcpListener::TcpListener(Dispatcher& dispatcher, const Ipv4Address& addr, uint16_t port) : dispatcher(&dispatcher) {
+TcpListener::TcpListener(Dispatcher& dispatcher, const Ipv4Address& addr, uint16_t port, bool reusePort) : dispatcher(&dispatcher) {
   std::string message;
   listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
   if (listener == -1) {
@@ -39,7 +39,8 @@ TcpListener::TcpListener(Dispatcher& dispatcher, const Ipv4Address& addr, uint16
       message = "fcntl failed, " + lastErrorMessage();
     } else {
       int on = 1;
-      if (setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &on, sizeof on) == -1) {
+      if (setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &on, sizeof on) == -1 ||
+        (reusePort && setsockopt(listener, SOL_SOCKET, SO_REUSEPORT, &on, sizeof on) == -1)) {
         message = "setsockopt failed, " + lastErrorMessage();
       } else {
         sockaddr_in address;
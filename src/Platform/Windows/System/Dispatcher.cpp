@@ -16,6 +16,7 @@
 #endif
 #include <winsock2.h>
 #include "ErrorMessage.h"
+#include <System/ThreadPool.h>
 
 namespace System {
 
@@ -63,6 +64,7 @@ Dispatcher::Dispatcher() {
         firstResumingContext = nullptr;
         firstReusableContext = nullptr;
         runningContextCount = 0;
+        threadPool = nullptr;
         return;
       }
 
@@ -96,6 +98,7 @@ Dispatcher::~Dispatcher() {
     DeleteFiber(fiber);
   }
 
+  delete threadPool;
   int wsaResult = WSACleanup();
   assert(wsaResult == 0);
   BOOL result = CloseHandle(completionPort);
@@ -315,6 +318,16 @@ void Dispatcher::yield() {
   }
 }
 
+ThreadPool& Dispatcher::getThreadPool() {
+  assert(GetCurrentThreadId() == threadId);
+  if (threadPool == nullptr) {
+    unsigned threadCount = std::thread::hardware_concurrency();
+    threadPool = new ThreadPool(threadCount > 0 ? threadCount : 1);
+  }
+
+  return *threadPool;
+}
+
 void Dispatcher::addTimer(uint64_t time, NativeContext* context) {
   assert(GetCurrentThreadId() == threadId);
   timers.insert(std::make_pair(time, context));
@@ -324,20 +337,36 @@ void* Dispatcher::getCompletionPort() const {
   return completionPort;
 }
 
-NativeContext& Dispatcher::getReusableContext() {
-  if (firstReusableContext == nullptr) {
-    void* fiber = CreateFiberEx(STACK_SIZE, RESERVE_STACK_SIZE, 0, contextProcedureStatic, this);
+NativeContext& Dispatcher::getReusableContext(size_t stackSize) {
+  if (stackSize == 0) {
+    stackSize = RESERVE_STACK_SIZE;
+  }
+
+  NativeContext** link = &firstReusableContext;
+  while (*link != nullptr && (*link)->stackSize != stackSize) {
+    link = &(*link)->next;
+  }
+
+  if (*link == nullptr) {
+    void* fiber = CreateFiberEx(stackSize < STACK_SIZE ? stackSize : STACK_SIZE, stackSize, 0, contextProcedureStatic, this);
     if (fiber == NULL) {
       throw std::runtime_error("Dispatcher::getReusableContext, CreateFiberEx failed, " + lastErrorMessage());
     }
 
+    // the new context announces itself through an empty list
+    NativeContext* reusableContexts = firstReusableContext;
+    firstReusableContext = nullptr;
     SwitchToFiber(fiber);
     assert(firstReusableContext != nullptr);
-    firstReusableContext->fiber = fiber;
+    NativeContext* context = firstReusableContext;
+    firstReusableContext = reusableContexts;
+    context->fiber = fiber;
+    context->stackSize = stackSize;
+    return *context;
   }
 
-  NativeContext* context = firstReusableContext;
-  firstReusableContext = context->next;
+  NativeContext* context = *link;
+  *link = context->next;
   return *context;
 }
 
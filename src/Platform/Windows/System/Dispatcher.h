@@ -15,9 +15,11 @@
 namespace System {
 
 struct NativeContextGroup;
+class ThreadPool;
 
 struct NativeContext {
   void* fiber;
+  size_t stackSize;
   bool interrupted;
   NativeContext* next;
   NativeContextGroup* group;
@@ -49,11 +51,14 @@ public:
   void pushContext(NativeContext* context);
   void remoteSpawn(std::function<void()>&& procedure);
   void yield();
+  // the pool RemoteContext runs its operations on, started with the first one
+  ThreadPool& getThreadPool();
 
   // Platform-specific
   void addTimer(uint64_t time, NativeContext* context);
   void* getCompletionPort() const;
-  NativeContext& getReusableContext();
+  // stack size 0 is the default one, it is the reserved size of the fiber stack
+  NativeContext& getReusableContext(size_t stackSize = 0);
   void pushReusableContext(NativeContext&);
   void interruptTimer(uint64_t time, NativeContext* context);
 
@@ -74,6 +79,7 @@ private:
   NativeContext* lastResumingContext;
   NativeContext* firstReusableContext;
   size_t runningContextCount;
+  ThreadPool* threadPool;
 
   void contextProcedure();
   static void __stdcall contextProcedureStatic(void* context);
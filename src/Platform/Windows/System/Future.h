@@ -1,25 +0,0 @@
-// Copyright (c) 2011-2017 The Cryptonote developers
-// Copyright (c) 2014-2017 XDN developers
-// Copyright (c) 2016-2017 BXC developers
-// Copyright (c) 2017 Doppler developers
-// Distributed under the MIT/X11 software license, see the accompanying
-// file COPYING or http://www.opensource.org/licenses/mit-license.php.
-
-#pragma once
-
-#include <future>
-
-namespace System {
-
-namespace Detail {
-
-template<class T> using Future = std::future<T>;
-
-template<class T> Future<T> async(std::function<T()>&& operation) {
-  return std::async(std::launch::async, std::move(operation));
-}
-
-}
-
-}
-
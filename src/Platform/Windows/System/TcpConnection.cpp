@@ -151,9 +151,37 @@ size_t TcpConnection::write(const uint8_t* data, size_t size) {
   }
 
   WSABUF buf{static_cast<ULONG>(size), reinterpret_cast<char*>(const_cast<uint8_t*>(data))};
+  return send(&buf, 1, size);
+}
+
+size_t TcpConnection::write(const std::vector<std::pair<const uint8_t*, size_t>>& buffers) {
+  assert(dispatcher != nullptr);
+  assert(writeContext == nullptr);
+  if (dispatcher->interrupted()) {
+    throw InterruptedException();
+  }
+
+  std::vector<WSABUF> bufs;
+  bufs.reserve(buffers.size());
+  size_t size = 0;
+  for (const auto& buffer : buffers) {
+    if (buffer.second != 0) {
+      bufs.push_back(WSABUF{static_cast<ULONG>(buffer.second), reinterpret_cast<char*>(const_cast<uint8_t*>(buffer.first))});
+      size += buffer.second;
+    }
+  }
+
+  if (size == 0) {
+    return 0;
+  }
+
+  return send(bufs.data(), bufs.size(), size);
+}
+
+size_t TcpConnection::send(void* buffers, size_t count, size_t size) {
   TcpConnectionContext context;
   context.hEvent = NULL;
-  if (WSASend(connection, &buf, 1, NULL, 0, &context, NULL) != 0) {
+  if (WSASend(connection, static_cast<WSABUF*>(buffers), static_cast<DWORD>(count), NULL, 0, &context, NULL) != 0) {
     int lastError = WSAGetLastError();
     if (lastError != WSA_IO_PENDING) {
       throw std::runtime_error("TcpConnection::write, WSASend failed, " + errorMessage(lastError));
@@ -9,6 +9,8 @@
 
 #include <cstdint>
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace System {
 
@@ -25,6 +27,8 @@ public:
   TcpConnection& operator=(TcpConnection&& other);
   size_t read(uint8_t* data, size_t size);
   size_t write(const uint8_t* data, size_t size);
+  // gathers the buffers into a single send, returns how many bytes of them were written
+  size_t write(const std::vector<std::pair<const uint8_t*, size_t>>& buffers);
   std::pair<Ipv4Address, uint16_t> getPeerAddressAndPort() const;
 
 private:
@@ -37,6 +41,7 @@ private:
   void* writeContext;
 
   TcpConnection(Dispatcher& dispatcher, size_t connection);
+  size_t send(void* buffers, size_t count, size_t size);
 };
 
 }
@@ -262,6 +262,10 @@ struct COMMAND_RPC_GET_INFO {
     uint64_t difficulty;
     uint64_t tx_count;
     uint64_t tx_pool_size;
+    uint64_t tx_pool_bytes;
+    uint64_t tx_pool_max_bytes;
+    uint64_t tx_pool_evicted_count;
+    uint64_t tx_pool_min_fee_per_kb;
     uint64_t alt_blocks_count;
     uint64_t outgoing_connections_count;
     uint64_t incoming_connections_count;
@@ -277,6 +281,10 @@ struct COMMAND_RPC_GET_INFO {
       KV_MEMBER(difficulty)
       KV_MEMBER(tx_count)
       KV_MEMBER(tx_pool_size)
+      KV_MEMBER(tx_pool_bytes)
+      KV_MEMBER(tx_pool_max_bytes)
+      KV_MEMBER(tx_pool_evicted_count)
+      KV_MEMBER(tx_pool_min_fee_per_kb)
       KV_MEMBER(alt_blocks_count)
       KV_MEMBER(outgoing_connections_count)
       KV_MEMBER(incoming_connections_count)
@@ -295,6 +303,47 @@ struct COMMAND_RPC_STOP_MINING {
   typedef STATUS_STRUCT response;
 };
 
+//-----------------------------------------------
+struct mining_thread_statistics {
+  uint64_t hashes;
+  uint64_t hashrate;
+  uint64_t hashing_time;
+  uint64_t waiting_time;
+
+  void serialize(ISerializer &s) {
+    KV_MEMBER(hashes)
+    KV_MEMBER(hashrate)
+    KV_MEMBER(hashing_time)
+    KV_MEMBER(waiting_time)
+  }
+};
+
+struct COMMAND_RPC_GET_MINING_STATISTICS {
+  typedef EMPTY_STRUCT request;
+
+  struct response {
+    std::string status;
+    bool mining;
+    uint64_t hashrate;
+    std::vector<mining_thread_statistics> threads;
+    uint64_t blocks_found;
+    uint64_t blocks_rejected;
+    uint64_t last_template_age;
+    uint64_t average_template_age;
+
+    void serialize(ISerializer &s) {
+      KV_MEMBER(status)
+      KV_MEMBER(mining)
+      KV_MEMBER(hashrate)
+      KV_MEMBER(threads)
+      KV_MEMBER(blocks_found)
+      KV_MEMBER(blocks_rejected)
+      KV_MEMBER(last_template_age)
+      KV_MEMBER(average_template_age)
+    }
+  };
+};
+
 //-----------------------------------------------
 struct COMMAND_RPC_STOP_DAEMON {
   typedef EMPTY_STRUCT request;
@@ -6,16 +6,23 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include "HttpServer.h"
+#include <algorithm>
+#include <deque>
 #include <boost/scope_exit.hpp>
 
 #include <HTTP/HttpParser.h>
 #include <System/InterruptedException.h>
-#include <System/TcpStream.h>
 #include <System/Ipv4Address.h>
 
 using namespace Logging;
 
 namespace {
+
+// the input buffer grows to fit a larger request and shrinks back once it is served
+const size_t INPUT_BUFFER_SIZE = 16 * 1024;
+// responses to pipelined requests are sent together, once no complete request is left or this many are ready
+const size_t MAX_PENDING_RESPONSES = 16;
+
 std::string base64Encode(const std::string& data) {
   static const char* encodingTable = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
   const size_t resultSize = 4 * ((data.size() + 2) / 3);
@@ -51,6 +58,58 @@ void fillUnauthorizedResponse(CryptoNote::HttpResponse& response) {
   response.setBody("Authorization required");
 }
 
+// HTTP/1.1 connections persist unless the client asks to close them, HTTP/1.0 ones only when it asks to keep them
+bool isKeepAlive(const CryptoNote::HttpRequest& request) {
+  auto headerIt = request.getHeaders().find("connection");
+  if (headerIt != request.getHeaders().end()) {
+    std::string value = headerIt->second;
+    std::transform(value.begin(), value.end(), value.begin(), ::tolower);
+    if (value.find("close") != std::string::npos) {
+      return false;
+    }
+
+    if (value.find("keep-alive") != std::string::npos) {
+      return true;
+    }
+  }
+
+  return request.getVersion() != "HTTP/1.0";
+}
+
+// heads holds the heads of all the responses one after another, headEnds where each of them ends
+void writeResponses(System::TcpConnection& connection, const std::deque<CryptoNote::HttpResponse>& responses,
+  const std::string& heads, const std::vector<size_t>& headEnds) {
+  std::vector<std::pair<const uint8_t*, size_t>> buffers;
+  buffers.reserve(2 * responses.size());
+  size_t headBegin = 0;
+  for (size_t i = 0; i < responses.size(); ++i) {
+    buffers.emplace_back(reinterpret_cast<const uint8_t*>(heads.data()) + headBegin, headEnds[i] - headBegin);
+    const std::string& body = responses[i].getBody();
+    if (!body.empty()) {
+      buffers.emplace_back(reinterpret_cast<const uint8_t*>(body.data()), body.size());
+    }
+
+    headBegin = headEnds[i];
+  }
+
+  while (!buffers.empty()) {
+    size_t written = connection.write(buffers);
+
+    // drop what has been sent, a partially sent buffer stays in front
+    auto sent = buffers.begin();
+    while (sent != buffers.end() && written >= sent->second) {
+      written -= sent->second;
+      ++sent;
+    }
+
+    buffers.erase(buffers.begin(), sent);
+    if (written != 0) {
+      buffers.front().first += written;
+      buffers.front().second -= written;
+    }
+  }
+}
+
 }
 
 namespace CryptoNote {
@@ -60,8 +119,8 @@ HttpServer::HttpServer(System::Dispatcher& dispatcher, Logging::ILogger& log)
 
 }
 
-void HttpServer::start(const std::string& address, uint16_t port, const std::string& user, const std::string& password) {
-  m_listener = System::TcpListener(m_dispatcher, System::Ipv4Address(address), port);
+void HttpServer::start(const std::string& address, uint16_t port, const std::string& user, const std::string& password, bool reusePort) {
+  m_listener = System::TcpListener(m_dispatcher, System::Ipv4Address(address), port, reusePort);
   workingContextGroup.spawn(std::bind(&HttpServer::acceptLoop, this));
 
   if (!user.empty() || !password.empty()) {
@@ -100,16 +159,53 @@ void HttpServer::acceptLoop() {
 
     workingContextGroup.spawn(std::bind(&HttpServer::acceptLoop, this));
 
-    System::TcpStreambuf streambuf(connection);
-    std::iostream stream(&streambuf);
+    // requests are parsed where they were read to, the responses go out once the received requests are served
     HttpParser parser;
+    std::vector<char> input(INPUT_BUFFER_SIZE);
+    size_t begin = 0;
+    size_t end = 0;
+    HttpRequest req;
+    std::deque<HttpResponse> responses;
+    std::string heads;
+    std::vector<size_t> headEnds;
+    bool keepAlive = true;
+    while (keepAlive) {
+      size_t size = parser.parseRequest(input.data() + begin, end - begin, req);
+      if (size == 0) {
+        if (!responses.empty()) {
+          writeResponses(connection, responses, heads, headEnds);
+          responses.clear();
+          heads.clear();
+          headEnds.clear();
+        }
+
+        // bounded by the parser, which rejects a longer head or Content-Length
+        size_t required = parser.getRequiredSize();
+        std::copy(input.begin() + begin, input.begin() + end, input.begin());
+        end -= begin;
+        begin = 0;
+        if (required > input.size()) {
+          input.resize(required);
+        } else if (end == input.size()) {
+          input.resize(2 * input.size());
+        } else if (end == 0 && input.size() > INPUT_BUFFER_SIZE) {
+          input.resize(INPUT_BUFFER_SIZE);
+          input.shrink_to_fit();
+        }
+
+        size_t transferred = connection.read(reinterpret_cast<uint8_t*>(input.data() + end), input.size() - end);
+        if (transferred == 0) {
+          break;
+        }
+
+        end += transferred;
+        continue;
+      }
 
-    for (;;) {
-      HttpRequest req;
-      HttpResponse resp;
+      begin += size;
+      responses.emplace_back();
+      HttpResponse& resp = responses.back();
       resp.addHeader("Access-Control-Allow-Origin", "*");
-
-      parser.receiveRequest(stream, req);
       if (authenticate(req)) {
         processRequest(req, resp);
       } else {
@@ -117,11 +213,21 @@ void HttpServer::acceptLoop() {
         fillUnauthorizedResponse(resp);
       }
 
-      stream << resp;
-      stream.flush();
+      keepAlive = isKeepAlive(req);
+      if (!keepAlive) {
+        resp.addHeader("Connection", "close");
+      } else if (req.getVersion() == "HTTP/1.0") {
+        resp.addHeader("Connection", "keep-alive");
+      }
 
-      if (stream.peek() == std::iostream::traits_type::eof()) {
-        break;
+      resp.appendHead(heads);
+      headEnds.push_back(heads.size());
+      req = HttpRequest();
+      if (!keepAlive || responses.size() == MAX_PENDING_RESPONSES) {
+        writeResponses(connection, responses, heads, headEnds);
+        responses.clear();
+        heads.clear();
+        headEnds.clear();
       }
     }
 
@@ -28,7 +28,8 @@ public:
 
   HttpServer(System::Dispatcher& dispatcher, Logging::ILogger& log);
 
-  void start(const std::string& address, uint16_t port, const std::string& user = "", const std::string& password = "");
+  // with reusePort, servers on other dispatchers can listen on the same port
+  void start(const std::string& address, uint16_t port, const std::string& user = "", const std::string& password = "", bool reusePort = false);
   void stop();
 
   virtual void processRequest(const HttpRequest& request, HttpResponse& response) = 0;
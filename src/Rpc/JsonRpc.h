@@ -10,6 +10,7 @@
 #include <boost/optional.hpp>
 #include <boost/foreach.hpp>
 #include <functional>
+#include <memory>
 
 #include "CoreRpcServerCommandsDefinitions.h"
 #include <Common/JsonValue.h>
@@ -121,10 +122,14 @@ class JsonRpcResponse {
 public:
 
   JsonRpcResponse() : psResp(Common::JsonValue::OBJECT) {}
+  // the reader points into the body
+  JsonRpcResponse(const JsonRpcResponse&) = delete;
+  JsonRpcResponse& operator=(const JsonRpcResponse&) = delete;
 
   void parse(const std::string& responseBody) {
+    body = responseBody;
     try {
-      psResp = Common::JsonValue::fromString(responseBody);
+      reader.reset(new JsonInputBufferSerializer(body.data(), body.size()));
     } catch (std::exception&) {
       throw JsonRpcError(errParseError);
     }
@@ -138,40 +143,51 @@ public:
 
   void setError(const JsonRpcError& err) {
     psResp.set("error", storeToJsonValue(err));
+    result.clear();
   }
 
   bool getError(JsonRpcError& err) const {
-    if (!psResp.contains("error")) {
-      return false;
-    }
-
-    loadFromJsonValue(err, psResp("error"));
-    return true;
+    return getMember(err, "error");
   }
 
   std::string getBody() {
     psResp.set("jsonrpc", std::string("2.0"));
-    return psResp.toString();
+    std::string responseBody = psResp.toString();
+    if (!result.empty()) {
+      // the result is written straight to text, it goes last in the envelope object
+      responseBody.insert(responseBody.size() - 1, ",\"result\":" + result);
+    }
+
+    return responseBody;
   }
 
   template <typename T>
   bool setResult(const T& v) {
-    psResp.set("result", storeToJsonValue(v));
+    result = storeToJson(v);
     return true;
   }
 
   template <typename T>
   bool getResult(T& v) const {
-    if (!psResp.contains("result")) {
+    return getMember(v, "result");
+  }
+
+private:
+  template <typename T>
+  bool getMember(T& v, Common::StringView name) const {
+    if (!reader || !reader->beginObject(name)) {
       return false;
     }
 
-    loadFromJsonValue(v, psResp("result"));
+    serialize(v, *reader);
+    reader->endObject();
     return true;
   }
 
-private:
   Common::JsonValue psResp;
+  std::string result;
+  std::string body;
+  std::unique_ptr<JsonInputBufferSerializer> reader;
 };
 
 
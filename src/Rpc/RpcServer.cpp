@@ -89,6 +89,7 @@ std::unordered_map<std::string, RpcServer::RpcHandler<RpcServer::HandlerFunction
   { "/sendrawtransaction", { jsonMethod<COMMAND_RPC_SEND_RAW_TX>(&RpcServer::on_send_raw_tx), false } },
   { "/start_mining", { jsonMethod<COMMAND_RPC_START_MINING>(&RpcServer::on_start_mining), false } },
   { "/stop_mining", { jsonMethod<COMMAND_RPC_STOP_MINING>(&RpcServer::on_stop_mining), false } },
+  { "/get_mining_statistics", { jsonMethod<COMMAND_RPC_GET_MINING_STATISTICS>(&RpcServer::on_get_mining_statistics), true } },
   { "/stop_daemon", { jsonMethod<COMMAND_RPC_STOP_DAEMON>(&RpcServer::on_stop_daemon), true } },
 
   // json rpc
@@ -196,18 +197,18 @@ bool RpcServer::on_get_blocks(const COMMAND_RPC_GET_BLOCKS_FAST::request& req, C
   res.current_height = totalBlockCount;
   res.start_height = startBlockIndex;
 
+  res.blocks.reserve(supplement.size());
   for (const auto& blockId : supplement) {
-    assert(m_core.have_block(blockId));
-    auto completeBlock = m_core.getBlock(blockId);
-    assert(completeBlock != nullptr);
+    auto block = m_core.getSerializedBlock(blockId);
+    if (block == nullptr) {
+      // the chain was switched after the supplement was found
+      res.status = "Failed";
+      return false;
+    }
 
     res.blocks.resize(res.blocks.size() + 1);
-    res.blocks.back().block = asString(toBinaryArray(completeBlock->getBlock()));
-
-    res.blocks.back().txs.reserve(completeBlock->getTransactionCount());
-    for (size_t i = 0; i < completeBlock->getTransactionCount(); ++i) {
-      res.blocks.back().txs.push_back(asString(toBinaryArray(completeBlock->getTransaction(i))));
-    }
+    res.blocks.back().block = block->block;
+    res.blocks.back().txs.assign(block->transactions.begin(), block->transactions.end());
   }
 
   res.status = CORE_RPC_STATUS_OK;
@@ -321,13 +322,18 @@ bool RpcServer::on_get_info(const COMMAND_RPC_GET_INFO::request& req, COMMAND_RP
   res.height = m_core.get_current_blockchain_height();
   res.difficulty = m_core.getNextBlockDifficulty();
   res.tx_count = m_core.get_blockchain_total_transactions() - res.height; //without coinbase
-  res.tx_pool_size = m_core.get_pool_transactions_count();
+  tx_memory_pool::PoolStatistics poolStatistics = m_core.getPoolStatistics();
+  res.tx_pool_size = poolStatistics.transactionsCount;
+  res.tx_pool_bytes = poolStatistics.size;
+  res.tx_pool_max_bytes = poolStatistics.maxSize;
+  res.tx_pool_evicted_count = poolStatistics.evictedCount;
+  res.tx_pool_min_fee_per_kb = poolStatistics.minimumFeeRate;
   res.alt_blocks_count = m_core.get_alternative_blocks_count();
   uint64_t total_conn = m_p2p.get_connections_count();
   res.outgoing_connections_count = m_p2p.get_outgoing_connections_count();
   res.incoming_connections_count = total_conn - res.outgoing_connections_count;
-  res.white_peerlist_size = m_p2p.getPeerlistManager().get_white_peers_count();
-  res.grey_peerlist_size = m_p2p.getPeerlistManager().get_gray_peers_count();
+  res.white_peerlist_size = m_p2p.getWhitePeersCount();
+  res.grey_peerlist_size = m_p2p.getGrayPeersCount();
   res.last_known_block_index = std::max(static_cast<uint32_t>(1), m_protocolQuery.getObservedHeight()) - 1;
   res.full_deposit_amount = m_core.fullDepositAmount();
   res.full_deposit_interest = m_core.fullDepositInterest();
@@ -437,6 +443,28 @@ bool RpcServer::on_stop_mining(const COMMAND_RPC_STOP_MINING::request& req, COMM
   return true;
 }
 
+bool RpcServer::on_get_mining_statistics(const COMMAND_RPC_GET_MINING_STATISTICS::request& req, COMMAND_RPC_GET_MINING_STATISTICS::response& res) {
+  MinerStatistics statistics = m_core.get_miner().getStatistics();
+
+  res.mining = statistics.mining;
+  res.hashrate = statistics.hashRate;
+  for (const auto& thread : statistics.threads) {
+    mining_thread_statistics threadStatistics;
+    threadStatistics.hashes = thread.hashes;
+    threadStatistics.hashrate = thread.hashRate;
+    threadStatistics.hashing_time = thread.hashingTime;
+    threadStatistics.waiting_time = thread.waitingTime;
+    res.threads.push_back(threadStatistics);
+  }
+
+  res.blocks_found = statistics.blocksFound;
+  res.blocks_rejected = statistics.blocksRejected;
+  res.last_template_age = statistics.lastTemplateAge;
+  res.average_template_age = statistics.averageTemplateAge;
+  res.status = CORE_RPC_STATUS_OK;
+  return true;
+}
+
 bool RpcServer::on_stop_daemon(const COMMAND_RPC_STOP_DAEMON::request& req, COMMAND_RPC_STOP_DAEMON::response& res) {
   if (m_core.currency().isTestnet()) {
     m_p2p.sendStopSignal();
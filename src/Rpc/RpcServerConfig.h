@@ -23,6 +23,8 @@ public:
 
   std::string bindIp;
   uint16_t bindPort;
+  // each thread runs its own dispatcher, apart from the p2p one
+  uint32_t threads;
 };
 
 }
@@ -0,0 +1,105 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2014-2017 XDN developers
+// Copyright (c) 2016-2017 BXC developers
+// Copyright (c) 2017 Doppler developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "RpcServerPool.h"
+
+#include <System/Dispatcher.h>
+#include <System/Event.h>
+#include "Common/ScopeExit.h"
+
+#include "RpcServer.h"
+
+using namespace Logging;
+
+namespace CryptoNote {
+
+RpcServerPool::RpcServerPool(Logging::ILogger& log, core& c, NodeServer& p2p, const ICryptoNoteProtocolQuery& protocolQuery) :
+  m_log(log), logger(log, "RpcServerPool"), m_core(c), m_p2p(p2p), m_protocolQuery(protocolQuery) {
+}
+
+RpcServerPool::~RpcServerPool() {
+  stop();
+}
+
+void RpcServerPool::start(const std::string& address, uint16_t port, size_t threadCount) {
+  for (size_t i = 0; i < threadCount; ++i) {
+    std::unique_ptr<Worker> worker(new Worker());
+    worker->dispatcher = nullptr;
+    worker->stopEvent = nullptr;
+    auto started = worker->started.get_future();
+    worker->thread = std::thread(&RpcServerPool::run, this, std::ref(*worker), address, port, threadCount > 1);
+
+    try {
+      started.get();
+    } catch (std::exception&) {
+      worker->thread.join();
+      stop();
+      throw;
+    }
+
+    m_workers.push_back(std::move(worker));
+  }
+
+  logger(DEBUGGING) << "RPC server is running on " << threadCount << " threads";
+}
+
+void RpcServerPool::stop() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto& worker : m_workers) {
+      if (worker->dispatcher != nullptr) {
+        System::Event* stopEvent = worker->stopEvent;
+        worker->dispatcher->remoteSpawn([stopEvent] {
+          stopEvent->set();
+        });
+      }
+    }
+  }
+
+  for (auto& worker : m_workers) {
+    worker->thread.join();
+  }
+
+  m_workers.clear();
+}
+
+void RpcServerPool::run(Worker& worker, const std::string& address, uint16_t port, bool reusePort) {
+  bool running = false;
+  try {
+    System::Dispatcher dispatcher;
+    System::Event stopEvent(dispatcher);
+    RpcServer server(dispatcher, m_log, m_core, m_p2p, m_protocolQuery);
+    server.start(address, port, "", "", reusePort);
+
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      worker.dispatcher = &dispatcher;
+      worker.stopEvent = &stopEvent;
+    }
+
+    // cleared before the dispatcher is destroyed, also when the server fails
+    Tools::ScopeExit detach([this, &worker] {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      worker.dispatcher = nullptr;
+      worker.stopEvent = nullptr;
+    });
+
+    running = true;
+    worker.started.set_value();
+
+    stopEvent.wait();
+    server.stop();
+  } catch (std::exception& e) {
+    if (!running) {
+      worker.started.set_exception(std::current_exception());
+    } else {
+      logger(ERROR, BRIGHT_RED) << "RPC server thread failed: " << e.what();
+    }
+  }
+}
+
+}
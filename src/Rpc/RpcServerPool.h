@@ -0,0 +1,62 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2014-2017 XDN developers
+// Copyright (c) 2016-2017 BXC developers
+// Copyright (c) 2017 Doppler developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <Logging/LoggerRef.h>
+
+namespace System {
+class Dispatcher;
+class Event;
+}
+
+namespace CryptoNote {
+
+class core;
+class NodeServer;
+class ICryptoNoteProtocolQuery;
+
+// Runs an RpcServer on each of its threads, every one with its own dispatcher, so slow requests never hold up
+// the p2p dispatcher. With several threads the servers share the port and the kernel spreads connections among them.
+class RpcServerPool {
+public:
+  RpcServerPool(Logging::ILogger& log, core& c, NodeServer& p2p, const ICryptoNoteProtocolQuery& protocolQuery);
+  ~RpcServerPool();
+
+  // throws when a server can't start, the servers already running are stopped then
+  void start(const std::string& address, uint16_t port, size_t threadCount);
+  // safe to call again, a worker whose thread has failed is skipped
+  void stop();
+
+private:
+  struct Worker {
+    std::thread thread;
+    std::promise<void> started;
+    // set by the thread while its dispatcher exists, guarded by m_mutex
+    System::Dispatcher* dispatcher;
+    System::Event* stopEvent;
+  };
+
+  void run(Worker& worker, const std::string& address, uint16_t port, bool reusePort);
+
+  Logging::ILogger& m_log;
+  Logging::LoggerRef logger;
+  core& m_core;
+  NodeServer& m_p2p;
+  const ICryptoNoteProtocolQuery& m_protocolQuery;
+  std::mutex m_mutex;
+  std::vector<std::unique_ptr<Worker>> m_workers;
+};
+
+}
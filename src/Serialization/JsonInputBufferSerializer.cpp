@@ -0,0 +1,598 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2014-2017 XDN developers
+// Copyright (c) 2016-2017 BXC developers
+// Copyright (c) 2017 Doppler developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "JsonInputBufferSerializer.h"
+
+#include <algorithm>
+#include <cassert>
+#include <sstream>
+#include <stdexcept>
+#include "Common/StringTools.h"
+
+using namespace Common;
+using namespace CryptoNote;
+
+namespace {
+
+// skipping is recursive, deeper data would only exhaust the stack
+const size_t MAX_NESTING_DEPTH = 100;
+
+bool isDigit(char c) {
+  return c >= '0' && c <= '9';
+}
+
+unsigned readHex4(const char* data) {
+  unsigned value = 0;
+  for (size_t i = 0; i < 4; ++i) {
+    value = value << 4 | Common::fromHex(data[i]);
+  }
+
+  return value;
+}
+
+void appendUtf8(unsigned codePoint, std::string& text) {
+  if (codePoint < 0x80) {
+    text += static_cast<char>(codePoint);
+  } else if (codePoint < 0x800) {
+    text += static_cast<char>(0xc0 | codePoint >> 6);
+    text += static_cast<char>(0x80 | (codePoint & 0x3f));
+  } else if (codePoint < 0x10000) {
+    text += static_cast<char>(0xe0 | codePoint >> 12);
+    text += static_cast<char>(0x80 | (codePoint >> 6 & 0x3f));
+    text += static_cast<char>(0x80 | (codePoint & 0x3f));
+  } else {
+    text += static_cast<char>(0xf0 | codePoint >> 18);
+    text += static_cast<char>(0x80 | (codePoint >> 12 & 0x3f));
+    text += static_cast<char>(0x80 | (codePoint >> 6 & 0x3f));
+    text += static_cast<char>(0x80 | (codePoint & 0x3f));
+  }
+}
+
+// the escapes were validated when the string was skipped
+void unescape(StringView raw, std::string& value) {
+  const char* data = raw.getData();
+  size_t size = raw.getSize();
+  value.clear();
+  size_t begin = 0;
+  for (size_t i = 0; i < size; ++i) {
+    if (data[i] != '\\') {
+      continue;
+    }
+
+    value.append(data + begin, i - begin);
+    char c = data[++i];
+    switch (c) {
+    case 'b': value += '\b'; break;
+    case 'f': value += '\f'; break;
+    case 'n': value += '\n'; break;
+    case 'r': value += '\r'; break;
+    case 't': value += '\t'; break;
+    case 'u': {
+      unsigned codePoint = readHex4(data + i + 1);
+      i += 4;
+      if (codePoint >= 0xd800 && codePoint < 0xdc00 && i + 6 < size && data[i + 1] == '\\' && data[i + 2] == 'u') {
+        unsigned low = readHex4(data + i + 3);
+        if (low >= 0xdc00 && low < 0xe000) {
+          codePoint = 0x10000 + ((codePoint - 0xd800) << 10) + (low - 0xdc00);
+          i += 6;
+        }
+      }
+
+      appendUtf8(codePoint, value);
+      break;
+    }
+    default:
+      value += c;
+      break;
+    }
+
+    begin = i + 1;
+  }
+
+  value.append(data + begin, size - begin);
+}
+
+}
+
+JsonInputBufferSerializer::JsonInputBufferSerializer(const void* data, size_t size) :
+  m_data(static_cast<const char*>(data)), m_size(size) {
+  size_t offset = skipSpace(0);
+  if (at(offset) != '{') {
+    throw std::runtime_error("Serializer doesn't support this type of serialization: Object expected.");
+  }
+
+  // the root object is indexed and the whole text is walked, so malformed data fails here
+  offset = skipSpace(indexObject(offset, 0));
+  if (offset != m_size) {
+    throw std::runtime_error("Unexpected data after JSON object");
+  }
+
+  m_frames.push_back({ false, 0, 0, 0 });
+}
+
+ISerializer::SerializerType JsonInputBufferSerializer::type() const {
+  return ISerializer::INPUT;
+}
+
+bool JsonInputBufferSerializer::beginObject(Common::StringView name) {
+  size_t offset;
+  if (!findValue(name, offset)) {
+    return false;
+  }
+
+  if (m_data[offset] != '{') {
+    throw std::runtime_error("Value type is not object");
+  }
+
+  size_t begin = m_entries.size();
+  valueRead(indexObject(offset, m_frames.size()));
+  m_frames.push_back({ false, begin, 0, 0 });
+  return true;
+}
+
+void JsonInputBufferSerializer::endObject() {
+  assert(m_frames.size() > 1 && !m_frames.back().isArray);
+  m_entries.resize(m_frames.back().begin);
+  m_frames.pop_back();
+}
+
+bool JsonInputBufferSerializer::beginArray(size_t& size, Common::StringView name) {
+  size = 0;
+  size_t offset;
+  if (m_frames.back().isArray) {
+    if (!findValue(name, offset)) {
+      return false;
+    }
+
+    if (m_data[offset] != '[') {
+      throw std::runtime_error("Value type is not array");
+    }
+
+    // the items of an array in an array aren't counted when the outer one is skipped
+    valueRead(skipArray(offset, m_frames.size(), size));
+  } else {
+    Frame& frame = m_frames.back();
+    auto end = m_entries.end();
+    auto it = std::find_if(m_entries.begin() + frame.begin, end, [&](const Entry& entry) { return entry.name == name; });
+    if (it == end) {
+      return false;
+    }
+
+    offset = it->offset;
+    if (m_data[offset] != '[') {
+      throw std::runtime_error("Value type is not array");
+    }
+
+    size = it->count;
+  }
+
+  m_frames.push_back({ true, 0, size, skipSpace(offset + 1) });
+  return true;
+}
+
+void JsonInputBufferSerializer::endArray() {
+  assert(m_frames.size() > 1 && m_frames.back().isArray);
+  m_frames.pop_back();
+}
+
+bool JsonInputBufferSerializer::operator()(uint8_t& value, Common::StringView name) {
+  return getNumber(name, value);
+}
+
+bool JsonInputBufferSerializer::operator()(int16_t& value, Common::StringView name) {
+  return getNumber(name, value);
+}
+
+bool JsonInputBufferSerializer::operator()(uint16_t& value, Common::StringView name) {
+  return getNumber(name, value);
+}
+
+bool JsonInputBufferSerializer::operator()(int32_t& value, Common::StringView name) {
+  return getNumber(name, value);
+}
+
+bool JsonInputBufferSerializer::operator()(uint32_t& value, Common::StringView name) {
+  return getNumber(name, value);
+}
+
+bool JsonInputBufferSerializer::operator()(int64_t& value, Common::StringView name) {
+  return getNumber(name, value);
+}
+
+bool JsonInputBufferSerializer::operator()(uint64_t& value, Common::StringView name) {
+  return getNumber(name, value);
+}
+
+bool JsonInputBufferSerializer::operator()(double& value, Common::StringView name) {
+  size_t offset;
+  if (!findValue(name, offset)) {
+    return false;
+  }
+
+  if (m_data[offset] != '-' && !isDigit(m_data[offset])) {
+    throw std::runtime_error("Value type is not number");
+  }
+
+  size_t end = skipNumber(offset);
+  std::istringstream(std::string(m_data + offset, end - offset)) >> value;
+  valueRead(end);
+  return true;
+}
+
+bool JsonInputBufferSerializer::operator()(bool& value, Common::StringView name) {
+  size_t offset;
+  if (!findValue(name, offset)) {
+    return false;
+  }
+
+  if (m_data[offset] == 't') {
+    value = true;
+    offset += 4;
+  } else if (m_data[offset] == 'f') {
+    value = false;
+    offset += 5;
+  } else {
+    throw std::runtime_error("Value type is not bool");
+  }
+
+  valueRead(offset);
+  return true;
+}
+
+bool JsonInputBufferSerializer::operator()(std::string& value, Common::StringView name) {
+  StringView str;
+  if (!readString(name, str)) {
+    return false;
+  }
+
+  unescape(str, value);
+  return true;
+}
+
+bool JsonInputBufferSerializer::binary(void* value, size_t size, Common::StringView name) {
+  StringView str;
+  if (!readString(name, str)) {
+    return false;
+  }
+
+  if ((str.getSize() & 1) != 0 || str.getSize() / 2 > size) {
+    throw std::runtime_error("Binary block size mismatch");
+  }
+
+  for (size_t i = 0; i < str.getSize() / 2; ++i) {
+    static_cast<uint8_t*>(value)[i] = Common::fromHex(str[i * 2]) << 4 | Common::fromHex(str[i * 2 + 1]);
+  }
+
+  return true;
+}
+
+bool JsonInputBufferSerializer::binary(std::string& value, Common::StringView name) {
+  StringView str;
+  if (!readString(name, str)) {
+    return false;
+  }
+
+  if ((str.getSize() & 1) != 0) {
+    throw std::runtime_error("Binary block size mismatch");
+  }
+
+  value.resize(str.getSize() / 2);
+  for (size_t i = 0; i < value.size(); ++i) {
+    value[i] = static_cast<char>(Common::fromHex(str[i * 2]) << 4 | Common::fromHex(str[i * 2 + 1]));
+  }
+
+  return true;
+}
+
+size_t JsonInputBufferSerializer::indexObject(size_t offset, size_t depth) {
+  if (depth > MAX_NESTING_DEPTH) {
+    throw std::runtime_error("JSON nesting is too deep");
+  }
+
+  offset = skipSpace(offset + 1);
+  if (at(offset) == '}') {
+    return offset + 1;
+  }
+
+  for (;;) {
+    if (at(offset) != '"') {
+      throw std::runtime_error("Member name expected");
+    }
+
+    StringView name = readRawString(offset);
+    offset = skipSpace(offset);
+    if (at(offset) != ':') {
+      throw std::runtime_error("':' expected");
+    }
+
+    offset = skipSpace(offset + 1);
+    Entry entry = { name, offset, 0 };
+    if (at(offset) == '[') {
+      offset = skipArray(offset, depth + 1, entry.count);
+    } else {
+      offset = skipValue(offset, depth + 1);
+    }
+
+    m_entries.push_back(entry);
+    offset = skipSpace(offset);
+    char c = at(offset++);
+    if (c == '}') {
+      return offset;
+    }
+
+    if (c != ',') {
+      throw std::runtime_error("',' or '}' expected");
+    }
+
+    offset = skipSpace(offset);
+  }
+}
+
+size_t JsonInputBufferSerializer::skipValue(size_t offset, size_t depth) const {
+  if (depth > MAX_NESTING_DEPTH) {
+    throw std::runtime_error("JSON nesting is too deep");
+  }
+
+  char c = at(offset);
+  switch (c) {
+  case '{': {
+    offset = skipSpace(offset + 1);
+    if (at(offset) == '}') {
+      return offset + 1;
+    }
+
+    for (;;) {
+      if (at(offset) != '"') {
+        throw std::runtime_error("Member name expected");
+      }
+
+      offset = skipSpace(skipString(offset));
+      if (at(offset) != ':') {
+        throw std::runtime_error("':' expected");
+      }
+
+      offset = skipSpace(skipValue(skipSpace(offset + 1), depth + 1));
+      c = at(offset++);
+      if (c == '}') {
+        return offset;
+      }
+
+      if (c != ',') {
+        throw std::runtime_error("',' or '}' expected");
+      }
+
+      offset = skipSpace(offset);
+    }
+  }
+  case '[': {
+    size_t count;
+    return skipArray(offset, depth + 1, count);
+  }
+  case '"':
+    return skipString(offset);
+  case 't':
+    return skipLiteral(offset, "true");
+  case 'f':
+    return skipLiteral(offset, "false");
+  case 'n':
+    return skipLiteral(offset, "null");
+  default:
+    if (c == '-' || isDigit(c)) {
+      return skipNumber(offset);
+    }
+
+    throw std::runtime_error("Unexpected character in JSON");
+  }
+}
+
+size_t JsonInputBufferSerializer::skipArray(size_t offset, size_t depth, size_t& count) const {
+  count = 0;
+  offset = skipSpace(offset + 1);
+  if (at(offset) == ']') {
+    return offset + 1;
+  }
+
+  for (;;) {
+    offset = skipSpace(skipValue(offset, depth));
+    ++count;
+    char c = at(offset++);
+    if (c == ']') {
+      return offset;
+    }
+
+    if (c != ',') {
+      throw std::runtime_error("',' or ']' expected");
+    }
+
+    offset = skipSpace(offset);
+  }
+}
+
+size_t JsonInputBufferSerializer::skipString(size_t offset) const {
+  for (++offset;; ++offset) {
+    unsigned char c = static_cast<unsigned char>(at(offset));
+    if (c == '"') {
+      return offset + 1;
+    }
+
+    if (c < 0x20) {
+      throw std::runtime_error("Control character in JSON string");
+    }
+
+    if (c == '\\') {
+      c = static_cast<unsigned char>(at(++offset));
+      if (c == 'u') {
+        for (size_t i = 0; i < 4; ++i) {
+          uint8_t digit;
+          if (!Common::fromHex(at(++offset), digit)) {
+            throw std::runtime_error("Invalid escape in JSON string");
+          }
+        }
+      } else if (c != '"' && c != '\\' && c != '/' && c != 'b' && c != 'f' && c != 'n' && c != 'r' && c != 't') {
+        throw std::runtime_error("Invalid escape in JSON string");
+      }
+    }
+  }
+}
+
+size_t JsonInputBufferSerializer::skipNumber(size_t offset) const {
+  if (m_data[offset] == '-') {
+    ++offset;
+  }
+
+  if (at(offset) == '0') {
+    ++offset;
+  } else if (isDigit(at(offset))) {
+    while (offset < m_size && isDigit(m_data[offset])) {
+      ++offset;
+    }
+  } else {
+    throw std::runtime_error("Invalid JSON number");
+  }
+
+  if (offset < m_size && m_data[offset] == '.') {
+    if (!isDigit(at(++offset))) {
+      throw std::runtime_error("Invalid JSON number");
+    }
+
+    while (offset < m_size && isDigit(m_data[offset])) {
+      ++offset;
+    }
+  }
+
+  if (offset < m_size && (m_data[offset] == 'e' || m_data[offset] == 'E')) {
+    ++offset;
+    if (at(offset) == '+' || at(offset) == '-') {
+      ++offset;
+    }
+
+    if (!isDigit(at(offset))) {
+      throw std::runtime_error("Invalid JSON number");
+    }
+
+    while (offset < m_size && isDigit(m_data[offset])) {
+      ++offset;
+    }
+  }
+
+  return offset;
+}
+
+size_t JsonInputBufferSerializer::skipLiteral(size_t offset, const char* literal) const {
+  for (; *literal != '\0'; ++literal, ++offset) {
+    if (at(offset) != *literal) {
+      throw std::runtime_error("Unexpected character in JSON");
+    }
+  }
+
+  return offset;
+}
+
+size_t JsonInputBufferSerializer::skipSpace(size_t offset) const {
+  while (offset < m_size && (m_data[offset] == ' ' || m_data[offset] == '\n' || m_data[offset] == '\r' || m_data[offset] == '\t')) {
+    ++offset;
+  }
+
+  return offset;
+}
+
+char JsonInputBufferSerializer::at(size_t offset) const {
+  if (offset >= m_size) {
+    throw std::runtime_error("Unexpected end of JSON");
+  }
+
+  return m_data[offset];
+}
+
+int64_t JsonInputBufferSerializer::readInteger(size_t& offset) const {
+  // the number was validated when it was skipped, only a fraction or an exponent can follow the digits
+  bool negative = m_data[offset] == '-';
+  size_t begin = negative ? offset + 1 : offset;
+  if (begin >= m_size || !isDigit(m_data[begin])) {
+    throw std::runtime_error("Value type is not integer");
+  }
+
+  uint64_t value = 0;
+  size_t end = begin;
+  for (; end < m_size && isDigit(m_data[end]); ++end) {
+    uint64_t digit = static_cast<uint64_t>(m_data[end] - '0');
+    if (value > (UINT64_MAX - digit) / 10) {
+      throw std::runtime_error("Integer is out of range");
+    }
+
+    value = value * 10 + digit;
+  }
+
+  if (end < m_size && (m_data[end] == '.' || m_data[end] == 'e' || m_data[end] == 'E')) {
+    throw std::runtime_error("Value type is not integer");
+  }
+
+  offset = end;
+  if (negative) {
+    if (value > static_cast<uint64_t>(INT64_MAX) + 1) {
+      throw std::runtime_error("Integer is out of range");
+    }
+
+    return static_cast<int64_t>(0 - value);
+  }
+
+  // unsigned values past INT64_MAX come back unchanged through the cast of the caller
+  return static_cast<int64_t>(value);
+}
+
+Common::StringView JsonInputBufferSerializer::readRawString(size_t& offset) const {
+  size_t begin = offset + 1;
+  offset = skipString(offset);
+  return StringView(m_data + begin, offset - 1 - begin);
+}
+
+bool JsonInputBufferSerializer::findValue(Common::StringView name, size_t& offset) {
+  Frame& frame = m_frames.back();
+  if (frame.isArray) {
+    if (frame.count == 0) {
+      throw std::runtime_error("Array index is out of range");
+    }
+
+    --frame.count;
+    offset = frame.offset;
+    return true;
+  }
+
+  auto end = m_entries.end();
+  auto it = std::find_if(m_entries.begin() + frame.begin, end, [&](const Entry& entry) { return entry.name == name; });
+  if (it == end) {
+    return false;
+  }
+
+  offset = it->offset;
+  return true;
+}
+
+void JsonInputBufferSerializer::valueRead(size_t offset) {
+  Frame& frame = m_frames.back();
+  if (frame.isArray && frame.count != 0) {
+    // the separator was validated when the array was skipped
+    offset = skipSpace(offset);
+    assert(m_data[offset] == ',');
+    frame.offset = skipSpace(offset + 1);
+  }
+}
+
+bool JsonInputBufferSerializer::readString(Common::StringView name, Common::StringView& value) {
+  size_t offset;
+  if (!findValue(name, offset)) {
+    return false;
+  }
+
+  if (m_data[offset] != '"') {
+    throw std::runtime_error("Value type is not string");
+  }
+
+  value = readRawString(offset);
+  valueRead(offset);
+  return true;
+}
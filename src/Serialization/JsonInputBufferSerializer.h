@@ -0,0 +1,99 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2014-2017 XDN developers
+// Copyright (c) 2016-2017 BXC developers
+// Copyright (c) 2017 Doppler developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include "ISerializer.h"
+
+namespace CryptoNote {
+
+// Reads the root object of a JSON text in place, without building a JsonValue. The text is validated in a single
+// pass while the members of the root object are indexed, an object is indexed the same way when it is entered.
+class JsonInputBufferSerializer : public ISerializer {
+public:
+  // the storage isn't copied and has to outlive the serializer
+  JsonInputBufferSerializer(const void* data, size_t size);
+
+  virtual SerializerType type() const override;
+
+  virtual bool beginObject(Common::StringView name) override;
+  virtual void endObject() override;
+
+  virtual bool beginArray(size_t& size, Common::StringView name) override;
+  virtual void endArray() override;
+
+  virtual bool operator()(uint8_t& value, Common::StringView name) override;
+  virtual bool operator()(int16_t& value, Common::StringView name) override;
+  virtual bool operator()(uint16_t& value, Common::StringView name) override;
+  virtual bool operator()(int32_t& value, Common::StringView name) override;
+  virtual bool operator()(uint32_t& value, Common::StringView name) override;
+  virtual bool operator()(int64_t& value, Common::StringView name) override;
+  virtual bool operator()(uint64_t& value, Common::StringView name) override;
+  virtual bool operator()(double& value, Common::StringView name) override;
+  virtual bool operator()(bool& value, Common::StringView name) override;
+  virtual bool operator()(std::string& value, Common::StringView name) override;
+  virtual bool binary(void* value, size_t size, Common::StringView name) override;
+  virtual bool binary(std::string& value, Common::StringView name) override;
+
+  template<typename T>
+  bool operator()(T& value, Common::StringView name) {
+    return ISerializer::operator()(value, name);
+  }
+
+private:
+  // the offsets point to the first character of the values, count is the number of items of an array value
+  struct Entry {
+    Common::StringView name;
+    size_t offset;
+    size_t count;
+  };
+
+  // an open object owns the entries from begin to the end of m_entries, an open array reads its items in order
+  struct Frame {
+    bool isArray;
+    size_t begin;
+    size_t count;
+    size_t offset;
+  };
+
+  size_t indexObject(size_t offset, size_t depth);
+  size_t skipValue(size_t offset, size_t depth) const;
+  size_t skipArray(size_t offset, size_t depth, size_t& count) const;
+  size_t skipString(size_t offset) const;
+  size_t skipNumber(size_t offset) const;
+  size_t skipLiteral(size_t offset, const char* literal) const;
+  size_t skipSpace(size_t offset) const;
+  char at(size_t offset) const;
+
+  int64_t readInteger(size_t& offset) const;
+  Common::StringView readRawString(size_t& offset) const;
+
+  bool findValue(Common::StringView name, size_t& offset);
+  void valueRead(size_t offset);
+  bool readString(Common::StringView name, Common::StringView& value);
+
+  template <typename T>
+  bool getNumber(Common::StringView name, T& value) {
+    size_t offset;
+    if (!findValue(name, offset)) {
+      return false;
+    }
+
+    value = static_cast<T>(readInteger(offset));
+    valueRead(offset);
+    return true;
+  }
+
+  const char* m_data;
+  size_t m_size;
+  std::vector<Entry> m_entries;
+  std::vector<Frame> m_frames;
+};
+
+}
@@ -0,0 +1,205 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2014-2017 XDN developers
+// Copyright (c) 2016-2017 BXC developers
+// Copyright (c) 2017 Doppler developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "JsonOutputBufferSerializer.h"
+
+#include <cassert>
+#include <cstdio>
+#include "Common/StringTools.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+const char HEX_DIGITS[] = "0123456789abcdef";
+
+}
+
+JsonOutputBufferSerializer::JsonOutputBufferSerializer(std::string& buffer) : m_buffer(buffer) {
+  m_buffer += '{';
+  m_levels.push_back({ false, true });
+}
+
+ISerializer::SerializerType JsonOutputBufferSerializer::type() const {
+  return ISerializer::OUTPUT;
+}
+
+bool JsonOutputBufferSerializer::beginObject(Common::StringView name) {
+  beginValue(name);
+  m_buffer += '{';
+  m_levels.push_back({ false, true });
+  return true;
+}
+
+void JsonOutputBufferSerializer::endObject() {
+  assert(m_levels.size() > 1 && !m_levels.back().isArray);
+  m_buffer += '}';
+  m_levels.pop_back();
+}
+
+bool JsonOutputBufferSerializer::beginArray(size_t& size, Common::StringView name) {
+  beginValue(name);
+  m_buffer += '[';
+  m_levels.push_back({ true, true });
+  return true;
+}
+
+void JsonOutputBufferSerializer::endArray() {
+  assert(m_levels.size() > 1 && m_levels.back().isArray);
+  m_buffer += ']';
+  m_levels.pop_back();
+}
+
+bool JsonOutputBufferSerializer::operator()(uint8_t& value, Common::StringView name) {
+  beginValue(name);
+  writeInteger(value);
+  return true;
+}
+
+bool JsonOutputBufferSerializer::operator()(int16_t& value, Common::StringView name) {
+  beginValue(name);
+  writeInteger(value);
+  return true;
+}
+
+bool JsonOutputBufferSerializer::operator()(uint16_t& value, Common::StringView name) {
+  beginValue(name);
+  writeInteger(value);
+  return true;
+}
+
+bool JsonOutputBufferSerializer::operator()(int32_t& value, Common::StringView name) {
+  beginValue(name);
+  writeInteger(value);
+  return true;
+}
+
+bool JsonOutputBufferSerializer::operator()(uint32_t& value, Common::StringView name) {
+  beginValue(name);
+  writeInteger(value);
+  return true;
+}
+
+bool JsonOutputBufferSerializer::operator()(int64_t& value, Common::StringView name) {
+  beginValue(name);
+  writeInteger(value);
+  return true;
+}
+
+bool JsonOutputBufferSerializer::operator()(uint64_t& value, Common::StringView name) {
+  // written as signed the same way JsonOutputStreamSerializer does, so the readers of JsonValue still parse it
+  beginValue(name);
+  writeInteger(static_cast<int64_t>(value));
+  return true;
+}
+
+bool JsonOutputBufferSerializer::operator()(double& value, Common::StringView name) {
+  beginValue(name);
+  // the same text as JsonValue gives for a real
+  char text[400];
+  int size = snprintf(text, sizeof(text), "%.11f", value);
+  assert(size > 0 && static_cast<size_t>(size) < sizeof(text));
+  while (size > 1 && text[size - 2] != '.' && text[size - 1] == '0') {
+    --size;
+  }
+
+  m_buffer.append(text, size);
+  return true;
+}
+
+bool JsonOutputBufferSerializer::operator()(bool& value, Common::StringView name) {
+  beginValue(name);
+  m_buffer += value ? "true" : "false";
+  return true;
+}
+
+bool JsonOutputBufferSerializer::operator()(std::string& value, Common::StringView name) {
+  beginValue(name);
+  writeString(value.data(), value.size());
+  return true;
+}
+
+bool JsonOutputBufferSerializer::binary(void* value, size_t size, Common::StringView name) {
+  beginValue(name);
+  m_buffer += '"';
+  Common::toHex(value, size, m_buffer);
+  m_buffer += '"';
+  return true;
+}
+
+bool JsonOutputBufferSerializer::binary(std::string& value, Common::StringView name) {
+  return binary(const_cast<char*>(value.data()), value.size(), name);
+}
+
+void JsonOutputBufferSerializer::finish() {
+  assert(m_levels.size() == 1);
+  m_buffer += '}';
+  m_levels.pop_back();
+}
+
+void JsonOutputBufferSerializer::beginValue(Common::StringView name) {
+  assert(!m_levels.empty());
+  Level& level = m_levels.back();
+  if (!level.empty) {
+    m_buffer += ',';
+  }
+
+  level.empty = false;
+  if (!level.isArray) {
+    writeString(name.getData(), name.getSize());
+    m_buffer += ':';
+  }
+}
+
+void JsonOutputBufferSerializer::writeInteger(int64_t value) {
+  char text[20];
+  char* end = text + sizeof(text);
+  char* begin = end;
+  uint64_t magnitude = value < 0 ? 0 - static_cast<uint64_t>(value) : static_cast<uint64_t>(value);
+  do {
+    *--begin = static_cast<char>('0' + magnitude % 10);
+    magnitude /= 10;
+  } while (magnitude != 0);
+
+  if (value < 0) {
+    m_buffer += '-';
+  }
+
+  m_buffer.append(begin, end);
+}
+
+void JsonOutputBufferSerializer::writeString(const char* data, size_t size) {
+  m_buffer += '"';
+  size_t begin = 0;
+  for (size_t i = 0; i < size; ++i) {
+    unsigned char c = static_cast<unsigned char>(data[i]);
+    if (c >= 0x20 && c != '"' && c != '\\') {
+      continue;
+    }
+
+    m_buffer.append(data + begin, i - begin);
+    begin = i + 1;
+    m_buffer += '\\';
+    switch (c) {
+    case '"': m_buffer += '"'; break;
+    case '\\': m_buffer += '\\'; break;
+    case '\b': m_buffer += 'b'; break;
+    case '\f': m_buffer += 'f'; break;
+    case '\n': m_buffer += 'n'; break;
+    case '\r': m_buffer += 'r'; break;
+    case '\t': m_buffer += 't'; break;
+    default:
+      m_buffer += "u00";
+      m_buffer += HEX_DIGITS[c >> 4];
+      m_buffer += HEX_DIGITS[c & 0x0f];
+      break;
+    }
+  }
+
+  m_buffer.append(data + begin, size - begin);
+  m_buffer += '"';
+}
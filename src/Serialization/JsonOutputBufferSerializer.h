@@ -0,0 +1,65 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2014-2017 XDN developers
+// Copyright (c) 2016-2017 BXC developers
+// Copyright (c) 2017 Doppler developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include "ISerializer.h"
+
+namespace CryptoNote {
+
+// Writes the JSON text of the root object straight into the buffer as the values come, without building a JsonValue
+class JsonOutputBufferSerializer : public ISerializer {
+public:
+  // the root object is appended to the buffer, the buffer has to outlive the serializer
+  explicit JsonOutputBufferSerializer(std::string& buffer);
+
+  virtual SerializerType type() const override;
+
+  virtual bool beginObject(Common::StringView name) override;
+  virtual void endObject() override;
+
+  virtual bool beginArray(size_t& size, Common::StringView name) override;
+  virtual void endArray() override;
+
+  virtual bool operator()(uint8_t& value, Common::StringView name) override;
+  virtual bool operator()(int16_t& value, Common::StringView name) override;
+  virtual bool operator()(uint16_t& value, Common::StringView name) override;
+  virtual bool operator()(int32_t& value, Common::StringView name) override;
+  virtual bool operator()(uint32_t& value, Common::StringView name) override;
+  virtual bool operator()(int64_t& value, Common::StringView name) override;
+  virtual bool operator()(uint64_t& value, Common::StringView name) override;
+  virtual bool operator()(double& value, Common::StringView name) override;
+  virtual bool operator()(bool& value, Common::StringView name) override;
+  virtual bool operator()(std::string& value, Common::StringView name) override;
+  virtual bool binary(void* value, size_t size, Common::StringView name) override;
+  virtual bool binary(std::string& value, Common::StringView name) override;
+
+  template<typename T>
+  bool operator()(T& value, Common::StringView name) {
+    return ISerializer::operator()(value, name);
+  }
+
+  // closes the root object, nothing can be written after
+  void finish();
+
+private:
+  struct Level {
+    bool isArray;
+    bool empty;
+  };
+
+  void beginValue(Common::StringView name);
+  void writeInteger(int64_t value);
+  void writeString(const char* data, size_t size);
+
+  std::string& m_buffer;
+  std::vector<Level> m_levels;
+};
+
+}
@@ -11,7 +11,6 @@
 #include <cassert>
 #include <cstring>
 #include <stdexcept>
-#include <Common/StreamTools.h>
 #include "KVBinaryCommon.h"
 
 using namespace Common;
@@ -19,147 +18,190 @@ using namespace CryptoNote;
 
 namespace {
 
+const size_t MAX_STRING_SIZE = 100 * 1024 * 1024;
+// skipping is recursive, deeper data would only exhaust the stack
+const size_t MAX_NESTING_DEPTH = 100;
+
 template <typename T>
-T readPod(Common::IInputStream& s) {
+T readPod(const uint8_t* data) {
   T v;
-  read(s, &v, sizeof(T));
+  memcpy(&v, data, sizeof(T));
   return v;
 }
 
-template <typename T, typename JsonT = T>
-JsonValue readPodJson(Common::IInputStream& s) {
-  JsonValue jv;
-  jv = static_cast<JsonT>(readPod<T>(s));
-  return jv;
 }
 
-template <typename T>
-JsonValue readIntegerJson(Common::IInputStream& s) {
-  return readPodJson<T, int64_t>(s);
+KVBinaryInputStreamSerializer::KVBinaryInputStreamSerializer(const void* data, size_t size) :
+  m_data(static_cast<const uint8_t*>(data)), m_size(size) {
+  parseStorage();
 }
 
-size_t readVarint(Common::IInputStream& s) {
-  uint8_t b = read<uint8_t>(s);
-  uint8_t size_mask = b & PORTABLE_RAW_SIZE_MARK_MASK;
-  size_t bytesLeft = 0;
+KVBinaryInputStreamSerializer::KVBinaryInputStreamSerializer(Common::IInputStream& strm) {
+  size_t size = 0;
+  for (;;) {
+    m_storage.resize(std::max<size_t>(size * 2, 4096));
+    size_t read = strm.readSome(&m_storage[size], m_storage.size() - size);
+    if (read == 0) {
+      break;
+    }
 
-  switch (size_mask){
-  case PORTABLE_RAW_SIZE_MARK_BYTE:
-    bytesLeft = 0;
-    break;
-  case PORTABLE_RAW_SIZE_MARK_WORD:
-    bytesLeft = 1;
-    break;
-  case PORTABLE_RAW_SIZE_MARK_DWORD:
-    bytesLeft = 3;
-    break;
-  case PORTABLE_RAW_SIZE_MARK_INT64:
-    bytesLeft = 7;
-    break;
+    size += read;
   }
 
-  size_t value = b;
+  m_storage.resize(size);
+  m_data = reinterpret_cast<const uint8_t*>(m_storage.data());
+  m_size = m_storage.size();
+  parseStorage();
+}
 
-  for (size_t i = 1; i <= bytesLeft; ++i) {
-    size_t n = read<uint8_t>(s);
-    value |= n << (i * 8);
+ISerializer::SerializerType KVBinaryInputStreamSerializer::type() const {
+  return ISerializer::INPUT;
+}
+
+bool KVBinaryInputStreamSerializer::beginObject(Common::StringView name) {
+  uint8_t type;
+  size_t offset;
+  if (!findValue(name, type, offset)) {
+    return false;
   }
 
-  value >>= 2;
-  return value;
+  if (type != BIN_KV_SERIALIZE_TYPE_OBJECT) {
+    throw std::runtime_error("Value type is not object");
+  }
+
+  size_t begin = m_entries.size();
+  valueRead(indexSection(offset));
+  m_frames.push_back({ false, begin, 0, 0, 0 });
+  return true;
 }
 
-std::string readString(Common::IInputStream& s) {
-  auto size = readVarint(s);
-  if (size > 100 * 1024 * 1024) {
-    throw std::runtime_error("string size is too big");
+void KVBinaryInputStreamSerializer::endObject() {
+  assert(!m_frames.empty() && !m_frames.back().isArray);
+  m_entries.resize(m_frames.back().begin);
+  m_frames.pop_back();
+}
+
+bool KVBinaryInputStreamSerializer::beginArray(size_t& size, Common::StringView name) {
+  size = 0;
+  if (m_frames.back().isArray) {
+    throw std::runtime_error("Nested arrays are not supported");
+  }
+
+  uint8_t type;
+  size_t offset;
+  if (!findValue(name, type, offset)) {
+    return false;
   }
 
-  std::string str;
-  str.resize(size);
-  if (size) {
-    read(s, &str[0], size);
+  if ((type & BIN_KV_SERIALIZE_FLAG_ARRAY) == 0) {
+    throw std::runtime_error("Value type is not array");
   }
-  return str;
+
+  size = readVarint(offset);
+  m_frames.push_back({ true, 0, static_cast<uint8_t>(type & ~BIN_KV_SERIALIZE_FLAG_ARRAY), size, offset });
+  return true;
 }
 
-JsonValue readStringJson(Common::IInputStream& s) {
-  return JsonValue(readString(s));
+void KVBinaryInputStreamSerializer::endArray() {
+  assert(!m_frames.empty() && m_frames.back().isArray);
+  m_frames.pop_back();
 }
 
-void readName(Common::IInputStream& s, std::string& name) {
-  uint8_t len = readPod<uint8_t>(s);
-  if (len) {
-    name.resize(len);
-    read(s, &name[0], len);
-  }
+bool KVBinaryInputStreamSerializer::operator()(uint8_t& value, Common::StringView name) {
+  return getNumber(name, value);
 }
 
-JsonValue loadValue(Common::IInputStream& stream, uint8_t type);
-JsonValue loadSection(Common::IInputStream& stream);
-JsonValue loadEntry(Common::IInputStream& stream);
-JsonValue loadArray(Common::IInputStream& stream, uint8_t itemType);
+bool KVBinaryInputStreamSerializer::operator()(int16_t& value, Common::StringView name) {
+  return getNumber(name, value);
+}
 
+bool KVBinaryInputStreamSerializer::operator()(uint16_t& value, Common::StringView name) {
+  return getNumber(name, value);
+}
 
-JsonValue loadSection(Common::IInputStream& stream) {
-  JsonValue sec(JsonValue::OBJECT);
-  size_t count = readVarint(stream);
-  std::string name;
+bool KVBinaryInputStreamSerializer::operator()(int32_t& value, Common::StringView name) {
+  return getNumber(name, value);
+}
 
-  while (count--) {
-    readName(stream, name);
-    sec.insert(name, loadEntry(stream));
-  }
+bool KVBinaryInputStreamSerializer::operator()(uint32_t& value, Common::StringView name) {
+  return getNumber(name, value);
+}
 
-  return sec;
+bool KVBinaryInputStreamSerializer::operator()(int64_t& value, Common::StringView name) {
+  return getNumber(name, value);
 }
 
-JsonValue loadValue(Common::IInputStream& stream, uint8_t type) {
-  switch (type) {
-  case BIN_KV_SERIALIZE_TYPE_INT64:  return readIntegerJson<int64_t>(stream);
-  case BIN_KV_SERIALIZE_TYPE_INT32:  return readIntegerJson<int32_t>(stream);
-  case BIN_KV_SERIALIZE_TYPE_INT16:  return readIntegerJson<int16_t>(stream);
-  case BIN_KV_SERIALIZE_TYPE_INT8:   return readIntegerJson<int8_t>(stream);
-  case BIN_KV_SERIALIZE_TYPE_UINT64: return readIntegerJson<uint64_t>(stream);
-  case BIN_KV_SERIALIZE_TYPE_UINT32: return readIntegerJson<uint32_t>(stream);
-  case BIN_KV_SERIALIZE_TYPE_UINT16: return readIntegerJson<uint16_t>(stream);
-  case BIN_KV_SERIALIZE_TYPE_UINT8:  return readIntegerJson<uint8_t>(stream);
-  case BIN_KV_SERIALIZE_TYPE_DOUBLE: return readPodJson<double>(stream);
-  case BIN_KV_SERIALIZE_TYPE_BOOL:   return JsonValue(read<uint8_t>(stream) != 0);
-  case BIN_KV_SERIALIZE_TYPE_STRING: return readStringJson(stream);
-  case BIN_KV_SERIALIZE_TYPE_OBJECT: return loadSection(stream);
-  case BIN_KV_SERIALIZE_TYPE_ARRAY:  return loadArray(stream, type);
-  default:
-    throw std::runtime_error("Unknown data type");
-    break;
+bool KVBinaryInputStreamSerializer::operator()(uint64_t& value, Common::StringView name) {
+  return getNumber(name, value);
+}
+
+bool KVBinaryInputStreamSerializer::operator()(double& value, Common::StringView name) {
+  uint8_t type;
+  size_t offset;
+  if (!findValue(name, type, offset)) {
+    return false;
   }
+
+  if (type == BIN_KV_SERIALIZE_TYPE_DOUBLE) {
+    value = readPod<double>(read(offset, sizeof(double)));
+  } else {
+    value = static_cast<double>(readInteger(type, offset));
+  }
+
+  valueRead(offset);
+  return true;
 }
 
-JsonValue loadEntry(Common::IInputStream& stream) {
-  uint8_t type = readPod<uint8_t>(stream);
+bool KVBinaryInputStreamSerializer::operator()(bool& value, Common::StringView name) {
+  uint8_t type;
+  size_t offset;
+  if (!findValue(name, type, offset)) {
+    return false;
+  }
+
+  if (type != BIN_KV_SERIALIZE_TYPE_BOOL) {
+    throw std::runtime_error("Value type is not bool");
+  }
 
-  if (type & BIN_KV_SERIALIZE_FLAG_ARRAY) {
-    type &= ~BIN_KV_SERIALIZE_FLAG_ARRAY;
-    return loadArray(stream, type);
+  value = *read(offset, 1) != 0;
+  valueRead(offset);
+  return true;
+}
+
+bool KVBinaryInputStreamSerializer::operator()(std::string& value, Common::StringView name) {
+  StringView str;
+  if (!readString(name, str)) {
+    return false;
   }
 
-  return loadValue(stream, type);
+  value.assign(str.getData(), str.getSize());
+  return true;
 }
 
-JsonValue loadArray(Common::IInputStream& stream, uint8_t itemType) {
-  JsonValue arr(JsonValue::ARRAY);
-  size_t count = readVarint(stream);
+bool KVBinaryInputStreamSerializer::binary(void* value, size_t size, Common::StringView name) {
+  StringView str;
+  if (!readString(name, str)) {
+    return false;
+  }
 
-  while (count--) {
-    arr.pushBack(loadValue(stream, itemType));
+  if (str.getSize() != size) {
+    throw std::runtime_error("Binary block size mismatch");
+  }
+
+  if (size != 0) {
+    memcpy(value, str.getData(), size);
   }
 
-  return arr;
+  return true;
 }
 
+bool KVBinaryInputStreamSerializer::binary(std::string& value, Common::StringView name) {
+  return (*this)(value, name); // load as string
+}
 
-JsonValue parseBinary(Common::IInputStream& stream) {
-  auto hdr = readPod<KVBinaryStorageBlockHeader>(stream);
+void KVBinaryInputStreamSerializer::parseStorage() {
+  size_t offset = 0;
+  auto hdr = readPod<KVBinaryStorageBlockHeader>(read(offset, sizeof(KVBinaryStorageBlockHeader)));
 
   if (
     hdr.m_signature_a != PORTABLE_STORAGE_SIGNATUREA ||
@@ -171,30 +213,198 @@ JsonValue parseBinary(Common::IInputStream& stream) {
     throw std::runtime_error("Unknown binary storage format version");
   }
 
-  return loadSection(stream);
+  // the root section is indexed and the whole storage is walked, so malformed data fails here
+  indexSection(offset);
+  m_frames.push_back({ false, 0, 0, 0, 0 });
+}
+
+size_t KVBinaryInputStreamSerializer::indexSection(size_t offset) {
+  size_t count = readVarint(offset);
+
+  while (count--) {
+    uint8_t nameSize = *read(offset, 1);
+    const uint8_t* name = read(offset, nameSize);
+    uint8_t type = *read(offset, 1);
+
+    m_entries.push_back({ StringView(reinterpret_cast<const char*>(name), nameSize), type, offset });
+    if (type & BIN_KV_SERIALIZE_FLAG_ARRAY) {
+      offset = skipArray(type & ~BIN_KV_SERIALIZE_FLAG_ARRAY, offset, m_frames.size());
+    } else {
+      offset = skipValue(type, offset, m_frames.size());
+    }
+  }
+
+  return offset;
 }
 
+size_t KVBinaryInputStreamSerializer::skipValue(uint8_t type, size_t offset, size_t depth) const {
+  if (depth > MAX_NESTING_DEPTH) {
+    throw std::runtime_error("Binary storage nesting is too deep");
+  }
+
+  switch (type) {
+  case BIN_KV_SERIALIZE_TYPE_INT64:
+  case BIN_KV_SERIALIZE_TYPE_UINT64:
+  case BIN_KV_SERIALIZE_TYPE_DOUBLE:
+    read(offset, 8);
+    break;
+  case BIN_KV_SERIALIZE_TYPE_INT32:
+  case BIN_KV_SERIALIZE_TYPE_UINT32:
+    read(offset, 4);
+    break;
+  case BIN_KV_SERIALIZE_TYPE_INT16:
+  case BIN_KV_SERIALIZE_TYPE_UINT16:
+    read(offset, 2);
+    break;
+  case BIN_KV_SERIALIZE_TYPE_INT8:
+  case BIN_KV_SERIALIZE_TYPE_UINT8:
+  case BIN_KV_SERIALIZE_TYPE_BOOL:
+    read(offset, 1);
+    break;
+  case BIN_KV_SERIALIZE_TYPE_STRING:
+    readString(offset);
+    break;
+  case BIN_KV_SERIALIZE_TYPE_OBJECT: {
+    size_t count = readVarint(offset);
+    while (count--) {
+      uint8_t nameSize = *read(offset, 1);
+      read(offset, nameSize);
+      uint8_t entryType = *read(offset, 1);
+      if (entryType & BIN_KV_SERIALIZE_FLAG_ARRAY) {
+        offset = skipArray(entryType & ~BIN_KV_SERIALIZE_FLAG_ARRAY, offset, depth + 1);
+      } else {
+        offset = skipValue(entryType, offset, depth + 1);
+      }
+    }
+    break;
+  }
+  case BIN_KV_SERIALIZE_TYPE_ARRAY:
+    offset = skipArray(type, offset, depth + 1);
+    break;
+  default:
+    throw std::runtime_error("Unknown data type");
+  }
+
+  return offset;
 }
 
-KVBinaryInputStreamSerializer::KVBinaryInputStreamSerializer(Common::IInputStream& strm) : JsonInputValueSerializer(parseBinary(strm)) {
+size_t KVBinaryInputStreamSerializer::skipArray(uint8_t itemType, size_t offset, size_t depth) const {
+  size_t count = readVarint(offset);
+  while (count--) {
+    offset = skipValue(itemType, offset, depth);
+  }
+
+  return offset;
 }
 
-bool KVBinaryInputStreamSerializer::binary(void* value, size_t size, Common::StringView name) {
-  std::string str;
+const uint8_t* KVBinaryInputStreamSerializer::read(size_t& offset, size_t size) const {
+  if (size > m_size - offset) {
+    throw std::runtime_error("Unexpected end of binary storage");
+  }
 
-  if (!(*this)(str, name)) {
-    return false;
+  const uint8_t* data = m_data + offset;
+  offset += size;
+  return data;
+}
+
+size_t KVBinaryInputStreamSerializer::readVarint(size_t& offset) const {
+  uint8_t b = *read(offset, 1);
+  uint8_t size_mask = b & PORTABLE_RAW_SIZE_MARK_MASK;
+  size_t bytesLeft = 0;
+
+  switch (size_mask){
+  case PORTABLE_RAW_SIZE_MARK_BYTE:
+    bytesLeft = 0;
+    break;
+  case PORTABLE_RAW_SIZE_MARK_WORD:
+    bytesLeft = 1;
+    break;
+  case PORTABLE_RAW_SIZE_MARK_DWORD:
+    bytesLeft = 3;
+    break;
+  case PORTABLE_RAW_SIZE_MARK_INT64:
+    bytesLeft = 7;
+    break;
   }
 
-  if (str.size() != size) {
-    throw std::runtime_error("Binary block size mismatch");
+  size_t value = b;
+  const uint8_t* rest = read(offset, bytesLeft);
+
+  for (size_t i = 1; i <= bytesLeft; ++i) {
+    size_t n = rest[i - 1];
+    value |= n << (i * 8);
+  }
+
+  value >>= 2;
+  return value;
+}
+
+int64_t KVBinaryInputStreamSerializer::readInteger(uint8_t type, size_t& offset) const {
+  switch (type) {
+  case BIN_KV_SERIALIZE_TYPE_INT64:  return readPod<int64_t>(read(offset, sizeof(int64_t)));
+  case BIN_KV_SERIALIZE_TYPE_INT32:  return readPod<int32_t>(read(offset, sizeof(int32_t)));
+  case BIN_KV_SERIALIZE_TYPE_INT16:  return readPod<int16_t>(read(offset, sizeof(int16_t)));
+  case BIN_KV_SERIALIZE_TYPE_INT8:   return readPod<int8_t>(read(offset, sizeof(int8_t)));
+  case BIN_KV_SERIALIZE_TYPE_UINT64: return static_cast<int64_t>(readPod<uint64_t>(read(offset, sizeof(uint64_t))));
+  case BIN_KV_SERIALIZE_TYPE_UINT32: return readPod<uint32_t>(read(offset, sizeof(uint32_t)));
+  case BIN_KV_SERIALIZE_TYPE_UINT16: return readPod<uint16_t>(read(offset, sizeof(uint16_t)));
+  case BIN_KV_SERIALIZE_TYPE_UINT8:  return readPod<uint8_t>(read(offset, sizeof(uint8_t)));
+  default:
+    throw std::runtime_error("Value type is not integer");
+  }
+}
+
+Common::StringView KVBinaryInputStreamSerializer::readString(size_t& offset) const {
+  size_t size = readVarint(offset);
+  if (size > MAX_STRING_SIZE) {
+    throw std::runtime_error("string size is too big");
+  }
+
+  return StringView(reinterpret_cast<const char*>(read(offset, size)), size);
+}
+
+bool KVBinaryInputStreamSerializer::findValue(Common::StringView name, uint8_t& type, size_t& offset) {
+  Frame& frame = m_frames.back();
+  if (frame.isArray) {
+    if (frame.count == 0) {
+      throw std::runtime_error("Array index is out of range");
+    }
+
+    --frame.count;
+    type = frame.itemType;
+    offset = frame.offset;
+    return true;
   }
 
-  memcpy(value, str.data(), size);
+  auto end = m_entries.end();
+  auto it = std::find_if(m_entries.begin() + frame.begin, end, [&](const Entry& entry) { return entry.name == name; });
+  if (it == end) {
+    return false;
+  }
+
+  type = it->type;
+  offset = it->offset;
   return true;
 }
 
-bool KVBinaryInputStreamSerializer::binary(std::string& value, Common::StringView name) {
-  return (*this)(value, name); // load as string
+void KVBinaryInputStreamSerializer::valueRead(size_t offset) {
+  if (m_frames.back().isArray) {
+    m_frames.back().offset = offset;
+  }
 }
 
+bool KVBinaryInputStreamSerializer::readString(Common::StringView name, Common::StringView& value) {
+  uint8_t type;
+  size_t offset;
+  if (!findValue(name, type, offset)) {
+    return false;
+  }
+
+  if (type != BIN_KV_SERIALIZE_TYPE_STRING) {
+    throw std::runtime_error("Value type is not string");
+  }
+
+  value = readString(offset);
+  valueRead(offset);
+  return true;
+}
@@ -7,18 +7,95 @@
 
 #pragma once
 
+#include <vector>
 #include <Common/IInputStream.h>
 #include "ISerializer.h"
-#include "JsonInputValueSerializer.h"
 
 namespace CryptoNote {
 
-class KVBinaryInputStreamSerializer : public JsonInputValueSerializer {
+// Reads values straight from the storage bytes. Only the names of the open sections are indexed, strings and blobs
+// are copied once, from the storage into the value being filled.
+class KVBinaryInputStreamSerializer : public ISerializer {
 public:
+  // the storage isn't copied and has to outlive the serializer
+  KVBinaryInputStreamSerializer(const void* data, size_t size);
+  // reads the rest of the stream
   KVBinaryInputStreamSerializer(Common::IInputStream& strm);
 
+  virtual SerializerType type() const override;
+
+  virtual bool beginObject(Common::StringView name) override;
+  virtual void endObject() override;
+
+  virtual bool beginArray(size_t& size, Common::StringView name) override;
+  virtual void endArray() override;
+
+  virtual bool operator()(uint8_t& value, Common::StringView name) override;
+  virtual bool operator()(int16_t& value, Common::StringView name) override;
+  virtual bool operator()(uint16_t& value, Common::StringView name) override;
+  virtual bool operator()(int32_t& value, Common::StringView name) override;
+  virtual bool operator()(uint32_t& value, Common::StringView name) override;
+  virtual bool operator()(int64_t& value, Common::StringView name) override;
+  virtual bool operator()(uint64_t& value, Common::StringView name) override;
+  virtual bool operator()(double& value, Common::StringView name) override;
+  virtual bool operator()(bool& value, Common::StringView name) override;
+  virtual bool operator()(std::string& value, Common::StringView name) override;
   virtual bool binary(void* value, size_t size, Common::StringView name) override;
   virtual bool binary(std::string& value, Common::StringView name) override;
+
+  template<typename T>
+  bool operator()(T& value, Common::StringView name) {
+    return ISerializer::operator()(value, name);
+  }
+
+private:
+  struct Entry {
+    Common::StringView name;
+    uint8_t type;
+    size_t offset;
+  };
+
+  // an open section owns the entries from begin to the end of m_entries, an open array reads its items in order
+  struct Frame {
+    bool isArray;
+    size_t begin;
+    uint8_t itemType;
+    size_t count;
+    size_t offset;
+  };
+
+  void parseStorage();
+  size_t indexSection(size_t offset);
+  size_t skipValue(uint8_t type, size_t offset, size_t depth) const;
+  size_t skipArray(uint8_t itemType, size_t offset, size_t depth) const;
+
+  const uint8_t* read(size_t& offset, size_t size) const;
+  size_t readVarint(size_t& offset) const;
+  int64_t readInteger(uint8_t type, size_t& offset) const;
+  Common::StringView readString(size_t& offset) const;
+
+  bool findValue(Common::StringView name, uint8_t& type, size_t& offset);
+  void valueRead(size_t offset);
+  bool readString(Common::StringView name, Common::StringView& value);
+
+  template <typename T>
+  bool getNumber(Common::StringView name, T& value) {
+    uint8_t type;
+    size_t offset;
+    if (!findValue(name, type, offset)) {
+      return false;
+    }
+
+    value = static_cast<T>(readInteger(type, offset));
+    valueRead(offset);
+    return true;
+  }
+
+  std::string m_storage;
+  const uint8_t* m_data;
+  size_t m_size;
+  std::vector<Entry> m_entries;
+  std::vector<Frame> m_frames;
 };
 
 }
@@ -11,7 +11,9 @@
 #include <vector>
 #include <Common/MemoryInputStream.h>
 #include <Common/StringOutputStream.h>
+#include "JsonInputBufferSerializer.h"
 #include "JsonInputStreamSerializer.h"
+#include "JsonOutputBufferSerializer.h"
 #include "JsonOutputStreamSerializer.h"
 #include "KVBinaryInputStreamSerializer.h"
 #include "KVBinaryOutputStreamSerializer.h"
@@ -81,17 +83,30 @@ void loadFromJsonValue(std::list<T>& v, const Common::JsonValue& js) {
 
 template <typename T>
 std::string storeToJson(const T& v) {
-  return storeToJsonValue(v).toString();
+  std::string result;
+  JsonOutputBufferSerializer s(result);
+  serialize(const_cast<T&>(v), s);
+  s.finish();
+  return result;
 }
 
+// the serializers write objects, other values go through JsonValue
+template <typename T>
+std::string storeToJson(const std::vector<T>& v) { return storeToJsonValue(v).toString(); }
+
+template <typename T>
+std::string storeToJson(const std::list<T>& v) { return storeToJsonValue(v).toString(); }
+
+inline std::string storeToJson(const std::string& v) { return storeToJsonValue(v).toString(); }
+
 template <typename T>
 bool loadFromJson(T& v, const std::string& buf) {
   try {
     if (buf.empty()) {
       return true;
     }
-    auto js = Common::JsonValue::fromString(buf);
-    loadFromJsonValue(v, js);
+    JsonInputBufferSerializer s(buf.data(), buf.size());
+    serialize(v, s);
   } catch (std::exception&) {
     return false;
   }
@@ -112,8 +127,7 @@ std::string storeToBinaryKeyValue(const T& v) {
 template <typename T>
 bool loadFromBinaryKeyValue(T& v, const std::string& buf) {
   try {
-    Common::MemoryInputStream stream(buf.data(), buf.size());
-    KVBinaryInputStreamSerializer s(stream);
+    KVBinaryInputStreamSerializer s(buf.data(), buf.size());
     serialize(v, s);
     return true;
   } catch (std::exception&) {
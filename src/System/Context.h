@@ -16,8 +16,8 @@ namespace System {
 template<typename ResultType = void>
 class Context {
 public:
-  Context(Dispatcher& dispatcher, std::function<ResultType()>&& target) : 
-    dispatcher(dispatcher), target(std::move(target)), ready(dispatcher), bindingContext(dispatcher.getReusableContext()) {
+  Context(Dispatcher& dispatcher, std::function<ResultType()>&& target, size_t stackSize = 0) :
+    dispatcher(dispatcher), target(std::move(target)), ready(dispatcher), bindingContext(dispatcher.getReusableContext(stackSize)) {
     bindingContext.interrupted = false;
     bindingContext.groupNext = nullptr;
     bindingContext.groupPrev = nullptr;
@@ -80,8 +80,8 @@ private:
 template<>
 class Context<void> {
 public:
-  Context(Dispatcher& dispatcher, std::function<void()>&& target) :
-    dispatcher(dispatcher), target(std::move(target)), ready(dispatcher), bindingContext(dispatcher.getReusableContext()) {
+  Context(Dispatcher& dispatcher, std::function<void()>&& target, size_t stackSize = 0) :
+    dispatcher(dispatcher), target(std::move(target)), ready(dispatcher), bindingContext(dispatcher.getReusableContext(stackSize)) {
     bindingContext.interrupted = false;
     bindingContext.groupNext = nullptr;
     bindingContext.groupPrev = nullptr;
@@ -10,11 +10,11 @@
 
 namespace System {
 
-ContextGroup::ContextGroup(Dispatcher& dispatcher) : dispatcher(&dispatcher) {
+ContextGroup::ContextGroup(Dispatcher& dispatcher, size_t stackSize) : dispatcher(&dispatcher), stackSize(stackSize) {
   contextGroup.firstContext = nullptr;
 }
 
-ContextGroup::ContextGroup(ContextGroup&& other) : dispatcher(other.dispatcher) {
+ContextGroup::ContextGroup(ContextGroup&& other) : dispatcher(other.dispatcher), stackSize(other.stackSize) {
   if (dispatcher != nullptr) {
     assert(other.contextGroup.firstContext == nullptr);
     contextGroup.firstContext = nullptr;
@@ -32,6 +32,7 @@ ContextGroup::~ContextGroup() {
 ContextGroup& ContextGroup::operator=(ContextGroup&& other) {
   assert(dispatcher == nullptr || contextGroup.firstContext == nullptr);
   dispatcher = other.dispatcher;
+  stackSize = other.stackSize;
   if (dispatcher != nullptr) {
     assert(other.contextGroup.firstContext == nullptr);
     contextGroup.firstContext = nullptr;
@@ -50,7 +51,7 @@ void ContextGroup::interrupt() {
 
 void ContextGroup::spawn(std::function<void()>&& procedure) {
   assert(dispatcher != nullptr);
-  NativeContext& context = dispatcher->getReusableContext();
+  NativeContext& context = dispatcher->getReusableContext(stackSize);
   if (contextGroup.firstContext != nullptr) {
     context.groupPrev = contextGroup.lastContext;
     assert(contextGroup.lastContext->groupNext == nullptr);
@@ -13,7 +13,8 @@ namespace System {
 
 class ContextGroup {
 public:
-  explicit ContextGroup(Dispatcher& dispatcher);
+  // contexts of the group run on stacks of stackSize bytes, 0 is the default size of the dispatcher
+  explicit ContextGroup(Dispatcher& dispatcher, size_t stackSize = 0);
   ContextGroup(const ContextGroup&) = delete;
   ContextGroup(ContextGroup&& other);
   ~ContextGroup();
@@ -25,6 +26,7 @@ public:
 
 private:
   Dispatcher* dispatcher;
+  size_t stackSize;
   NativeContextGroup contextGroup;
 };
 
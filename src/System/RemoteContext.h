@@ -8,27 +8,78 @@
 #pragma once
 
 #include <cassert>
+#include <exception>
+#include <memory>
 #include <System/Dispatcher.h>
 #include <System/Event.h>
-#include <System/Future.h>
 #include <System/InterruptedException.h>
+#include <System/ThreadPool.h>
 
 namespace System {
 
+namespace Detail {
+
+// Result of the operation, stored by the worker thread before it notifies the dispatcher
+template<class T> class RemoteResult {
+public:
+  void run(std::function<T()>& procedure) {
+    try {
+      value.reset(new T(procedure()));
+    } catch (...) {
+      exception = std::current_exception();
+    }
+  }
+
+  T get() {
+    if (exception != nullptr) {
+      std::rethrow_exception(exception);
+    }
+
+    return std::move(*value);
+  }
+
+private:
+  std::unique_ptr<T> value;
+  std::exception_ptr exception;
+};
+
+template<> class RemoteResult<void> {
+public:
+  void run(std::function<void()>& procedure) {
+    try {
+      procedure();
+    } catch (...) {
+      exception = std::current_exception();
+    }
+  }
+
+  void get() {
+    if (exception != nullptr) {
+      std::rethrow_exception(exception);
+    }
+  }
+
+private:
+  std::exception_ptr exception;
+};
+
+}
+
 template<class T = void> class RemoteContext {
 public:
-  // Start a thread, execute operation in it, continue execution of current context.
+  // Execute operation on the thread pool of the dispatcher, continue execution of current context.
   RemoteContext(Dispatcher& d, std::function<T()>&& operation)
-      : dispatcher(d), event(d), procedure(std::move(operation)), future(System::Detail::async<T>([this] { return asyncProcedure(); })), interrupted(false) {
+      : dispatcher(d), event(d), procedure(std::move(operation)), interrupted(false) {
+    d.getThreadPool().push([this] { asyncProcedure(); });
   }
 
-  // Run other task on dispatcher until future is ready, then return lambda's result, or rethrow exception. UB if called more than once.
+  // Run other task on dispatcher until operation is done, then return lambda's result, or rethrow exception. UB if called more than once.
   T get() const {
     wait();
-    return future.get();
+    return result.get();
   }
 
-  // Run other task on dispatcher until future is ready.
+  // Run other task on dispatcher until operation is done.
   void wait() const {
     while (!event.get()) {
       try {
@@ -43,20 +94,12 @@ public:
     }
   }
 
-  // Wait future to complete.
+  // Wait operation to complete, the worker doesn't touch the context once the event is set.
   ~RemoteContext() {
     try {
       wait();
     } catch (std::exception&) {
     }
-
-    try {
-      // windows future implementation doesn't wait for completion on destruction
-      if (future.valid()) {
-        future.wait();
-      }
-    } catch (std::exception&) {
-    }
   }
 
 private:
@@ -75,17 +118,17 @@ private:
     Event& event;
   };
 
-  // This function is executed in future object
-  T asyncProcedure() {
+  // This function is executed in a worker thread
+  void asyncProcedure() {
     NotifyOnDestruction guard(dispatcher, event);
     assert(procedure != nullptr);
-    return procedure();
+    result.run(procedure);
   }
 
   Dispatcher& dispatcher;
   mutable Event event;
   std::function<T()> procedure;
-  mutable System::Detail::Future<T> future;
+  mutable Detail::RemoteResult<T> result;
   mutable bool interrupted;
 };
 
@@ -25,7 +25,7 @@ public:
 private:
   TcpConnection& connection;
   std::array<char, 4096> readBuf;
-  std::array<uint8_t, 1024> writeBuf;
+  std::array<uint8_t, 4096> writeBuf;
 
   std::streambuf::int_type overflow(std::streambuf::int_type ch) override;
   int sync() override;
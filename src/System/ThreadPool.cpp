@@ -0,0 +1,86 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2014-2017 XDN developers
+// Copyright (c) 2016-2017 BXC developers
+// Copyright (c) 2017 Doppler developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "ThreadPool.h"
+
+namespace System {
+
+ThreadPool::ThreadPool(size_t maxIdleThreads) : maxIdleThreads(maxIdleThreads), idleCount(0), stopped(false) {
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    stopped = true;
+    condition.notify_all();
+    while (!workers.empty()) {
+      exitCondition.wait(lock);
+    }
+  }
+
+  joinExitedWorkers();
+}
+
+void ThreadPool::push(std::function<void()>&& procedure) {
+  joinExitedWorkers();
+  std::unique_lock<std::mutex> lock(mutex);
+  if (procedures.size() < idleCount) {
+    procedures.push(std::move(procedure));
+    condition.notify_one();
+    return;
+  }
+
+  // the new worker takes the procedure once the lock is released
+  workers.emplace_back();
+  auto worker = std::prev(workers.end());
+  try {
+    *worker = std::thread(&ThreadPool::workerProcedure, this, worker);
+  } catch (...) {
+    workers.erase(worker);
+    throw;
+  }
+
+  procedures.push(std::move(procedure));
+}
+
+void ThreadPool::workerProcedure(std::list<std::thread>::iterator worker) {
+  std::unique_lock<std::mutex> lock(mutex);
+  for (;;) {
+    while (procedures.empty()) {
+      if (stopped || idleCount >= maxIdleThreads) {
+        exitedWorkers.splice(exitedWorkers.end(), workers, worker);
+        exitCondition.notify_one();
+        return;
+      }
+
+      ++idleCount;
+      condition.wait(lock);
+      --idleCount;
+    }
+
+    std::function<void()> procedure = std::move(procedures.front());
+    procedures.pop();
+    lock.unlock();
+    procedure();
+    procedure = nullptr;
+    lock.lock();
+  }
+}
+
+void ThreadPool::joinExitedWorkers() {
+  std::list<std::thread> exited;
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    exited.swap(exitedWorkers);
+  }
+
+  for (auto& worker : exited) {
+    worker.join();
+  }
+}
+
+}
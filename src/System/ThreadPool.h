@@ -0,0 +1,48 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2014-2017 XDN developers
+// Copyright (c) 2016-2017 BXC developers
+// Copyright (c) 2017 Doppler developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <queue>
+#include <thread>
+
+namespace System {
+
+// Runs procedures on worker threads. A procedure goes to an idle worker when there is one, otherwise a new worker is
+// started, so a long procedure never holds up the others. At most maxIdleThreads workers stay around once they run
+// out of work, the rest exit.
+class ThreadPool {
+public:
+  explicit ThreadPool(size_t maxIdleThreads);
+  ThreadPool(const ThreadPool&) = delete;
+  // waits for the pushed procedures to finish
+  ~ThreadPool();
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  // the procedure must not throw
+  void push(std::function<void()>&& procedure);
+
+private:
+  void workerProcedure(std::list<std::thread>::iterator worker);
+  void joinExitedWorkers();
+
+  const size_t maxIdleThreads;
+  std::mutex mutex;
+  std::condition_variable condition;
+  std::condition_variable exitCondition;
+  std::queue<std::function<void()>> procedures;
+  std::list<std::thread> workers;
+  std::list<std::thread> exitedWorkers;
+  size_t idleCount;
+  bool stopped;
+};
+
+}
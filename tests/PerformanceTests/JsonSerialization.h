@@ -0,0 +1,72 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2014-2017 XDN developers
+// Copyright (c) 2016-2017 BXC developers
+// Copyright (c) 2017 Doppler developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include "Common/StringTools.h"
+#include "crypto/hash.h"
+#include "Rpc/CoreRpcServerCommandsDefinitions.h"
+#include "Serialization/SerializationTools.h"
+
+// A f_blocks_list_json sized response, the JsonValue path builds the tree in between while the buffer one doesn't
+class json_serialization_test_base {
+public:
+  static const size_t loop_count = 100;
+  static const uint32_t block_count = 10000;
+
+  bool init() {
+    m_response.status = CORE_RPC_STATUS_OK;
+    for (uint32_t i = 0; i < block_count; ++i) {
+      CryptoNote::f_block_short_response block;
+      block.timestamp = 1500000000 + i * 240;
+      block.height = i;
+      block.difficulty = 1000000 + i;
+      block.hash = Common::podToHex(Crypto::cn_fast_hash(&i, sizeof(i)));
+      block.tx_count = i % 7;
+      block.cumul_size = 400 + i % 1000;
+      m_response.blocks.push_back(block);
+    }
+
+    m_text = CryptoNote::storeToJson(m_response);
+    return true;
+  }
+
+protected:
+  CryptoNote::F_COMMAND_RPC_GET_BLOCKS_LIST::response m_response;
+  std::string m_text;
+};
+
+class test_json_value_store : public json_serialization_test_base {
+public:
+  bool test() {
+    return CryptoNote::storeToJsonValue(m_response).toString().size() > block_count;
+  }
+};
+
+class test_json_buffer_store : public json_serialization_test_base {
+public:
+  bool test() {
+    return CryptoNote::storeToJson(m_response).size() > block_count;
+  }
+};
+
+class test_json_value_load : public json_serialization_test_base {
+public:
+  bool test() {
+    CryptoNote::F_COMMAND_RPC_GET_BLOCKS_LIST::response response;
+    CryptoNote::loadFromJsonValue(response, Common::JsonValue::fromString(m_text));
+    return response.blocks.size() == block_count;
+  }
+};
+
+class test_json_buffer_load : public json_serialization_test_base {
+public:
+  bool test() {
+    CryptoNote::F_COMMAND_RPC_GET_BLOCKS_LIST::response response;
+    return CryptoNote::loadFromJson(response, m_text) && response.blocks.size() == block_count;
+  }
+};
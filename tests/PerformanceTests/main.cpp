@@ -16,6 +16,7 @@
 #include "GenerateKeyImage.h"
 #include "GenerateKeyImageHelper.h"
 #include "IsOutToAccount.h"
+#include "JsonSerialization.h"
 
 int main(int argc, char** argv)
 {
@@ -60,6 +61,11 @@ int main(int argc, char** argv)
 
   TEST_PERFORMANCE0(test_cn_slow_hash);
 
+  TEST_PERFORMANCE0(test_json_value_store);
+  TEST_PERFORMANCE0(test_json_buffer_store);
+  TEST_PERFORMANCE0(test_json_value_load);
+  TEST_PERFORMANCE0(test_json_buffer_load);
+
   std::cout << "Tests finished. Elapsed time: " << timer.elapsed_ms() / 1000 << " sec" << std::endl;
 
   return 0;
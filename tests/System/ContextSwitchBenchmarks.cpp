@@ -0,0 +1,89 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2014-2017 XDN developers
+// Copyright (c) 2016-2017 BXC developers
+// Copyright (c) 2017 Doppler developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <chrono>
+#include <iostream>
+#include <System/Context.h>
+#include <System/Dispatcher.h>
+#include <System/Event.h>
+#include <gtest/gtest.h>
+
+#ifdef __linux__
+#include <ucontext.h>
+#endif
+
+using namespace System;
+
+namespace {
+
+const size_t ROUND_TRIPS = 200000;
+
+double switchesPerSecond(std::chrono::steady_clock::duration duration) {
+  return 2 * ROUND_TRIPS / std::chrono::duration<double>(duration).count();
+}
+
+#ifdef __linux__
+ucontext_t mainUcontext;
+ucontext_t pingUcontext;
+
+void pingProcedure() {
+  for (;;) {
+    swapcontext(&pingUcontext, &mainUcontext);
+  }
+}
+#endif
+
+}
+
+// Two contexts wake each other through events, every round trip is two switches without a system call
+TEST(ContextSwitchBenchmarks, dispatcherSwitchesPerSecond) {
+  Dispatcher dispatcher;
+  Event ping(dispatcher);
+  Event pong(dispatcher);
+  size_t rounds = 0;
+
+  Context<> context(dispatcher, [&] {
+    for (size_t i = 0; i < ROUND_TRIPS; ++i) {
+      ping.wait();
+      ping.clear();
+      ++rounds;
+      pong.set();
+    }
+  });
+
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < ROUND_TRIPS; ++i) {
+    ping.set();
+    pong.wait();
+    pong.clear();
+  }
+
+  auto duration = std::chrono::steady_clock::now() - start;
+  context.get();
+  ASSERT_EQ(ROUND_TRIPS, rounds);
+  std::cout << "Dispatcher: " << static_cast<uint64_t>(switchesPerSecond(duration)) << " switches per second" << std::endl;
+}
+
+#ifdef __linux__
+// What every switch of the dispatcher cost when it was built on swapcontext
+TEST(ContextSwitchBenchmarks, swapcontextSwitchesPerSecond) {
+  std::vector<uint8_t> stack(64 * 1024);
+  ASSERT_EQ(0, getcontext(&pingUcontext));
+  pingUcontext.uc_stack.ss_sp = stack.data();
+  pingUcontext.uc_stack.ss_size = stack.size();
+  pingUcontext.uc_link = nullptr;
+  makecontext(&pingUcontext, pingProcedure, 0);
+
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < ROUND_TRIPS; ++i) {
+    swapcontext(&mainUcontext, &pingUcontext);
+  }
+
+  auto duration = std::chrono::steady_clock::now() - start;
+  std::cout << "swapcontext: " << static_cast<uint64_t>(switchesPerSecond(duration)) << " switches per second" << std::endl;
+}
+#endif
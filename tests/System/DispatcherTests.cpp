@@ -5,6 +5,7 @@
 
 #include <future>
 #include <System/Context.h>
+#include <System/ContextGroup.h>
 #include <System/Dispatcher.h>
 #include <System/Event.h>
 #include <System/Timer.h>
@@ -12,6 +13,17 @@
 
 using namespace System;
 
+namespace {
+
+// every call takes about a kilobyte of the stack
+size_t recurse(size_t depth) {
+  volatile uint8_t frame[1024];
+  frame[0] = static_cast<uint8_t>(depth);
+  return depth == 0 ? frame[0] : recurse(depth - 1) + frame[0];
+}
+
+}
+
 class DispatcherTests : public testing::Test {
 public:
   Dispatcher dispatcher;
@@ -374,3 +386,23 @@ TEST_F(DispatcherTests, yieldExecutesIoOnItsFront) {
   dispatcher.yield();
   ASSERT_TRUE(spawnDone);
 }
+
+TEST_F(DispatcherTests, contextGroupRunsOnItsStackSize) {
+  size_t result = 0;
+  ContextGroup contextGroup(dispatcher, 1024 * 1024);
+  contextGroup.spawn([&] {
+    result = recurse(512);
+  });
+
+  contextGroup.wait();
+  ASSERT_NE(0, result);
+}
+
+#ifdef __linux__
+TEST_F(DispatcherTests, stackOverflowFaultsOnGuardPage) {
+  ASSERT_DEATH({
+    Context<size_t> context(dispatcher, [] { return recurse(1024); });
+    context.get();
+  }, "");
+}
+#endif
@@ -3,6 +3,9 @@
 // Distributed under the MIT/X11 software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include <atomic>
+#include <set>
+#include <thread>
 #include <System/RemoteContext.h>
 #include <System/Dispatcher.h>
 #include <System/ContextGroup.h>
@@ -132,3 +135,40 @@ TEST_F(RemoteContextTests, waitMethodWaitsForContexCompletionOnInterrupt) {
   ASSERT_GE(std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count(), 10);
 }
 
+
+TEST_F(RemoteContextTests, operationsReuseWorkerThreads) {
+  std::set<std::thread::id> threads;
+  for (size_t i = 0; i < 1000; ++i) {
+    threads.insert(RemoteContext<std::thread::id>(dispatcher, [] { return std::this_thread::get_id(); }).get());
+  }
+
+  ASSERT_LT(threads.size(), 100u);
+}
+
+TEST_F(RemoteContextTests, blockedOperationsDontHoldUpOthers) {
+  // more operations than idle workers are kept, each one waits for all the others to start
+  const size_t operationCount = 2 * std::thread::hardware_concurrency() + 2;
+  std::atomic<size_t> started(0);
+  size_t finished = 0;
+  ContextGroup cg(dispatcher);
+  for (size_t i = 0; i < operationCount; ++i) {
+    cg.spawn([&] {
+      bool allStarted = RemoteContext<bool>(dispatcher, [&] {
+        ++started;
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (started < operationCount && std::chrono::steady_clock::now() < deadline) {
+          std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        return started == operationCount;
+      }).get();
+
+      if (allStarted) {
+        ++finished;
+      }
+    });
+  }
+
+  cg.wait();
+  ASSERT_EQ(operationCount, finished);
+}
@@ -263,6 +263,58 @@ TEST_F(TcpConnectionTests, sendBigChunk) {
   ASSERT_EQ(buf, incoming);
 }
 
+TEST_F(TcpConnectionTests, sendBigChunksGathered) {
+  connect();
+
+  std::vector<std::vector<uint8_t>> bufs(5);
+  std::vector<uint8_t> expected;
+  for (size_t i = 0; i < bufs.size(); ++i) {
+    bufs[i].resize((i + 1) * 1024 * 1024);
+    fillRandomBuf(bufs[i]);
+    expected.insert(expected.end(), bufs[i].begin(), bufs[i].end());
+  }
+
+  std::vector<uint8_t> incoming;
+  Event readComplete(dispatcher);
+
+  contextGroup.spawn([&]{
+    uint8_t readBuf[1024];
+    size_t readSize;
+    while ((readSize = connection2.read(readBuf, sizeof(readBuf))) > 0) {
+      incoming.insert(incoming.end(), readBuf, readBuf + readSize);
+    }
+
+    readComplete.set();
+  });
+
+  contextGroup.spawn([&]{
+    std::vector<std::pair<const uint8_t*, size_t>> buffers;
+    for (const auto& buf : bufs) {
+      buffers.emplace_back(buf.data(), buf.size());
+    }
+
+    while (!buffers.empty()) {
+      size_t transferred = connection1.write(buffers);
+      while (!buffers.empty() && transferred >= buffers.front().second) {
+        transferred -= buffers.front().second;
+        buffers.erase(buffers.begin());
+      }
+
+      if (transferred != 0) {
+        buffers.front().first += transferred;
+        buffers.front().second -= transferred;
+      }
+    }
+
+    connection1 = TcpConnection(); // close connection
+  });
+
+  readComplete.wait();
+
+  ASSERT_EQ(expected.size(), incoming.size());
+  ASSERT_EQ(expected, incoming);
+}
+
 TEST_F(TcpConnectionTests, writeWhenReadWaiting) {
   connect();
 
@@ -0,0 +1,96 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2014-2017 XDN developers
+// Copyright (c) 2016-2017 BXC developers
+// Copyright (c) 2017 Doppler developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <chrono>
+#include <iostream>
+#include <vector>
+#include <System/ContextGroup.h>
+#include <System/Dispatcher.h>
+#include <System/Ipv4Address.h>
+#include <System/TcpConnection.h>
+#include <System/TcpConnector.h>
+#include <System/TcpListener.h>
+#include <gtest/gtest.h>
+
+using namespace System;
+
+namespace {
+
+const Ipv4Address LISTEN_ADDRESS("127.0.0.1");
+const uint16_t LISTEN_PORT = 6666;
+const size_t CONNECTIONS = 256;
+const size_t ROUND_TRIPS = 200;
+const size_t MESSAGE_SIZE = 64;
+
+void readFully(TcpConnection& connection, uint8_t* data, size_t size) {
+  while (size > 0) {
+    size_t transferred = connection.read(data, size);
+    if (transferred == 0) {
+      throw std::runtime_error("connection closed");
+    }
+
+    data += transferred;
+    size -= transferred;
+  }
+}
+
+}
+
+// Every connection keeps one message in flight, so most of the wakeups come from many sockets becoming ready together
+TEST(TcpEchoBenchmarks, manyConnectionsRoundTripsPerSecond) {
+  Dispatcher dispatcher;
+  TcpListener listener(dispatcher, LISTEN_ADDRESS, LISTEN_PORT);
+  std::vector<TcpConnection> clients(CONNECTIONS);
+  std::vector<TcpConnection> servers(CONNECTIONS);
+  for (size_t i = 0; i < CONNECTIONS; ++i) {
+    clients[i] = TcpConnector(dispatcher).connect(LISTEN_ADDRESS, LISTEN_PORT);
+    servers[i] = listener.accept();
+  }
+
+  ContextGroup contextGroup(dispatcher);
+  for (auto& server : servers) {
+    contextGroup.spawn([&server] {
+      uint8_t data[MESSAGE_SIZE];
+      for (;;) {
+        size_t size = server.read(data, MESSAGE_SIZE);
+        if (size == 0) {
+          break;
+        }
+
+        for (size_t offset = 0; offset < size;) {
+          offset += server.write(data + offset, size - offset);
+        }
+      }
+    });
+  }
+
+  size_t roundTrips = 0;
+  auto start = std::chrono::steady_clock::now();
+  ContextGroup clientGroup(dispatcher);
+  for (auto& client : clients) {
+    clientGroup.spawn([&client, &roundTrips] {
+      uint8_t data[MESSAGE_SIZE] = {};
+      for (size_t i = 0; i < ROUND_TRIPS; ++i) {
+        for (size_t offset = 0; offset < MESSAGE_SIZE;) {
+          offset += client.write(data + offset, MESSAGE_SIZE - offset);
+        }
+
+        readFully(client, data, MESSAGE_SIZE);
+        ++roundTrips;
+      }
+    });
+  }
+
+  clientGroup.wait();
+  auto duration = std::chrono::steady_clock::now() - start;
+  clients.clear();
+  contextGroup.wait();
+
+  ASSERT_EQ(CONNECTIONS * ROUND_TRIPS, roundTrips);
+  std::cout << "Echo over " << CONNECTIONS << " connections: " <<
+    static_cast<uint64_t>(roundTrips / std::chrono::duration<double>(duration).count()) << " round trips per second" << std::endl;
+}
@@ -4,6 +4,7 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <thread>
+#include <vector>
 #include <System/Context.h>
 #include <System/Dispatcher.h>
 #include <System/ContextGroup.h>
@@ -266,3 +267,46 @@ TEST_F(TimerTests, timerWithZeroTimeIsYielding) {
   Timer(dispatcher).sleep(std::chrono::milliseconds(0));
   ASSERT_TRUE(done);
 }
+
+TEST_F(TimerTests, manyTimersExpireInDeadlineOrder) {
+  const size_t TIMER_COUNT = 200;
+  std::vector<size_t> order;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = TIMER_COUNT; i-- > 0;) {
+    contextGroup.spawn([&, i] {
+      Timer(dispatcher).sleep(std::chrono::milliseconds(2 * (i + 1)));
+      ASSERT_LE(std::chrono::milliseconds(2 * (i + 1)), std::chrono::steady_clock::now() - start);
+      order.push_back(i);
+    });
+  }
+
+  contextGroup.wait();
+  ASSERT_EQ(TIMER_COUNT, order.size());
+  for (size_t i = 0; i < TIMER_COUNT; ++i) {
+    ASSERT_EQ(i, order[i]);
+  }
+}
+
+TEST_F(TimerTests, interruptedTimersLeaveOthersRunning) {
+  ContextGroup interruptedGroup(dispatcher);
+  size_t interrupted = 0;
+  size_t expired = 0;
+  for (size_t i = 0; i < 100; ++i) {
+    (i % 2 == 0 ? interruptedGroup : contextGroup).spawn([&, i] {
+      try {
+        Timer(dispatcher).sleep(std::chrono::milliseconds(i % 2 == 0 ? 1000 : 20 + i));
+        ++expired;
+      } catch (InterruptedException&) {
+        ++interrupted;
+      }
+    });
+  }
+
+  Timer(dispatcher).sleep(std::chrono::milliseconds(10));
+  interruptedGroup.interrupt();
+  interruptedGroup.wait();
+  ASSERT_EQ(50u, interrupted);
+  ASSERT_EQ(0u, expired);
+  contextGroup.wait();
+  ASSERT_EQ(50u, expired);
+}
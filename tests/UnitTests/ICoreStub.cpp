@@ -339,10 +339,18 @@ bool ICoreStub::handleIncomingTransaction(const CryptoNote::Transaction& tx, con
   return poolTxVerificationResult;
 }
 
+void ICoreStub::handleIncomingTransactions(const std::vector<CryptoNote::BinaryArray>& txBlobs, std::vector<CryptoNote::tx_verification_context>& tvcs) {
+  tvcs.assign(txBlobs.size(), CryptoNote::tx_verification_context());
+}
+
 bool ICoreStub::have_block(const Crypto::Hash& id) {
   return blocks.count(id) > 0;
 }
 
+bool ICoreStub::haveTransaction(const Crypto::Hash& id) {
+  return transactions.count(id) > 0 || transactionPool.count(id) > 0;
+}
+
 void ICoreStub::setPoolTxVerificationResult(bool result) {
   poolTxVerificationResult = result;
 }
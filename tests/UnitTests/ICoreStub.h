@@ -46,6 +46,7 @@ public:
     uint32_t& start_height, uint32_t& current_height, uint32_t& full_offset, std::vector<CryptoNote::BlockShortInfo>& entries) override;
 
   virtual bool have_block(const Crypto::Hash& id) override;
+  virtual bool haveTransaction(const Crypto::Hash& id) override;
   std::vector<Crypto::Hash> buildSparseChain() override;
   std::vector<Crypto::Hash> buildSparseChain(const Crypto::Hash& startBlockId) override;
   virtual bool get_stat_info(CryptoNote::core_stat_info& st_inf) override { return false; }
@@ -53,6 +54,7 @@ public:
   virtual void pause_mining() override {}
   virtual void update_block_template_and_resume_mining() override {}
   virtual bool handle_incoming_block_blob(const CryptoNote::BinaryArray& block_blob, CryptoNote::block_verification_context& bvc, bool control_miner, bool relay_block) override { return false; }
+  virtual bool checkBlockProofOfWork(const CryptoNote::Block& block) override { return false; }
   virtual bool handle_get_objects(CryptoNote::NOTIFY_REQUEST_GET_OBJECTS::request& arg, CryptoNote::NOTIFY_RESPONSE_GET_OBJECTS::request& rsp) override { return false; }
   virtual void on_synchronized() override {}
   virtual bool getOutByMSigGIndex(uint64_t amount, uint64_t gindex, CryptoNote::MultisignatureOutput& out) override { return true; }
@@ -79,6 +81,7 @@ public:
   virtual bool getTransactionsByPaymentId(const Crypto::Hash& paymentId, std::vector<CryptoNote::Transaction>& transactions) override;
   virtual std::unique_ptr<CryptoNote::IBlock> getBlock(const Crypto::Hash& blockId) override;
   virtual bool handleIncomingTransaction(const CryptoNote::Transaction& tx, const Crypto::Hash& txHash, size_t blobSize, CryptoNote::tx_verification_context& tvc, bool keptByBlock, uint32_t height) override;
+  virtual void handleIncomingTransactions(const std::vector<CryptoNote::BinaryArray>& txBlobs, std::vector<CryptoNote::tx_verification_context>& tvcs) override;
   virtual std::error_code executeLocked(const std::function<std::error_code()>& func) override;
 
   virtual bool addMessageQueue(CryptoNote::MessageQueue<CryptoNote::BlockchainMessage>& messageQueuePtr) override;
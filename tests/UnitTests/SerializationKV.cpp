@@ -122,3 +122,62 @@ TEST(KVSerialize, BigCollection) {
   ASSERT_TRUE(CryptoNote::loadFromBinaryKeyValue(ts2, buf));
   EXPECT_EQ(ts1, ts2);
 }
+
+namespace {
+
+struct ReorderedElement {
+  uint32_t nonce;
+  std::string name;
+
+  void serialize(ISerializer& s) {
+    s(nonce, "nonce");
+    s(name, "name");
+  }
+};
+
+struct ReorderedStruct {
+  uint64_t u64;
+  std::vector<ReorderedElement> vec1;
+
+  void serialize(ISerializer& s) {
+    s(u64, "u64");
+    s(vec1, "vec1");
+  }
+};
+
+}
+
+TEST(KVSerialize, FieldsAreReadInAnyOrderAndUnknownOnesAreSkipped) {
+  TestStruct ts1;
+  ts1.u8 = 1;
+  ts1.u32 = 2;
+  ts1.u64 = 3;
+  ts1.root.name = "root";
+
+  TestElement sample;
+  sample.name = "element";
+  sample.nonce = 7;
+  sample.u32array.resize(10, 5);
+  ts1.vec1.resize(3, sample);
+
+  ReorderedStruct ts2;
+  std::string buf = CryptoNote::storeToBinaryKeyValue(ts1);
+  ASSERT_TRUE(CryptoNote::loadFromBinaryKeyValue(ts2, buf));
+  EXPECT_EQ(3, ts2.u64);
+  ASSERT_EQ(3, ts2.vec1.size());
+  for (const auto& element : ts2.vec1) {
+    EXPECT_EQ(7, element.nonce);
+    EXPECT_EQ("element", element.name);
+  }
+}
+
+TEST(KVSerialize, TruncatedStorageIsRejected) {
+  TestElement testData1, testData2;
+  testData1.name = "hello";
+  testData1.nonce = 12345;
+
+  std::string buf = CryptoNote::storeToBinaryKeyValue(testData1);
+  for (size_t size = 0; size < buf.size(); ++size) {
+    ASSERT_FALSE(CryptoNote::loadFromBinaryKeyValue(testData2, buf.substr(0, size)));
+  }
+}
@@ -0,0 +1,211 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2014-2017 XDN developers
+// Copyright (c) 2016-2017 BXC developers
+// Copyright (c) 2017 Doppler developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "gtest/gtest.h"
+
+#include <boost/uuid/random_generator.hpp>
+
+#include "Common/StringTools.h"
+#include "CryptoNoteProtocol/BlockDownloadScheduler.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+const size_t CHUNK_SIZE = 10;
+const size_t WINDOW_CHUNKS = 4;
+const size_t CHUNKS_PER_PEER = 2;
+
+Crypto::Hash blockId(uint32_t height) {
+  Crypto::Hash hash = {};
+  *reinterpret_cast<uint32_t*>(hash.data) = height + 1;
+  return hash;
+}
+
+// ids of an entry starting at the known block startHeight
+std::vector<Crypto::Hash> chainEntry(uint32_t startHeight, uint32_t count) {
+  std::vector<Crypto::Hash> ids;
+  for (uint32_t height = startHeight; height < startHeight + count; ++height) {
+    ids.push_back(blockId(height));
+  }
+
+  return ids;
+}
+
+std::vector<block_complete_entry> blocksFor(const std::vector<Crypto::Hash>& ids) {
+  std::vector<block_complete_entry> blocks;
+  for (const auto& id : ids) {
+    block_complete_entry entry;
+    entry.block = Common::podToHex(id);
+    blocks.push_back(entry);
+  }
+
+  return blocks;
+}
+
+class BlockDownloadSchedulerTest : public testing::Test {
+public:
+  BlockDownloadSchedulerTest() :
+    scheduler(CHUNK_SIZE, WINDOW_CHUNKS, CHUNKS_PER_PEER, std::chrono::seconds(30), std::chrono::seconds(5)),
+    now(BlockDownloadScheduler::Clock::now()) {
+    boost::uuids::random_generator generator;
+    peer1 = generator();
+    peer2 = generator();
+  }
+
+protected:
+  BlockDownloadScheduler::Delivery deliver(const BlockDownloadScheduler::PeerId& peer, const std::vector<Crypto::Hash>& ids) {
+    return scheduler.deliver(peer, ids, blocksFor(ids), {});
+  }
+
+  BlockDownloadScheduler scheduler;
+  BlockDownloadScheduler::Clock::time_point now;
+  BlockDownloadScheduler::PeerId peer1;
+  BlockDownloadScheduler::PeerId peer2;
+};
+
+}
+
+TEST_F(BlockDownloadSchedulerTest, chunksAreSpreadOverPeersWithinLimits) {
+  ASSERT_TRUE(scheduler.addBlockIds(0, chainEntry(0, 101)));
+  ASSERT_EQ(101, scheduler.nextHeight());
+
+  std::vector<Crypto::Hash> chunk;
+  ASSERT_TRUE(scheduler.assignChunk(peer1, 1000, now, chunk));
+  ASSERT_EQ(chainEntry(1, CHUNK_SIZE), chunk);
+  ASSERT_TRUE(scheduler.assignChunk(peer1, 1000, now, chunk));
+  ASSERT_FALSE(scheduler.assignChunk(peer1, 1000, now, chunk));
+  ASSERT_EQ(CHUNKS_PER_PEER, scheduler.inFlight(peer1));
+
+  ASSERT_TRUE(scheduler.assignChunk(peer2, 1000, now, chunk));
+  ASSERT_EQ(chainEntry(1 + 2 * CHUNK_SIZE, CHUNK_SIZE), chunk);
+  ASSERT_TRUE(scheduler.assignChunk(peer2, 1000, now, chunk));
+  // the rest is out of the window
+  ASSERT_FALSE(scheduler.assignChunk(peer2, 1000, now, chunk));
+}
+
+TEST_F(BlockDownloadSchedulerTest, peerIsOnlyAskedForBlocksItHas) {
+  ASSERT_TRUE(scheduler.addBlockIds(0, chainEntry(0, 41)));
+
+  std::vector<Crypto::Hash> chunk;
+  ASSERT_FALSE(scheduler.assignChunk(peer1, CHUNK_SIZE, now, chunk));
+  ASSERT_TRUE(scheduler.assignChunk(peer1, CHUNK_SIZE + 1, now, chunk));
+}
+
+TEST_F(BlockDownloadSchedulerTest, chunksAreReadyInHeightOrder) {
+  ASSERT_TRUE(scheduler.addBlockIds(0, chainEntry(0, 21)));
+
+  std::vector<Crypto::Hash> first;
+  std::vector<Crypto::Hash> second;
+  ASSERT_TRUE(scheduler.assignChunk(peer1, 1000, now, first));
+  ASSERT_TRUE(scheduler.assignChunk(peer2, 1000, now, second));
+
+  std::vector<Crypto::Hash> reversed(second.rbegin(), second.rend());
+  ASSERT_EQ(BlockDownloadScheduler::Delivery::ACCEPTED, deliver(peer2, reversed));
+
+  std::vector<block_complete_entry> blocks;
+  BlockDownloadScheduler::PeerId deliveredBy;
+  ASSERT_FALSE(scheduler.popReady(blocks, deliveredBy));
+
+  ASSERT_EQ(BlockDownloadScheduler::Delivery::ACCEPTED, deliver(peer1, first));
+  ASSERT_TRUE(scheduler.popReady(blocks, deliveredBy));
+  ASSERT_EQ(peer1, deliveredBy);
+  ASSERT_EQ(Common::podToHex(first.front()), blocks.front().block);
+
+  ASSERT_TRUE(scheduler.popReady(blocks, deliveredBy));
+  ASSERT_EQ(peer2, deliveredBy);
+  ASSERT_EQ(Common::podToHex(second.front()), blocks.front().block);
+  ASSERT_TRUE(scheduler.empty());
+}
+
+TEST_F(BlockDownloadSchedulerTest, timedOutChunkGoesToAnotherPeer) {
+  ASSERT_TRUE(scheduler.addBlockIds(0, chainEntry(0, 11)));
+
+  std::vector<Crypto::Hash> chunk;
+  ASSERT_TRUE(scheduler.assignChunk(peer1, 1000, now, chunk));
+  ASSERT_FALSE(scheduler.assignChunk(peer2, 1000, now, chunk));
+
+  auto later = now + std::chrono::seconds(31);
+  BlockDownloadScheduler::PeerRequests expired;
+  ASSERT_EQ(1, scheduler.expire(later, expired));
+  ASSERT_EQ(1, expired.size());
+  ASSERT_EQ(chunk, expired[peer1]);
+  ASSERT_EQ(0, scheduler.inFlight(peer1));
+  ASSERT_FALSE(scheduler.assignChunk(peer1, 1000, later, chunk));
+  ASSERT_TRUE(scheduler.assignChunk(peer2, 1000, later, chunk));
+
+  // a late response is still taken
+  ASSERT_TRUE(scheduler.isPending(chunk.front()));
+  ASSERT_EQ(BlockDownloadScheduler::Delivery::ACCEPTED, deliver(peer1, chunk));
+  ASSERT_FALSE(scheduler.isPending(chunk.front()));
+  ASSERT_EQ(0, scheduler.inFlight(peer2));
+  ASSERT_EQ(BlockDownloadScheduler::Delivery::STALE, deliver(peer2, chunk));
+}
+
+TEST_F(BlockDownloadSchedulerTest, requestsWithinTimeoutDoNotExpire) {
+  ASSERT_TRUE(scheduler.addBlockIds(0, chainEntry(0, 21)));
+
+  std::vector<Crypto::Hash> first;
+  std::vector<Crypto::Hash> second;
+  ASSERT_TRUE(scheduler.assignChunk(peer1, 1000, now, first));
+  ASSERT_TRUE(scheduler.assignChunk(peer2, 1000, now + std::chrono::seconds(20), second));
+
+  BlockDownloadScheduler::PeerRequests expired;
+  ASSERT_EQ(1, scheduler.expire(now + std::chrono::seconds(31), expired));
+  ASSERT_EQ(1, expired.count(peer1));
+  ASSERT_EQ(0, expired.count(peer2));
+  ASSERT_EQ(1, scheduler.inFlight(peer2));
+}
+
+TEST_F(BlockDownloadSchedulerTest, stalledOldestChunkIsAlsoRequestedFromAnotherPeer) {
+  ASSERT_TRUE(scheduler.addBlockIds(0, chainEntry(0, 21)));
+
+  std::vector<Crypto::Hash> head;
+  std::vector<Crypto::Hash> chunk;
+  ASSERT_TRUE(scheduler.assignChunk(peer1, 1000, now, head));
+  ASSERT_TRUE(scheduler.assignChunk(peer2, 1000, now, chunk));
+  ASSERT_EQ(BlockDownloadScheduler::Delivery::ACCEPTED, deliver(peer2, chunk));
+
+  ASSERT_FALSE(scheduler.assignChunk(peer2, 1000, now, chunk));
+  ASSERT_TRUE(scheduler.assignChunk(peer2, 1000, now + std::chrono::seconds(5), chunk));
+  ASSERT_EQ(head, chunk);
+}
+
+TEST_F(BlockDownloadSchedulerTest, incompleteResponseReleasesChunk) {
+  ASSERT_TRUE(scheduler.addBlockIds(0, chainEntry(0, 11)));
+
+  std::vector<Crypto::Hash> chunk;
+  ASSERT_TRUE(scheduler.assignChunk(peer1, 1000, now, chunk));
+
+  std::vector<Crypto::Hash> received(chunk.begin(), chunk.end() - 1);
+  std::vector<Crypto::Hash> missed(chunk.end() - 1, chunk.end());
+  ASSERT_EQ(BlockDownloadScheduler::Delivery::INCOMPLETE, scheduler.deliver(peer1, received, blocksFor(received), missed));
+  ASSERT_EQ(0, scheduler.inFlight(peer1));
+  ASSERT_TRUE(scheduler.assignChunk(peer2, 1000, now, chunk));
+}
+
+TEST_F(BlockDownloadSchedulerTest, blockIdsHaveToExtendScheduledSpan) {
+  ASSERT_TRUE(scheduler.addBlockIds(0, chainEntry(0, 21)));
+
+  std::vector<Crypto::Hash> fork = chainEntry(5, 30);
+  fork[15] = blockId(1000);
+  ASSERT_FALSE(scheduler.addBlockIds(5, fork));
+  ASSERT_EQ(21, scheduler.nextHeight());
+
+  ASSERT_TRUE(scheduler.addBlockIds(5, chainEntry(5, 30)));
+  ASSERT_EQ(35, scheduler.nextHeight());
+}
+
+TEST_F(BlockDownloadSchedulerTest, removedPeerChunksAreReleased) {
+  ASSERT_TRUE(scheduler.addBlockIds(0, chainEntry(0, 11)));
+
+  std::vector<Crypto::Hash> chunk;
+  ASSERT_TRUE(scheduler.assignChunk(peer1, 1000, now, chunk));
+  scheduler.removePeer(peer1);
+  ASSERT_TRUE(scheduler.assignChunk(peer2, 1000, now, chunk));
+  ASSERT_EQ(chainEntry(1, CHUNK_SIZE), chunk);
+}
@@ -0,0 +1,218 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2014-2017 XDN developers
+// Copyright (c) 2016-2017 BXC developers
+// Copyright (c) 2017 Doppler developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "gtest/gtest.h"
+
+#include <boost/uuid/random_generator.hpp>
+
+#include <System/Dispatcher.h>
+
+#include "Common/StringTools.h"
+#include "CryptoNoteCore/CryptoNoteFormatUtils.h"
+#include "CryptoNoteCore/CryptoNoteTools.h"
+#include "CryptoNoteCore/VerificationContext.h"
+#include "CryptoNoteProtocol/CryptoNoteProtocolHandler.h"
+#include "Logging/ConsoleLogger.h"
+#include "P2p/LevinProtocol.h"
+
+#include "ICoreStub.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+class CompactBlockCoreStub : public ICoreStub {
+public:
+  virtual bool handle_incoming_tx(const BinaryArray& tx_blob, tx_verification_context& tvc, bool keeped_by_block) override {
+    blockTxs.push_back(tx_blob);
+    return true;
+  }
+
+  virtual bool handle_incoming_block_blob(const BinaryArray& block_blob, block_verification_context& bvc, bool control_miner, bool relay_block) override {
+    blocks.push_back(block_blob);
+    return true;
+  }
+
+  std::vector<BinaryArray> blockTxs;
+  std::vector<BinaryArray> blocks;
+};
+
+class P2pEndpointRecorder : public p2p_endpoint_stub {
+public:
+  virtual bool invoke_notify_to_peer(int command, const BinaryArray& req_buff, const CryptoNoteConnectionContext& context) override {
+    notifications.emplace_back(command, req_buff);
+    return true;
+  }
+
+  virtual void report_invalid_data(const CryptoNoteConnectionContext& context) override {
+    ++invalidDataReports;
+  }
+
+  template <typename Command>
+  bool last(typename Command::request& request) const {
+    return !notifications.empty() && notifications.back().first == Command::ID && LevinProtocol::decode(notifications.back().second, request);
+  }
+
+  std::vector<std::pair<int, BinaryArray>> notifications;
+  size_t invalidDataReports = 0;
+};
+
+Transaction createTransaction(uint64_t unlockTime) {
+  Transaction tx;
+  tx.version = 1;
+  tx.unlockTime = unlockTime;
+  tx.inputs.push_back(BaseInput{static_cast<uint32_t>(unlockTime)});
+  return tx;
+}
+
+class CompactBlockRelayTest : public ::testing::Test {
+public:
+  CompactBlockRelayTest() :
+    handler(core.currency(), dispatcher, core, &p2p, logger),
+    txs({createTransaction(1), createTransaction(2), createTransaction(3)}) {
+    context.version = P2PProtocolVersion::V2;
+    context.m_connection_id = boost::uuids::random_generator()();
+    context.m_state = CryptoNoteConnectionContext::state_normal;
+
+    block = core.currency().genesisBlock();
+    block.timestamp = 1;
+    for (const auto& tx : txs) {
+      block.transactionHashes.push_back(getObjectHash(tx));
+    }
+  }
+
+  template <typename Command>
+  void notify(typename Command::request& request) {
+    BinaryArray out;
+    bool handled;
+    handler.handleCommand(true, Command::ID, LevinProtocol::encode(request), out, context, handled);
+  }
+
+  void addToPool(const Transaction& tx) {
+    tx_verification_context tvc = boost::value_initialized<tx_verification_context>();
+    core.handleIncomingTransaction(tx, getObjectHash(tx), toBinaryArray(tx).size(), tvc, false, 0);
+  }
+
+  void sendCompactBlock() {
+    NOTIFY_NEW_COMPACT_BLOCK::request compact;
+    compact.block = Common::asString(toBinaryArray(block));
+    compact.current_blockchain_height = 2;
+    compact.hop = 1;
+    notify<NOTIFY_NEW_COMPACT_BLOCK>(compact);
+  }
+
+  Logging::ConsoleLogger logger;
+  System::Dispatcher dispatcher;
+  CompactBlockCoreStub core;
+  P2pEndpointRecorder p2p;
+  CryptoNoteProtocolHandler handler;
+  CryptoNoteConnectionContext context;
+  std::vector<Transaction> txs;
+  Block block;
+};
+
+}
+
+TEST_F(CompactBlockRelayTest, blockIsAssembledFromPool) {
+  for (const auto& tx : txs) {
+    addToPool(tx);
+  }
+
+  sendCompactBlock();
+
+  ASSERT_TRUE(p2p.notifications.empty());
+  ASSERT_EQ(1, core.blocks.size());
+  ASSERT_EQ(toBinaryArray(block), core.blocks.front());
+  ASSERT_TRUE(core.blockTxs.empty());
+}
+
+TEST_F(CompactBlockRelayTest, missingTransactionsAreRequestedAndBlockIsAssembledFromResponse) {
+  addToPool(txs[0]);
+  addToPool(txs[2]);
+
+  sendCompactBlock();
+  ASSERT_TRUE(core.blocks.empty());
+
+  NOTIFY_REQUEST_BLOCK_TXS::request request;
+  ASSERT_TRUE(p2p.last<NOTIFY_REQUEST_BLOCK_TXS>(request));
+  ASSERT_EQ(get_block_hash(block), request.block_hash);
+  ASSERT_EQ(std::vector<Crypto::Hash>({getObjectHash(txs[1])}), request.txs);
+
+  NOTIFY_RESPONSE_BLOCK_TXS::request response;
+  response.block_hash = request.block_hash;
+  response.txs.push_back(Common::asString(toBinaryArray(txs[1])));
+  notify<NOTIFY_RESPONSE_BLOCK_TXS>(response);
+
+  ASSERT_EQ(1, core.blocks.size());
+  ASSERT_EQ(toBinaryArray(block), core.blocks.front());
+  ASSERT_EQ(std::vector<BinaryArray>({toBinaryArray(txs[1])}), core.blockTxs);
+  ASSERT_EQ(CryptoNoteConnectionContext::state_normal, context.m_state);
+}
+
+TEST_F(CompactBlockRelayTest, shortResponseFallsBackToSynchronization) {
+  addToPool(txs[0]);
+
+  sendCompactBlock();
+
+  NOTIFY_REQUEST_BLOCK_TXS::request request;
+  ASSERT_TRUE(p2p.last<NOTIFY_REQUEST_BLOCK_TXS>(request));
+  ASSERT_EQ(2, request.txs.size());
+
+  NOTIFY_RESPONSE_BLOCK_TXS::request response;
+  response.block_hash = request.block_hash;
+  response.txs.push_back(Common::asString(toBinaryArray(txs[1])));
+  notify<NOTIFY_RESPONSE_BLOCK_TXS>(response);
+
+  ASSERT_TRUE(core.blocks.empty());
+  NOTIFY_REQUEST_CHAIN::request chainRequest;
+  ASSERT_TRUE(p2p.last<NOTIFY_REQUEST_CHAIN>(chainRequest));
+  ASSERT_EQ(CryptoNoteConnectionContext::state_synchronizing, context.m_state);
+}
+
+TEST_F(CompactBlockRelayTest, unparsableCompactBlockIsReportedAsInvalidData) {
+  NOTIFY_NEW_COMPACT_BLOCK::request compact;
+  compact.block = "garbage";
+  compact.current_blockchain_height = 2;
+  compact.hop = 1;
+  notify<NOTIFY_NEW_COMPACT_BLOCK>(compact);
+
+  ASSERT_EQ(1, p2p.invalidDataReports);
+  ASSERT_EQ(CryptoNoteConnectionContext::state_shutdown, context.m_state);
+}
+
+TEST_F(CompactBlockRelayTest, onlyTransactionsOfRequestedBlockAreServed) {
+  core.addBlock(block);
+  for (const auto& tx : txs) {
+    core.addTransaction(tx);
+  }
+
+  Transaction other = createTransaction(4);
+  core.addTransaction(other);
+
+  NOTIFY_REQUEST_BLOCK_TXS::request request;
+  request.block_hash = get_block_hash(block);
+  request.txs = {getObjectHash(txs[1]), getObjectHash(other), getObjectHash(txs[1]), getObjectHash(txs[2])};
+  notify<NOTIFY_REQUEST_BLOCK_TXS>(request);
+
+  NOTIFY_RESPONSE_BLOCK_TXS::request response;
+  ASSERT_TRUE(p2p.last<NOTIFY_RESPONSE_BLOCK_TXS>(response));
+  ASSERT_EQ(request.block_hash, response.block_hash);
+  ASSERT_EQ(std::vector<std::string>({Common::asString(toBinaryArray(txs[1])), Common::asString(toBinaryArray(txs[2]))}), response.txs);
+}
+
+TEST_F(CompactBlockRelayTest, unknownBlockGetsEmptyResponse) {
+  core.addTransaction(txs[0]);
+
+  NOTIFY_REQUEST_BLOCK_TXS::request request;
+  request.block_hash = get_block_hash(block);
+  request.txs = {getObjectHash(txs[0])};
+  notify<NOTIFY_REQUEST_BLOCK_TXS>(request);
+
+  NOTIFY_RESPONSE_BLOCK_TXS::request response;
+  ASSERT_TRUE(p2p.last<NOTIFY_RESPONSE_BLOCK_TXS>(response));
+  ASSERT_TRUE(response.txs.empty());
+}
@@ -0,0 +1,114 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2014-2017 XDN developers
+// Copyright (c) 2016-2017 BXC developers
+// Copyright (c) 2017 Doppler developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "gtest/gtest.h"
+
+#include <sstream>
+#include <vector>
+#include "HTTP/HttpParser.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+const std::string REQUEST = "POST /json_rpc HTTP/1.1\r\nHost: 127.0.0.1\r\nContent-Length: 5\r\nConnection:  keep-alive \r\n\r\nhello";
+
+}
+
+TEST(HttpParserTest, parsesRequestInPlace) {
+  HttpParser parser;
+  HttpRequest request;
+  ASSERT_EQ(REQUEST.size(), parser.parseRequest(REQUEST.data(), REQUEST.size(), request));
+  ASSERT_EQ("POST", request.getMethod());
+  ASSERT_EQ("/json_rpc", request.getUrl());
+  ASSERT_EQ("HTTP/1.1", request.getVersion());
+  ASSERT_EQ("127.0.0.1", request.getHeaders().at("host"));
+  ASSERT_EQ("keep-alive", request.getHeaders().at("connection"));
+  ASSERT_EQ("hello", request.getBody());
+}
+
+TEST(HttpParserTest, waitsForWholeRequest) {
+  HttpParser parser;
+  HttpRequest request;
+  for (size_t size = 0; size < REQUEST.size(); ++size) {
+    ASSERT_EQ(0, parser.parseRequest(REQUEST.data(), size, request));
+    if (size < REQUEST.size() - 5) {
+      ASSERT_EQ(0, parser.getRequiredSize());
+    } else {
+      ASSERT_EQ(REQUEST.size(), parser.getRequiredSize());
+    }
+  }
+
+  ASSERT_EQ(REQUEST.size(), parser.parseRequest(REQUEST.data(), REQUEST.size(), request));
+  ASSERT_EQ("hello", request.getBody());
+  ASSERT_EQ(0, parser.getRequiredSize());
+}
+
+TEST(HttpParserTest, parsesPipelinedRequests) {
+  std::string data = REQUEST + "GET /getinfo HTTP/1.0\r\n\r\n" + REQUEST;
+  HttpParser parser;
+  HttpRequest first;
+  size_t offset = parser.parseRequest(data.data(), data.size(), first);
+  ASSERT_EQ(REQUEST.size(), offset);
+
+  HttpRequest second;
+  size_t size = parser.parseRequest(data.data() + offset, data.size() - offset, second);
+  ASSERT_EQ(25, size);
+  ASSERT_EQ("GET", second.getMethod());
+  ASSERT_EQ("/getinfo", second.getUrl());
+  ASSERT_EQ("HTTP/1.0", second.getVersion());
+  ASSERT_TRUE(second.getBody().empty());
+  offset += size;
+
+  HttpRequest third;
+  ASSERT_EQ(REQUEST.size(), parser.parseRequest(data.data() + offset, data.size() - offset, third));
+  ASSERT_EQ("hello", third.getBody());
+}
+
+TEST(HttpParserTest, rejectsMalformedHeads) {
+  HttpParser parser;
+  HttpRequest request;
+  std::string noUrl = "GET\r\n\r\n";
+  ASSERT_THROW(parser.parseRequest(noUrl.data(), noUrl.size(), request), std::system_error);
+
+  std::string noColon = "GET / HTTP/1.1\r\nHost\r\n\r\n";
+  ASSERT_THROW(HttpParser().parseRequest(noColon.data(), noColon.size(), request), std::system_error);
+
+  std::string emptyName = "GET / HTTP/1.1\r\n: value\r\n\r\n";
+  ASSERT_THROW(HttpParser().parseRequest(emptyName.data(), emptyName.size(), request), std::system_error);
+
+  std::string endless(128 * 1024, 'a');
+  ASSERT_THROW(HttpParser().parseRequest(endless.data(), endless.size(), request), std::system_error);
+}
+
+TEST(HttpParserTest, receivesResponseBodyFromStream) {
+  std::string body(10000, 'x');
+  std::istringstream stream("HTTP/1.1 200 OK\r\nContent-Length: 10000\r\n\r\n" + body);
+  HttpResponse response;
+  HttpParser().receiveResponse(stream, response);
+  ASSERT_EQ(HttpResponse::STATUS_200, response.getStatus());
+  ASSERT_EQ(body, response.getBody());
+}
+
+TEST(HttpParserTest, rejectsInvalidContentLength) {
+  HttpRequest request;
+  std::vector<std::string> lengths = { "-1", "5x", "", "18446744073709551615", std::to_string(HttpParser::MAX_BODY_SIZE + 1) };
+  for (const std::string& length : lengths) {
+    std::string head = "POST / HTTP/1.1\r\nContent-Length: " + length + "\r\n\r\n";
+    ASSERT_THROW(HttpParser().parseRequest(head.data(), head.size(), request), std::system_error);
+
+    std::istringstream stream("HTTP/1.1 200 OK\r\nContent-Length: " + length + "\r\n\r\n");
+    HttpResponse response;
+    ASSERT_THROW(HttpParser().receiveResponse(stream, response), std::system_error);
+  }
+}
+
+TEST(HttpParserTest, failsOnResponseBodyShorterThanAnnounced) {
+  std::istringstream stream("HTTP/1.1 200 OK\r\nContent-Length: 1000000\r\n\r\nhello");
+  HttpResponse response;
+  ASSERT_THROW(HttpParser().receiveResponse(stream, response), std::system_error);
+}
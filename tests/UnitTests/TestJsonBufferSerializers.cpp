@@ -0,0 +1,186 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2014-2017 XDN developers
+// Copyright (c) 2016-2017 BXC developers
+// Copyright (c) 2017 Doppler developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "gtest/gtest.h"
+
+#include <array>
+#include "Serialization/JsonInputBufferSerializer.h"
+#include "Serialization/JsonOutputBufferSerializer.h"
+#include "Serialization/SerializationOverloads.h"
+#include "Serialization/SerializationTools.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+struct Item {
+  std::string name;
+  uint32_t nonce;
+  std::array<uint8_t, 8> blob;
+  std::vector<uint64_t> amounts;
+
+  bool operator==(const Item& other) const {
+    return name == other.name && nonce == other.nonce && blob == other.blob && amounts == other.amounts;
+  }
+
+  void serialize(ISerializer& s) {
+    s(name, "name");
+    s(nonce, "nonce");
+    s.binary(blob.data(), blob.size(), "blob");
+    s(amounts, "amounts");
+  }
+};
+
+struct Message {
+  uint8_t u8;
+  int16_t i16;
+  int32_t i32;
+  int64_t i64;
+  uint64_t u64;
+  double real;
+  bool flag;
+  std::string text;
+  std::string data;
+  Item item;
+  std::vector<Item> items;
+  std::vector<std::vector<uint32_t>> matrix;
+
+  bool operator==(const Message& other) const {
+    return u8 == other.u8 && i16 == other.i16 && i32 == other.i32 && i64 == other.i64 && u64 == other.u64 &&
+      real == other.real && flag == other.flag && text == other.text && data == other.data && item == other.item &&
+      items == other.items && matrix == other.matrix;
+  }
+
+  void serialize(ISerializer& s) {
+    s(u8, "u8");
+    s(i16, "i16");
+    s(i32, "i32");
+    s(i64, "i64");
+    s(u64, "u64");
+    s(real, "real");
+    s(flag, "flag");
+    s(text, "text");
+    s.binary(data, "data");
+    s(item, "item");
+    s(items, "items");
+    s(matrix, "matrix");
+  }
+};
+
+Message makeMessage() {
+  Message message;
+  message.u8 = 200;
+  message.i16 = -300;
+  message.i32 = -70000;
+  message.i64 = INT64_MIN;
+  message.u64 = UINT64_MAX;
+  message.real = 0.25;
+  message.flag = true;
+  message.text = "plain text";
+  message.data = std::string("\x00\x01\xfe\xff", 4);
+  message.item = { "root", 7, { { 1, 2, 3, 4, 5, 6, 7, 8 } }, { 1, 2, 3 } };
+  message.items.push_back({ "first", 1, { { 0 } }, {} });
+  message.items.push_back({ "second", 2, { { 0xff } }, { 10000000000000 } });
+  message.matrix = { { 1, 2 }, {}, { 3 } };
+  return message;
+}
+
+template <typename T>
+void loadFromBuffer(T& value, const std::string& text) {
+  JsonInputBufferSerializer s(text.data(), text.size());
+  serialize(value, s);
+}
+
+}
+
+TEST(JsonBufferSerializers, roundTrip) {
+  Message message = makeMessage();
+  std::string text = storeToJson(message);
+
+  Message loaded;
+  loadFromBuffer(loaded, text);
+  ASSERT_EQ(message, loaded);
+}
+
+TEST(JsonBufferSerializers, writesTextJsonValueReads) {
+  Item item = { "item", 3, { { 1, 2, 3, 4, 5, 6, 7, 8 } }, { UINT64_MAX, 0, 10000000000000 } };
+  std::string text = storeToJson(item);
+
+  Item loaded;
+  loadFromJsonValue(loaded, Common::JsonValue::fromString(text));
+  ASSERT_EQ(item, loaded);
+}
+
+TEST(JsonBufferSerializers, readsTextJsonValueWrites) {
+  Message message = makeMessage();
+  message.matrix.clear();
+  std::string text = storeToJsonValue(message).toString();
+
+  Message loaded;
+  loadFromBuffer(loaded, text);
+  ASSERT_EQ(message, loaded);
+}
+
+TEST(JsonBufferSerializers, escapesStrings) {
+  Item item = { "quote\" backslash\\ tab\t line\n bell\x07 utf8 \xc3\xa9", 0, {}, {} };
+  std::string text = storeToJson(item);
+  ASSERT_NE(std::string::npos, text.find("\\\"")) << text;
+  ASSERT_NE(std::string::npos, text.find("\\u0007")) << text;
+
+  Item loaded;
+  loadFromBuffer(loaded, text);
+  ASSERT_EQ(item.name, loaded.name);
+
+  loadFromBuffer(loaded, "{\"name\":\"\\u00e9\\ud83d\\ude00\\/\"}");
+  ASSERT_EQ("\xc3\xa9\xf0\x9f\x98\x80/", loaded.name);
+}
+
+TEST(JsonBufferSerializers, skipsUnknownAndKeepsMissingMembers) {
+  Item item;
+  item.nonce = 5;
+  loadFromBuffer(item, " {\n\"extra\" : [ { \"a\" : [1, 2.5e3, null] }, true, false ] ,\"name\" : \"x\", \"more\": {} } ");
+  ASSERT_EQ("x", item.name);
+  ASSERT_EQ(5, item.nonce);
+  ASSERT_TRUE(item.amounts.empty());
+}
+
+TEST(JsonBufferSerializers, rejectsMalformedText) {
+  std::vector<std::string> badTexts{
+    "",
+    "[]",
+    "{",
+    "{} {}",
+    "{\"name\"}",
+    "{\"name\":}",
+    "{\"name\":\"x\",}",
+    "{\"nonce\":01}",
+    "{\"nonce\":1.}",
+    "{\"nonce\":-}",
+    "{\"name\":\"\\x\"}",
+    "{\"name\":\"\\u12\"}",
+    "{\"name\":\"a\nb\"}",
+    "{\"amounts\":[1,]}",
+    "{\"more\":tru}",
+    "{\"more\":" + std::string(1000, '[') + std::string(1000, ']') + "}"
+  };
+
+  for (const auto& text : badTexts) {
+    Item item;
+    ASSERT_ANY_THROW(loadFromBuffer(item, text)) << text;
+    ASSERT_FALSE(loadFromJson(item, text + " ")) << text;
+  }
+}
+
+TEST(JsonBufferSerializers, rejectsValuesOfWrongType) {
+  Item item;
+  ASSERT_ANY_THROW(loadFromBuffer(item, "{\"nonce\":\"1\"}"));
+  ASSERT_ANY_THROW(loadFromBuffer(item, "{\"nonce\":1.5}"));
+  ASSERT_ANY_THROW(loadFromBuffer(item, "{\"name\":1}"));
+  ASSERT_ANY_THROW(loadFromBuffer(item, "{\"amounts\":{}}"));
+  ASSERT_ANY_THROW(loadFromBuffer(item, "{\"blob\":\"0102030405060708090a\"}"));
+  ASSERT_ANY_THROW(loadFromBuffer(item, "{\"amounts\":[18446744073709551616]}"));
+}
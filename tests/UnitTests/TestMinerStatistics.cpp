@@ -0,0 +1,81 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2014-2017 XDN developers
+// Copyright (c) 2016-2017 BXC developers
+// Copyright (c) 2017 Doppler developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "gtest/gtest.h"
+
+#include "CryptoNoteCore/MinerStatistics.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+MinerThreadStatistics threadStatistics(uint64_t hashRate, uint64_t hashingTime, uint64_t waitingTime) {
+  MinerThreadStatistics thread;
+  thread.hashes = hashRate * hashingTime / 1000;
+  thread.hashRate = hashRate;
+  thread.hashingTime = hashingTime;
+  thread.waitingTime = waitingTime;
+  return thread;
+}
+
+}
+
+TEST(MinerStatisticsTest, totalHashRateOfNoThreadsIsZero) {
+  ASSERT_EQ(0, totalHashRate({}));
+}
+
+TEST(MinerStatisticsTest, totalHashRateSumsThreads) {
+  std::vector<MinerThreadStatistics> threads = { threadStatistics(120, 1000, 0), threadStatistics(80, 1000, 0), threadStatistics(0, 0, 1000) };
+  ASSERT_EQ(200, totalHashRate(threads));
+}
+
+TEST(MinerStatisticsTest, averageTemplateAgeIsZeroBeforeFirstBlock) {
+  ASSERT_EQ(0, averageTemplateAge(0, 0, 0));
+  ASSERT_EQ(0, averageTemplateAge(500, 0, 0));
+}
+
+TEST(MinerStatisticsTest, averageTemplateAgeCountsRejectedBlocks) {
+  ASSERT_EQ(300, averageTemplateAge(900, 2, 1));
+  ASSERT_EQ(900, averageTemplateAge(900, 1, 0));
+}
+
+TEST(MinerStatisticsTest, printShowsTotalsAndThreads) {
+  MinerStatistics statistics;
+  statistics.mining = true;
+  statistics.threads = { threadStatistics(120, 3000, 1000), threadStatistics(80, 1000, 0) };
+  statistics.hashRate = totalHashRate(statistics.threads);
+  statistics.blocksFound = 2;
+  statistics.blocksRejected = 1;
+  statistics.lastTemplateAge = 400;
+  statistics.averageTemplateAge = averageTemplateAge(900, statistics.blocksFound, statistics.blocksRejected);
+
+  ASSERT_EQ(
+    "Mining: yes, hashrate: 200 H/s\n"
+    "Blocks found: 2, rejected: 1\n"
+    "Template age at block find: last 400 ms, average 300 ms\n"
+    "Thread 0: 120 H/s, 360 hashes, hashing 3000 ms, waiting 1000 ms (75.0% busy)\n"
+    "Thread 1: 80 H/s, 80 hashes, hashing 1000 ms, waiting 0 ms (100.0% busy)\n",
+    printMinerStatistics(statistics));
+}
+
+TEST(MinerStatisticsTest, printIdleThreadAsNotBusy) {
+  MinerStatistics statistics;
+  statistics.mining = false;
+  statistics.threads = { threadStatistics(0, 0, 0) };
+  statistics.hashRate = totalHashRate(statistics.threads);
+  statistics.blocksFound = 0;
+  statistics.blocksRejected = 0;
+  statistics.lastTemplateAge = 0;
+  statistics.averageTemplateAge = averageTemplateAge(0, 0, 0);
+
+  ASSERT_EQ(
+    "Mining: no, hashrate: 0 H/s\n"
+    "Blocks found: 0, rejected: 0\n"
+    "Template age at block find: last 0 ms, average 0 ms\n"
+    "Thread 0: 0 H/s, 0 hashes, hashing 0 ms, waiting 0 ms (0.0% busy)\n",
+    printMinerStatistics(statistics));
+}
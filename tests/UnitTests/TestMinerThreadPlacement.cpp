@@ -0,0 +1,147 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2014-2017 XDN developers
+// Copyright (c) 2016-2017 BXC developers
+// Copyright (c) 2017 Doppler developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <fstream>
+#include <thread>
+
+#include <boost/filesystem.hpp>
+
+#include "CryptoNoteCore/MinerThreadPlacement.h"
+
+using namespace CryptoNote;
+
+#ifdef __linux__
+
+namespace {
+
+// a fake /sys/devices/system/cpu tree
+class CpuSysfs {
+public:
+  CpuSysfs() : m_root(boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("test_sysfs_%%%%%%%%%%%%")) {
+    boost::filesystem::create_directories(m_root);
+  }
+
+  ~CpuSysfs() {
+    boost::system::error_code ignore;
+    boost::filesystem::remove_all(m_root, ignore);
+  }
+
+  std::string path() const {
+    return m_root.string() + "/";
+  }
+
+  void setOnline(const std::string& cpus) {
+    write("online", cpus);
+  }
+
+  void addCpu(unsigned cpu, unsigned package, unsigned core) {
+    write(cpuPath(cpu) + "topology/physical_package_id", std::to_string(package));
+    write(cpuPath(cpu) + "topology/core_id", std::to_string(core));
+    addCache(cpu, 0, "1", "32K");
+    addCache(cpu, 1, "1", "32K");
+    addCache(cpu, 2, "2", "256K");
+  }
+
+  void addL3(unsigned cpu, const std::string& sharedCpus, const std::string& size) {
+    write(cpuPath(cpu) + "cache/index3/level", "3");
+    write(cpuPath(cpu) + "cache/index3/shared_cpu_list", sharedCpus);
+    write(cpuPath(cpu) + "cache/index3/size", size);
+  }
+
+private:
+  void addCache(unsigned cpu, unsigned index, const std::string& level, const std::string& size) {
+    std::string cachePath = cpuPath(cpu) + "cache/index" + std::to_string(index) + "/";
+    write(cachePath + "level", level);
+    write(cachePath + "shared_cpu_list", std::to_string(cpu));
+    write(cachePath + "size", size);
+  }
+
+  static std::string cpuPath(unsigned cpu) {
+    return "cpu" + std::to_string(cpu) + "/";
+  }
+
+  void write(const std::string& relativePath, const std::string& line) {
+    boost::filesystem::path path = m_root / relativePath;
+    boost::filesystem::create_directories(path.parent_path());
+    std::ofstream file(path.string());
+    file << line << std::endl;
+  }
+
+  boost::filesystem::path m_root;
+};
+
+std::vector<unsigned> placementOrder(const MinerThreadPlacement& placement, size_t threads) {
+  std::vector<unsigned> cpus;
+  for (size_t thread = 0; thread < threads; ++thread) {
+    cpus.push_back(placement.cpuForThread(thread));
+  }
+
+  return cpus;
+}
+
+}
+
+TEST(MinerThreadPlacementTest, missingTopologyLeavesThreadsToScheduler) {
+  CpuSysfs sysfs;
+  MinerThreadPlacement placement(sysfs.path());
+
+  ASSERT_FALSE(placement.isAvailable());
+  ASSERT_EQ(std::max(1u, std::thread::hardware_concurrency()), placement.defaultThreadCount());
+}
+
+TEST(MinerThreadPlacementTest, coresGoBeforeSmtSiblings) {
+  // one package without L3 information, cores 0 and 1 with siblings 2 and 3
+  CpuSysfs sysfs;
+  sysfs.setOnline("0-3");
+  sysfs.addCpu(0, 0, 0);
+  sysfs.addCpu(1, 0, 1);
+  sysfs.addCpu(2, 0, 0);
+  sysfs.addCpu(3, 0, 1);
+
+  MinerThreadPlacement placement(sysfs.path());
+  ASSERT_TRUE(placement.isAvailable());
+  ASSERT_EQ(2, placement.defaultThreadCount());
+  ASSERT_EQ(std::vector<unsigned>({0, 1, 2, 3}), placementOrder(placement, 4));
+}
+
+TEST(MinerThreadPlacementTest, eachDomainIsFilledUpToItsCapacityFirst) {
+  // two L3 domains of four cores with SMT siblings, the first holds one scratchpad, the second three
+  CpuSysfs sysfs;
+  sysfs.setOnline("0-15");
+  for (unsigned cpu = 0; cpu < 16; ++cpu) {
+    unsigned package = (cpu / 4) % 2;
+    sysfs.addCpu(cpu, package, cpu % 4);
+    if (package == 0) {
+      sysfs.addL3(cpu, "0-3,8-11", "2048K");
+    } else {
+      sysfs.addL3(cpu, "4-7,12-15", "6M");
+    }
+  }
+
+  MinerThreadPlacement placement(sysfs.path());
+  ASSERT_EQ(4, placement.defaultThreadCount());
+  ASSERT_EQ(std::vector<unsigned>({0, 4, 5, 6}), placementOrder(placement, 4));
+  ASSERT_EQ(std::vector<unsigned>({0, 4, 5, 6, 1, 2, 3, 7, 8, 12, 9, 13, 10, 14, 11, 15}), placementOrder(placement, 16));
+}
+
+TEST(MinerThreadPlacementTest, cacheSmallerThanScratchpadStillGetsOneThread) {
+  CpuSysfs sysfs;
+  sysfs.setOnline("0-1");
+  sysfs.addCpu(0, 0, 0);
+  sysfs.addCpu(1, 0, 1);
+  sysfs.addL3(0, "0-1", "1024K");
+  sysfs.addL3(1, "0-1", "1024K");
+
+  MinerThreadPlacement placement(sysfs.path());
+  ASSERT_EQ(1, placement.defaultThreadCount());
+  ASSERT_EQ(std::vector<unsigned>({0, 1, 0}), placementOrder(placement, 3));
+}
+
+#endif
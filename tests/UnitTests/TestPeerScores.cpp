@@ -0,0 +1,108 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2014-2017 XDN developers
+// Copyright (c) 2016-2017 BXC developers
+// Copyright (c) 2017 Doppler developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "gtest/gtest.h"
+
+#include "Common/MemoryInputStream.h"
+#include "Common/VectorOutputStream.h"
+#include "P2p/PeerScores.h"
+#include "Serialization/BinaryInputStreamSerializer.h"
+#include "Serialization/BinaryOutputStreamSerializer.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+const uint64_t NOW = 1500000000;
+
+NetworkAddress peer(uint32_t index) {
+  return { index + 1, 32001 };
+}
+
+}
+
+TEST(PeerScoresTest, unknownPeerIsNeutral) {
+  PeerScores scores(10);
+
+  PeerScore score;
+  ASSERT_FALSE(scores.get(peer(0), score));
+  ASSERT_DOUBLE_EQ(1.0, scores.score(peer(0)));
+}
+
+TEST(PeerScoresTest, fasterPeerScoresMore) {
+  PeerScores scores(10);
+  scores.addConnectRtt(peer(0), std::chrono::milliseconds(50), NOW);
+  scores.addConnectRtt(peer(1), std::chrono::milliseconds(800), NOW);
+  scores.addDownload(peer(2), 4 * 1024 * 1024, std::chrono::milliseconds(1000), NOW);
+  scores.addDownload(peer(3), 16 * 1024, std::chrono::milliseconds(1000), NOW);
+
+  ASSERT_GT(scores.score(peer(0)), 1.0);
+  ASSERT_LT(scores.score(peer(1)), 1.0);
+  ASSERT_GT(scores.score(peer(2)), scores.score(peer(0)));
+  ASSERT_LT(scores.score(peer(3)), 1.0);
+  ASSERT_GT(scores.score(peer(3)), 0.0);
+}
+
+TEST(PeerScoresTest, measurementsAreAveraged) {
+  PeerScores scores(10);
+  scores.addConnectRtt(peer(0), std::chrono::milliseconds(100), NOW);
+  scores.addConnectRtt(peer(0), std::chrono::milliseconds(500), NOW);
+
+  PeerScore score;
+  ASSERT_TRUE(scores.get(peer(0), score));
+  ASSERT_EQ(200, score.connectRtt);
+}
+
+TEST(PeerScoresTest, invalidDataAndUptime) {
+  PeerScores scores(10);
+  scores.addUptime(peer(0), 12 * 60 * 60, NOW);
+  scores.addInvalidData(peer(1), NOW);
+
+  ASSERT_DOUBLE_EQ(1.5, scores.score(peer(0)));
+  ASSERT_DOUBLE_EQ(0.25, scores.score(peer(1)));
+
+  auto all = scores.getAll();
+  ASSERT_EQ(2, all.size());
+  ASSERT_EQ(peer(0), all[0].first);
+  ASSERT_EQ(1, all[1].second.invalidData);
+}
+
+TEST(PeerScoresTest, leastRecentlyUpdatedPeerIsForgotten) {
+  PeerScores scores(2);
+  scores.addUptime(peer(0), 1, NOW + 1);
+  scores.addUptime(peer(1), 1, NOW);
+  scores.addUptime(peer(2), 1, NOW + 2);
+
+  PeerScore score;
+  ASSERT_TRUE(scores.get(peer(0), score));
+  ASSERT_FALSE(scores.get(peer(1), score));
+  ASSERT_TRUE(scores.get(peer(2), score));
+}
+
+TEST(PeerScoresTest, serialization) {
+  PeerScores scores(10);
+  scores.addConnectRtt(peer(0), std::chrono::milliseconds(120), NOW);
+  scores.addDownload(peer(1), 1024 * 1024, std::chrono::milliseconds(2000), NOW);
+  scores.addInvalidData(peer(1), NOW);
+
+  std::vector<uint8_t> data;
+  Common::VectorOutputStream output(data);
+  BinaryOutputStreamSerializer serializer(output);
+  scores.serialize(serializer);
+
+  PeerScores loaded(10);
+  Common::MemoryInputStream input(data.data(), data.size());
+  BinaryInputStreamSerializer deserializer(input);
+  loaded.serialize(deserializer);
+
+  PeerScore score;
+  ASSERT_TRUE(loaded.get(peer(1), score));
+  ASSERT_EQ(512 * 1024, score.downloadRate);
+  ASSERT_EQ(1, score.invalidData);
+  ASSERT_EQ(NOW, score.lastUpdate);
+  ASSERT_DOUBLE_EQ(scores.score(peer(0)), loaded.score(peer(0)));
+}
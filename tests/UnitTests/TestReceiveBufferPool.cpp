@@ -0,0 +1,56 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2014-2017 XDN developers
+// Copyright (c) 2016-2017 BXC developers
+// Copyright (c) 2017 Doppler developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "gtest/gtest.h"
+
+#include "P2p/ReceiveBufferPool.h"
+
+using namespace CryptoNote;
+
+TEST(ReceiveBufferPoolTest, takeFromEmptyPoolReservesSize) {
+  ReceiveBufferPool pool(1000);
+  BinaryArray buffer = pool.take(100);
+  ASSERT_GE(buffer.capacity(), 100);
+  ASSERT_EQ(0, pool.count());
+}
+
+TEST(ReceiveBufferPoolTest, bufferIsReused) {
+  ReceiveBufferPool pool(1000);
+  BinaryArray buffer = pool.take(100);
+  buffer.resize(100);
+  const uint8_t* data = buffer.data();
+  pool.put(std::move(buffer));
+  ASSERT_EQ(1, pool.count());
+
+  BinaryArray reused = pool.take(50);
+  ASSERT_EQ(data, reused.data());
+  ASSERT_TRUE(reused.empty());
+  ASSERT_EQ(0, pool.count());
+  ASSERT_EQ(0, pool.size());
+}
+
+TEST(ReceiveBufferPoolTest, smallestFittingBufferIsTaken) {
+  ReceiveBufferPool pool(1000);
+  BinaryArray big = pool.take(400);
+  BinaryArray small = pool.take(200);
+  const uint8_t* smallData = small.data();
+  pool.put(std::move(big));
+  pool.put(std::move(small));
+
+  ASSERT_EQ(smallData, pool.take(150).data());
+  ASSERT_EQ(1, pool.count());
+  ASSERT_GE(pool.take(300).capacity(), 300);
+  ASSERT_EQ(0, pool.count());
+}
+
+TEST(ReceiveBufferPoolTest, poolKeepsNoMoreThanMaxSize) {
+  ReceiveBufferPool pool(1000);
+  pool.put(pool.take(600));
+  pool.put(pool.take(600));
+  ASSERT_EQ(1, pool.count());
+  ASSERT_LE(pool.size(), 1000);
+}
@@ -0,0 +1,90 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2014-2017 XDN developers
+// Copyright (c) 2016-2017 BXC developers
+// Copyright (c) 2017 Doppler developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "gtest/gtest.h"
+
+#include "CryptoNoteCore/SerializedBlockCache.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+Crypto::Hash makeHash(uint8_t id) {
+  Crypto::Hash hash = {};
+  hash.data[0] = id;
+  return hash;
+}
+
+// a block of blockSize bytes with one transaction of txSize bytes
+std::shared_ptr<const SerializedBlock> makeBlock(size_t blockSize, size_t txSize) {
+  auto block = std::make_shared<SerializedBlock>();
+  block->timestamp = 0;
+  block->block.assign(blockSize, 'b');
+  block->transactions.push_back(std::string(txSize, 't'));
+  return block;
+}
+
+}
+
+TEST(SerializedBlockCache, findsInsertedBlocks) {
+  SerializedBlockCache cache(1000);
+  auto block = makeBlock(100, 50);
+  cache.insert(makeHash(1), block);
+
+  ASSERT_EQ(block, cache.find(makeHash(1)));
+  ASSERT_EQ(nullptr, cache.find(makeHash(2)));
+  ASSERT_EQ(150, cache.size());
+}
+
+TEST(SerializedBlockCache, evictsLeastRecentlyUsed) {
+  SerializedBlockCache cache(300);
+  cache.insert(makeHash(1), makeBlock(100, 0));
+  cache.insert(makeHash(2), makeBlock(100, 0));
+  cache.insert(makeHash(3), makeBlock(100, 0));
+  ASSERT_NE(nullptr, cache.find(makeHash(1)));
+
+  cache.insert(makeHash(4), makeBlock(50, 50));
+  ASSERT_NE(nullptr, cache.find(makeHash(1)));
+  ASSERT_EQ(nullptr, cache.find(makeHash(2)));
+  ASSERT_NE(nullptr, cache.find(makeHash(3)));
+  ASSERT_NE(nullptr, cache.find(makeHash(4)));
+  ASSERT_EQ(300, cache.size());
+}
+
+TEST(SerializedBlockCache, removesAndClears) {
+  SerializedBlockCache cache(1000);
+  cache.insert(makeHash(1), makeBlock(100, 0));
+  cache.insert(makeHash(2), makeBlock(100, 0));
+
+  cache.remove(makeHash(1));
+  ASSERT_EQ(nullptr, cache.find(makeHash(1)));
+  ASSERT_EQ(100, cache.size());
+
+  cache.clear();
+  ASSERT_EQ(nullptr, cache.find(makeHash(2)));
+  ASSERT_EQ(0, cache.size());
+}
+
+TEST(SerializedBlockCache, replacesBlockOfSameHash) {
+  SerializedBlockCache cache(1000);
+  cache.insert(makeHash(1), makeBlock(100, 0));
+  auto block = makeBlock(200, 0);
+  cache.insert(makeHash(1), block);
+
+  ASSERT_EQ(block, cache.find(makeHash(1)));
+  ASSERT_EQ(200, cache.size());
+}
+
+TEST(SerializedBlockCache, skipsBlockLargerThanCache) {
+  SerializedBlockCache cache(100);
+  cache.insert(makeHash(1), makeBlock(50, 0));
+  cache.insert(makeHash(2), makeBlock(100, 1));
+
+  ASSERT_EQ(nullptr, cache.find(makeHash(2)));
+  ASSERT_NE(nullptr, cache.find(makeHash(1)));
+  ASSERT_EQ(50, cache.size());
+}
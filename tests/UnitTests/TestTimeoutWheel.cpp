@@ -0,0 +1,94 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2014-2017 XDN developers
+// Copyright (c) 2016-2017 BXC developers
+// Copyright (c) 2017 Doppler developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "gtest/gtest.h"
+
+#include <boost/uuid/random_generator.hpp>
+
+#include "P2p/TimeoutWheel.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+const size_t SLOTS = 8;
+
+class TimeoutWheelTest : public testing::Test {
+public:
+  TimeoutWheelTest() :
+    start(TimeoutWheel::Clock::now()),
+    wheel(std::chrono::seconds(1), SLOTS, start) {
+    boost::uuids::random_generator generator;
+    connection1 = generator();
+    connection2 = generator();
+  }
+
+protected:
+  std::vector<TimeoutWheel::ConnectionId> expire(std::chrono::milliseconds elapsed) {
+    std::vector<TimeoutWheel::ConnectionId> expired;
+    wheel.expire(start + elapsed, expired);
+    return expired;
+  }
+
+  TimeoutWheel::Clock::time_point start;
+  TimeoutWheel wheel;
+  TimeoutWheel::ConnectionId connection1;
+  TimeoutWheel::ConnectionId connection2;
+};
+
+}
+
+TEST_F(TimeoutWheelTest, deadlineExpiresOnce) {
+  wheel.set(connection1, start + std::chrono::milliseconds(2500));
+
+  ASSERT_TRUE(expire(std::chrono::milliseconds(2000)).empty());
+  ASSERT_EQ(std::vector<TimeoutWheel::ConnectionId>({ connection1 }), expire(std::chrono::milliseconds(3000)));
+  ASSERT_EQ(0, wheel.size());
+  ASSERT_TRUE(expire(std::chrono::milliseconds(20000)).empty());
+}
+
+TEST_F(TimeoutWheelTest, setReplacesDeadline) {
+  wheel.set(connection1, start + std::chrono::seconds(1));
+  wheel.set(connection1, start + std::chrono::seconds(5));
+  ASSERT_EQ(1, wheel.size());
+
+  ASSERT_TRUE(expire(std::chrono::seconds(4)).empty());
+  ASSERT_EQ(std::vector<TimeoutWheel::ConnectionId>({ connection1 }), expire(std::chrono::seconds(5)));
+}
+
+TEST_F(TimeoutWheelTest, cancelledDeadlineDoesntExpire) {
+  wheel.set(connection1, start + std::chrono::seconds(1));
+  wheel.set(connection2, start + std::chrono::seconds(1));
+  wheel.cancel(connection1);
+
+  ASSERT_EQ(std::vector<TimeoutWheel::ConnectionId>({ connection2 }), expire(std::chrono::seconds(1)));
+}
+
+TEST_F(TimeoutWheelTest, deadlineBeyondRoundWaitsForIt) {
+  wheel.set(connection1, start + std::chrono::seconds(SLOTS + 2));
+
+  ASSERT_TRUE(expire(std::chrono::seconds(2)).empty());
+  ASSERT_TRUE(expire(std::chrono::seconds(SLOTS + 1)).empty());
+  ASSERT_EQ(std::vector<TimeoutWheel::ConnectionId>({ connection1 }), expire(std::chrono::seconds(SLOTS + 2)));
+}
+
+TEST_F(TimeoutWheelTest, longPauseExpiresEverything) {
+  wheel.set(connection1, start + std::chrono::seconds(3));
+  wheel.set(connection2, start + std::chrono::seconds(SLOTS * 3));
+
+  auto expired = expire(std::chrono::seconds(SLOTS * 10));
+  ASSERT_EQ(2, expired.size());
+  ASSERT_EQ(0, wheel.size());
+}
+
+TEST_F(TimeoutWheelTest, passedDeadlineExpiresOnNextTick) {
+  ASSERT_TRUE(expire(std::chrono::seconds(5)).empty());
+  wheel.set(connection1, start + std::chrono::seconds(1));
+
+  ASSERT_TRUE(expire(std::chrono::milliseconds(5500)).empty());
+  ASSERT_EQ(std::vector<TimeoutWheel::ConnectionId>({ connection1 }), expire(std::chrono::seconds(6)));
+}
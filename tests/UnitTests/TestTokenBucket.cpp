@@ -0,0 +1,58 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2014-2017 XDN developers
+// Copyright (c) 2016-2017 BXC developers
+// Copyright (c) 2017 Doppler developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "gtest/gtest.h"
+
+#include "P2p/TokenBucket.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+const TokenBucket::Clock::time_point START = TokenBucket::Clock::now();
+
+}
+
+TEST(TokenBucketTest, unlimitedBucketNeverDelays) {
+  TokenBucket bucket;
+  bucket.consume(START, 1000000000);
+  ASSERT_EQ(TokenBucket::Clock::duration::zero(), bucket.delay(START));
+}
+
+TEST(TokenBucketTest, burstOfOneSecondIsFree) {
+  TokenBucket bucket(1000);
+  bucket.consume(START, 1000);
+  ASSERT_EQ(TokenBucket::Clock::duration::zero(), bucket.delay(START));
+}
+
+TEST(TokenBucketTest, debtDelaysUntilPaidOff) {
+  TokenBucket bucket(1000);
+  bucket.consume(START, 3000);
+
+  auto delay = bucket.delay(START);
+  ASSERT_GE(delay, std::chrono::seconds(2));
+  ASSERT_LT(delay, std::chrono::milliseconds(2001));
+  ASSERT_GT(bucket.delay(START + std::chrono::milliseconds(1900)), TokenBucket::Clock::duration::zero());
+  ASSERT_EQ(TokenBucket::Clock::duration::zero(), bucket.delay(START + std::chrono::seconds(2)));
+}
+
+TEST(TokenBucketTest, idleTimeRefillsOneSecondAtMost) {
+  TokenBucket bucket(1000);
+  bucket.consume(START, 1000);
+  bucket.delay(START + std::chrono::seconds(10));
+
+  bucket.consume(START + std::chrono::seconds(10), 1500);
+  ASSERT_GT(bucket.delay(START + std::chrono::seconds(10)), std::chrono::milliseconds(400));
+}
+
+TEST(TokenBucketTest, setRateResetsBucket) {
+  TokenBucket bucket(1000);
+  bucket.consume(START, 5000);
+  bucket.setRate(0);
+  ASSERT_EQ(TokenBucket::Clock::duration::zero(), bucket.delay(START));
+  ASSERT_EQ(0, bucket.rate());
+}
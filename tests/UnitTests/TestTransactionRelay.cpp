@@ -0,0 +1,224 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2014-2017 XDN developers
+// Copyright (c) 2016-2017 BXC developers
+// Copyright (c) 2017 Doppler developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "gtest/gtest.h"
+
+#include <boost/uuid/random_generator.hpp>
+
+#include "CryptoNoteProtocol/TransactionRelay.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+const size_t KNOWN_TXS_PER_PEER = 10;
+const size_t MAX_ANNOUNCEMENT = 3;
+const size_t MAX_QUEUED_PER_PEER = 6;
+const size_t MAX_REQUESTS_PER_PEER = 4;
+const size_t MAX_REQUESTS = 6;
+const size_t MAX_ANNOUNCERS = 2;
+
+Crypto::Hash txId(uint32_t index) {
+  Crypto::Hash hash = {};
+  *reinterpret_cast<uint32_t*>(hash.data) = index + 1;
+  return hash;
+}
+
+class TransactionRelayTest : public testing::Test {
+public:
+  TransactionRelayTest() :
+    relay(KNOWN_TXS_PER_PEER, MAX_ANNOUNCEMENT, MAX_QUEUED_PER_PEER, MAX_REQUESTS_PER_PEER, MAX_REQUESTS, MAX_ANNOUNCERS,
+      std::chrono::milliseconds(100), std::chrono::seconds(10)),
+    now(TransactionRelay::Clock::now()) {
+    boost::uuids::random_generator generator;
+    peer1 = generator();
+    peer2 = generator();
+    peer3 = generator();
+    peer4 = generator();
+  }
+
+protected:
+  // the timer of the peer is random, an hour is far beyond it
+  bool takeAnnouncement(const TransactionRelay::PeerId& peer, std::vector<Crypto::Hash>& txs) {
+    relay.takeAnnouncement(peer, now, txs);
+    now += std::chrono::hours(1);
+    return relay.takeAnnouncement(peer, now, txs);
+  }
+
+  TransactionRelay relay;
+  TransactionRelay::Clock::time_point now;
+  TransactionRelay::PeerId peer1;
+  TransactionRelay::PeerId peer2;
+  TransactionRelay::PeerId peer3;
+  TransactionRelay::PeerId peer4;
+};
+
+}
+
+TEST_F(TransactionRelayTest, transactionIsQueuedOnlyForPeersThatDontKnowIt) {
+  relay.markKnown(peer1, txId(0));
+
+  ASSERT_FALSE(relay.queue(peer1, txId(0)));
+  ASSERT_TRUE(relay.queue(peer2, txId(0)));
+  ASSERT_FALSE(relay.queue(peer2, txId(0)));
+  ASSERT_TRUE(relay.isKnown(peer2, txId(0)));
+}
+
+TEST_F(TransactionRelayTest, announcementWaitsForTimer) {
+  ASSERT_TRUE(relay.queue(peer1, txId(0)));
+
+  std::vector<Crypto::Hash> txs;
+  ASSERT_FALSE(relay.takeAnnouncement(peer1, now, txs));
+  ASSERT_TRUE(relay.takeAnnouncement(peer1, now + std::chrono::hours(1), txs));
+  ASSERT_EQ(std::vector<Crypto::Hash>({ txId(0) }), txs);
+  ASSERT_FALSE(relay.takeAnnouncement(peer1, now + std::chrono::hours(2), txs));
+}
+
+TEST_F(TransactionRelayTest, announcementIsLimitedInSize) {
+  for (uint32_t i = 0; i < 5; ++i) {
+    ASSERT_TRUE(relay.queue(peer1, txId(i)));
+  }
+
+  std::vector<Crypto::Hash> txs;
+  ASSERT_TRUE(takeAnnouncement(peer1, txs));
+  ASSERT_EQ(std::vector<Crypto::Hash>({ txId(0), txId(1), txId(2) }), txs);
+  ASSERT_TRUE(takeAnnouncement(peer1, txs));
+  ASSERT_EQ(std::vector<Crypto::Hash>({ txId(3), txId(4) }), txs);
+}
+
+TEST_F(TransactionRelayTest, oldKnownTransactionsAreForgotten) {
+  for (uint32_t i = 0; i < KNOWN_TXS_PER_PEER; ++i) {
+    relay.markKnown(peer1, txId(i));
+  }
+
+  ASSERT_FALSE(relay.isKnown(peer1, txId(0)));
+  ASSERT_TRUE(relay.isKnown(peer1, txId(KNOWN_TXS_PER_PEER - 1)));
+}
+
+TEST_F(TransactionRelayTest, transactionIsRequestedFromOnePeer) {
+  std::vector<Crypto::Hash> toRequest;
+  relay.request(peer1, { txId(0), txId(1) }, now, toRequest);
+  ASSERT_EQ(std::vector<Crypto::Hash>({ txId(0), txId(1) }), toRequest);
+
+  toRequest.clear();
+  relay.request(peer2, { txId(1), txId(2) }, now, toRequest);
+  ASSERT_EQ(std::vector<Crypto::Hash>({ txId(2) }), toRequest);
+
+  relay.received(txId(1));
+  toRequest.clear();
+  relay.request(peer3, { txId(1) }, now, toRequest);
+  ASSERT_EQ(std::vector<Crypto::Hash>({ txId(1) }), toRequest);
+}
+
+TEST_F(TransactionRelayTest, timedOutRequestGoesToNextAnnouncer) {
+  std::vector<Crypto::Hash> toRequest;
+  relay.request(peer1, { txId(0) }, now, toRequest);
+  relay.request(peer2, { txId(0) }, now, toRequest);
+
+  TransactionRelay::PeerRequests retries;
+  ASSERT_EQ(0, relay.expire(now + std::chrono::seconds(9), retries));
+  ASSERT_EQ(1, relay.expire(now + std::chrono::seconds(10), retries));
+  ASSERT_EQ(1, retries.size());
+  ASSERT_EQ(std::vector<Crypto::Hash>({ txId(0) }), retries[peer2]);
+
+  retries.clear();
+  ASSERT_EQ(1, relay.expire(now + std::chrono::seconds(20), retries));
+  ASSERT_TRUE(retries.empty());
+
+  toRequest.clear();
+  relay.request(peer3, { txId(0) }, now, toRequest);
+  ASSERT_EQ(std::vector<Crypto::Hash>({ txId(0) }), toRequest);
+}
+
+TEST_F(TransactionRelayTest, requestOfRemovedPeerGoesToNextAnnouncer) {
+  std::vector<Crypto::Hash> toRequest;
+  relay.request(peer1, { txId(0), txId(1) }, now, toRequest);
+  relay.request(peer2, { txId(0) }, now, toRequest);
+  relay.removePeer(peer1);
+
+  TransactionRelay::PeerRequests retries;
+  ASSERT_EQ(1, relay.expire(now, retries));
+  ASSERT_EQ(std::vector<Crypto::Hash>({ txId(0) }), retries[peer2]);
+
+  toRequest.clear();
+  relay.request(peer3, { txId(1) }, now, toRequest);
+  ASSERT_EQ(std::vector<Crypto::Hash>({ txId(1) }), toRequest);
+}
+
+TEST_F(TransactionRelayTest, fullQueueDropsOldestTransactions) {
+  for (uint32_t i = 0; i < MAX_QUEUED_PER_PEER + 2; ++i) {
+    ASSERT_TRUE(relay.queue(peer1, txId(i)));
+  }
+
+  std::vector<Crypto::Hash> txs;
+  ASSERT_TRUE(takeAnnouncement(peer1, txs));
+  ASSERT_EQ(std::vector<Crypto::Hash>({ txId(2), txId(3), txId(4) }), txs);
+  ASSERT_TRUE(takeAnnouncement(peer1, txs));
+  ASSERT_EQ(std::vector<Crypto::Hash>({ txId(5), txId(6), txId(7) }), txs);
+  ASSERT_FALSE(takeAnnouncement(peer1, txs));
+}
+
+TEST_F(TransactionRelayTest, requestsPerPeerAreLimited) {
+  std::vector<Crypto::Hash> toRequest;
+  relay.request(peer1, { txId(0), txId(1), txId(2), txId(3), txId(4) }, now, toRequest);
+  ASSERT_EQ(MAX_REQUESTS_PER_PEER, toRequest.size());
+
+  // the announcement over the limit is only remembered
+  ASSERT_TRUE(relay.isKnown(peer1, txId(4)));
+  toRequest.clear();
+  relay.request(peer2, { txId(4) }, now, toRequest);
+  ASSERT_EQ(std::vector<Crypto::Hash>({ txId(4) }), toRequest);
+
+  relay.received(txId(0));
+  toRequest.clear();
+  relay.request(peer1, { txId(5) }, now, toRequest);
+  ASSERT_EQ(std::vector<Crypto::Hash>({ txId(5) }), toRequest);
+}
+
+TEST_F(TransactionRelayTest, requestsOfAllPeersAreLimited) {
+  std::vector<Crypto::Hash> toRequest;
+  relay.request(peer1, { txId(0), txId(1), txId(2), txId(3) }, now, toRequest);
+  relay.request(peer2, { txId(4), txId(5), txId(6) }, now, toRequest);
+  ASSERT_EQ(MAX_REQUESTS, toRequest.size());
+
+  relay.received(txId(4));
+  toRequest.clear();
+  relay.request(peer3, { txId(7), txId(8) }, now, toRequest);
+  ASSERT_EQ(std::vector<Crypto::Hash>({ txId(7) }), toRequest);
+}
+
+TEST_F(TransactionRelayTest, announcersOfRequestAreLimited) {
+  std::vector<Crypto::Hash> toRequest;
+  relay.request(peer1, { txId(0) }, now, toRequest);
+  relay.request(peer2, { txId(0) }, now, toRequest);
+  relay.request(peer3, { txId(0) }, now, toRequest);
+  relay.request(peer4, { txId(0) }, now, toRequest);
+
+  TransactionRelay::PeerRequests retries;
+  ASSERT_EQ(1, relay.expire(now + std::chrono::seconds(10), retries));
+  ASSERT_EQ(std::vector<Crypto::Hash>({ txId(0) }), retries[peer2]);
+  retries.clear();
+  ASSERT_EQ(1, relay.expire(now + std::chrono::seconds(20), retries));
+  ASSERT_EQ(std::vector<Crypto::Hash>({ txId(0) }), retries[peer3]);
+  retries.clear();
+  ASSERT_EQ(1, relay.expire(now + std::chrono::seconds(30), retries));
+  ASSERT_TRUE(retries.empty());
+}
+
+TEST_F(TransactionRelayTest, timedOutRequestSkipsAnnouncersAtTheirLimit) {
+  std::vector<Crypto::Hash> toRequest;
+  relay.request(peer1, { txId(0) }, now, toRequest);
+  auto later = now + std::chrono::seconds(5);
+  relay.request(peer2, { txId(1), txId(2), txId(3), txId(4) }, later, toRequest);
+  relay.request(peer2, { txId(0) }, later, toRequest);
+  relay.request(peer3, { txId(0) }, later, toRequest);
+
+  TransactionRelay::PeerRequests retries;
+  ASSERT_EQ(1, relay.expire(now + std::chrono::seconds(10), retries));
+  ASSERT_EQ(1, retries.size());
+  ASSERT_EQ(std::vector<Crypto::Hash>({ txId(0) }), retries[peer3]);
+}
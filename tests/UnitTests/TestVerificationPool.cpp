@@ -0,0 +1,51 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2014-2017 XDN developers
+// Copyright (c) 2016-2017 BXC developers
+// Copyright (c) 2017 Doppler developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "CryptoNoteCore/VerificationPool.h"
+
+using namespace CryptoNote;
+
+TEST(VerificationPool, runsEveryIndexOnceWithoutWorkers) {
+  VerificationPool pool;
+  std::vector<int> calls(10, 0);
+  pool.run(calls.size(), [&](size_t i) { ++calls[i]; });
+  ASSERT_EQ(std::vector<int>(10, 1), calls);
+}
+
+TEST(VerificationPool, runsBatchesOfSeveralCallers) {
+  VerificationPool pool;
+  pool.start(2);
+
+  const size_t callerCount = 4;
+  const size_t batchSize = 1000;
+  std::vector<std::vector<std::atomic<int>>> calls(callerCount);
+  std::vector<std::thread> callers;
+  for (size_t caller = 0; caller < callerCount; ++caller) {
+    calls[caller] = std::vector<std::atomic<int>>(batchSize);
+    callers.emplace_back([&, caller] {
+      for (size_t batch = 0; batch < 10; ++batch) {
+        pool.run(batchSize, [&](size_t i) { ++calls[caller][i]; });
+      }
+    });
+  }
+
+  for (auto& caller : callers) {
+    caller.join();
+  }
+
+  pool.stop();
+  for (size_t caller = 0; caller < callerCount; ++caller) {
+    for (size_t i = 0; i < batchSize; ++i) {
+      ASSERT_EQ(10, calls[caller][i]);
+    }
+  }
+}
@@ -6,6 +6,7 @@
 #include "gtest/gtest.h"
 
 #include <algorithm>
+#include <fstream>
 
 #include <boost/filesystem/operations.hpp>
 
@@ -15,6 +16,7 @@
 #include "CryptoNoteCore/Currency.h"
 #include "CryptoNoteCore/TransactionExtra.h"
 #include "CryptoNoteCore/TransactionPool.h"
+#include "CryptoNoteCore/TransactionPoolJournal.h"
 
 #include <Logging/ConsoleLogger.h>
 #include <Logging/LoggerGroup.h>
@@ -805,3 +807,214 @@ TEST_F(TxPool_FillBlockTemplate, TxPoolContinuesToAddOrdinaryTransactionsUpTo125
     TEST_MAX_TX_COUNT_PER_BLOCK - fusionTxCount,
     fusionTxCount));
 }
+
+TEST_F(tx_pool, LowestFeeRateTransactionIsEvictedWhenPoolIsFull) {
+  TestPool<TransactionValidator, FakeTimeProvider> pool(currency, logger);
+  const uint64_t fee = currency.minimumFee();
+
+  Transaction lowFeeTx;
+  Transaction highFeeTx;
+  Transaction middleFeeTx;
+  GenerateTransaction(currency, lowFeeTx, fee, 1);
+  GenerateTransaction(currency, highFeeTx, fee * 10, 1);
+  GenerateTransaction(currency, middleFeeTx, fee * 5, 1);
+
+  pool.setMaxPoolSize(getObjectBinarySize(lowFeeTx) + getObjectBinarySize(highFeeTx));
+
+  tx_verification_context tvc = boost::value_initialized<tx_verification_context>();
+  ASSERT_TRUE(pool.add_tx(lowFeeTx, tvc, false, 0));
+  ASSERT_TRUE(tvc.m_added_to_pool);
+  ASSERT_TRUE(pool.add_tx(highFeeTx, tvc, false, 0));
+  ASSERT_TRUE(tvc.m_added_to_pool);
+  ASSERT_EQ(0, pool.getStatistics().evictedCount);
+
+  ASSERT_TRUE(pool.add_tx(middleFeeTx, tvc, false, 0));
+  ASSERT_TRUE(tvc.m_added_to_pool);
+
+  ASSERT_EQ(2, pool.get_transactions_count());
+  ASSERT_FALSE(pool.have_tx(getObjectHash(lowFeeTx)));
+  ASSERT_TRUE(pool.have_tx(getObjectHash(highFeeTx)));
+  ASSERT_TRUE(pool.have_tx(getObjectHash(middleFeeTx)));
+
+  auto statistics = pool.getStatistics();
+  ASSERT_EQ(1, statistics.evictedCount);
+  ASSERT_LE(statistics.size, statistics.maxSize);
+  ASSERT_GT(statistics.minimumFeeRate, 0);
+}
+
+TEST_F(tx_pool, MinimumFeeRateRejectsCheapTransactionsAndDecays) {
+  TestPool<TransactionValidator, FakeTimeProvider> pool(currency, logger);
+  const uint64_t fee = currency.minimumFee();
+
+  Transaction firstTx;
+  Transaction secondTx;
+  GenerateTransaction(currency, firstTx, fee, 1);
+  GenerateTransaction(currency, secondTx, fee * 2, 1);
+
+  pool.setMaxPoolSize(getObjectBinarySize(firstTx));
+
+  tx_verification_context tvc = boost::value_initialized<tx_verification_context>();
+  ASSERT_TRUE(pool.add_tx(firstTx, tvc, false, 0));
+  ASSERT_TRUE(pool.add_tx(secondTx, tvc, false, 0));
+  ASSERT_EQ(1, pool.get_transactions_count());
+  ASSERT_TRUE(pool.have_tx(getObjectHash(secondTx)));
+
+  Transaction cheapTx;
+  GenerateTransaction(currency, cheapTx, fee, 1);
+  tvc = boost::value_initialized<tx_verification_context>();
+  ASSERT_FALSE(pool.add_tx(cheapTx, tvc, false, 0));
+  ASSERT_TRUE(tvc.m_tx_fee_too_small);
+  ASSERT_FALSE(tvc.m_added_to_pool);
+
+  pool.timeProvider.timeNow += 10 * CryptoNote::parameters::CRYPTONOTE_MEMPOOL_MIN_FEE_RATE_HALF_LIFE;
+  pool.on_idle();
+  ASSERT_EQ(0, pool.getStatistics().minimumFeeRate);
+}
+
+class PreverifiedTransactionValidator : public CryptoNote::ITransactionValidator {
+public:
+  PreverifiedTransactionValidator() : fullChecks(0), spentKeyImages(false) {}
+
+  virtual bool checkTransactionInputs(const CryptoNote::Transaction& tx, BlockInfo& maxUsedBlock) override {
+    ++fullChecks;
+    return true;
+  }
+
+  virtual bool checkTransactionInputs(const CryptoNote::Transaction& tx, BlockInfo& maxUsedBlock, BlockInfo& lastFailed) override {
+    return !maxUsedBlock.empty();
+  }
+
+  virtual bool haveSpentKeyImages(const CryptoNote::Transaction& tx) override {
+    return spentKeyImages;
+  }
+
+  virtual bool checkTransactionSize(size_t blobSize) override {
+    return true;
+  }
+
+  size_t fullChecks;
+  bool spentKeyImages;
+};
+
+TEST_F(tx_pool, PreverifiedTransactionIsAddedWithoutCheckingInputsAgain) {
+  TestPool<PreverifiedTransactionValidator, FakeTimeProvider> pool(currency, logger);
+
+  Transaction tx;
+  GenerateTransaction(currency, tx, currency.minimumFee(), 1);
+  Crypto::Hash txHash = getObjectHash(tx);
+
+  BlockInfo maxUsedBlock;
+  maxUsedBlock.height = 1;
+  maxUsedBlock.id = txHash;
+
+  tx_verification_context tvc = boost::value_initialized<tx_verification_context>();
+  ASSERT_TRUE(pool.add_tx(tx, txHash, getObjectBinarySize(tx), tvc, false, 0, &maxUsedBlock));
+  ASSERT_TRUE(tvc.m_added_to_pool);
+  ASSERT_TRUE(tvc.m_should_be_relayed);
+  ASSERT_EQ(0, pool.validator.fullChecks);
+}
+
+TEST_F(tx_pool, PreverifiedTransactionIsRejectedIfKeyImagesWereSpentMeanwhile) {
+  TestPool<PreverifiedTransactionValidator, FakeTimeProvider> pool(currency, logger);
+  pool.validator.spentKeyImages = true;
+
+  Transaction tx;
+  GenerateTransaction(currency, tx, currency.minimumFee(), 1);
+  Crypto::Hash txHash = getObjectHash(tx);
+
+  BlockInfo maxUsedBlock;
+  maxUsedBlock.height = 1;
+  maxUsedBlock.id = txHash;
+
+  tx_verification_context tvc = boost::value_initialized<tx_verification_context>();
+  ASSERT_FALSE(pool.add_tx(tx, txHash, getObjectBinarySize(tx), tvc, false, 0, &maxUsedBlock));
+  ASSERT_TRUE(tvc.m_verifivation_failed);
+  ASSERT_FALSE(tvc.m_added_to_pool);
+  ASSERT_FALSE(pool.have_tx(txHash));
+}
+
+TEST_F(tx_pool, TransactionsAreRestoredFromJournalAfterUncleanShutdown) {
+  TransactionValidator validator;
+  FakeTimeProvider timeProvider;
+  std::unique_ptr<tx_memory_pool> pool(new tx_memory_pool(currency, validator, timeProvider, logger));
+  ASSERT_TRUE(pool->init(m_configDir.string()));
+
+  Transaction keptTx;
+  Transaction takenTx;
+  GenerateTransaction(currency, keptTx, currency.minimumFee(), 1);
+  GenerateTransaction(currency, takenTx, currency.minimumFee(), 1);
+
+  tx_verification_context tvc = boost::value_initialized<tx_verification_context>();
+  ASSERT_TRUE(pool->add_tx(keptTx, tvc, false, 0));
+  ASSERT_TRUE(pool->add_tx(takenTx, tvc, false, 0));
+
+  Transaction tx;
+  size_t blobSize;
+  uint64_t fee;
+  ASSERT_TRUE(pool->take_tx(getObjectHash(takenTx), tx, blobSize, fee));
+
+  // no deinit(), so only the journal knows about these changes
+  pool.reset(new tx_memory_pool(currency, validator, timeProvider, logger));
+  ASSERT_TRUE(pool->init(m_configDir.string()));
+
+  ASSERT_EQ(1, pool->get_transactions_count());
+  ASSERT_TRUE(pool->have_tx(getObjectHash(keptTx)));
+  ASSERT_FALSE(pool->have_tx(getObjectHash(takenTx)));
+  ASSERT_EQ(getObjectBinarySize(keptTx), pool->getStatistics().size);
+}
+
+namespace {
+
+std::string writeJournal(const boost::filesystem::path& directory, Logging::ILogger& logger, const std::vector<BinaryArray>& records) {
+  boost::filesystem::create_directories(directory);
+  std::string journalPath = (directory / "pooljournal.bin").string();
+  TransactionPoolJournal journal(logger);
+  journal.start(journalPath, (directory / "poolstate.bin").string());
+  for (auto record : records) {
+    journal.append(std::move(record));
+  }
+
+  journal.stop();
+  return journalPath;
+}
+
+}
+
+TEST_F(tx_pool, JournalReplayStopsAtTruncatedRecord) {
+  std::vector<BinaryArray> written = { BinaryArray(100, 1), BinaryArray(200, 2) };
+  std::string journalPath = writeJournal(m_configDir, logger, written);
+  boost::filesystem::resize_file(journalPath, boost::filesystem::file_size(journalPath) - 1);
+
+  std::vector<BinaryArray> records;
+  ASSERT_TRUE(TransactionPoolJournal::load(journalPath, records));
+  ASSERT_EQ(std::vector<BinaryArray>(written.begin(), written.begin() + 1), records);
+}
+
+TEST_F(tx_pool, JournalReplayStopsAtCorruptedLength) {
+  std::vector<BinaryArray> written = { BinaryArray(100, 1), BinaryArray(200, 2), BinaryArray(300, 3) };
+  std::string journalPath = writeJournal(m_configDir, logger, written);
+
+  // the length of the second record is raised to 4 GiB - 1, the records after it are dropped as well
+  std::fstream journalFile(journalPath, std::ios_base::binary | std::ios_base::in | std::ios_base::out);
+  journalFile.seekp(8 + 100);
+  journalFile.write("\xff\xff\xff\xff", 4);
+  journalFile.close();
+
+  std::vector<BinaryArray> records;
+  ASSERT_TRUE(TransactionPoolJournal::load(journalPath, records));
+  ASSERT_EQ(std::vector<BinaryArray>(written.begin(), written.begin() + 1), records);
+}
+
+TEST_F(tx_pool, JournalReplayStopsAtRecordWithBadChecksum) {
+  std::vector<BinaryArray> written = { BinaryArray(100, 1), BinaryArray(200, 2), BinaryArray(300, 3) };
+  std::string journalPath = writeJournal(m_configDir, logger, written);
+
+  std::fstream journalFile(journalPath, std::ios_base::binary | std::ios_base::in | std::ios_base::out);
+  journalFile.seekp(8 + 100 + 8 + 50);
+  journalFile.write("\x07", 1);
+  journalFile.close();
+
+  std::vector<BinaryArray> records;
+  ASSERT_TRUE(TransactionPoolJournal::load(journalPath, records));
+  ASSERT_EQ(std::vector<BinaryArray>(written.begin(), written.begin() + 1), records);
+}